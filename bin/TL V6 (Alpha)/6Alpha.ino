@@ -11,11 +11,30 @@
 
    Features:
    - 🌞 Tagesmodus: Festes Ampelprogramm mit Fußgängeranforderung
+     (Signalplan als geprüfte Flash-Tabelle, Phasenplan.h)
    - 🌚 Nachtmodus: Sensorgesteuerte Ampel mit Auto-Erkennung
+   - 🔀 Betriebsarten wechseln nur an sicheren Punkten (Betriebsarten.h)
    - 🚦 Blinkmodus bei Inaktivität
    - 🚸 Fußgänger-Warnblinkphase
    - 🔒 Entprellte Taster mit Interrupts
    - 📈 Serielles Debugging-Interface
+   - 🖼️ Optional: E-Paper-Statusschild (StatusSchild.h)
+   - 📟 Optional: Statusseite auf 20x4-LCD über I2C (StatusLcd.h)
+   - 💡 Optional: WS2812-Lampen mit Dimmung (NeoPixelTreiber.h)
+   - 🔌 Optional: Lampen über Schieberegister/MCP23017 (IoTreiber.h)
+   - 🚑 Optional: Vorrang für Einsatzfahrzeuge per 433 MHz (Vorrang.h)
+   - 🚌 Optional: ÖPNV-Bevorrechtigung über CAN/J1939 (Busvorrang.h)
+   - 💾 Optional: Sensorspur auf SD aufnehmen/abspielen (SensorSpur.h, crashfest: Sektorlog.h)
+   - 📊 Optional: Umlauf/Grünzeiten nach Webster aus Zählwerten (Umlauf.h)
+   - 🔋 Optional: Stromsparender Nacht-Blinkbetrieb (Sparbetrieb.h)
+   - 🚂 Optional: Bahnübergang-Vorrang mit Schranke (Bahnuebergang.h)
+   - 🎚️ Optional: Alle Taster an einem Analogpin (TasterLeiter.h)
+   - 🧵 Optional: Kooperative Fäden auf ARM-Boards (Faeden.h)
+   - ⌨️ Optional: AT-Befehle über Serial/Bluetooth (lib/ATCommands)
+   - 📡 Optional: Binäre Verbindung zum ESP32-Begleiter (Begleiter.h)
+   - 📅 Optional: Wochenplan nach RTC mit Feiertagen und Sommerzeit (Kalender.h)
+   - 🩺 Optional: Detektorüberwachung mit Rückfall auf Daueranforderung (Detektoren.h)
+   - 🛩️ Optional: Blackbox der Lampenbilder im SPI-Flash (Blackbox.h)
 
    Pinbelegung:
    Siehe CONFIG SECTION unten
@@ -25,6 +44,8 @@
    ===================================================== */
 
 #include <NewPing.h>  // Für zuverlässige Ultraschallmessung
+#include "LampenAusgabe.h"
+#include "Phasenplan.h"
 
 // =====================================================
 // KONFIGURATIONSBEREICH - ALLES ANPASSBAR
@@ -52,24 +73,61 @@ const uint8_t FUSSGAENGER_LICHTER[4][2] = {
 };
 
 // Ultraschallsensoren [Trigger, Echo]
+#define SENSOR_MAX_CM 300
+#ifndef SONAR_OST_TRIGGER            // auf dem PC per -D gesetzt
+#define SONAR_OST_TRIGGER 18         // mit ESP_BEGLEITER umlegen (Serial1), z.B. 41/42
+#define SONAR_OST_ECHO    19
+#endif
 NewPing SONAR[4] = {
-  NewPing(14, 15, 300),  // Nord (max 300cm)
-  NewPing(16, 17, 300),  // Süd (max 300cm)
-  NewPing(18, 19, 300),  // Ost (max 300cm)
-  NewPing(1, 0, 300)     // West (max 300cm)
+  NewPing(14, 15, SENSOR_MAX_CM),  // Nord
+  NewPing(16, 17, SENSOR_MAX_CM),  // Süd
+  NewPing(SONAR_OST_TRIGGER, SONAR_OST_ECHO, SENSOR_MAX_CM),  // Ost
+  NewPing(1, 0, SENSOR_MAX_CM)     // West
 };
 
 // Fußgängertaster (jetzt an Interrupt-fähigen Pins)
 const uint8_t FUSSGAENGER_TASTER[4] = {3, 18, 19, 20}; // Beispielhafte Pins: Nord, Süd, Ost, West
 
+// Alternativ: alle Taster als Widerstandsleiter an einem Analogpin
+#ifndef TASTER_LEITER        // auf dem PC per -D gesetzt
+#define TASTER_LEITER   0    // 1 = Fußgänger- und Modustaster an LEITER_PIN, Interrupt-Pins bleiben frei
+#endif
+#define LEITER_PIN      A0   // 10k Pull-up nach 5V, Tasten siehe LEITER_SCHWELLEN
+#ifndef LEITER_FREILAUF      // auf dem PC per -D gesetzt
+#define LEITER_FREILAUF 1    // 0 = ADC nur bei Timer0-Überlauf (1 kHz), besser mit NACHT_SPARBETRIEB
+#endif
+
 // -------------------------
 // ZEITEINSTELLUNGEN (MILLISEKUNDEN)
 // -------------------------
+// Tagesprogramm: Signalbild und Dauer pro Phase (Phasenplan.h)
+constexpr PlanPhase TAGESPLAN[] PROGMEM = {
+  //          Dauer  Nord        Süd         Ost         West
+  plan_phase(10000, PLAN_GRUEN, PLAN_GRUEN, PLAN_ROT,   PLAN_ROT),
+  plan_phase( 3000, PLAN_GELB,  PLAN_GELB,  PLAN_ROT,   PLAN_ROT),
+  plan_phase(10000, PLAN_ROT,   PLAN_ROT,   PLAN_GRUEN, PLAN_GRUEN),
+  plan_phase( 3000, PLAN_ROT,   PLAN_ROT,   PLAN_GELB,  PLAN_GELB),
+};
+#define TAGESPLAN_PHASEN (sizeof(TAGESPLAN) / sizeof(TAGESPLAN[0]))
+#define GELB_MIN         3000   // kürzeste Gelbzeit (ms)
+#define ZWISCHENZEIT_MIN 3000   // Ende Grün bis Grün einer feindlichen Zufahrt (ms)
+
+// Nord/Süd gegen Ost/West
+constexpr uint16_t FEINDLICH = plan_feindlich(0, 2) | plan_feindlich(0, 3) |
+                               plan_feindlich(1, 2) | plan_feindlich(1, 3);
+
+static_assert(plan_gruen_vertraeglich(TAGESPLAN, FEINDLICH), "TAGESPLAN: Grün für feindliche Zufahrten");
+static_assert(plan_gelb_vollstaendig(TAGESPLAN, GELB_MIN), "TAGESPLAN: Grün endet ohne (ausreichend) Gelb");
+static_assert(plan_zwischenzeiten(TAGESPLAN, FEINDLICH, ZWISCHENZEIT_MIN), "TAGESPLAN: Zwischenzeit zu kurz");
+// Umlaufoptimierung, Busvorrang und AT+FORCE rechnen mit
+// Grün, Gelb, Grün, Gelb
+static_assert(TAGESPLAN_PHASEN == 4, "TAGESPLAN: vier Phasen erwartet");
+
 enum ZEITEN {
-  TAGES_PHASEN[] = {10000, 3000, 10000, 3000}, // Grün, Gelb, Grün, Gelb
   NACHT_GRUEN     = 15000,   // Grünphase bei Autoerkennung
   NACHT_GELB      = 3000,    // Gelbphase
   BLINK_INTERVALL = 500,     // Gelblichtblinken
+  BLINK_RAEUMZEIT = 2000,    // Alles-Rot zwischen Gelbblinken und Grün
   FUSSG_GEHZEIT   = 8000,    // Dauer Grünphase
   FUSSG_BLINKZEIT = 500,     // Blinkintervall
   ENTSPRELLZEIT   = 200      // Entprellzeit Taster
@@ -80,12 +138,177 @@ enum ZEITEN {
 // -------------------------
 #define SENSOR_AKTIV_DISTANZ 150  // Autoerkennung bis 1.5m (cm)
 #define SENSOR_UPDATE        500   // Sensorabfrageintervall
+#ifndef UMLAUF_OPTIMIERUNG         // auf dem PC per -D gesetzt
+#define UMLAUF_OPTIMIERUNG   0     // 1 = Tagesprogramm passt Umlauf/Grünzeiten an den gezählten Verkehr an
+#endif
+#ifndef NACHT_SPARBETRIEB          // auf dem PC per -D gesetzt
+#define NACHT_SPARBETRIEB    0     // 1 = Nacht-Blinken schläft zwischen Flanken und Sweeps (Solarbetrieb)
+#endif
+#ifndef DETEKTOR_UEBERWACHUNG      // auf dem PC per -D gesetzt
+#define DETEKTOR_UEBERWACHUNG 0    // 1 = tote/klebende Sensoren erkennen, Zufahrt dann dauernd angefordert (Detektoren.h)
+#endif
+#define DETEKTOR_HINTERGRUND 1     // 1 = ohne Fahrzeug sieht jeder Sensor die Gegenseite (< SENSOR_MAX_CM)
+#define DETEKTOR_RECALL_GRUEN 8000 // Nachtgrün einer gestörten Zufahrt (ms), gedeckelt statt NACHT_GRUEN
+
+// -------------------------
+// LAMPENTREIBER
+// -------------------------
+#ifndef LAMPEN_NEOPIXEL              // auf dem PC per -D gesetzt
+#define LAMPEN_NEOPIXEL      0       // 1 = WS2812-Kette an 1 Pin statt 20 GPIOs
+#endif
+#define NEOPIXEL_PIN         5       // Datenleitung der Kette
+#define LICHTSENSOR_PIN      A1      // LDR für Helligkeitsnachführung
+#ifndef LAMPEN_IOEXPANDER            // auf dem PC per -D gesetzt
+#define LAMPEN_IOEXPANDER    0       // 1 = Lampen über Schieberegister/Portexpander (lib/IoAbstraction)
+#endif
+#define IOEXP_MCP23017       0       // 0 = 74HC595-Kette, 1 = 2x MCP23017 (I2C)
+#define SR_DATEN_PIN         34
+#define SR_TAKT_PIN          35
+#define SR_LATCH_PIN         36
+#define SR_ANZAHL            3       // 3x 8 Ausgänge für 20 Lampen
+#define MCP23017_ADRESSE_1   0x20
+#define MCP23017_ADRESSE_2   0x21
+
+// -------------------------
+// STATUSSCHILD (E-PAPER)
+// -------------------------
+#ifndef STATUS_EPAPER                // auf dem PC per -D gesetzt
+#define STATUS_EPAPER        0       // 1 = E-Paper-Statusschild (lib/Adafruit_EPD)
+#endif
+#define SCHILD_INTERVALL     60000   // Mindestabstand zwischen zwei Refreshes (ms)
+#define EPD_PANEL            ThinkInk_290_Mono_M06   // UC8151D, kann Teil-Refresh
+#define EPD_DC               44
+#define EPD_RESET            45
+#define EPD_CS               46
+#define EPD_SRAM_CS          43      // SRAM auf dem Breakout (-1 = 4,7 KB Framebuffer im Mega-RAM)
+#define EPD_BUSY             47
+
+// -------------------------
+// STATUS-LCD (20x4, I2C)
+// -------------------------
+#ifndef STATUS_LCD                   // auf dem PC per -D gesetzt
+#define STATUS_LCD           0       // 1 = Statusseite auf Zeichen-LCD mit PCF8574 (StatusLcd.h, lib/LiquidCrystal_I2C)
+#endif
+#define LCD_ADRESSE          0x27    // PCF8574A: 0x3F
+#define LCD_SEITE_MS         250     // so oft wird die Seite neu gezeichnet (nur im RAM)
+#define LCD_ZEICHEN_PRO_TICK 5       // Zeichen bzw. setCursor pro Aufruf, je ~0,6 ms auf dem Bus
+#define LCD_AUFFRISCHEN_MS   600000  // ab und zu alles neu schicken (Störung auf der Leitung)
+
+// -------------------------
+// VORRANG (EINSATZFAHRZEUGE)
+// -------------------------
+#ifndef VORRANG_AKTIV                // auf dem PC per -D gesetzt
+#define VORRANG_AKTIV          0     // 1 = 433-MHz-Vorrang (lib/rc-switch)
+#endif
+#ifndef VORRANG_SIMULATION           // auf dem PC per -D gesetzt
+#define VORRANG_SIMULATION     0     // 1 = Codes per Serial ("V<code>") statt Funk
+#endif
+#define VORRANG_EMPFAENGER_PIN 21    // Datenpin des 433-MHz-Empfängers (Interrupt)
+
+// -------------------------
+// ÖPNV-BEVORRECHTIGUNG (CAN/J1939)
+// -------------------------
+#ifndef BUSVORRANG_AKTIV             // auf dem PC per -D gesetzt
+#define BUSVORRANG_AKTIV       0     // 1 = Busmeldungen über MCP2515 auswerten
+#endif
+#define CAN_CS_PIN             48    // Chip-Select des MCP2515
+#define CAN_FRAMES_PRO_LOOP    8     // Empfangsbudget pro Loop
+
+// -------------------------
+// BAHNÜBERGANG
+// -------------------------
+#ifndef BAHN_VORRANG                 // auf dem PC per -D gesetzt
+#define BAHN_VORRANG           0     // 1 = Zugmeldung räumt die Gleise, Schranke per Schrittmotor (lib/AccelStepper)
+#endif
+#define BAHN_MELDER_PIN        37    // Einschaltkontakt (LOW = Zug kommt)
+#define BAHN_ZUFAHRT           2     // Zufahrt über die Gleise (0=Nord, 1=Süd, 2=Ost, 3=West)
+#define SCHRANKE_STEP_PIN      38    // Schrittmotortreiber (z.B. A4988)
+#define SCHRANKE_DIR_PIN       39
+#define SCHRANKE_ENABLE_PIN    40
+
+// -------------------------
+// SENSORSPUR (AUFNAHME/WIEDERGABE)
+// -------------------------
+#ifndef SENSOR_SPUR                  // auf dem PC per -D gesetzt
+#define SENSOR_SPUR            0     // 0 = aus, 1 = Echos+Taster auf SD aufnehmen, 2 = Spur statt Sensoren abspielen
+#endif
+#define SPUR_SD_CS             53    // Chip-Select der SD-Karte
+#define SPUR_DATEI             "SPUR.BIN"
+#define SPUR_TASTER_MODUS      4     // Kanal des Modustasters in der Spur
+#ifndef SPUR_SEKTOREN                // auf dem PC per -D gesetzt
+#define SPUR_SEKTOREN          0     // 1 = vorbelegte Datei, rohe Sektoren mit Folgenummer+CRC (Sektorlog.h, lib/SdFat_-_Adafruit_Fork,
+                                     //     Build-Flag -DCHECK_FLASH_PROGRAMMING=0)
+#endif
+#ifndef SPUR_SEKTOR_MB               // auf dem PC per -D gesetzt
+#define SPUR_SEKTOR_MB         64    // Dateigröße, reicht für eine Woche (ein Sektor alle 5 s)
+#endif
+
+// -------------------------
+// BLACKBOX (SPI-FLASH)
+// -------------------------
+#ifndef BLACKBOX_AKTIV               // auf dem PC per -D gesetzt
+#define BLACKBOX_AKTIV         0     // 1 = Lampenbilder, Erkennung, Taster als Ring ins SPI-Flash (Blackbox.h, lib/Adafruit_SPIFlash)
+#endif
+#define BLACKBOX_CS            49    // Chip-Select des Flashs (z.B. W25Q16), gemeinsamer SPI-Bus
+#define BLACKBOX_START         0     // Adresse im Flash (Sektorgrenze)
+#define BLACKBOX_BYTES         (256UL * 1024)  // 64 Sektoren, reicht für mehrere Tage
+#define BLACKBOX_ZEILEN_PRO_TICK 4   // AT+BBOX: Ausgabezeilen pro Aufruf
+
+// -------------------------
+// KOOPERATIVE FÄDEN (ARM: DUE, ZERO)
+// -------------------------
+#ifndef KOOP_FAEDEN                  // auf dem PC per -D gesetzt
+#define KOOP_FAEDEN            0     // 1 = Sensor-, Telemetrie- und HMI-Faden neben der Phasen-Loop (lib/Scheduler)
+#endif
+#define LATENZ_MESSUNG         0     // 1 = Abstände der Taster-/Sensor-/Phasen-/Statusdurchläufe messen (auch ohne Fäden)
+#define FADEN_STACK_SENSOR     1024  // Bytes, nach "Stack genutzt" im Status verkleinern
+#define FADEN_STACK_TELEMETRIE 1536  // Statusausgabe mit Serial.print braucht am meisten
+#define FADEN_STACK_HMI        1024
+
+// -------------------------
+// AT-KONSOLE (SERIELL/BLUETOOTH)
+// -------------------------
+#ifndef AT_KONSOLE                   // auf dem PC per -D gesetzt
+#define AT_KONSOLE             0     // 1 = AT+PHASE?, AT+DET?, AT+PLAN=, AT+FORCE=, AT+HOLD=, AT+STATS?, AT+UHR=, AT+BBOX (lib/ATCommands)
+#endif
+#define KONSOLE_PORT           Serial  // z.B. Serial1 mit einem Bluetooth-Modul (HC-05)
+#define KONSOLE_PUFFER         24    // längste Befehlszeile inkl. "AT" (ohne CR/LF)
+#define KONSOLE_BYTES_PRO_TICK 16    // Lesebudget pro Aufruf, ein Befehl wird im selben Aufruf beantwortet
+#define KONSOLE_MINDESTGRUEN   5000  // AT+FORCE kürzt Grünphasen höchstens bis hierhin (ms)
+
+// -------------------------
+// ESP32-BEGLEITER (BINÄR ÜBER UART)
+// -------------------------
+#ifndef ESP_BEGLEITER                // auf dem PC per -D gesetzt
+#define ESP_BEGLEITER          0     // 1 = Berichte an den ESP32, Aufträge vom ESP32 (lib/SerialCom, Begleiter.h)
+#endif
+#define BEGLEITER_PORT         Serial1   // TX1/RX1 = 18/19: Sonar Ost umlegen, Taster über TASTER_LEITER
+#define BEGLEITER_BAUD         1000000   // 16 MHz / 16: auf dem Mega ohne Baudratenfehler
+#define BEGLEITER_INTERVALL    1000  // unaufgeforderter Bericht (ms)
+#define BEGLEITER_WIEDERHOLEN  20    // ms ohne Quittung bis zur Wiederholung (ESP32-Loop + Leitung)
+#define BEGLEITER_BYTES_PRO_TICK 40  // Lesebudget pro Aufruf, reicht für einen Auftrag samt Quittung
+#if ESP_BEGLEITER && !TASTER_LEITER
+#error "ESP_BEGLEITER: Serial1 (18/19) belegt die Fußgängertaster Süd/Ost, TASTER_LEITER=1 setzen"
+#endif
+#if ESP_BEGLEITER && (SONAR_OST_TRIGGER == 18 || SONAR_OST_TRIGGER == 19 || SONAR_OST_ECHO == 18 || SONAR_OST_ECHO == 19)
+#error "ESP_BEGLEITER: Serial1 (18/19) belegt den Sonar Ost, SONAR_OST_TRIGGER/SONAR_OST_ECHO umlegen"
+#endif
+
+// -------------------------
+// KALENDER (DS3231, MEZ/MESZ)
+// -------------------------
+#ifndef KALENDER_AKTIV               // auf dem PC per -D gesetzt
+#define KALENDER_AKTIV         0     // 1 = TAG/NACHT, Selbsttest, Spurwechsel nach Wochenplan (Kalender.h, lib/RTClib)
+#endif
+// Plan: KALENDER_PLAN unten, RTC an SDA/SCL (20/21), läuft in UTC
 
 // =====================================================
 // GLOBALE VARIABLEN & ZUSTÄNDE
 // =====================================================
 enum MODI { TAG, NACHT };
 enum LICHTZUSTAND { ROT, GELB, GRUEN };
+static_assert((uint8_t)ROT == (uint8_t)PLAN_ROT && (uint8_t)GELB == (uint8_t)PLAN_GELB &&
+              (uint8_t)GRUEN == (uint8_t)PLAN_GRUEN, "Signalbilder wie LICHTZUSTAND");
 
 // Systemzustand
 volatile MODI aktueller_modus = TAG;
@@ -93,52 +316,287 @@ uint32_t modus_wechsel_zeit = 0;
 uint32_t phasen_startzeit = 0;
 uint8_t aktuelle_phase = 0;
 
+// Tasterflanken: die ISRs (auch die der Widerstandsleiter) legen
+// sie nur ab, verarbeitet wird in der Loop (taster_abholen)
+#include "TasterFlanke.h"
+TasterFlanken taster_flanken(8);
+
 // Fußgängermanagement
-volatile bool fussg_anforderung[4] = {false};
+bool fussg_anforderung[4] = {false};
 bool fussg_aktiv = false;
+// Bit pro Richtung: Furt belegt von Fußgängergrün bis fussg_setzen(ROT),
+// auch in den dunklen Takten des Warnblinkens (Vorrang/Bahn räumen dann)
+uint8_t fussg_phasen = 0;
 uint32_t fussg_letzte_aktivierung = 0;
 
 // Nachtmodus
 bool auto_erkannt[4] = {false};
+uint16_t sensor_cm[4] = {0};
+// Letzter vollständiger Sweep für Leser außerhalb des Sweeps
+// (Status, ESP32-Begleiter) - nie halb alt, halb neu
+struct SensorBild {
+  uint16_t cm[4];
+  uint8_t erkannt;          // Bitmaske der Zufahrten
+  uint32_t zeit_ms;
+};
+tccollection::SeqLockSnapshot<SensorBild> sensor_bild;
 uint32_t letzte_sensor_aktualisierung = 0;
 uint8_t aktive_richtung = 0;
+bool blinkbetrieb = false;
+bool blinkzustand = false;
+uint32_t letztes_blinken = 0;
+bool blink_raeumen = false;        // Abgabe angefordert: Alles-Rot statt Blinken
+uint32_t blink_raeumen_seit = 0;
+
+// Betriebsarten (Tabelle BETRIEBSARTEN unten)
+#include "Betriebsarten.h"
+enum BETRIEBSART { BETRIEB_FESTZEIT, BETRIEB_NACHT, BETRIEB_BLINKEN, BETRIEB_VORRANG, BETRIEB_HAND };
+BetriebsartVerwalter betrieb;
+bool tag_geraeumt = false;   // Gelb ist gerade abgelaufen: sicherer Punkt im Festzeitprogramm
+
+// Stromsparender Blinkbetrieb
+#if NACHT_SPARBETRIEB
+#include "Sparbetrieb.h"
+Sparbetrieb sparbetrieb;
+#endif
+
+// Umlaufoptimierung (startet mit dem festen Tagesprogramm)
+#if UMLAUF_OPTIMIERUNG
+#include "Umlauf.h"
+const uint16_t TAGES_PHASEN[4] = {TAGESPLAN[0].dauer, TAGESPLAN[1].dauer, TAGESPLAN[2].dauer, TAGESPLAN[3].dauer};
+UmlaufOptimierer umlauf(TAGES_PHASEN);
+uint32_t umlauf_startzeit = 0;
+#endif
+
+// Gesundheit der vier Ultraschallsensoren
+#if DETEKTOR_UEBERWACHUNG
+#include "Detektoren.h"
+DetektorWaechter detektoren[4] = {
+  DetektorWaechter(DETEKTOR_HINTERGRUND), DetektorWaechter(DETEKTOR_HINTERGRUND),
+  DetektorWaechter(DETEKTOR_HINTERGRUND), DetektorWaechter(DETEKTOR_HINTERGRUND)
+};
+#endif
+
+// Lampentreiber
+#if LAMPEN_NEOPIXEL
+#include "NeoPixelTreiber.h"
+NeoPixelTreiber lampentreiber(NEOPIXEL_PIN, LICHTSENSOR_PIN);
+#elif LAMPEN_IOEXPANDER
+#include "IoTreiber.h"
+#include <IoAbstractionWire.h>
+// Arduino-Pins 0..99, die Expander hängen dahinter (ab Pin 100)
+MultiIoAbstraction lampen_io(100);
+#if IOEXP_MCP23017
+IoTreiber lampentreiber(lampen_io, 100);
+#else
+// Ausgänge des Schieberegisters beginnen bei SHIFT_REGISTER_OUTPUT_CUTOVER
+IoTreiber lampentreiber(lampen_io, 100 + SHIFT_REGISTER_OUTPUT_CUTOVER);
+#endif
+#else
+GpioTreiber lampentreiber(&AMPELN[0][0], &FUSSGAENGER_LICHTER[0][0]);
+#endif
+
+// Einsatzfahrzeug-Vorrang
+#if VORRANG_AKTIV
+#include "Vorrang.h"
+// Freigabeliste: Code, Bitlänge, Zufahrt (0=Nord, 1=Süd, 2=Ost, 3=West)
+const VorrangFreigabe VORRANG_FREIGABEN[] PROGMEM = {
+  {0x5A0F01, 24, 0},
+  {0x5A0F02, 24, 1},
+  {0x5A0F03, 24, 2},
+  {0x5A0F04, 24, 3}
+};
+Vorrang vorrang(VORRANG_FREIGABEN, sizeof(VORRANG_FREIGABEN) / sizeof(VORRANG_FREIGABEN[0]), fussg_phasen);
+#if VORRANG_SIMULATION
+SimEmpfaenger vorrang_empfaenger;
+#else
+RcEmpfaenger vorrang_empfaenger;
+#endif
+#endif
+
+// ÖPNV-Bevorrechtigung
+#if BUSVORRANG_AKTIV
+#include <SPI.h>
+#include <mcp2515.h>
+#include "Busvorrang.h"
+MCP2515 can_controller(CAN_CS_PIN);
+#endif
+
+// Bahnübergang
+#if BAHN_VORRANG
+#include "Bahnuebergang.h"
+Bahnuebergang bahn(BAHN_MELDER_PIN, BAHN_ZUFAHRT, SCHRANKE_STEP_PIN, SCHRANKE_DIR_PIN, SCHRANKE_ENABLE_PIN,
+                   fussg_phasen);
+#endif
+
+// Sensorspur
+#if SENSOR_SPUR
+#include "SensorSpur.h"   // SD.h bzw. mit SPUR_SEKTOREN SdFat.h
+#if SENSOR_SPUR == 1
+SpurSchreiber spur;
+#else
+SpurLeser spur;
+#endif
+#if SPUR_SEKTOREN
+SdFs spur_karte;   // gemeinsamer SPI-Bus (CAN, E-Paper): SHARED_SPI
+#endif
+#endif
+
+// Blackbox: Einträge gehen in den RAM, ins Flash aus der Loop
+#if BLACKBOX_AKTIV
+#include <Adafruit_SPIFlashBase.h>
+#include "Blackbox.h"
+Adafruit_FlashTransport_SPI blackbox_transport(BLACKBOX_CS, SPI);
+Adafruit_SPIFlashBase blackbox_flash(&blackbox_transport);
+Blackbox blackbox;
+Print *blackbox_leser = NULL;   // AT+BBOX läuft, Ausgabe dorthin
+#endif
+
+// Taster an einem Analogpin
+#if TASTER_LEITER
+#if LAMPEN_NEOPIXEL
+#error "TASTER_LEITER belegt den ADC, der Lichtsensor (analogRead) geht dann nicht"
+#endif
+#include "TasterLeiter.h"
+// Taste k schaltet R_k nach GND (10k Pull-up), 8-Bit-ADC-Wert:
+//   0: 0     -> 0     Fußgänger Nord
+//   1: 1k5   -> 33    Fußgänger Süd
+//   2: 3k3   -> 63    Fußgänger Ost
+//   3: 5k6   -> 92    Fußgänger West
+//   4: 10k   -> 128   Modus (Kanal wie SPUR_TASTER_MODUS)
+//   5: 15k   -> 153   frei
+//   6: 27k   -> 187   frei
+//   7: 68k   -> 223   frei
+//   keine    -> 255
+// Schwellen jeweils in der Mitte zwischen zwei Tasten
+const uint8_t LEITER_SCHWELLEN[] PROGMEM = {16, 48, 77, 110, 140, 170, 205, 239};
+TasterLeiter leiter(LEITER_SCHWELLEN, sizeof(LEITER_SCHWELLEN));
+#endif
+
+// Kooperative Fäden und Latenzmessung
+#if KOOP_FAEDEN
+#ifdef __AVR__
+#error "KOOP_FAEDEN braucht lib/Scheduler, das gibt es nur für ARM (Due, Zero)"
+#endif
+#if NACHT_SPARBETRIEB
+#error "NACHT_SPARBETRIEB schläft über avr/sleep.h und passt nicht zu KOOP_FAEDEN"
+#endif
+#include <Scheduler.h>
+uint8_t faden_sensor = 0;
+uint8_t faden_telemetrie = 0;
+uint8_t faden_hmi = 0;
+#endif
+#if KOOP_FAEDEN || LATENZ_MESSUNG
+#include "Faeden.h"
+FadenUhr uhr_taster;       // taster_abholen (HMI)
+FadenUhr uhr_sensor;       // sensoren_messen
+FadenUhr uhr_phase;        // loop()
+FadenUhr uhr_status;       // zeige_status
+#endif
+
+// Signalprogramme (für Statusanzeige)
+enum PLAENE { PLAN_TAG, PLAN_NACHT, PLAN_BLINKEN };
+
+// AT-Konsole: Befehle werden im Eingabepuffer zerlegt, kein String, kein Heap
+#if AT_KONSOLE
+#if VORRANG_SIMULATION
+#error "VORRANG_SIMULATION und AT_KONSOLE lesen beide Serial"
+#endif
+#include <ATCommands.h>
+ATCommands konsole;
+char konsole_puffer[KONSOLE_PUFFER + 1];
+int8_t konsole_ziel = -1;           // AT+FORCE: Zielphase, bis dahin Grün auf Mindestgrün
+bool konsole_halten = false;        // AT+HOLD=1: Tagesphase bleibt stehen
+uint32_t konsole_max_us = 0;        // längster update()-Aufruf
+#endif
+
+// ESP32-Begleiter: Auftrag rein, Bericht raus, beides als feste Struktur
+#if ESP_BEGLEITER
+#include "Begleiter.h"
+BegleiterAuftrag begleiter_auftrag;
+BegleiterLink begleiter(BEGLEITER_PORT, begleiter_auftrag, BEGLEITER_WIEDERHOLEN);
+bool begleiter_antwort_offen = false;   // Fenster war voll, Antwort folgt im nächsten Aufruf
+uint16_t begleiter_antwort = 0;
+uint8_t begleiter_ergebnis = BEGLEITER_OK;
+uint32_t begleiter_letzter_bericht = 0;
+uint32_t begleiter_max_us = 0;          // längster bearbeiten()-Aufruf
+#endif
+
+// Wochenplan in Ortszeit, Feiertage zählen als Sonntag
+#if KALENDER_AKTIV
+#include <RTClib.h>
+#include "Kalender.h"
+enum KalenderAktion : uint8_t { KAL_TAG, KAL_NACHT, KAL_SELBSTTEST, KAL_SPUR_WECHSELN };
+const KalenderEintrag KALENDER_PLAN[] PROGMEM = {
+  // Tage                                  Uhrzeit  Aktion
+  {KALENDER_WERKTAGS,                       5, 30,  KAL_TAG},
+  {KALENDER_WERKTAGS,                      22,  0,  KAL_NACHT},
+  {KALENDER_WOCHENENDE,                     8,  0,  KAL_TAG},
+  {KALENDER_WOCHENENDE,                    23,  0,  KAL_NACHT},
+  {KALENDER_SO | KALENDER_OHNE_FEIERTAG,    3, 15,  KAL_SELBSTTEST},     // nachts, kaum Verkehr
+#if SENSOR_SPUR == 1
+  {KALENDER_MO | KALENDER_OHNE_FEIERTAG,    0,  0,  KAL_SPUR_WECHSELN},  // eine Spurdatei pro Woche
+#endif
+};
+RTC_DS3231 rtc;
+Kalender kalender(KALENDER_PLAN, sizeof(KALENDER_PLAN) / sizeof(KALENDER_PLAN[0]));
+bool kalender_laeuft = false;      // erst mit gültiger RTC
+uint8_t kalender_stumme_sensoren = 0;   // beim letzten Selbsttest ohne Echo
+#endif
+
+#if STATUS_EPAPER
+#include "StatusSchild.h"
+static_assert(schild_kann_teilrefresh<EPD_PANEL>(0), "EPD_PANEL ohne displayPartial: jedes Update ein voller Refresh");
+EPaperSchild<EPD_PANEL> schild(EPD_DC, EPD_RESET, EPD_CS, EPD_SRAM_CS, EPD_BUSY);
+#endif
+
+#if STATUS_LCD
+#include "StatusLcd.h"
+LiquidCrystal_I2C lcd(LCD_ADRESSE, LCD_SPALTEN, LCD_ZEILEN);
+LcdSeite lcd_seite(lcd);
+#endif
 
 // =====================================================
 // INTERRUPT SERVICE ROUTINEN FÜR TASTER
 // =====================================================
-void fussgaenger_taster0_ISR() {
-  static uint32_t letzter_druck = 0;
-  if (millis() - letzter_druck > ENTSPRELLZEIT) {
-    fussg_anforderung[0] = true;
-    Serial.println(F("Fußgängeranforderung: 0"));
-    letzter_druck = millis();
-  }
-}
+void fussgaenger_taster0_ISR() { fussgaenger_taster_ISR(0); }
+void fussgaenger_taster1_ISR() { fussgaenger_taster_ISR(1); }
+void fussgaenger_taster2_ISR() { fussgaenger_taster_ISR(2); }
+void fussgaenger_taster3_ISR() { fussgaenger_taster_ISR(3); }
 
-void fussgaenger_taster1_ISR() {
-  static uint32_t letzter_druck = 0;
-  if (millis() - letzter_druck > ENTSPRELLZEIT) {
-    fussg_anforderung[1] = true;
-    Serial.println(F("Fußgängeranforderung: 1"));
-    letzter_druck = millis();
-  }
+void fussgaenger_taster_ISR(uint8_t taster) {
+#if SENSOR_SPUR == 1
+  spur.taster(taster, LOW);
+#endif
+  uint32_t jetzt = millis();
+  taster_flanken.put(TasterFlanke{taster, LOW, jetzt});
 }
 
-void fussgaenger_taster2_ISR() {
-  static uint32_t letzter_druck = 0;
-  if (millis() - letzter_druck > ENTSPRELLZEIT) {
-    fussg_anforderung[2] = true;
-    Serial.println(F("Fußgängeranforderung: 2"));
-    letzter_druck = millis();
+// Flanken aus den ISRs verteilen (Loop, Warteschleifen, Sparbetrieb)
+void taster_abholen() {
+#if KOOP_FAEDEN || LATENZ_MESSUNG
+  uhr_taster.runde();
+#endif
+  TasterFlanke f;
+  while (taster_flanken.get(f)) {
+#if SENSOR_SPUR == 1 && TASTER_LEITER
+    // Die ADC-ISR kennt die Spur nicht, aufgenommen wird hier
+    noInterrupts();
+    spur.taster(f.taster, f.pegel);
+    interrupts();
+#endif
+    taster_verteilen(f.taster, f.pegel, f.ms);
   }
 }
 
-void fussgaenger_taster3_ISR() {
-  static uint32_t letzter_druck = 0;
-  if (millis() - letzter_druck > ENTSPRELLZEIT) {
-    fussg_anforderung[3] = true;
-    Serial.println(F("Fußgängeranforderung: 3"));
-    letzter_druck = millis();
+// Entprellte Anforderung (aus der Loop oder der Spurwiedergabe)
+void fussgaenger_anfordern(uint8_t taster) {
+  static uint32_t letzter_druck[4] = {0};
+  if (millis() - letzter_druck[taster] > ENTSPRELLZEIT) {
+    fussg_anforderung[taster] = true;
+    Serial.print(F("Fußgängeranforderung: "));
+    Serial.println(taster);
+    letzter_druck[taster] = millis();
   }
 }
 
@@ -147,8 +605,14 @@ void fussgaenger_taster3_ISR() {
 // =====================================================
 void init_taster() {
   /* Initialisiert alle Taster mit Interrupts */
+#if TASTER_LEITER
+  // Alle Taster über den ADC, die Flanken kommen wie aus den ISRs
+  leiter.starten(LEITER_PIN, taster_flanken);
+#else
   pinMode(MODE_BUTTON, INPUT_PULLUP);
+#if SENSOR_SPUR != 2
   attachInterrupt(digitalPinToInterrupt(MODE_BUTTON), modus_taster_ISR, CHANGE);
+#endif
   
   // Initialisiere Fußgängertaster als Input mit Pullup
   pinMode(FUSSGAENGER_TASTER[0], INPUT_PULLUP);
@@ -156,11 +620,15 @@ void init_taster() {
   pinMode(FUSSGAENGER_TASTER[2], INPUT_PULLUP);
   pinMode(FUSSGAENGER_TASTER[3], INPUT_PULLUP);
 
+#if SENSOR_SPUR != 2
   // Weise jedem Taster seine eigene ISR zu
+  // (bei Spurwiedergabe kommen die Flanken aus der Spur)
   attachInterrupt(digitalPinToInterrupt(FUSSGAENGER_TASTER[0]), fussgaenger_taster0_ISR, FALLING);
   attachInterrupt(digitalPinToInterrupt(FUSSGAENGER_TASTER[1]), fussgaenger_taster1_ISR, FALLING);
   attachInterrupt(digitalPinToInterrupt(FUSSGAENGER_TASTER[2]), fussgaenger_taster2_ISR, FALLING);
   attachInterrupt(digitalPinToInterrupt(FUSSGAENGER_TASTER[3]), fussgaenger_taster3_ISR, FALLING);
+#endif
+#endif
 }
 
 // =====================================================
@@ -171,10 +639,76 @@ void setup() {
   Serial.println(F("🚦 Systemstart 🚦"));
   
   // Initialisiere alle Ampeln
+#if LAMPEN_IOEXPANDER
+#if IOEXP_MCP23017
+  Wire.begin();
+  lampen_io.addIoExpander(ioFrom23017(MCP23017_ADRESSE_1), 16);
+  lampen_io.addIoExpander(ioFrom23017(MCP23017_ADRESSE_2), 16);
+#else
+  lampen_io.addIoExpander(outputOnlyFromShiftRegister(SR_TAKT_PIN, SR_DATEN_PIN, SR_LATCH_PIN, SR_ANZAHL),
+                          SHIFT_REGISTER_OUTPUT_CUTOVER + 32);
+#endif
+#endif
+#if BLACKBOX_AKTIV
+  blackbox_starten();   // vor dem ersten Lampenbild
+#endif
+  lampen.starten(lampentreiber);
   ampeln_reseten();
+  lampen.ausgeben();
+  betriebsarten_starten();
   
   // Taster mit Interrupts initialisieren
   init_taster();
+
+#if BUSVORRANG_AKTIV
+  can_controller.reset();
+  can_controller.setBitrate(CAN_250KBPS, MCP_8MHZ);
+  can_controller.setNormalMode();
+#endif
+
+#if VORRANG_AKTIV
+#if !VORRANG_SIMULATION
+  vorrang_empfaenger.starten(VORRANG_EMPFAENGER_PIN);
+#endif
+  vorrang.starten(vorrang_empfaenger);
+#endif
+
+#if BAHN_VORRANG
+  bahn.starten();
+#endif
+
+#if STATUS_EPAPER
+  schild.starten(zeichne_schild, SCHILD_INTERVALL);
+#endif
+
+#if STATUS_LCD
+  lcd_seite.starten();   // die Bibliothek wartet dabei ~1 s auf das LCD
+  if (lcd_seite.fehler()) Serial.println(F("LCD antwortet nicht"));
+#endif
+
+#if SENSOR_SPUR
+  spur_starten();
+#endif
+
+#if NACHT_SPARBETRIEB
+  sparbetrieb.starten(spar_blinken, spar_messen, spar_status, BLINK_INTERVALL, SENSOR_UPDATE);
+#endif
+
+#if AT_KONSOLE
+  konsole_starten();
+#endif
+
+#if ESP_BEGLEITER
+  BEGLEITER_PORT.begin(BEGLEITER_BAUD);
+#endif
+
+#if KALENDER_AKTIV
+  kalender_starten();
+#endif
+
+#if KOOP_FAEDEN
+  faeden_starten();
+#endif
   
   Serial.println(F("System bereit!"));
   Serial.println(F("========================"));
@@ -184,86 +718,132 @@ void setup() {
 // HAUPTSCHLEIFE (WIEDERHOLT SICH ENDLOS)
 // =====================================================
 void loop() {
-  // Hauptsteuerungslogik
+#if KOOP_FAEDEN || LATENZ_MESSUNG
+  uhr_phase.runde();
+#endif
+#if BUSVORRANG_AKTIV
+  bus_empfangen();
+#endif
+
+#if !KOOP_FAEDEN   // sonst im HMI-Faden
+#if SENSOR_SPUR
+  spur.bearbeiten();
+#endif
+  taster_abholen();
+  konsole_bearbeiten();
+  begleiter_bearbeiten();
+  kalender_bearbeiten();
+  blackbox_bearbeiten();
+  lcd_bearbeiten();
+#endif
+
+#if NACHT_SPARBETRIEB
+  // Nur Gelbblinken, nichts zu tun: schlafen statt alle 10ms drehen
+  if (aktueller_modus == NACHT && blinkbetrieb && !fussg_aktiv) {
+    sparbetrieb.laufen(spar_abbruch, BLINK_INTERVALL - min(millis() - letztes_blinken, (uint32_t)BLINK_INTERVALL));
+  }
+#endif
+
+  // Hauptsteuerungslogik (Bahn- und Einsatzfahrzeug-Vorrang sind
+  // Betriebsarten, Fußgänger ruhen währenddessen)
   verwalte_modus();
+  if (betrieb.ist() != BETRIEB_VORRANG) {
+    verarbeite_fussgaenger();
+  }
+
+  // Lampenbild gesammelt ausgeben (nur bei Änderung)
+  lampen.ausgeben();
   
-  // Fußgängeranforderungen bearbeiten
-  verarbeite_fussgaenger();
-  
+#if !KOOP_FAEDEN   // sonst im Telemetrie- bzw. HMI-Faden
   // Debug-Infos
   zeige_status();
+
+#if STATUS_EPAPER
+  // Statusschild (refresht nur bei Modus-/Planwechsel)
+  schild_bearbeiten();
+#endif
+#endif
   
-  // Kleine Pause zur Prozessorentlastung
+  // Kleine Pause zur Prozessorentlastung (mit Fäden: die anderen laufen)
+#if BAHN_VORRANG
+  warten(10);   // die Schranke fährt währenddessen weiter
+#else
   delay(10);
+#endif
 }
 
 // =====================================================
 // MODUS-STEUERUNG
 // =====================================================
+// Gewünschte Betriebsart bestimmen, gewechselt wird erst am
+// sicheren Punkt der laufenden (Betriebsarten.h)
 void verwalte_modus() {
-  switch(aktueller_modus) {
-    case TAG:
-      tagesmodus_logik();
-      break;
-    case NACHT:
-      nachtmodus_logik();
-      break;
+  if (betrieb.takt(betriebsart_soll())) betriebsart_melden();
+  blinkbetrieb = betrieb.ist() == BETRIEB_BLINKEN && !blink_raeumen;
+}
+
+uint8_t betriebsart_soll() {
+  if (bahn_laeuft() || vorrang_laeuft()) return BETRIEB_VORRANG;
+  if (aktueller_modus == TAG) {
+#if AT_KONSOLE
+    if (konsole_halten) return BETRIEB_HAND;
+#endif
+    return BETRIEB_FESTZEIT;
   }
+  sensor_update();
+  return autos_erkannt() ? BETRIEB_NACHT : BETRIEB_BLINKEN;
+}
+
+void betriebsart_melden() {
+  Serial.print(F("Betriebsart: "));
+  Serial.println(betrieb.name(betrieb.ist()));
 }
 
 // -------------------------
 // TAGESMODUS-LOGIK
 // -------------------------
 void tagesmodus_logik() {
-  /* Regelbetrieb mit festem Phasenzyklus:
+  /* Regelbetrieb mit festem Phasenzyklus laut TAGESPLAN:
      1. Nord/Süd Grün (10s)
      2. Nord/Süd Gelb (3s)
      3. Ost/West Grün (10s)
-     4. Ost/West Gelb (3s) */
-  switch(aktuelle_phase) {
-    case 0: // Phase 1: Nord/Süd Grün
-      ampeln_setzen(0, GRUEN);
-      ampeln_setzen(1, GRUEN);
-      ampeln_setzen(2, ROT);
-      ampeln_setzen(3, ROT);
-      phasen_wechsel(TAGES_PHASEN[0]);
-      break;
-    case 1: // Übergangsphase Gelb
-      ampeln_setzen(0, GELB);
-      ampeln_setzen(1, GELB);
-      phasen_wechsel(TAGES_PHASEN[1]);
-      break;
-    case 2: // Phase 3: Ost/West Grün
-      ampeln_setzen(2, GRUEN);
-      ampeln_setzen(3, GRUEN);
-      ampeln_setzen(0, ROT);
-      ampeln_setzen(1, ROT);
-      phasen_wechsel(TAGES_PHASEN[2]);
-      break;
-    case 3: // Übergangsphase Gelb
-      ampeln_setzen(2, GELB);
-      ampeln_setzen(3, GELB);
-      phasen_wechsel(TAGES_PHASEN[3]);
-      break;
+     4. Ost/West Gelb (3s)
+     Mit UMLAUF_OPTIMIERUNG werden die Zufahrten auch
+     tagsüber gezählt und die Grünzeiten nachgeführt. */
+#if UMLAUF_OPTIMIERUNG
+  sensor_update();
+#endif
+  tag_geraeumt = false;
+  tagesbild_setzen();
+  phasen_wechsel(phasen_dauer(aktuelle_phase));
+}
+
+// Ein Tabelleneintrag pro Aufruf, egal wie lang der Plan ist
+void tagesbild_setzen() {
+  uint8_t bild = plan_bild_lesen(TAGESPLAN, aktuelle_phase);
+  for (uint8_t i = 0; i < 4; i++) {
+    ampeln_setzen(i, (LICHTZUSTAND)plan_signal(bild, i));
   }
 }
 
 // -------------------------
 // NACHTMODUS-LOGIK
 // -------------------------
+// Nur mit erkannten Autos, sonst ist Nachtblinken dran
 void nachtmodus_logik() {
-  sensor_update();
-  
-  if (!autos_erkannt()) {
-    blinkmodus_aktivieren();
-    return;
-  }
-  
-  if (millis() - phasen_startzeit > NACHT_GRUEN) {
+  if (millis() - phasen_startzeit > nacht_gruen(aktive_richtung)) {
+    ampeln_setzen(aktive_richtung, ROT);   // Gelb nicht neben dem nächsten Grün stehen lassen
     aktive_richtung = naechste_richtung_finden();
     phasen_startzeit = millis();
   }
-  
+
+  // Kein Auto mehr bzw. Tag angefordert: Grün gleich beenden,
+  // das Gelb läuft voll, danach ist der sichere Punkt
+  uint16_t gelb_ab = nacht_gruen(aktive_richtung) - NACHT_GELB;
+  if (betrieb.soll() != BETRIEB_NACHT && millis() - phasen_startzeit < gelb_ab) {
+    phasen_startzeit = millis() - gelb_ab;
+  }
+
   verarbeite_nachtzyklus(aktive_richtung);
 }
 
@@ -275,28 +855,104 @@ void nachtmodus_logik() {
 // AMPELSTEUERUNG
 // -------------------------
 void ampeln_setzen(uint8_t kreuzung, LICHTZUSTAND zustand) {
-  digitalWrite(AMPELN[kreuzung][ROT], zustand == ROT ? HIGH : LOW);
-  digitalWrite(AMPELN[kreuzung][GELB], zustand == GELB ? HIGH : LOW);
-  digitalWrite(AMPELN[kreuzung][GRUEN], zustand == GRUEN ? HIGH : LOW);
+  lampen.setzen(lampe_ampel(kreuzung, ROT), zustand == ROT);
+  lampen.setzen(lampe_ampel(kreuzung, GELB), zustand == GELB);
+  lampen.setzen(lampe_ampel(kreuzung, GRUEN), zustand == GRUEN);
+}
+
+void fussg_setzen(uint8_t richtung, LICHTZUSTAND zustand) {
+  lampen.setzen(lampe_fussg(richtung, false), zustand == ROT);
+  lampen.setzen(lampe_fussg(richtung, true), zustand == GRUEN);
+  if (zustand == GRUEN) fussg_phasen |= 1 << richtung;
+  else fussg_phasen &= ~(1 << richtung);
 }
 
 void ampeln_reseten() {
   for(uint8_t i=0; i<4; i++) {
     ampeln_setzen(i, ROT);
-    digitalWrite(FUSSGAENGER_LICHTER[i][ROT], HIGH);
-    digitalWrite(FUSSGAENGER_LICHTER[i][GRUEN], LOW);
+    fussg_setzen(i, ROT);
+  }
+}
+
+// Wartet blockierend, bricht aber bei Zug oder Einsatzfahrzeug ab
+bool warten(uint32_t dauer) {
+  uint32_t start = millis();
+  while (millis() - start < dauer) {
+#if KOOP_FAEDEN
+    yield();   // Taster, Spur und Sensoren laufen in ihren Fäden
+#else
+#if SENSOR_SPUR
+    spur.bearbeiten();
+#endif
+    taster_abholen();
+    konsole_bearbeiten();
+    begleiter_bearbeiten();
+    kalender_bearbeiten();
+    blackbox_bearbeiten();
+    lcd_bearbeiten();
+#endif
+#if BAHN_VORRANG
+    bahn.bewegen();
+    if (bahn.aktiv()) return false;
+#endif
+#if VORRANG_AKTIV
+    vorrang_empfangen();
+    if (vorrang.aktiv()) return false;
+#endif
   }
+  return true;
 }
 
 // -------------------------
 // PHASENVERWALTUNG
 // -------------------------
+// Dauer der laufenden Tagesphase (ggf. mit Busbevorrechtigung)
+uint16_t phasen_dauer(uint8_t phase) {
+#if BUSVORRANG_AKTIV
+  // phase ^ 2: Grünphase der anderen Achse
+  return busvorrang.phasendauer(phase, plan_dauer(phase), plan_dauer((phase + 1) % TAGESPLAN_PHASEN),
+                                plan_dauer(phase ^ 2), millis() - phasen_startzeit);
+#else
+  return plan_dauer(phase);
+#endif
+}
+
+// Dauer laut Signalplan: fest oder vom Optimierer
+uint16_t plan_dauer(uint8_t phase) {
+#if UMLAUF_OPTIMIERUNG
+  return umlauf.dauer(phase);
+#else
+  return plan_dauer_lesen(TAGESPLAN, phase);
+#endif
+}
+
 void phasen_wechsel(uint16_t dauer) {
+#if AT_KONSOLE
+  // Auf dem Weg zur erzwungenen Phase Grün kürzen, Gelb läuft voll
+  if (konsole_ziel >= 0 && aktuelle_phase != konsole_ziel && aktuelle_phase % 2 == 0) {
+    dauer = min(dauer, (uint16_t)KONSOLE_MINDESTGRUEN);
+  }
+#endif
   if(millis() - phasen_startzeit >= dauer) {
-    aktuelle_phase = (aktuelle_phase + 1) % 4;
+#if BUSVORRANG_AKTIV
+    busvorrang.phase_beendet(aktuelle_phase);
+#endif
+    // Ende einer Phase ohne Grün (Gelb): alles Rot, hier darf gewechselt werden
+    tag_geraeumt = !plan_gruen(plan_bild_lesen(TAGESPLAN, aktuelle_phase));
+    aktuelle_phase = (aktuelle_phase + 1) % TAGESPLAN_PHASEN;
+#if AT_KONSOLE
+    if (aktuelle_phase == konsole_ziel) konsole_ziel = -1;
+#endif
     phasen_startzeit = millis();
     Serial.print(F("Neue Phase: "));
     Serial.println(aktuelle_phase);
+#if UMLAUF_OPTIMIERUNG
+    if (aktuelle_phase == 0) {
+      // Plan für den nächsten Umlauf
+      umlauf.umlauf_beendet(millis() - umlauf_startzeit);
+      umlauf_startzeit = millis();
+    }
+#endif
   }
 }
 
@@ -325,36 +981,136 @@ void verarbeite_fussgaenger() {
 void fussgaenger_phase_starten(uint8_t richtung) {
   // Vorbereitung
   ampeln_setzen(richtung, GELB);
-  delay(2000);
+  lampen.ausgeben();
+  if (!warten(2000)) return;
   ampeln_setzen(richtung, ROT);
   
   // Grünphase
-  digitalWrite(FUSSGAENGER_LICHTER[richtung][ROT], LOW);
-  digitalWrite(FUSSGAENGER_LICHTER[richtung][GRUEN], HIGH);
-  delay(FUSSG_GEHZEIT);
+  fussg_setzen(richtung, GRUEN);
+  lampen.ausgeben();
+  bool weiter = warten(FUSSG_GEHZEIT);
   
   // Warnblinken
-  for(uint8_t i=0; i<5; i++) {
-    digitalWrite(FUSSGAENGER_LICHTER[richtung][GRUEN], !digitalRead(FUSSGAENGER_LICHTER[richtung][GRUEN]));
-    delay(FUSSG_BLINKZEIT);
+  uint8_t gruen = lampe_fussg(richtung, true);
+  for(uint8_t i=0; weiter && i<5; i++) {
+    lampen.setzen(gruen, !lampen.lesen(gruen));
+    lampen.ausgeben();
+    weiter = warten(FUSSG_BLINKZEIT);
   }
   
-  // Zurücksetzen
-  digitalWrite(FUSSGAENGER_LICHTER[richtung][GRUEN], LOW);
-  digitalWrite(FUSSGAENGER_LICHTER[richtung][ROT], HIGH);
+  // Zurücksetzen (nach Abbruch durch Vorrang/Bahn haben die
+  // Fußgänger dort schon Rot, dann ist nur die Furt wieder frei)
+  fussg_setzen(richtung, ROT);
 }
 
 // -------------------------
 // NACHTMODUS-FUNKTIONEN
 // -------------------------
 void sensor_update() {
+#if !KOOP_FAEDEN   // sonst misst der Sensor-Faden
   if(millis() - letzte_sensor_aktualisierung > SENSOR_UPDATE) {
-    for(uint8_t i=0; i<4; i++) {
-      auto_erkannt[i] = (SONAR[i].ping_cm() > 0 && SONAR[i].ping_cm() < SENSOR_AKTIV_DISTANZ);
-    }
-    letzte_sensor_aktualisierung = millis();
+    sensoren_messen();
+  }
+#endif
+}
+
+// Ein Sweep über alle vier Zufahrten
+void sensoren_messen() {
+#if KOOP_FAEDEN || LATENZ_MESSUNG
+  uhr_sensor.runde();
+#endif
+  for(uint8_t i=0; i<4; i++) {
+    // Einmal pingen und merken (ein Ping dauert bis ~20ms)
+    sensor_cm[i] = sensor_messen(i);
+#if UMLAUF_OPTIMIERUNG
+    // Jedes neu auftauchende Fahrzeug zählen
+    bool vorher = auto_erkannt[i];
+#endif
+    auto_erkannt[i] = (sensor_cm[i] > 0 && sensor_cm[i] < SENSOR_AKTIV_DISTANZ);
+#if DETEKTOR_UEBERWACHUNG
+    detektor_bewerten(i);
+#endif
+#if UMLAUF_OPTIMIERUNG
+    if (auto_erkannt[i] && !vorher) umlauf.fahrzeug(i);
+#endif
+#if KOOP_FAEDEN
+    // Zwischen den Pings abgeben, Vorrang und Bahn laufen in der Loop
+    yield();
+#else
+    // Zwischen den Pings auf Einsatzfahrzeuge hören (Latenz < 100ms)
+    vorrang_empfangen();
+    bahn_bewegen();
+#endif
+  }
+  letzte_sensor_aktualisierung = millis();
+
+  SensorBild bild;
+  bild.erkannt = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    bild.cm[i] = sensor_cm[i];
+    if (auto_erkannt[i]) bild.erkannt |= 1 << i;
+  }
+  bild.zeit_ms = letzte_sensor_aktualisierung;
+  sensor_bild.write(bild);
+#if BLACKBOX_AKTIV
+  blackbox.erkannt(bild.erkannt);
+#endif
+}
+
+// Ein Ping in cm, bei Sensorspur aufgenommen bzw. aus der Spur
+uint16_t sensor_messen(uint8_t zufahrt) {
+#if SENSOR_SPUR == 2
+  uint16_t echo_us = spur.echo(zufahrt, SENSOR_MAX_CM * US_ROUNDTRIP_CM);
+#else
+  uint16_t echo_us = SONAR[zufahrt].ping();
+#if SENSOR_SPUR == 1
+  spur.echo(zufahrt, echo_us);
+#endif
+#endif
+  return NewPing::convert_cm(echo_us);
+}
+
+// Nachtgrün pro Zufahrt, gestörte Detektoren nur gedeckelt
+uint16_t nacht_gruen(uint8_t richtung) {
+#if DETEKTOR_UEBERWACHUNG
+  if (detektoren[richtung].gestoert()) return DETEKTOR_RECALL_GRUEN;
+#else
+  (void)richtung;
+#endif
+  return NACHT_GRUEN;
+}
+
+#if DETEKTOR_UEBERWACHUNG
+// Rohwert bewerten, gestört heißt Daueranforderung (die Zufahrt
+// kommt in jedem Nachtumlauf dran statt nie bzw. immer voll)
+void detektor_bewerten(uint8_t zufahrt) {
+  DetektorWaechter &d = detektoren[zufahrt];
+  if (d.messung(sensor_cm[zufahrt], auto_erkannt[zufahrt])) detektor_melden(zufahrt);
+  if (d.gestoert()) auto_erkannt[zufahrt] = true;
+}
+
+void detektor_melden(uint8_t zufahrt) {
+  const DetektorWaechter &d = detektoren[zufahrt];
+  Serial.print(F("Detektor Zufahrt "));
+  Serial.print(zufahrt);
+  if (!d.gestoert()) {
+    Serial.println(F(" wieder in Ordnung"));
+    return;
   }
+  Serial.print(F(" gestört:"));
+  detektor_grund_ausgeben(d.grund());
+  Serial.print(F(" (kein Echo "));
+  Serial.print(d.kein_echo_prozent());
+  Serial.println(F("%), Daueranforderung"));
+}
+
+void detektor_grund_ausgeben(uint8_t grund) {
+  if (grund & DETEKTOR_KEIN_ECHO) Serial.print(F(" kein Echo"));
+  if (grund & DETEKTOR_KLEBT) Serial.print(F(" klebt"));
+  if (grund & DETEKTOR_FLATTERT) Serial.print(F(" flattert"));
+  if (grund & DETEKTOR_SPRINGT) Serial.print(F(" springt"));
 }
+#endif
 
 bool autos_erkannt() {
   for(uint8_t i=0; i<4; i++) {
@@ -377,69 +1133,1227 @@ uint8_t naechste_richtung_finden() {
 }
 
 void blinkmodus_aktivieren() {
-  static bool blinkzustand = false;
-  static uint32_t letztes_blinken = 0;
-  
-  if(millis() - letztes_blinken > BLINK_INTERVALL) {
-    blinkzustand = !blinkzustand;
-    for(uint8_t i=0; i<4; i++) {
-      digitalWrite(AMPELN[i][GELB], blinkzustand);
+  // Abgabe angefordert: nicht aus dem Gelb gleich ins Grün,
+  // erst Alles-Rot (blinken_sicher)
+  if (betrieb.soll() != BETRIEB_BLINKEN) {
+    if (!blink_raeumen) {
+      ampeln_reseten();
+      blink_raeumen = true;
+      blink_raeumen_seit = millis();
     }
-    letztes_blinken = millis();
+    return;
   }
+  blink_raeumen = false;
+  if(millis() - letztes_blinken > BLINK_INTERVALL) {
+    blinken_umschalten();
+  }
+}
+
+void blinken_umschalten() {
+  blinkzustand = !blinkzustand;
+  for(uint8_t i=0; i<4; i++) {
+    lampen.setzen(lampe_ampel(i, GELB), blinkzustand);
+  }
+  letztes_blinken = millis();
 }
 
 void verarbeite_nachtzyklus(uint8_t richtung) {
   uint32_t vergangene_zeit = millis() - phasen_startzeit;
+  uint32_t gruen = nacht_gruen(richtung);
   
-  if(vergangene_zeit < NACHT_GRUEN - NACHT_GELB) {
+  if(vergangene_zeit < gruen - NACHT_GELB) {
     ampeln_setzen(richtung, GRUEN);
-  } else if(vergangene_zeit < NACHT_GRUEN) {
+  } else if(vergangene_zeit < gruen) {
     ampeln_setzen(richtung, GELB);
   } else {
     ampeln_setzen(richtung, ROT);
   }
 }
 
+// -------------------------
+// BETRIEBSARTEN
+// -------------------------
+// Festzeit: Übernahme mit allen Zufahrten auf Rot, die Phase
+// läuft weiter bzw. beginnt neu (nach Vorrang: Querachse)
+void festzeit_beginnen() {
+  ampeln_reseten();
+  phasen_startzeit = millis();
+  tag_geraeumt = false;
+}
+
+bool festzeit_sicher() {
+  return tag_geraeumt;
+}
+
+// Nacht: gleich die erste Zufahrt mit Auto bedienen
+void nacht_beginnen() {
+  ampeln_reseten();
+  phasen_startzeit = millis() - nacht_gruen(aktive_richtung) - 1;
+}
+
+// Erst wenn die bediente Zufahrt wieder Rot hat
+bool nacht_sicher() {
+  return millis() - phasen_startzeit >= nacht_gruen(aktive_richtung);
+}
+
+bool blinken_sicher() {
+  return blink_raeumen && millis() - blink_raeumen_seit >= BLINK_RAEUMZEIT;
+}
+
+// Vorrang und Bahn schalten die Lampen selbst
+void vorrang_takt() {
+}
+
+// Hand (AT+HOLD=1): das Grün der laufenden Phase bleibt stehen.
+// Wird etwas anderes verlangt (auch AT+HOLD=0), laufen Grün und
+// Gelb voll wie in Festzeit, abgegeben wird nach dem Gelb
+void hand_takt() {
+  if (betrieb.soll() != BETRIEB_HAND) {
+    tagesmodus_logik();
+    return;
+  }
+  tag_geraeumt = false;
+  tagesbild_setzen();
+  phasen_startzeit = millis();
+}
+
+const Betriebsart BETRIEBSARTEN[] = {
+  //  Name        beginnen           takt                   sicher           Vorrang
+  {"Festzeit", festzeit_beginnen, tagesmodus_logik,      festzeit_sicher, false},
+  {"Nacht",    nacht_beginnen,    nachtmodus_logik,      nacht_sicher,    false},
+  {"Blinken",  ampeln_reseten,    blinkmodus_aktivieren, blinken_sicher,  false},
+  {"Vorrang",  NULL,              vorrang_takt,          NULL,            true},
+  {"Hand",     NULL,              hand_takt,             festzeit_sicher, false},
+};
+
+void betriebsarten_starten() {
+  betrieb.starten(BETRIEBSARTEN, aktueller_modus == TAG ? BETRIEB_FESTZEIT : BETRIEB_BLINKEN);
+}
+
+// -------------------------
+// SPARBETRIEB (NACHT-BLINKEN)
+// -------------------------
+#if NACHT_SPARBETRIEB
+void spar_blinken() {
+  blinken_umschalten();
+  lampen.ausgeben();
+}
+
+bool spar_messen() {
+  sensoren_messen();
+  return autos_erkannt();
+}
+
+void spar_status() {
+  zeige_status();
+}
+
+// Zurück in die Loop bei Fahrzeug, Tastendruck, Moduswechsel, Vorrang
+bool spar_abbruch() {
+#if SENSOR_SPUR
+  spur.bearbeiten();
+#endif
+  taster_abholen();
+  konsole_bearbeiten();
+  begleiter_bearbeiten();
+  kalender_bearbeiten();
+  blackbox_bearbeiten();
+  lcd_bearbeiten();
+  if (aktueller_modus != NACHT || autos_erkannt()) return true;
+  for (uint8_t i = 0; i < 4; i++) {
+    if (fussg_anforderung[i]) return true;
+  }
+#if BAHN_VORRANG
+  bahn.bewegen();
+  if (bahn.aktiv()) return true;
+#endif
+#if VORRANG_AKTIV
+  vorrang_empfangen();
+  if (vorrang.aktiv()) return true;
+#endif
+  return false;
+}
+#endif
+
+// -------------------------
+// ÖPNV-BEVORRECHTIGUNG
+// -------------------------
+#if BUSVORRANG_AKTIV
+void bus_empfangen() {
+  // Begrenztes Budget pro Loop, damit ein voller Bus nicht blockiert
+  struct can_frame frame;
+  for (uint8_t i = 0; i < CAN_FRAMES_PRO_LOOP; i++) {
+    if (can_controller.readMessage(&frame) != MCP2515::ERROR_OK) break;
+    if (frame.can_id & CAN_EFF_FLAG) {
+      busvorrang_verteilen(frame.can_id & CAN_EFF_MASK, frame.can_dlc, frame.data);
+    }
+  }
+}
+#endif
+
+// -------------------------
+// EINSATZFAHRZEUG-VORRANG
+// -------------------------
+void vorrang_empfangen() {
+#if VORRANG_AKTIV
+#if VORRANG_SIMULATION
+  // Software-Ersatz für den Funkempfänger: "V<code>" + Enter
+  static uint32_t code = 0;
+  static bool lese_code = false;
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == 'V') {
+      lese_code = true;
+      code = 0;
+    } else if (lese_code && c >= '0' && c <= '9') {
+      code = code * 10 + (c - '0');
+    } else if (lese_code && (c == '\n' || c == '\r')) {
+      vorrang_empfaenger.einspeisen(code);
+      lese_code = false;
+    }
+  }
+#endif
+  if (vorrang.pruefen()) {
+    Serial.print(F("Vorrang angefordert: "));
+    Serial.println(vorrang.richtung());
+  }
+#endif
+}
+
+bool vorrang_laeuft() {
+#if VORRANG_AKTIV
+  static bool lief = false;
+
+  vorrang_empfangen();
+  if (vorrang.bearbeiten()) {
+    lief = true;
+    return true;
+  }
+  if (lief) {
+    // Normalbetrieb mit der Querachse neu beginnen
+    lief = false;
+    aktuelle_phase = vorrang.richtung() < 2 ? 2 : 0;
+    phasen_startzeit = millis();
+    Serial.println(F("Vorrang beendet"));
+  }
+#endif
+  return false;
+}
+
+// -------------------------
+// BAHNÜBERGANG
+// -------------------------
+void bahn_bewegen() {
+#if BAHN_VORRANG
+  bahn.bewegen();
+#endif
+}
+
+bool bahn_laeuft() {
+#if BAHN_VORRANG
+  static bool lief = false;
+
+  bahn.bewegen();
+  if (bahn.bearbeiten()) {
+    if (!lief) {
+      Serial.print(F("Bahnvorrang: Zug gemeldet, Latenz "));
+      Serial.print(bahn.latenz_us());
+      Serial.println(F("us"));
+    }
+    lief = true;
+    return true;
+  }
+  if (lief) {
+    // Normalbetrieb mit der Gleisachse neu beginnen
+    lief = false;
+    aktuelle_phase = bahn.zufahrt() < 2 ? 0 : 2;
+    phasen_startzeit = millis();
+    Serial.print(F("Bahnvorrang beendet: Latenz "));
+    Serial.print(bahn.latenz_us());
+    Serial.print(F("us, Schranke zu "));
+    Serial.print(bahn.schranke_zu_ms());
+    Serial.print(F("ms, auf "));
+    Serial.print(bahn.schranke_auf_ms());
+    Serial.print(F("ms, Sperre "));
+    Serial.print(bahn.sperre_ms());
+    Serial.println(F("ms"));
+  }
+#endif
+  return false;
+}
+
+// -------------------------
+// SENSORSPUR
+// -------------------------
+#if SENSOR_SPUR
+void spur_starten() {
+#if SPUR_SEKTOREN
+  if (!spur_karte.begin(SdSpiConfig(SPUR_SD_CS, SHARED_SPI, SD_SCK_MHZ(8)))) {
+#else
+  if (!SD.begin(SPUR_SD_CS)) {
+#endif
+    Serial.println(F("Sensorspur: keine SD-Karte"));
+    return;
+  }
+#if SENSOR_SPUR == 1 && SPUR_SEKTOREN
+  bool ok = spur.starten(spur_karte, SPUR_DATEI, SPUR_SEKTOR_MB * 1048576UL);
+#elif SENSOR_SPUR == 1
+  SD.remove(SPUR_DATEI);
+  bool ok = spur.starten(SD.open(SPUR_DATEI, FILE_WRITE));
+#elif SPUR_SEKTOREN
+  bool ok = spur.starten(spur_karte, SPUR_DATEI, taster_ereignis);
+#else
+  bool ok = spur.starten(SD.open(SPUR_DATEI), taster_ereignis);
+#endif
+  Serial.print(F("Sensorspur "));
+  Serial.print(SENSOR_SPUR == 1 ? F("Aufnahme") : F("Wiedergabe"));
+  Serial.println(ok ? F(" läuft") : F(": Datei fehlt/ungültig"));
+}
+#endif
+
+// -------------------------
+// BLACKBOX
+// -------------------------
+// Pro Aufruf höchstens ein Flash-Kommando, und nur wenn das
+// Flash frei ist; AT+BBOX gibt ein paar Zeilen pro Aufruf aus
+void blackbox_bearbeiten() {
+#if BLACKBOX_AKTIV
+  if (blackbox_leser && blackbox.lesbar()) {
+    BlackboxEintrag e;
+    for (uint8_t i = 0; i < BLACKBOX_ZEILEN_PRO_TICK && blackbox_leser; i++) {
+      if (blackbox.naechster(e)) {
+        blackbox_zeile(*blackbox_leser, e);
+      } else {
+        blackbox_leser->println(F("+BBOX:ENDE"));
+        blackbox_leser = NULL;
+      }
+    }
+  }
+  blackbox.bearbeiten();
+#endif
+}
+
+#if BLACKBOX_AKTIV
+void blackbox_starten() {
+  if (!blackbox_flash.begin() || !blackbox.starten(blackbox_flash, BLACKBOX_START, BLACKBOX_BYTES)) {
+    Serial.println(F("Blackbox: kein SPI-Flash"));
+    return;
+  }
+  lampen.beobachten(blackbox_lampen);
+}
+
+void blackbox_lampen(LampenBild bild) {
+  blackbox.lampen(bild);
+}
+
+// +BBOX:<ms>,S|N,<Bild hex>,<Fahrzeug-Bits>   Anfang bzw. Neustart (millis() ab 0)
+// +BBOX:<ms>,L,<Bild hex>                      Lampenbild
+// +BBOX:<ms>,E,<Fahrzeug-Bits>                 Erkennung
+// +BBOX:<ms>,T,<Taster>,<Pegel>                Tasterflanke
+void blackbox_zeile(Print &aus, const BlackboxEintrag &e) {
+  aus.print(F("+BBOX:"));
+  aus.print(e.zeit_ms);
+  switch (e.art) {
+    case BB_ANFANG:
+      aus.print(e.neustart ? F(",N,") : F(",S,"));
+      blackbox_bild(aus, e.bild);
+      aus.print(',');
+      aus.println(e.erkannt);
+      break;
+    case BB_LAMPEN:
+      aus.print(F(",L,"));
+      blackbox_bild(aus, e.bild);
+      aus.println();
+      break;
+    case BB_ERKANNT:
+      aus.print(F(",E,"));
+      aus.println(e.erkannt);
+      break;
+    default:
+      aus.print(F(",T,"));
+      aus.print(e.taster);
+      aus.print(',');
+      aus.println(e.pegel);
+  }
+}
+
+// Bild als Hex, höchste Lampe links (print kann kein 64 Bit)
+void blackbox_bild(Print &aus, LampenBild bild) {
+  for (int8_t b = BLACKBOX_LAMPENBYTES - 1; b >= 0; b--) {
+    uint8_t byte = bild >> (8 * b);
+    if (byte < 0x10) aus.print('0');
+    aus.print(byte, HEX);
+  }
+}
+#endif
+
+// -------------------------
+// STATUS-LCD
+// -------------------------
+// Die Seite wird alle LCD_SEITE_MS nur im RAM neu gezeichnet,
+// aufs LCD gehen pro Aufruf höchstens LCD_ZEICHEN_PRO_TICK
+// Änderungen (StatusLcd.h)
+void lcd_bearbeiten() {
+#if STATUS_LCD
+  static uint32_t gezeichnet = 0;
+  static uint32_t aufgefrischt = 0;
+  if (millis() - gezeichnet >= LCD_SEITE_MS) {
+    gezeichnet = millis();
+    lcd_zeichnen();
+  }
+  if (millis() - aufgefrischt >= LCD_AUFFRISCHEN_MS) {
+    aufgefrischt = millis();
+    lcd_seite.auffrischen();
+  }
+  lcd_seite.bearbeiten(LCD_ZEICHEN_PRO_TICK);
+#endif
+}
+
+#if STATUS_LCD
+// TAG   Festzeit  P  3    Modus, Betriebsart (">" = Wechsel wartet), Phase
+// N####|123*S##    45     Zufahrt, Abstand als Balken (# voll, | Glyphe 1..4)
+// O     --- W#|   201     und in cm, * = erkannt
+// Fg -S--      0:12:34    Fußgängeranforderungen, Laufzeit
+void lcd_zeichnen() {
+  static const char ZUFAHRTEN[] = "NSOW";
+  SensorBild bild = sensor_bild.read();
+  lcd_seite.leeren();
+  lcd_seite.print(aktueller_modus == TAG ? F("TAG") : F("NACHT"));
+  lcd_seite.setzen(6, 0);
+  lcd_seite.print(betrieb.name(betrieb.ist()));
+  if (betrieb.soll() != betrieb.ist()) lcd_seite.print('>');
+  lcd_seite.setzen(16, 0);
+  lcd_seite.print('P');
+  lcd_seite.zahl(aktuelle_phase, 3);
+  for (uint8_t i = 0; i < 4; i++) {
+    uint8_t spalte = i % 2 * 10;
+    uint8_t zeile = 1 + i / 2;
+    lcd_seite.setzen(spalte, zeile);
+    lcd_seite.print(ZUFAHRTEN[i]);
+    lcd_seite.balken(spalte + 1, zeile, 5, bild.cm[i], SENSOR_MAX_CM);
+    if (bild.cm[i]) {
+      lcd_seite.zahl(bild.cm[i], 3);
+    } else {
+      lcd_seite.print(F("---"));   // kein Echo
+    }
+    if (bild.erkannt & (1 << i)) lcd_seite.print('*');
+  }
+  lcd_seite.setzen(0, 3);
+  lcd_seite.print(F("Fg "));
+  for (uint8_t i = 0; i < 4; i++) lcd_seite.print(fussg_anforderung[i] ? ZUFAHRTEN[i] : '-');
+  uint32_t s = millis() / 1000;
+  lcd_seite.setzen(11, 3);
+  lcd_seite.zahl(s / 3600, 3);
+  lcd_seite.print(':');
+  lcd_seite.zahl(s / 60 % 60, 2, '0');
+  lcd_seite.print(':');
+  lcd_seite.zahl(s % 60, 2, '0');
+}
+#endif
+
+#if SENSOR_SPUR == 2
+// Tasterflanke aus der Spur wie von der Hardware
+void taster_ereignis(uint8_t taster, uint8_t pegel) {
+  taster_verteilen(taster, pegel, millis());
+}
+#endif
+
+// Eine Tasterflanke an Modus- bzw. Fußgängerlogik
+void taster_verteilen(uint8_t taster, uint8_t pegel, uint32_t ms) {
+#if BLACKBOX_AKTIV
+  blackbox.taster(taster, pegel);
+#endif
+  if (taster == SPUR_TASTER_MODUS) modus_taster(pegel == LOW, ms);
+  else if (taster < 4 && pegel == LOW) fussgaenger_anfordern(taster);
+}
+
+#if SENSOR_SPUR == 2
+bool spur_beendet() {
+  return spur.beendet();
+}
+#endif
+
 // -------------------------
 // MODUS-TASTER ISR
 // -------------------------
 void modus_taster_ISR() {
+  uint8_t pegel = digitalRead(MODE_BUTTON);
+#if SENSOR_SPUR == 1
+  spur.taster(SPUR_TASTER_MODUS, pegel);
+#endif
+  uint32_t jetzt = millis();
+  taster_flanken.put(TasterFlanke{SPUR_TASTER_MODUS, pegel, jetzt});
+}
+
+// Gedrückt merken, beim Loslassen nach 3s den Modus wechseln
+// (ms: Zeit der Flanke, nicht der Verarbeitung)
+void modus_taster(bool gedrueckt, uint32_t ms) {
   static uint32_t gedrueckt_zeit = 0;
   
-  if(digitalRead(MODE_BUTTON) == LOW) {
-    gedrueckt_zeit = millis();
+  if(gedrueckt) {
+    gedrueckt_zeit = ms;
   } else {
-    if(millis() - gedrueckt_zeit > 3000) {
-      aktueller_modus = (aktueller_modus == TAG) ? NACHT : TAG;
-      Serial.print(F("Modus gewechselt auf: "));
-      Serial.println(aktueller_modus == TAG ? "TAG" : "NACHT");
-      ampeln_reseten();
-      phasen_startzeit = millis();
+    if(ms - gedrueckt_zeit > 3000) {
+      modus_setzen(aktueller_modus == TAG ? NACHT : TAG);
+    }
+  }
+}
+
+// Moduswechsel vom Taster oder von AT+PLAN
+void modus_setzen(MODI modus) {
+  aktueller_modus = modus;
+  Serial.print(F("Modus gewechselt auf: "));
+  Serial.println(aktueller_modus == TAG ? "TAG" : "NACHT");
+#if AT_KONSOLE
+  konsole_ziel = -1;
+#endif
+}
+
+// -------------------------
+// AT-KONSOLE
+// -------------------------
+// Budgetiert: höchstens KONSOLE_BYTES_PRO_TICK Bytes pro Aufruf
+void konsole_bearbeiten() {
+#if AT_KONSOLE
+  uint32_t start = micros();
+  konsole.update(KONSOLE_BYTES_PRO_TICK);
+  uint32_t dauer = micros() - start;
+  if (dauer > konsole_max_us) konsole_max_us = dauer;
+#endif
+}
+
+#if AT_KONSOLE
+// Ganze Zahl 0..grenze, sonst false (kein atoi: "x" wäre 0)
+bool konsole_zahl(const char *text, uint8_t grenze, uint8_t &wert) {
+  uint16_t zahl = 0;
+  if (!*text) return false;
+  for (; *text; text++) {
+    if (*text < '0' || *text > '9') return false;
+    zahl = zahl * 10 + (*text - '0');
+    if (zahl > grenze) return false;
+  }
+  wert = zahl;
+  return true;
+}
+
+// AT+PHASE?  ->  +PHASE:<modus>,<phase>,<plan>,<ms in der Phase>,<gehalten>,<ziel>
+bool at_phase_lesen(ATCommands *at) {
+  at->serial->print(F("+PHASE:"));
+  at->serial->print((uint8_t)aktueller_modus);
+  at->serial->print(',');
+  at->serial->print(aktuelle_phase);
+  at->serial->print(',');
+  at->serial->print(aktueller_plan());
+  at->serial->print(',');
+  at->serial->print(millis() - phasen_startzeit);
+  at->serial->print(',');
+  at->serial->print(konsole_halten);
+  at->serial->print(',');
+  at->serial->println(konsole_ziel);
+  return true;
+}
+
+bool at_phase_test(ATCommands *at) {
+  at->serial->println(F("+PHASE:<modus 0=TAG 1=NACHT>,<phase 0-3>,<plan>,<ms>,<gehalten>,<ziel -1=keins>"));
+  return true;
+}
+
+// AT+DET?  ->  +DET:<cm Nord>,<Süd>,<Ost>,<West>,<Fahrzeug-Bits>,<Fußgänger-Bits>,<Alter ms>
+bool at_det_lesen(ATCommands *at) {
+  SensorBild bild = sensor_bild.read();
+  uint8_t anforderungen = 0;
+  at->serial->print(F("+DET:"));
+  for (uint8_t i = 0; i < 4; i++) {
+    at->serial->print(bild.cm[i]);
+    at->serial->print(',');
+    if (fussg_anforderung[i]) anforderungen |= 1 << i;
+  }
+  at->serial->print(bild.erkannt);
+  at->serial->print(',');
+  at->serial->print(anforderungen);
+  at->serial->print(',');
+  at->serial->println(millis() - bild.zeit_ms);
+  return true;
+}
+
+// AT+PLAN?  ->  +PLAN:<0=TAG 1=NACHT 2=BLINKEN>
+bool at_plan_lesen(ATCommands *at) {
+  at->serial->print(F("+PLAN:"));
+  at->serial->println(aktueller_plan());
+  return true;
+}
+
+// AT+PLAN=<0|1>: Tages- bzw. Nachtprogramm (Blinken ergibt sich nachts ohne Verkehr)
+bool at_plan_schreiben(ATCommands *at) {
+  uint8_t plan;
+  if (!konsole_zahl(at->next(), PLAN_NACHT, plan)) return false;
+  MODI modus = plan == PLAN_TAG ? TAG : NACHT;
+  if (modus != aktueller_modus) modus_setzen(modus);
+  return true;
+}
+
+bool at_plan_test(ATCommands *at) {
+  at->serial->println(F("+PLAN:(0=TAG,1=NACHT)"));
+  return true;
+}
+
+// AT+FORCE=<0|2>: nächste Grünphase Nord/Süd bzw. Ost/West, nur tagsüber
+bool at_force_schreiben(ATCommands *at) {
+  uint8_t phase;
+  if (aktueller_modus != TAG || !konsole_zahl(at->next(), 3, phase) || phase % 2) return false;
+  konsole_ziel = phase == aktuelle_phase ? -1 : phase;
+  return true;
+}
+
+bool at_force_test(ATCommands *at) {
+  at->serial->println(F("+FORCE:(0=Nord/Süd,2=Ost/West) Grün bis dahin auf Mindestgrün"));
+  return true;
+}
+
+// AT+HOLD=<0|1>: Handbetrieb (hält das nächste Grün nach dem Gelb) bzw. weiter
+bool at_hold_schreiben(ATCommands *at) {
+  uint8_t halten;
+  if (!konsole_zahl(at->next(), 1, halten)) return false;
+  konsole_halten = halten;
+  return true;
+}
+
+bool at_hold_lesen(ATCommands *at) {
+  at->serial->print(F("+HOLD:"));
+  at->serial->println(konsole_halten);
+  return true;
+}
+
+// AT+STATS?  ->  eine Zeile +STATS:<name>,<wert> pro Zähler
+void konsole_zaehler(ATCommands *at, const char *name, uint32_t wert) {
+  at->serial->print(F("+STATS:"));
+  at->serial->print(name);
+  at->serial->print(',');
+  at->serial->println(wert);
+}
+
+bool at_stats_lesen(ATCommands *at) {
+  konsole_zaehler(at, "laufzeit_ms", millis());
+  konsole_zaehler(at, "konsole_max_us", konsole_max_us);
+  konsole_zaehler(at, "tasterflanken_verloren", taster_flanken.dropped());
+  konsole_zaehler(at, "sensor_sweeps", sensor_bild.version());
+  konsole_zaehler(at, "betriebsart_wechsel", betrieb.wechsel());
+  konsole_zaehler(at, "betriebsart_warten_max_ms", betrieb.warten_max_ms());
+#if KOOP_FAEDEN || LATENZ_MESSUNG
+  konsole_zaehler(at, "taster_abstand_max_us", uhr_taster.max_us());
+  konsole_zaehler(at, "phase_abstand_max_us", uhr_phase.max_us());
+#endif
+#if UMLAUF_OPTIMIERUNG
+  konsole_zaehler(at, "umlauf_rechenzeit_max_us", umlauf.rechenzeit_max_us());
+#endif
+#if VORRANG_AKTIV
+  konsole_zaehler(at, "vorrang_latenz_max_us", vorrang.latenz_max_us());
+#endif
+#if BAHN_VORRANG
+  konsole_zaehler(at, "zuege", bahn.zuege());
+#endif
+#if SENSOR_SPUR == 1 && SPUR_SEKTOREN
+  konsole_zaehler(at, "spur_schreiben_max_us", spur.datei().max_us());
+  konsole_zaehler(at, "spur_karte_belegt", spur.datei().aufgeschoben());
+#endif
+#if BLACKBOX_AKTIV
+  konsole_zaehler(at, "blackbox_verloren", blackbox.verloren());
+  konsole_zaehler(at, "blackbox_fehler", blackbox.fehler());
+  konsole_zaehler(at, "blackbox_max_us", blackbox.max_us());
+  konsole_zaehler(at, "blackbox_loeschungen", blackbox.loeschungen());
+#endif
+#if STATUS_LCD
+  konsole_zaehler(at, "lcd_zeichen", lcd_seite.zeichen());
+  konsole_zaehler(at, "lcd_max_us", lcd_seite.max_us());
+  konsole_zaehler(at, "lcd_fehler", lcd_seite.fehler());
+#endif
+#if TASTER_LEITER
+  konsole_zaehler(at, "leiter_latenz_max_us", leiter.latenz_max_us());
+  konsole_zaehler(at, "leiter_verloren", leiter.verloren());
+#endif
+#if LAMPEN_NEOPIXEL
+  konsole_zaehler(at, "show_max_us", lampentreiber.show_max_us());
+#endif
+#if LAMPEN_IOEXPANDER
+  konsole_zaehler(at, "sync_max_us", lampentreiber.sync_max_us());
+#endif
+#if ESP_BEGLEITER
+  konsole_zaehler(at, "begleiter_gesendet", begleiter.stats().sent);
+  konsole_zaehler(at, "begleiter_wiederholt", begleiter.stats().retransmitted);
+  konsole_zaehler(at, "begleiter_empfangen", begleiter.stats().received);
+  konsole_zaehler(at, "begleiter_crc_fehler", begleiter.stats().crcErrors);
+  konsole_zaehler(at, "begleiter_max_us", begleiter_max_us);
+#endif
+#if DETEKTOR_UEBERWACHUNG
+  {
+    uint8_t gestoert = 0;
+    uint16_t stoerungen = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+      if (detektoren[i].gestoert()) gestoert |= 1 << i;
+      stoerungen += detektoren[i].stoerungen();
+    }
+    konsole_zaehler(at, "detektoren_gestoert", gestoert);
+    konsole_zaehler(at, "detektor_stoerungen", stoerungen);
+  }
+#endif
+#if KALENDER_AKTIV
+  konsole_zaehler(at, "kalender_weckrufe", kalender.weckrufe());
+  konsole_zaehler(at, "kalender_ausgeloest", kalender.ausgeloest());
+  konsole_zaehler(at, "kalender_stumme_sensoren", kalender_stumme_sensoren);
+#endif
+  konsole_max_us = 0;
+  return true;
+}
+
+#if BLACKBOX_AKTIV
+// AT+BBOX  ->  alle Einträge, ältester zuerst, über mehrere Loops
+// (blackbox_bearbeiten), Format siehe blackbox_zeile
+bool at_bbox(ATCommands *at) {
+  blackbox.lesen_starten();
+  blackbox_leser = at->serial;
+  return true;
+}
+#endif
+
+#if KALENDER_AKTIV
+// AT+UHR?  ->  +UHR:<UTC Sekunden seit 1970>,<nächster Termin UTC, 0 = Kalender steht>
+bool at_uhr_lesen(ATCommands *at) {
+  at->serial->print(F("+UHR:"));
+  at->serial->print(kalender_uhr());
+  at->serial->print(',');
+  at->serial->println(kalender_laeuft ? kalender.naechster() : 0);
+  return true;
+}
+
+// AT+UHR=<UTC Sekunden seit 1970>, z.B. von "date +%s": RTC stellen
+bool at_uhr_schreiben(ATCommands *at) {
+  const char *text = at->next();
+  uint32_t sekunden = 0;
+  if (!*text) return false;
+  for (; *text; text++) {
+    if (*text < '0' || *text > '9' || sekunden > 429496728UL) return false;
+    sekunden = sekunden * 10 + (*text - '0');
+  }
+  rtc.adjust(DateTime(sekunden));
+  kalender_uhr_gestellt();
+  return true;
+}
+#endif
+
+const at_command_t KONSOLE_BEFEHLE[] = {
+  // Name      RUN   TEST            READ            WRITE
+  {"+PHASE", NULL, at_phase_test,  at_phase_lesen, NULL},
+  {"+DET",   NULL, NULL,           at_det_lesen,   NULL},
+  {"+PLAN",  NULL, at_plan_test,   at_plan_lesen,  at_plan_schreiben},
+  {"+FORCE", NULL, at_force_test,  NULL,           at_force_schreiben},
+  {"+HOLD",  NULL, NULL,           at_hold_lesen,  at_hold_schreiben},
+  {"+STATS", NULL, NULL,           at_stats_lesen, NULL},
+#if KALENDER_AKTIV
+  {"+UHR",   NULL, NULL,           at_uhr_lesen,   at_uhr_schreiben},
+#endif
+#if BLACKBOX_AKTIV
+  {"+BBOX",  at_bbox, NULL,           NULL,           NULL},
+#endif
+};
+
+void konsole_starten() {
+  konsole.begin(&KONSOLE_PORT, KONSOLE_BEFEHLE, sizeof(KONSOLE_BEFEHLE), konsole_puffer, sizeof(konsole_puffer));
+}
+#endif
+
+// -------------------------
+// ESP32-BEGLEITER
+// -------------------------
+// Wartet nie: liest höchstens BEGLEITER_BYTES_PRO_TICK Bytes,
+// ein Auftrag wird im selben Aufruf ausgeführt und beantwortet
+void begleiter_bearbeiten() {
+#if ESP_BEGLEITER
+  uint32_t start = micros();
+  if (begleiter.update(BEGLEITER_BYTES_PRO_TICK)) {
+    begleiter_ergebnis = begleiter_ausfuehren(begleiter_auftrag);
+    begleiter_antwort = begleiter_auftrag.nummer;
+    begleiter_antwort_offen = true;
+  }
+  if (begleiter_antwort_offen) {
+    if (begleiter_berichten(begleiter_antwort, begleiter_ergebnis)) begleiter_antwort_offen = false;
+  } else if (millis() - begleiter_letzter_bericht >= BEGLEITER_INTERVALL) {
+    begleiter_berichten(0, BEGLEITER_OK);
+  }
+  uint32_t dauer = micros() - start;
+  if (dauer > begleiter_max_us) begleiter_max_us = dauer;
+#endif
+}
+
+#if ESP_BEGLEITER
+// Dieselben Wege wie Taster und AT-Konsole
+uint8_t begleiter_ausfuehren(const BegleiterAuftrag &auftrag) {
+  switch (auftrag.art) {
+    case AUFTRAG_BERICHT:
+      return BEGLEITER_OK;
+    case AUFTRAG_PLAN: {
+      if (auftrag.wert > PLAN_NACHT) return BEGLEITER_ABGELEHNT;
+      MODI modus = auftrag.wert == PLAN_TAG ? TAG : NACHT;
+      if (modus != aktueller_modus) modus_setzen(modus);
+      return BEGLEITER_OK;
+    }
+    case AUFTRAG_FUSSGAENGER:
+      if (auftrag.wert > 3) return BEGLEITER_ABGELEHNT;
+      fussgaenger_anfordern(auftrag.wert);
+      return BEGLEITER_OK;
+  }
+  return BEGLEITER_UNBEKANNT;
+}
+
+// false, wenn das Fenster voll ist (ESP32 quittiert nicht)
+bool begleiter_berichten(uint16_t antwort_auf, uint8_t ergebnis) {
+  if (!begleiter.canSend()) return false;
+  SensorBild bild = sensor_bild.read();
+  BegleiterBericht bericht;
+  bericht.antwort_auf = antwort_auf;
+  bericht.ergebnis = ergebnis;
+  bericht.modus = aktueller_modus;
+  bericht.phase = aktuelle_phase;
+  bericht.plan = aktueller_plan();
+  bericht.erkannt = bild.erkannt;
+  bericht.anforderungen = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    bericht.cm[i] = bild.cm[i];
+    if (fussg_anforderung[i]) bericht.anforderungen |= 1 << i;
+  }
+  bericht.zeit_ms = millis();
+  bericht.phase_ms = millis() - phasen_startzeit;
+  bericht.sensor_sweeps = sensor_bild.version();
+  begleiter.send(bericht);
+  begleiter_letzter_bericht = millis();
+  return true;
+}
+#endif
+
+// -------------------------
+// KALENDER
+// -------------------------
+// TaskManagerIO trägt hier nur das Kalender-Ereignis: pro Aufruf
+// ein Zeitvergleich, die RTC wird nur beim Aufwachen gelesen
+void kalender_bearbeiten() {
+#if KALENDER_AKTIV
+  taskManager.runLoop();
+#endif
+}
+
+#if KALENDER_AKTIV
+void kalender_starten() {
+  if (!rtc.begin()) {
+    Serial.println(F("Kalender: keine RTC gefunden"));
+    return;
+  }
+  if (rtc.lostPower()) {
+    // Batterie leer: die DS3231 steht auf 2000, lieber kein Plan als ein falscher
+    Serial.println(F("Kalender: RTC hatte keinen Strom, erst stellen (AT+UHR=)"));
+    return;
+  }
+  kalender.starten(kalender_uhr, kalender_aktion);
+  kalender_laeuft = true;
+}
+
+uint32_t kalender_uhr() {
+  return rtc.now().unixtime();
+}
+
+// Nach AT+UHR=: neu anpeilen bzw. jetzt erst starten
+void kalender_uhr_gestellt() {
+  if (kalender_laeuft) {
+    kalender.uhr_gestellt();
+  } else {
+    kalender.starten(kalender_uhr, kalender_aktion);
+    kalender_laeuft = true;
+  }
+}
+
+// Nachgeholt wird nur der Plan, Selbsttest und Spurwechsel
+// erst wieder zum nächsten Termin
+void kalender_aktion(uint8_t aktion, bool nachgeholt) {
+  if (nachgeholt && aktion >= KAL_SELBSTTEST) return;
+  Serial.print(nachgeholt ? F("Kalender (nachgeholt): ") : F("Kalender: "));
+  switch (aktion) {
+    case KAL_TAG:
+    case KAL_NACHT: {
+      Serial.println(aktion == KAL_TAG ? F("Tagesprogramm") : F("Nachtprogramm"));
+      MODI modus = aktion == KAL_TAG ? TAG : NACHT;
+      if (modus != aktueller_modus) modus_setzen(modus);
+      break;
     }
+    case KAL_SELBSTTEST:
+      Serial.println(F("Selbsttest Detektoren"));
+      detektoren_pruefen();
+      break;
+#if SENSOR_SPUR == 1
+    case KAL_SPUR_WECHSELN:
+      Serial.println(F("neue Spurdatei"));
+      spur_wechseln();
+      break;
+#endif
+  }
+}
+
+// Ein Sweep: ohne Fahrzeug misst jeder Sensor die Gegenseite
+// der Fahrbahn, kein Echo heißt Sensor, Kabel oder Montage prüfen
+void detektoren_pruefen() {
+  sensoren_messen();
+  kalender_stumme_sensoren = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    if (sensor_cm[i]) continue;
+    kalender_stumme_sensoren |= 1 << i;
+    Serial.print(F("Selbsttest: Zufahrt "));
+    Serial.print(i);
+    Serial.println(F(" ohne Echo"));
+  }
+  if (!kalender_stumme_sensoren) Serial.println(F("Selbsttest: alle Zufahrten mit Echo"));
+}
+
+#if SENSOR_SPUR == 1
+// SPjjmmtt.BIN mit dem Datum des Wechsels (Ortszeit)
+void spur_wechseln() {
+  int16_t jahr;
+  uint8_t monat, tag;
+  Kalender::datum(Kalender::ortszeit(kalender_uhr()) / KALENDER_TAG_S, jahr, monat, tag);
+  char name[13];
+  snprintf(name, sizeof(name), "SP%02d%02d%02d.BIN", jahr % 100, monat, tag);
+#if SPUR_SEKTOREN
+  bool ok = spur.wechseln(spur_karte, name, SPUR_SEKTOR_MB * 1048576UL);
+#else
+  SD.remove(name);
+  bool ok = spur.wechseln(SD.open(name, FILE_WRITE));
+#endif
+  Serial.print(F("Sensorspur: weiter in "));
+  Serial.print(name);
+  Serial.println(ok ? F("") : F(" - Datei nicht angelegt"));
+}
+#endif
+#endif
+
+// -------------------------
+// KOOPERATIVE FÄDEN
+// -------------------------
+#if KOOP_FAEDEN
+// loop() bleibt der Phasen-Faden (Modus, Phasen, Fußgänger, Vorrang)
+void faeden_starten() {
+  faden_sensor = Scheduler.startLoop(sensor_faden, FADEN_STACK_SENSOR);
+  faden_telemetrie = Scheduler.startLoop(telemetrie_faden, FADEN_STACK_TELEMETRIE);
+  faden_hmi = Scheduler.startLoop(hmi_faden, FADEN_STACK_HMI);
+  if (!faden_sensor || !faden_telemetrie || !faden_hmi) {
+    Serial.println(F("Fäden: zu wenig Speicher für die Stacks"));
   }
 }
 
+// Sweep, Pause, Sweep - tagsüber nur für die Umlaufoptimierung
+void sensor_faden() {
+  while (aktueller_modus != NACHT && !UMLAUF_OPTIMIERUNG) yield();
+  sensoren_messen();
+  delay(SENSOR_UPDATE);
+}
+
+void telemetrie_faden() {
+  zeige_status();
+  delay(100);
+}
+
+// Taster, Spurwiedergabe und Statusschild
+void hmi_faden() {
+#if SENSOR_SPUR
+  spur.bearbeiten();
+#endif
+  taster_abholen();
+  konsole_bearbeiten();
+  begleiter_bearbeiten();
+  kalender_bearbeiten();
+  blackbox_bearbeiten();
+  lcd_bearbeiten();
+#if STATUS_EPAPER
+  schild_bearbeiten();
+#endif
+  yield();
+}
+
+void faden_stack_ausgeben(uint8_t faden) {
+  uint32_t groesse = Scheduler.stackSize(faden);
+  Serial.print(groesse - Scheduler.stackUnused(faden));
+  Serial.print(F("/"));
+  Serial.print(groesse);
+}
+#endif
+
+#if KOOP_FAEDEN || LATENZ_MESSUNG
+void faden_uhr_ausgeben(FadenUhr &uhr) {
+  Serial.print(uhr.mittel_us());
+  Serial.print(F("/"));
+  Serial.print(uhr.max_us());
+  uhr.zuruecksetzen();
+}
+#endif
+
 // -------------------------
 // DEBUGGING & STATUS
 // -------------------------
+uint8_t aktueller_plan() {
+  if (aktueller_modus == TAG) return PLAN_TAG;
+  return blinkbetrieb ? PLAN_BLINKEN : PLAN_NACHT;
+}
+
 void zeige_status() {
   static uint32_t letztes_update = 0;
+#if KOOP_FAEDEN || LATENZ_MESSUNG
+  uhr_status.runde();
+#endif
+
+#if STATUS_EPAPER
+  // Im Blinkbetrieb übernimmt das Schild - kein Sensor-Ping, keine Ausgabe
+  if (aktueller_plan() == PLAN_BLINKEN) return;
+#endif
   
   if(millis() - letztes_update > 1000) {
     Serial.println(F("\n=== Systemstatus ==="));
     Serial.print(F("Modus: "));
     Serial.println(aktueller_modus == TAG ? "TAG" : "NACHT");
+    Serial.print(F("Betriebsart: "));
+    Serial.print(betrieb.name(betrieb.ist()));
+    if (betrieb.soll() != betrieb.ist()) {
+      Serial.print(F(" -> "));
+      Serial.print(betrieb.name(betrieb.soll()));
+      Serial.print(F(" am sicheren Punkt"));
+    }
+    Serial.println();
     Serial.print(F("Aktive Phase: "));
     Serial.println(aktuelle_phase);
+#if LAMPEN_NEOPIXEL
+    Serial.print(F("Lampen-Helligkeit: "));
+    Serial.print(lampentreiber.helligkeit());
+    Serial.print(F("  show(): "));
+    Serial.print(lampentreiber.show_dauer_us());
+    Serial.print(F("us (max "));
+    Serial.print(lampentreiber.show_max_us());
+    Serial.println(F("us)"));
+#endif
+#if LAMPEN_IOEXPANDER
+    Serial.print(F("Lampen-Sync: "));
+    Serial.print(lampentreiber.sync_dauer_us());
+    Serial.print(F("us (max "));
+    Serial.print(lampentreiber.sync_max_us());
+    Serial.print(F("us, Fehler: "));
+    Serial.print(lampentreiber.fehler());
+    Serial.println(F(")"));
+#endif
+#if UMLAUF_OPTIMIERUNG
+    Serial.print(F("Umlauf: "));
+    Serial.print(umlauf.umlauf());
+    Serial.print(F("ms (Ziel "));
+    Serial.print(umlauf.ziel_umlauf());
+    Serial.print(F("ms, Y="));
+    Serial.print(umlauf.auslastung());
+    Serial.print(F("‰, Grün "));
+    Serial.print(umlauf.dauer(0));
+    Serial.print(F("/"));
+    Serial.print(umlauf.dauer(2));
+    Serial.print(F("ms, Rechenzeit max "));
+    Serial.print(umlauf.rechenzeit_max_us());
+    Serial.println(F("us)"));
+#endif
+#if NACHT_SPARBETRIEB
+    Serial.print(F("Sparbetrieb: Schlaf "));
+    Serial.print(sparbetrieb.schlaf_promille());
+    Serial.print(F("‰, Sweep alle "));
+    Serial.print(sparbetrieb.sensor_intervall());
+    Serial.println(F("ms"));
+#endif
+#if BAHN_VORRANG
+    Serial.print(F("Bahnvorrang: "));
+    Serial.print(bahn.zuege());
+    Serial.print(F(" Züge, Schranke "));
+    Serial.print(bahn.schranke_unten() ? F("unten") : F("oben/fährt"));
+    Serial.print(F(", letzte Latenz "));
+    Serial.print(bahn.latenz_us());
+    Serial.println(F("us"));
+#endif
+#if VORRANG_AKTIV
+    Serial.print(F("Vorrang-Latenz: "));
+    Serial.print(vorrang.latenz_letzte_us());
+    Serial.print(F("us (max "));
+    Serial.print(vorrang.latenz_max_us());
+    Serial.print(F("us, >100ms: "));
+    Serial.print(vorrang.ueberschreitungen());
+    Serial.print(F(", abgelehnt: "));
+    Serial.print(vorrang.abgelehnt());
+    Serial.println(F(")"));
+#endif
+#if TASTER_LEITER
+    Serial.print(F("Tastenleiter: "));
+    Serial.print(leiter.abtastungen());
+    Serial.print(F(" Abtastungen, Ø "));
+    Serial.print(leiter.abtast_ns());
+    Serial.print(F("ns/Abtastung, Latenz "));
+    Serial.print(leiter.latenz_letzte_us());
+    Serial.print(F("us (max "));
+    Serial.print(leiter.latenz_max_us());
+    Serial.print(F("us, verloren: "));
+    Serial.print(leiter.verloren());
+    Serial.println(F(")"));
+#endif
+#if KOOP_FAEDEN || LATENZ_MESSUNG
+    // Abstand zwischen zwei Durchläufen, Ø/max im letzten Intervall
+    Serial.print(F("Durchlauf-Abstand (us Ø/max): Taster "));
+    faden_uhr_ausgeben(uhr_taster);
+    Serial.print(F(", Sensor "));
+    faden_uhr_ausgeben(uhr_sensor);
+    Serial.print(F(", Phase "));
+    faden_uhr_ausgeben(uhr_phase);
+    Serial.print(F(", Status "));
+    faden_uhr_ausgeben(uhr_status);
+    Serial.println();
+#endif
+#if KOOP_FAEDEN
+    {
+      static uint32_t wechsel_vorher = 0;
+      static uint32_t zeit_vorher = 0;
+      uint32_t wechsel = Scheduler.switches();
+      Serial.print(F("Stack genutzt: Sensor "));
+      faden_stack_ausgeben(faden_sensor);
+      Serial.print(F(", Telemetrie "));
+      faden_stack_ausgeben(faden_telemetrie);
+      Serial.print(F(", HMI "));
+      faden_stack_ausgeben(faden_hmi);
+      Serial.print(F(", Wechsel/s "));
+      Serial.println((wechsel - wechsel_vorher) * 1000UL / max(millis() - zeit_vorher, 1UL));
+      wechsel_vorher = wechsel;
+      zeit_vorher = millis();
+    }
+#endif
+#if ESP_BEGLEITER
+    Serial.print(F("Begleiter: "));
+    Serial.print(begleiter.stats().sent);
+    Serial.print(F(" gesendet, "));
+    Serial.print(begleiter.stats().retransmitted);
+    Serial.print(F(" wiederholt, "));
+    Serial.print(begleiter.stats().received);
+    Serial.print(F(" empfangen, CRC-Fehler "));
+    Serial.print(begleiter.stats().crcErrors);
+    Serial.print(F(", unterwegs "));
+    Serial.print(begleiter.pending());
+    Serial.print(F(", Sitzungen "));
+    Serial.print(begleiter.stats().sessions);
+    Serial.print(F(" (max "));
+    Serial.print(begleiter_max_us);
+    Serial.println(F("us)"));
+    begleiter_max_us = 0;
+#endif
+#if DETEKTOR_UEBERWACHUNG
+    Serial.print(F("Detektoren:"));
+    for (uint8_t i = 0; i < 4; i++) {
+      Serial.print(F(" "));
+      Serial.print(i);
+      if (detektoren[i].gestoert()) detektor_grund_ausgeben(detektoren[i].grund());
+      else Serial.print(F(" ok"));
+      if (i < 3) Serial.print(F(","));
+    }
+    Serial.println();
+#endif
+#if KALENDER_AKTIV
+    if (kalender_laeuft) {
+      uint32_t termin = Kalender::ortszeit(kalender.naechster()) % KALENDER_TAG_S;
+      Serial.print(F("Kalender: nächster Termin "));
+      Serial.print(termin / 3600);
+      Serial.print(termin % 3600 < 600 ? F(":0") : F(":"));
+      Serial.print(termin % 3600 / 60);
+      Serial.print(F(", "));
+      Serial.print(kalender.ausgeloest());
+      Serial.print(F(" ausgelöst, "));
+      Serial.print(kalender.weckrufe());
+      Serial.println(F(" Weckrufe"));
+    }
+#endif
+#if SENSOR_SPUR == 1
+    Serial.print(F("Sensorspur: "));
+    Serial.print(spur.eintraege());
+    Serial.print(F(" Einträge, verloren: "));
+    Serial.println(spur.verloren());
+#if SPUR_SEKTOREN
+    Serial.print(F("Spursektoren: "));
+    Serial.print(spur.datei().sektoren());
+    Serial.print(F(", Schreiben max "));
+    Serial.print(spur.datei().max_us());
+    Serial.print(F("us, Karte belegt "));
+    Serial.print(spur.datei().aufgeschoben());
+    Serial.print(F("x, verloren "));
+    Serial.print(spur.datei().verloren());
+    Serial.println(spur.datei().voll() ? F(" Byte, Datei voll") : F(" Byte"));
+#endif
+#endif
+#if BLACKBOX_AKTIV
+    Serial.print(F("Blackbox: "));
+    Serial.print(blackbox.eintraege());
+    Serial.print(F(" Einträge, "));
+    Serial.print(blackbox.bytes());
+    Serial.print(F(" Byte, "));
+    Serial.print(blackbox.loeschungen());
+    Serial.print(F(" Sektoren gelöscht, max "));
+    Serial.print(blackbox.max_us());
+    Serial.print(F("us, verloren: "));
+    Serial.print(blackbox.verloren());
+    Serial.print(F(", Flash-Fehler: "));
+    Serial.println(blackbox.fehler());
+#endif
+#if STATUS_LCD
+    Serial.print(F("LCD: "));
+    Serial.print(lcd_seite.zeichen());
+    Serial.print(F(" Zeichen, "));
+    Serial.print(lcd_seite.setcursor());
+    Serial.print(F(" setCursor, max "));
+    Serial.print(lcd_seite.max_us());
+    Serial.print(F("us pro Aufruf, Fehler: "));
+    Serial.println(lcd_seite.fehler());
+#endif
+    if (taster_flanken.dropped()) {
+      Serial.print(F("Tasterflanken verloren: "));
+      Serial.println(taster_flanken.dropped());
+    }
     Serial.println(F("Sensorwerte:"));
+    SensorBild bild = sensor_bild.read();
     for(uint8_t i=0; i<4; i++) {
       Serial.print(i);
       Serial.print(F(": "));
-      Serial.print(SONAR[i].ping_cm());
+      Serial.print(bild.cm[i]);
       Serial.print(F("cm "));
-      Serial.println(auto_erkannt[i] ? "🟢" : "🔴");
+      Serial.println(bild.erkannt & (1 << i) ? "🟢" : "🔴");
     }
     letztes_update = millis();
   }
 }
+
+#if STATUS_EPAPER
+// Ein Refresh blockiert die Loop 0,5-2 s: nicht solange Bahn oder
+// Einsatzfahrzeug Vorrang haben, sonst bleiben Funkcodes liegen
+// und die Schranke steht. Das Schild zieht danach nach.
+void schild_bearbeiten() {
+  schild.melden(aktueller_modus, aktueller_plan());
+  if (betrieb.ist() == BETRIEB_VORRANG) return;
+#if BAHN_VORRANG
+  if (bahn.aktiv()) return;
+#endif
+#if VORRANG_AKTIV
+  if (vorrang.aktiv()) return;
+#endif
+  schild.bearbeiten();
+}
+
+void zeichne_schild(Adafruit_GFX &gfx, uint8_t modus, uint8_t plan) {
+  gfx.setTextColor(EPD_BLACK);
+  gfx.setTextSize(3);
+  gfx.setCursor(8, 8);
+  gfx.print(modus == TAG ? F("TAG") : F("NACHT"));
+  gfx.setTextSize(2);
+  gfx.setCursor(8, 56);
+  switch (plan) {
+    case PLAN_TAG:     gfx.print(F("Festzeitprogramm")); break;
+    case PLAN_NACHT:   gfx.print(F("Anforderung")); break;
+    case PLAN_BLINKEN: gfx.print(F("Gelb blinkt")); break;
+  }
+}
+#endif
@@ -0,0 +1,278 @@
+/* =====================================================
+   BAHNÜBERGANG-VORRANG MIT SCHRANKE (lib/AccelStepper)
+   =====================================================
+
+   Hinter einer Zufahrt (BAHN_ZUFAHRT) liegt ein Bahnübergang.
+   Meldet der Einschaltkontakt einen Zug, läuft:
+
+     1. Fußgänger sofort Rot, alle Zufahrten außer der
+        Gleiszufahrt die Grün zeigen -> Gelb, ein schon
+        laufendes Gelb läuft nur zu Ende (Raeumung.h)
+     2. Alles-Rot-Räumzeit
+        (entfällt wenn die Gleiszufahrt schon Grün hat und
+        nur ihre Gegenrichtung geräumt werden musste)
+     3. Gleise freifahren: nur die Gleiszufahrt Grün, damit
+        Fahrzeuge, die auf den Gleisen stehen, abfließen
+     4. Gleiszufahrt Gelb, dann Alles-Rot
+     5. Sperre: die Achse über die Gleise bleibt Rot, die
+        Querachse bekommt Grün, solange der Zug da ist
+     6. Zug weg (Kontakt BAHN_NACHLAUF frei) -> Schranke auf
+     7. Schranke oben: Querachse Gelb, Alles-Rot -> Normalbetrieb
+
+   Die Schranke fährt ab der Meldung parallel zu den Phasen
+   herunter. Der Schrittmotor läuft nur über run() aus
+   bewegen(): pro Aufruf höchstens ein Schritt, kein
+   runToPosition(). bewegen() muss deshalb oft aufgerufen
+   werden (Loop, Warteschleifen, zwischen den Pings).
+   Beim Einschalten muss die Schranke oben stehen (Position 0).
+
+   Pro Ereignis gemessen:
+     - Latenz: Meldung bis Ausgabe des ersten Räumbilds (µs)
+     - Fahrzeit der Schranke zu und auf (ms)
+     - Dauer der Sperre: Meldung bis Normalbetrieb (ms)
+
+   Header-only, wird nur eingebunden wenn BAHN_VORRANG=1.
+   ===================================================== */
+
+#ifndef BAHNUEBERGANG_H
+#define BAHNUEBERGANG_H
+
+#include <Arduino.h>
+#include <AccelStepper.h>
+#include "LampenAusgabe.h"
+#include "Raeumung.h"
+
+#define BAHN_GELBZEIT        3000    // Gelb (ms)
+#define BAHN_RAEUMZEIT       2000    // Alles-Rot (ms)
+#define BAHN_GLEISRAEUMEN    8000    // Grün zum Freifahren der Gleise (ms)
+#define BAHN_NACHLAUF        3000    // Kontakt so lange frei -> Zug weg (ms)
+#define SCHRANKE_ZU          800     // Schritte von oben bis unten
+#define SCHRANKE_TEMPO       400     // Schritte/s
+#define SCHRANKE_BESCHL      300     // Schritte/s²
+
+class Bahnuebergang {
+public:
+  // fussg_phasen: Bit pro Richtung, solange die Fußgänger dort
+  // Grün haben oder noch räumen (Warnblinken)
+  Bahnuebergang(uint8_t melder_pin, uint8_t zufahrt, uint8_t step_pin, uint8_t dir_pin, uint8_t enable_pin,
+                const uint8_t &fussg_phasen)
+    : _schranke(AccelStepper::DRIVER, step_pin, dir_pin), _melder(melder_pin), _zufahrt(zufahrt),
+      _enable(enable_pin), _fussg_phasen(fussg_phasen) {}
+
+  void starten() {
+    pinMode(_melder, INPUT_PULLUP);
+    _schranke.setEnablePin(_enable);
+    _schranke.setPinsInverted(false, false, true);   // Treiber-Enable ist Low-aktiv
+    _schranke.setMaxSpeed(SCHRANKE_TEMPO);
+    _schranke.setAcceleration(SCHRANKE_BESCHL);
+    _schranke.setCurrentPosition(0);
+    _schranke.enableOutputs();    // setzt die Pins als Ausgänge
+    _schranke.disableOutputs();
+  }
+
+  /* Fragt den Kontakt ab und macht ggf. einen Motorschritt.
+     Billig genug für jede Loop und für Warteschleifen. */
+  void bewegen();
+
+  /* Treibt die Lampen solange der Vorrang läuft.
+     Gibt false zurück sobald der Normalbetrieb wieder dran ist. */
+  bool bearbeiten();
+
+  bool aktiv() const { return _zustand != AUS; }
+  uint8_t zufahrt() const { return _zufahrt; }
+  bool schranke_unten() { return _schranke.currentPosition() == SCHRANKE_ZU; }
+
+  // Messwerte des letzten Ereignisses
+  uint32_t latenz_us() const { return _latenz; }
+  uint16_t schranke_zu_ms() const { return _fahrt_zu; }
+  uint16_t schranke_auf_ms() const { return _fahrt_auf; }
+  uint32_t sperre_ms() const { return _sperre; }
+  uint16_t zuege() const { return _zuege; }
+
+private:
+  enum Zustand { AUS, GELB, RAEUMEN, GLEIS_FREI, GLEIS_GELB, GLEIS_ROT, SPERRE,
+                 AUSLAUF_GELB, AUSLAUF_ROT };
+
+  void einleiten();
+  void wechseln(Zustand neu);
+  void bild_setzen();
+  void schranke_fahren(long ziel);
+
+  AccelStepper _schranke;
+  uint8_t _melder;
+  uint8_t _zufahrt;
+  uint8_t _enable;
+  const uint8_t &_fussg_phasen;
+
+  Zustand _zustand = AUS;
+  Raeumung _raeumung;             // Gelbbild vor dem Grün der Gleiszufahrt
+  bool _gleis_weiter = false;     // Gleiszufahrt bleibt im Gelb-Bild Grün
+  uint32_t _zustand_seit = 0;
+  bool _zug = false;
+  uint32_t _zug_zuletzt = 0;      // letzte Meldung des Kontakts (ms)
+  uint32_t _meldung_ms = 0;
+
+  bool _messen = false;
+  uint32_t _meldung_us = 0;
+  uint32_t _latenz = 0;
+  bool _faehrt = false;
+  uint32_t _fahrt_start = 0;
+  uint16_t _fahrt_zu = 0;
+  uint16_t _fahrt_auf = 0;
+  uint32_t _sperre = 0;
+  uint16_t _zuege = 0;
+};
+
+// =====================================================
+// IMPLEMENTIERUNG
+// =====================================================
+inline void Bahnuebergang::bewegen() {
+  if (digitalRead(_melder) == LOW) {
+    _zug_zuletzt = millis();
+    if (!_zug) {
+      _zug = true;
+      if (_zustand == AUS || _zustand == AUSLAUF_GELB || _zustand == AUSLAUF_ROT) {
+        // Neuer Zug (auch während des Auslaufs): von vorn
+        _meldung_us = micros();
+        _meldung_ms = millis();
+        _messen = true;
+        _zuege++;
+        einleiten();
+      }
+      schranke_fahren(SCHRANKE_ZU);
+    }
+  } else if (_zug && millis() - _zug_zuletzt >= BAHN_NACHLAUF) {
+    _zug = false;
+    schranke_fahren(0);
+  }
+
+  _schranke.run();
+  if (_faehrt && _schranke.distanceToGo() == 0) {
+    _faehrt = false;
+    uint16_t dauer = millis() - _fahrt_start;
+    if (_schranke.targetPosition() == 0) _fahrt_auf = dauer;
+    else _fahrt_zu = dauer;
+    _schranke.disableOutputs();
+  }
+}
+
+inline void Bahnuebergang::schranke_fahren(long ziel) {
+  if (_schranke.targetPosition() == ziel && !_faehrt) return;
+  _schranke.enableOutputs();
+  _schranke.moveTo(ziel);
+  _fahrt_start = millis();
+  _faehrt = true;
+}
+
+// Kürzesten sicheren Weg zum Grün der Gleiszufahrt bestimmen
+inline void Bahnuebergang::einleiten() {
+  bool gleis_gruen = lampen.lesen(lampe_ampel(_zufahrt, FARBE_GRUEN));
+  // Nicht das Lampenbild: im Warnblinken ist Fußgängergrün mal aus
+  bool fussg_gruen = _fussg_phasen != 0;
+
+  // Grün der Gleiszufahrt bleibt, jedes Gelb läuft zu Ende
+  bool offen = _raeumung.aufnehmen(1 << _zufahrt, BAHN_GELBZEIT);
+  // Räumt nur die Gegenrichtung, kann die Gleiszufahrt ohne
+  // Alles-Rot weiterfahren
+  uint8_t querachse = (_zufahrt < 2) ? 0x0C : 0x03;
+  _gleis_weiter = gleis_gruen && !fussg_gruen && !(_raeumung.offen() & querachse);
+
+  if (offen) {
+    wechseln(GELB);
+  } else if (gleis_gruen && !fussg_gruen) {
+    wechseln(GLEIS_FREI);
+  } else {
+    wechseln(RAEUMEN);
+  }
+}
+
+inline void Bahnuebergang::wechseln(Zustand neu) {
+  _zustand = neu;
+  _zustand_seit = millis();
+  if (neu == AUS) {
+    _sperre = millis() - _meldung_ms;
+    return;
+  }
+
+  bild_setzen();
+  lampen.ausgeben();
+
+  if (_messen) {
+    _messen = false;
+    _latenz = micros() - _meldung_us;
+  }
+}
+
+inline void Bahnuebergang::bild_setzen() {
+  uint8_t gleisachse = _zufahrt & 0xFE;   // 0/1 = Nord/Süd, 2/3 = Ost/West
+  for (uint8_t r = 0; r < ANZAHL_RICHTUNGEN; r++) {
+    lampen.setzen(lampe_fussg(r, true), false);
+    lampen.setzen(lampe_fussg(r, false), true);
+
+    uint8_t farbe = FARBE_ROT;
+    bool quer = (r & 0xFE) != gleisachse;
+    switch (_zustand) {
+      case GELB:
+        farbe = _raeumung.farbe(r);
+        break;
+      case GLEIS_FREI:
+        if (r == _zufahrt) farbe = FARBE_GRUEN;
+        break;
+      case GLEIS_GELB:
+        if (r == _zufahrt) farbe = FARBE_GELB;
+        break;
+      case SPERRE:
+        if (quer) farbe = FARBE_GRUEN;
+        break;
+      case AUSLAUF_GELB:
+        if (quer) farbe = FARBE_GELB;
+        break;
+      default:
+        break;
+    }
+    lampen.setzen(lampe_ampel(r, FARBE_ROT), farbe == FARBE_ROT);
+    lampen.setzen(lampe_ampel(r, FARBE_GELB), farbe == FARBE_GELB);
+    lampen.setzen(lampe_ampel(r, FARBE_GRUEN), farbe == FARBE_GRUEN);
+  }
+}
+
+inline bool Bahnuebergang::bearbeiten() {
+  uint32_t dauer = millis() - _zustand_seit;
+  switch (_zustand) {
+    case AUS:
+      return false;
+    case GELB:
+      if (_raeumung.fertig()) {
+        wechseln(_gleis_weiter ? GLEIS_FREI : RAEUMEN);
+      } else {
+        bild_setzen();   // jede Zufahrt wird Rot, sobald ihr Gelb um ist
+        lampen.ausgeben();
+      }
+      break;
+    case RAEUMEN:
+      if (dauer >= BAHN_RAEUMZEIT) wechseln(GLEIS_FREI);
+      break;
+    case GLEIS_FREI:
+      if (dauer >= BAHN_GLEISRAEUMEN) wechseln(GLEIS_GELB);
+      break;
+    case GLEIS_GELB:
+      if (dauer >= BAHN_GELBZEIT) wechseln(GLEIS_ROT);
+      break;
+    case GLEIS_ROT:
+      if (dauer >= BAHN_RAEUMZEIT) wechseln(SPERRE);
+      break;
+    case SPERRE:
+      // Erst wenn der Zug weg und die Schranke ganz oben ist
+      if (!_zug && !_faehrt && _schranke.currentPosition() == 0) wechseln(AUSLAUF_GELB);
+      break;
+    case AUSLAUF_GELB:
+      if (dauer >= BAHN_GELBZEIT) wechseln(AUSLAUF_ROT);
+      break;
+    case AUSLAUF_ROT:
+      if (dauer >= BAHN_RAEUMZEIT) wechseln(AUS);
+      break;
+  }
+  return _zustand != AUS;
+}
+
+#endif
@@ -0,0 +1,76 @@
+/* =====================================================
+   ESP32-BEGLEITER: BINÄRE VERBINDUNG (lib/SerialCom)
+   =====================================================
+
+   Der Mega bleibt die Steuerung, der ESP32 hängt als
+   Begleiter an einem Hardware-Port (WLAN, App, Logging).
+   Statt Textzeilen laufen feste Strukturen über die Leitung
+   (SerialLink aus lib/SerialCom): CRC-16, Folgenummern,
+   bis zu BEGLEITER_FENSTER Frames unterwegs, Wiederholung
+   nach Zeitablauf. Die Strukturen gehen so über den Draht,
+   wie sie im Speicher liegen - kein Zerlegen, kein Parsen.
+
+   Deshalb hier nur Typen fester Breite und packed: der ESP32
+   würde uint32_t sonst auf 4 Bytes ausrichten, der Mega
+   nicht. Die static_asserts halten beide Seiten gleich, der
+   ESP32-Sketch bindet genau diese Datei ein.
+
+   Ablauf:
+     ESP32 -> Mega  BegleiterAuftrag (nummer, art, wert)
+     Mega -> ESP32  BegleiterBericht mit antwort_auf = nummer
+                    und dem Ergebnis, sonst unaufgefordert alle
+                    BEGLEITER_INTERVALL mit antwort_auf = 0
+
+   Bei 1 MBaud braucht ein Bericht (28 + 8 Bytes Rahmen)
+   360 us auf der Leitung, Messung: host/BegleiterSim.cpp.
+   ===================================================== */
+
+#ifndef BEGLEITER_H
+#define BEGLEITER_H
+
+#include <Arduino.h>
+#include <SerialLink.h>
+
+#define BEGLEITER_FENSTER 4   // Frames pro Richtung unterwegs (Zweierpotenz)
+
+enum BegleiterArt : uint8_t {
+  AUFTRAG_BERICHT     = 0,   // nur ein frischer Bericht
+  AUFTRAG_PLAN        = 1,   // wert: 0 = TAG, 1 = NACHT
+  AUFTRAG_FUSSGAENGER = 2,   // wert: Zufahrt 0-3, wie ein Tastendruck
+};
+
+enum BegleiterErgebnis : uint8_t {
+  BEGLEITER_OK         = 0,
+  BEGLEITER_ABGELEHNT  = 1,  // Wert außerhalb des Bereichs
+  BEGLEITER_UNBEKANNT  = 2,  // art unbekannt (neuerer ESP32-Sketch?)
+};
+
+// ESP32 -> Mega
+struct __attribute__((packed)) BegleiterAuftrag {
+  uint16_t nummer;          // vom ESP32 hochgezählt, nie 0
+  uint8_t art;              // BegleiterArt
+  uint8_t wert;
+};
+
+// Mega -> ESP32
+struct __attribute__((packed)) BegleiterBericht {
+  uint16_t antwort_auf;     // nummer des Auftrags, 0 = unaufgefordert
+  uint8_t ergebnis;         // BegleiterErgebnis
+  uint8_t modus;            // 0 = TAG, 1 = NACHT
+  uint8_t phase;
+  uint8_t plan;             // 0 = TAG, 1 = NACHT, 2 = BLINKEN
+  uint8_t erkannt;          // Fahrzeug-Bits der Zufahrten
+  uint8_t anforderungen;    // Fußgänger-Bits
+  uint16_t cm[4];           // letzter vollständiger Sweep
+  uint32_t zeit_ms;
+  uint32_t phase_ms;        // seit Beginn der Phase
+  uint32_t sensor_sweeps;
+};
+
+static_assert(sizeof(BegleiterAuftrag) == 4, "BegleiterAuftrag: Layout muss auf Mega und ESP32 gleich sein");
+static_assert(sizeof(BegleiterBericht) == 28, "BegleiterBericht: Layout muss auf Mega und ESP32 gleich sein");
+
+// Mega-Seite, der ESP32 nimmt SerialLink<BegleiterBericht, BegleiterAuftrag, BEGLEITER_FENSTER>
+typedef SerialLink<BegleiterAuftrag, BegleiterBericht, BEGLEITER_FENSTER> BegleiterLink;
+
+#endif
@@ -0,0 +1,81 @@
+/* =====================================================
+   BETRIEBSARTEN: EINE STEUERUNG, AUSTAUSCHBARE LOGIK
+   =====================================================
+
+   Festzeit, verkehrsabhängige Nacht, Nachtblinken, Vorrang
+   und Handbetrieb sind Einträge einer Tabelle im Sketch,
+   alle auf denselben Lampen (LampenAusgabe) und derselben
+   Zeitbasis (millis, Loop-Takt). Pro Betriebsart:
+
+     beginnen   Übernahme: Lampen in einen definierten Zustand
+     takt       einmal pro Loop
+     sicher     darf die Betriebsart jetzt abgeben? (z.B. erst
+                nach dem Gelb, nie mitten im Grün)
+     vorrang    übernimmt sofort, ohne auf einen sicheren Punkt
+                zu warten (räumt selbst, z.B. Vorrang.h)
+
+   Der Sketch bestimmt in jedem Takt die gewünschte
+   Betriebsart (Taster, AT+PLAN, Kalender, Sensoren, Vorrang).
+   Weicht sie ab, läuft die alte weiter, bis sie sicher ist;
+   dann wechselt takt() im selben Loop-Durchlauf: beginnen()
+   und takt() der neuen, kein Zwischenbild, kein Neustart.
+
+   Header-only.
+   ===================================================== */
+
+#ifndef BETRIEBSARTEN_H
+#define BETRIEBSARTEN_H
+
+#include <Arduino.h>
+
+struct Betriebsart {
+  const char *name;
+  void (*beginnen)();   // NULL = nichts zu tun
+  void (*takt)();
+  bool (*sicher)();     // NULL = jederzeit
+  bool vorrang;
+};
+
+class BetriebsartVerwalter {
+public:
+  void starten(const Betriebsart *arten, uint8_t start) {
+    _arten = arten;
+    _ist = _soll = start;
+    if (_arten[_ist].beginnen) _arten[_ist].beginnen();
+  }
+
+  // Einmal pro Loop mit der gewünschten Betriebsart; true, wenn
+  // in diesem Takt gewechselt wurde
+  bool takt(uint8_t soll) {
+    if (soll != _soll) {
+      _soll = soll;
+      _soll_seit = millis();
+    }
+    bool wechsel = _soll != _ist && (_arten[_soll].vorrang || !_arten[_ist].sicher || _arten[_ist].sicher());
+    if (wechsel) {
+      uint32_t gewartet = millis() - _soll_seit;
+      if (gewartet > _warten_max) _warten_max = gewartet;
+      _ist = _soll;
+      _wechsel++;
+      if (_arten[_ist].beginnen) _arten[_ist].beginnen();
+    }
+    _arten[_ist].takt();
+    return wechsel;
+  }
+
+  uint8_t ist() const { return _ist; }
+  uint8_t soll() const { return _soll; }
+  const char *name(uint8_t art) const { return _arten[art].name; }
+  uint16_t wechsel() const { return _wechsel; }
+  uint32_t warten_max_ms() const { return _warten_max; }   // Wunsch bis sicherer Punkt
+
+private:
+  const Betriebsart *_arten = NULL;
+  uint8_t _ist = 0;
+  uint8_t _soll = 0;
+  uint32_t _soll_seit = 0;
+  uint16_t _wechsel = 0;
+  uint32_t _warten_max = 0;
+};
+
+#endif
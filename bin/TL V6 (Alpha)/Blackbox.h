@@ -0,0 +1,410 @@
+/* =====================================================
+   BLACKBOX: RINGSPEICHER IM SPI-FLASH (lib/Adafruit_SPIFlash)
+   =====================================================
+
+   Schaltschränke ohne SD-Karte wissen nach einem Absturz
+   oder Unfall nicht, was die Ampel gezeigt hat. Die Blackbox
+   schreibt jedes ausgegebene Lampenbild, jede Änderung der
+   Fahrzeugerkennung und jede Tasterflanke in einen Ring aus
+   Flash-Sektoren (4 KB, kleinste löschbare Einheit).
+
+   Eintrag (Delta zum vorigen Eintrag im Sektor):
+     1 Byte   Art (Bit 7..5) und Argument (Bit 4..0)
+     Lampen:  Argument = welche Bytes des Bildes sich ändern,
+              dann nur diese Bytes (XOR zum vorigen Bild)
+     Erkannt: Argument = Fahrzeug-Bits der vier Zufahrten
+     Taster:  Argument = Taster (Bit 2..0), Pegel (Bit 3)
+     1-5 Byte ms seit dem vorigen Eintrag (7 Bit pro Byte,
+              Bit 7 = es folgt noch eins), immer zuletzt
+   Ein Gelbblinken kostet so 4 statt 8 Byte, ein
+   Fahrzeugwechsel 2-3 statt 5. 0xFF (gelöscht) beendet den
+   Sektor; Einträge gehen nie über eine Sektorgrenze. Das
+   letzte Byte eines Eintrags ist nie 0xFF: ein beim
+   Stromausfall halb programmierter Eintrag (hinten noch
+   gelöscht) wird so erkannt und nicht mehr gelesen.
+
+   Jeder Sektor beginnt mit einem Kopf: Kennung, Folgenummer
+   (= logische Sektornummer, steigt auch über Neustarts),
+   millis() und das volle Lampenbild. Jeder Sektor ist damit
+   allein lesbar, der älteste darf jederzeit gelöscht werden.
+   Nach dem Einschalten geht es im Sektor nach dem neuesten
+   weiter (millis() fängt wieder bei 0 an).
+
+   Schreiben: eintragen() legt nur im RAM-Ring ab. bearbeiten()
+   gibt pro Aufruf höchstens EIN Kommando an das Flash und nur,
+   wenn es nicht mehr beschäftigt ist (isReady):
+     - Löschen des Sektors vor dem Schreibkopf, sobald weniger
+       als ein gelöschter Sektor Vorlauf da ist (das Flash
+       löscht danach 45..400 ms allein weiter)
+     - sonst eine Seite (bis 256 Byte) programmieren, spätestens
+       nach BLACKBOX_SYNC_MS auch eine angefangene (der Rest der
+       Seite ist noch gelöscht und wird später nachprogrammiert)
+   Die Loop wartet damit nie auf ein Löschen oder Programmieren.
+   Schlägt ein Kommando fehl (SPI gestört, Flash fehlt), zählt
+   fehler() mit und der nächste Aufruf wiederholt es: beim
+   Schreiben ab dem ersten nicht geschriebenen Byte, der Rest
+   wartet im RAM-Ring.
+   Adafruit_FlashCache passt hier nicht: sync() löscht und
+   schreibt bei jedem Sektorwechsel die vollen 4 KB (und wartet
+   dabei), und der Cache allein belegt die Hälfte des Mega-RAMs.
+
+   Lesen (AT+BBOX): ältester bis neuester Sektor, was noch
+   nicht im Flash steht, kommt aus dem RAM-Ring - wie
+   Adafruit_FlashCache::read().
+
+   Überlebt ein Stromausfall: alles bis zur letzten
+   programmierten Seite, verloren ist höchstens der RAM-Ring
+   (BLACKBOX_SYNC_MS).
+
+   Kompression, Schreibverstärkung und Lebensdauer des Flashs:
+   host/BlackboxSim.cpp.
+
+   start und bytes müssen auf Sektorgrenzen liegen, im Ring
+   stehen mindestens drei Sektoren. Aufbewahrt wird der Ring
+   weniger zwei Sektoren (Vorlauf).
+
+   Header-only, wird nur eingebunden wenn BLACKBOX_AKTIV=1.
+   ===================================================== */
+
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include <Arduino.h>
+#include <Adafruit_SPIFlashBase.h>
+#include "LampenAusgabe.h"
+
+#define BLACKBOX_SEKTOR    SFLASH_SECTOR_SIZE   // 4096
+#define BLACKBOX_SEITE     SFLASH_PAGE_SIZE     // 256
+#define BLACKBOX_PUFFER    256    // RAM-Ring (Zweierpotenz), reicht für ein Löschen
+#define BLACKBOX_SYNC_MS   1000   // angefangene Seite spätestens dann programmieren
+#define BLACKBOX_EINTRAG_MAX 6    // ohne Zeit: 1 + 5 Lampenbytes bei 40 Lampen
+#define BLACKBOX_LAMPENBYTES ((ANZAHL_LAMPEN + 7) / 8)
+
+static_assert(BLACKBOX_LAMPENBYTES <= 5, "Lampenmaske passt nicht in 5 Bit");
+static_assert((BLACKBOX_PUFFER & (BLACKBOX_PUFFER - 1)) == 0, "BLACKBOX_PUFFER muss eine Zweierpotenz sein");
+
+static const char BLACKBOX_KENNUNG[4] = {'B', 'B', 'X', '1'};
+
+enum BlackboxArt : uint8_t {
+  BB_LAMPEN  = 1,
+  BB_ERKANNT = 2,
+  BB_TASTER  = 3,
+  BB_ANFANG  = 4,   // nur beim Lesen: Sektorkopf (erster gelesener bzw. nach Neustart)
+  BB_ENDE    = 7,   // 0xFF = gelöscht
+};
+
+struct BlackboxKopf {
+  char kennung[4];
+  uint32_t folge;      // logische Sektornummer
+  uint32_t zeit_ms;    // millis() beim Kopf, Basis des ersten Eintrags
+  LampenBild bild;
+  uint8_t erkannt;
+  uint8_t neustart;    // 1 = erster Sektor nach dem Einschalten
+  uint16_t frei;
+};
+
+struct BlackboxEintrag {
+  uint32_t zeit_ms;
+  uint8_t art;         // BlackboxArt
+  bool neustart;       // BB_ANFANG: millis() fängt hier neu an
+  LampenBild bild;     // immer das volle Bild nach dem Eintrag
+  uint8_t erkannt;     // immer die Bits nach dem Eintrag
+  uint8_t taster;      // BB_TASTER
+  uint8_t pegel;
+};
+
+class Blackbox {
+public:
+  // Ring von bytes (ganze Sektoren) ab Adresse start im Flash;
+  // sucht den neuesten Sektor, geschrieben wird im nächsten
+  bool starten(Adafruit_SPIFlashBase &flash, uint32_t start, uint32_t bytes) {
+    _start = start;
+    _sektoren = bytes / BLACKBOX_SEKTOR;
+    if (_sektoren < 3) return false;
+    _flash = &flash;
+    uint32_t neuester = 0;
+    bool gefunden = false;
+    BlackboxKopf kopf;
+    for (uint32_t s = 0; s < _sektoren; s++) {
+      _flash->readBuffer(_start + s * BLACKBOX_SEKTOR, (uint8_t *)&kopf, sizeof(kopf));
+      if (kopf_gueltig(kopf, s) && (!gefunden || kopf.folge > neuester)) {
+        neuester = kopf.folge;
+        gefunden = true;
+      }
+    }
+    _schreiben = _programmiert = _geloescht = gefunden ? (neuester + 1) * BLACKBOX_SEKTOR : 0;
+    _neustart = true;
+    _letzte_sync = millis();
+    return true;
+  }
+
+  // -------------------------
+  // EINTRAGEN (nur RAM)
+  // -------------------------
+  void lampen(LampenBild bild) {
+    LampenBild diff = bild ^ _bild;
+    if (!diff) return;
+    uint8_t e[BLACKBOX_EINTRAG_MAX];
+    uint8_t maske = 0, n = 1;
+    for (uint8_t b = 0; b < BLACKBOX_LAMPENBYTES; b++) {
+      if (diff >> (8 * b) & 0xFF) {
+        maske |= 1 << b;
+        e[n++] = diff >> (8 * b);
+      }
+    }
+    e[0] = BB_LAMPEN << 5 | maske;
+    if (eintragen(e, n, 8)) _bild = bild;
+  }
+
+  void erkannt(uint8_t bits) {
+    if (bits == _erkannt) return;
+    uint8_t e = BB_ERKANNT << 5 | (bits & 0x0F);
+    if (eintragen(&e, 1, 5)) _erkannt = bits & 0x0F;
+  }
+
+  void taster(uint8_t taster, uint8_t pegel) {
+    uint8_t e = BB_TASTER << 5 | (pegel ? 0x08 : 0) | (taster & 0x07);
+    eintragen(&e, 1, 5);
+  }
+
+  // -------------------------
+  // FLASH (aus der Loop)
+  // -------------------------
+  // Höchstens ein Kommando, nie warten
+  void bearbeiten() {
+    if (!_flash) return;
+    uint32_t start = micros();
+    if (!_flash->isReady()) {
+      _belegt++;
+      return;
+    }
+    if (_geloescht < _schreiben + BLACKBOX_SEKTOR) {
+      // Vorlauf: der nächste Sektor ist gelöscht, bevor der Kopf ihn braucht
+      if (_flash->eraseSector((_start + physisch(_geloescht)) / BLACKBOX_SEKTOR)) {
+        _geloescht += BLACKBOX_SEKTOR;
+        _loeschungen++;
+      } else {
+        _fehler++;   // nächster Aufruf löscht denselben Sektor
+      }
+    } else if (_schreiben != _programmiert) {
+      uint32_t n = min(_schreiben - _programmiert, (uint32_t)(BLACKBOX_SEITE - _programmiert % BLACKBOX_SEITE));
+      n = min(n, (uint32_t)(BLACKBOX_PUFFER - _programmiert % BLACKBOX_PUFFER));   // am Ringende teilen
+      // Volle Seite sofort, angefangene erst nach BLACKBOX_SYNC_MS
+      if (_programmiert % BLACKBOX_SEITE + n < BLACKBOX_SEITE && millis() - _letzte_sync < BLACKBOX_SYNC_MS) return;
+      uint32_t geschrieben = _flash->writeBuffer(_start + physisch(_programmiert), _ring + _programmiert % BLACKBOX_PUFFER, n);
+      if (geschrieben < n) _fehler++;   // der Rest bleibt im RAM-Ring und wird beim nächsten Aufruf geschrieben
+      _programmiert += geschrieben;
+      _seiten++;
+      _programmiert_bytes += geschrieben;
+      if (_programmiert == _schreiben) _letzte_sync = millis();
+    } else {
+      _letzte_sync = millis();
+      return;
+    }
+    uint32_t dauer = micros() - start;
+    if (dauer > _max_us) _max_us = dauer;
+  }
+
+  // -------------------------
+  // LESEN
+  // -------------------------
+  void lesen_starten() {
+    uint32_t ende = _geloescht / BLACKBOX_SEKTOR;   // erster noch nicht gelöschter
+    _lese_sektor = ende > _sektoren ? ende - _sektoren : 0;
+    _lese_adr = 0;
+    _lese_erster = true;
+  }
+
+  // readBuffer() wartet auf ein laufendes Löschen: aus der Loop
+  // nur lesen, wenn das Flash frei ist
+  bool lesbar() { return !_flash || _flash->isReady(); }
+
+  // Nächster Eintrag, false am Ende
+  bool naechster(BlackboxEintrag &e) {
+    while (_flash) {
+      if (!_lese_adr) {
+        if (_lese_sektor * BLACKBOX_SEKTOR >= _schreiben) return false;
+        BlackboxKopf kopf;
+        uint32_t s = _lese_sektor++;
+        lesen(s * BLACKBOX_SEKTOR, (uint8_t *)&kopf, sizeof(kopf));
+        if (!kopf_gueltig(kopf, s % _sektoren) || kopf.folge != s) {
+          _lese_erster = true;   // Lücke: der nächste Kopf setzt neu auf
+          continue;
+        }
+        _lese_adr = s * BLACKBOX_SEKTOR + sizeof(kopf);
+        _lese_zeit = kopf.zeit_ms;
+        _lese_bild = kopf.bild;
+        _lese_erkannt = kopf.erkannt;
+        if (_lese_erster || kopf.neustart) {
+          e.zeit_ms = _lese_zeit;
+          e.art = BB_ANFANG;
+          e.neustart = kopf.neustart;
+          e.bild = _lese_bild;
+          e.erkannt = _lese_erkannt;
+          _lese_erster = false;
+          return true;
+        }
+      }
+      if (eintrag_lesen(e)) return true;
+      _lese_adr = 0;   // Sektorende
+    }
+    return false;
+  }
+
+  uint32_t eintraege() const { return _eintraege; }
+  uint32_t bytes() const { return _bytes; }              // kodiert, mit Köpfen und Füllbytes
+  uint32_t bytes_roh() const { return _bytes_roh; }      // als Zeit + Wert (4 + 1..4 Byte)
+  uint32_t programmiert() const { return _programmiert_bytes; }
+  uint32_t seiten() const { return _seiten; }
+  uint32_t loeschungen() const { return _loeschungen; }
+  uint32_t verloren() const { return _verloren; }        // RAM-Ring voll
+  uint32_t belegt() const { return _belegt; }            // Flash war noch beschäftigt
+  uint32_t fehler() const { return _fehler; }            // fehlgeschlagene, wiederholte Lösch-/Schreibkommandos
+  uint32_t max_us() const { return _max_us; }            // längstes bearbeiten()
+  uint32_t ring_bytes() const { return _sektoren * BLACKBOX_SEKTOR; }
+
+private:
+  bool kopf_gueltig(const BlackboxKopf &kopf, uint32_t physischer_sektor) const {
+    return !memcmp(kopf.kennung, BLACKBOX_KENNUNG, 4) && kopf.folge % _sektoren == physischer_sektor;
+  }
+
+  uint32_t physisch(uint32_t logisch) const { return logisch % (_sektoren * BLACKBOX_SEKTOR); }
+
+  // Eintrag (ohne Zeit) in den Ring, mit neuem Sektorkopf wenn
+  // nötig. Wird einer verworfen, bleibt das Delta beim nächsten.
+  bool eintragen(const uint8_t *e, uint8_t n, uint8_t roh) {
+    if (!_flash) return false;   // kein Flash gefunden
+    uint32_t jetzt = millis();
+    uint32_t frei = BLACKBOX_SEKTOR - _schreiben % BLACKBOX_SEKTOR;
+    bool kopf = _neustart || _schreiben % BLACKBOX_SEKTOR == 0 || frei < n + zeit_bytes(jetzt - _zeit);
+    // Mit Kopf zählt die Zeit ab dem Kopf (ein Byte)
+    uint32_t platz = kopf ? (_schreiben % BLACKBOX_SEKTOR ? frei : 0) + sizeof(BlackboxKopf) + n + 1
+                          : n + zeit_bytes(jetzt - _zeit);
+    if (BLACKBOX_PUFFER - (_schreiben - _programmiert) < platz) {
+      _verloren++;
+      return false;
+    }
+    if (kopf) {
+      // Rest des Sektors bleibt gelöscht (0xFF = Ende)
+      while (_schreiben % BLACKBOX_SEKTOR) ablegen(0xFF);
+      BlackboxKopf k;
+      memcpy(k.kennung, BLACKBOX_KENNUNG, 4);
+      k.folge = _schreiben / BLACKBOX_SEKTOR;
+      k.zeit_ms = _zeit = jetzt;
+      k.bild = _bild;
+      k.erkannt = _erkannt;
+      k.neustart = _neustart;
+      k.frei = 0;
+      _neustart = false;
+      for (uint8_t i = 0; i < sizeof(k); i++) ablegen(((const uint8_t *)&k)[i]);
+    }
+    for (uint8_t i = 0; i < n; i++) ablegen(e[i]);
+    uint32_t dt = jetzt - _zeit;
+    do {
+      ablegen((dt & 0x7F) | (dt > 0x7F ? 0x80 : 0));
+      dt >>= 7;
+    } while (dt);
+    _zeit = jetzt;
+    _eintraege++;
+    _bytes_roh += roh;
+    return true;
+  }
+
+  static uint8_t zeit_bytes(uint32_t dt) {
+    uint8_t n = 1;
+    while (dt >>= 7) n++;
+    return n;
+  }
+
+  void ablegen(uint8_t b) {
+    _ring[_schreiben % BLACKBOX_PUFFER] = b;
+    _schreiben++;
+    _bytes++;
+  }
+
+  // Logische Adresse: noch nicht programmiert -> aus dem Ring
+  void lesen(uint32_t adr, uint8_t *ziel, uint16_t n) {
+    for (uint16_t i = 0; i < n; i++, adr++) {
+      if (adr >= _programmiert && adr < _schreiben) {
+        ziel[i] = _ring[adr % BLACKBOX_PUFFER];
+      } else if (adr >= _schreiben) {
+        ziel[i] = 0xFF;
+      } else {
+        _flash->readBuffer(_start + physisch(adr), ziel + i, 1);
+      }
+    }
+  }
+
+  uint8_t lese_byte() {
+    uint8_t b = 0xFF;   // Lesefehler wie gelöscht
+    lesen(_lese_adr++, &b, 1);
+    return b;
+  }
+
+  // false am Sektorende und bei einem zerrissenen Eintrag
+  bool eintrag_lesen(BlackboxEintrag &e) {
+    if (_lese_adr % BLACKBOX_SEKTOR == 0) return false;   // Sektor bis zum letzten Byte voll
+    uint32_t sektor_ende = (_lese_adr / BLACKBOX_SEKTOR + 1) * BLACKBOX_SEKTOR;
+    uint8_t a = lese_byte();
+    uint8_t art = a >> 5;
+    if (art < BB_LAMPEN || art > BB_TASTER) return false;   // 0xFF: Ende des Sektors
+    LampenBild diff = 0;
+    if (art == BB_LAMPEN) {
+      for (uint8_t i = 0; i < BLACKBOX_LAMPENBYTES; i++) {
+        if (a >> i & 1) diff |= (LampenBild)lese_byte() << (8 * i);
+      }
+    }
+    uint32_t dt = 0;
+    uint8_t b, schieben = 0;
+    do {
+      b = lese_byte();
+      dt |= (uint32_t)(b & 0x7F) << schieben;
+      schieben += 7;
+    } while (b & 0x80 && schieben < 35);
+    if (b & 0x80 || _lese_adr > sektor_ende) return false;
+    _lese_zeit += dt;
+    _lese_bild ^= diff;
+    if (art == BB_ERKANNT) _lese_erkannt = a & 0x0F;
+    e.zeit_ms = _lese_zeit;
+    e.art = art;
+    e.neustart = false;
+    e.bild = _lese_bild;
+    e.erkannt = _lese_erkannt;
+    e.taster = a & 0x07;
+    e.pegel = a >> 3 & 1;
+    return true;
+  }
+
+  Adafruit_SPIFlashBase *_flash = NULL;
+  uint32_t _start = 0;
+  uint32_t _sektoren = 0;
+  uint8_t _ring[BLACKBOX_PUFFER];
+  uint32_t _schreiben = 0;      // logisch: nächstes Byte in den Ring
+  uint32_t _programmiert = 0;   // logisch: bis hier im Flash
+  uint32_t _geloescht = 0;      // logisch: bis hier gelöscht
+  uint32_t _zeit = 0;           // millis() des vorigen Eintrags
+  uint32_t _letzte_sync = 0;
+  LampenBild _bild = 0;         // wie im Ring kodiert
+  uint8_t _erkannt = 0;
+  bool _neustart = false;
+
+  uint32_t _lese_sektor = 0;
+  uint32_t _lese_adr = 0;       // 0 = nächster Sektorkopf
+  uint32_t _lese_zeit = 0;
+  LampenBild _lese_bild = 0;
+  uint8_t _lese_erkannt = 0;
+  bool _lese_erster = true;
+
+  uint32_t _eintraege = 0;
+  uint32_t _bytes = 0;
+  uint32_t _bytes_roh = 0;
+  uint32_t _programmiert_bytes = 0;
+  uint32_t _seiten = 0;
+  uint32_t _loeschungen = 0;
+  uint32_t _verloren = 0;
+  uint32_t _belegt = 0;
+  uint32_t _fehler = 0;
+  uint32_t _max_us = 0;
+};
+
+#endif
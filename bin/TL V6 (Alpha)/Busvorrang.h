@@ -0,0 +1,217 @@
+/* =====================================================
+   ÖPNV-BEVORRECHTIGUNG ÜBER J1939 (lib/SharkJ1939)
+   =====================================================
+
+   Busse melden Position und Türzustand über ein J1939-
+   Gateway. Die Frames werden über eine PGN-Tabelle im
+   SharkJ1939-Format (PGN_KNOWN_ENTRY, pgnCallback)
+   dekodiert - tabellengesteuert, ohne Heap.
+
+   Proprietäre PGNs (PDU2, Proprietary B):
+     0xFF10 BUSPOS   [0] Zufahrt  [1..2] Abstand m (LE)  [3] ETA s
+     0xFF11 BUSTUER  [0] Zufahrt  [1] Bit0 = Tür offen
+     0xFF12 BUSAB    [0] Zufahrt  (Bus hat die Haltlinie passiert)
+
+   Bevorrechtigung (Tagesprogramm, Phasen 0..3):
+     - Grünzeitverlängerung: Bus auf der grünen Achse kommt
+       kurz nach Grünende an -> Grün verlängern
+     - Grünzeitverkürzung: Bus auf der roten Achse -> laufendes
+       Grün kürzen, damit er früher Grün bekommt
+     Was eine Grünphase gewinnt, verliert die NÄCHSTE Grünphase
+     der anderen Achse - die Umlaufzeit bleibt erhalten, die
+     Koordinierung läuft nach spätestens einem Umlauf wieder
+     im alten Raster. Pro Grünphase höchstens ein Eingriff,
+     Grenzen über BUS_MAX_EINGRIFF / BUS_MIN_GRUEN.
+
+   Header-only, wird nur eingebunden wenn BUSVORRANG_AKTIV=1.
+   ===================================================== */
+
+#ifndef BUSVORRANG_H
+#define BUSVORRANG_H
+
+#include <Arduino.h>
+class MCP2515;            // SharkJ1939.h braucht nur die Deklaration
+#include <SharkJ1939.h>
+
+#define BUS_MAX_EINGRIFF   8000   // max. Verlängerung/Verkürzung pro Grünphase (ms)
+#define BUS_MIN_GRUEN      5000   // kein Grün wird kürzer als das (ms)
+#define BUS_MAX_ETA        30     // weiter entfernte Busse ignorieren (s)
+#define BUS_TIMEOUT        5000   // Meldung verfällt ohne Update (ms)
+#define BUS_RESERVE        2000   // Sicherheitszuschlag auf die ETA (ms)
+
+#define BUS_PGN_POS        0xFF10
+#define BUS_PGN_TUER       0xFF11
+#define BUS_PGN_AB         0xFF12
+
+// -------------------------
+// PGN AUS 29-BIT-ID (wie SharkJ1939)
+// -------------------------
+inline uint32_t j1939_pgn(uint32_t can_id) {
+  uint32_t pgn = (can_id & 0x03FFFF00UL) >> 8;
+  if (((pgn >> 8) & 0xFF) < 240) {
+    pgn &= 0x0003FF00UL;   // PDU1: Zieladresse abschneiden
+  }
+  return pgn;
+}
+
+// -------------------------
+// BEVORRECHTIGUNGSLOGIK
+// -------------------------
+class Busvorrang {
+public:
+  // --- Eingänge aus den PGN-Callbacks ---
+  void position(uint8_t richtung, uint8_t eta_s) {
+    if (richtung >= 4) return;
+    _bus[richtung].eta_ms = (uint32_t)eta_s * 1000;
+    _bus[richtung].zeit = millis();
+    _bus[richtung].gemeldet = eta_s <= BUS_MAX_ETA;
+  }
+
+  void tuer(uint8_t richtung, bool offen) {
+    if (richtung < 4) _bus[richtung].tuer_offen = offen;
+  }
+
+  void abmelden(uint8_t richtung) {
+    if (richtung < 4) _bus[richtung].gemeldet = false;
+  }
+
+  /* Dauer der laufenden Tagesphase inkl. Bevorrechtigung.
+     phase: 0 = N/S Grün, 1 = N/S Gelb, 2 = O/W Grün, 3 = O/W Gelb
+     gelb:  Dauer der folgenden Gelbphase (ms)
+     gegen: geplantes Grün der anderen Achse (ms), zahlt eine
+            Verlängerung und darf dabei nicht unter BUS_MIN_GRUEN */
+  uint16_t phasendauer(uint8_t phase, uint16_t basis, uint16_t gelb, uint16_t gegen, uint32_t verstrichen) {
+    if (phase & 1) return basis;   // Gelb wird nie angefasst
+
+    uint8_t g = phase >> 1;        // 0 = N/S, 1 = O/W
+    int32_t dauer = (int32_t)basis + _korrektur[g];
+    if (!_eingegriffen[g]) {
+      entscheiden(g, dauer, gelb, gegen, verstrichen);
+      dauer = (int32_t)basis + _korrektur[g];
+    }
+    if (dauer < BUS_MIN_GRUEN) dauer = BUS_MIN_GRUEN;
+    return dauer;
+  }
+
+  // Bei jedem Phasenwechsel aufrufen
+  void phase_beendet(uint8_t phase) {
+    if (phase & 1) return;
+    uint8_t g = phase >> 1;
+    _korrektur[g] = 0;             // verbraucht, Gegenbuchung liegt bei der anderen Achse
+    _eingegriffen[g] = false;
+  }
+
+  uint16_t verlaengerungen() const { return _verlaengerungen; }
+  uint16_t verkuerzungen() const { return _verkuerzungen; }
+
+private:
+  struct Bus {
+    uint32_t eta_ms;
+    uint32_t zeit;
+    bool gemeldet;
+    bool tuer_offen;
+  };
+
+  // Wartet ein Bus auf Achse "achse" (und steht nicht an der Haltestelle)?
+  bool bus_auf(uint8_t achse, uint32_t &eta_ms) {
+    bool gefunden = false;
+    for (uint8_t r = achse * 2; r < achse * 2 + 2; r++) {
+      Bus &b = _bus[r];
+      if (!b.gemeldet || b.tuer_offen) continue;
+      uint32_t alter = millis() - b.zeit;
+      if (alter > BUS_TIMEOUT) {
+        b.gemeldet = false;
+        continue;
+      }
+      uint32_t rest = b.eta_ms > alter ? b.eta_ms - alter : 0;
+      if (!gefunden || rest < eta_ms) eta_ms = rest;
+      gefunden = true;
+    }
+    return gefunden;
+  }
+
+  void buchen(uint8_t g, int32_t delta) {
+    _korrektur[g] += delta;
+    _korrektur[g ^ 1] -= delta;
+    _eingegriffen[g] = true;
+  }
+
+  void entscheiden(uint8_t g, int32_t dauer, uint16_t gelb, uint16_t gegen, uint32_t verstrichen) {
+    int32_t rest = dauer - (int32_t)verstrichen;
+    uint32_t eta = 0;
+
+    // Grünzeitverlängerung für die eigene Achse
+    if (bus_auf(g, eta)) {
+      int32_t fehlt = (int32_t)(eta + BUS_RESERVE) - rest;
+      if (fehlt > 0 && fehlt <= BUS_MAX_EINGRIFF) {
+        // Gegenachse darf nicht unter Mindestgrün fallen
+        int32_t spielraum = (int32_t)gegen + _korrektur[g ^ 1] - BUS_MIN_GRUEN;
+        if (fehlt <= spielraum) {
+          buchen(g, fehlt);
+          _verlaengerungen++;
+        }
+      }
+      return;   // Bus auf Grün hat Vorrang vor Kürzung
+    }
+
+    // Grünzeitverkürzung zugunsten der Gegenachse
+    if (bus_auf(g ^ 1, eta)) {
+      int32_t bis_gruen = rest + gelb;
+      int32_t kuerzen = bis_gruen - (int32_t)eta;
+      int32_t max_kuerzen = dauer - BUS_MIN_GRUEN;
+      if (max_kuerzen > rest) max_kuerzen = rest;   // Vergangenes kann nicht gekürzt werden
+      if (kuerzen > max_kuerzen) kuerzen = max_kuerzen;
+      if (kuerzen > BUS_MAX_EINGRIFF) kuerzen = BUS_MAX_EINGRIFF;
+      if (kuerzen > 0) {
+        buchen(g, -kuerzen);
+        _verkuerzungen++;
+      }
+    }
+  }
+
+  Bus _bus[4] = {};
+  int32_t _korrektur[2] = {0, 0};
+  bool _eingegriffen[2] = {false, false};
+  uint16_t _verlaengerungen = 0;
+  uint16_t _verkuerzungen = 0;
+};
+
+// -------------------------
+// PGN-TABELLE + CALLBACKS
+// -------------------------
+// Die Callbacks haben keinen Kontext -> eine globale Instanz
+static Busvorrang busvorrang;
+
+static void bus_pos_callback(uint8_t dlc, uint8_t *data) {
+  if (dlc >= 4) busvorrang.position(data[0], data[3]);
+}
+
+static void bus_tuer_callback(uint8_t dlc, uint8_t *data) {
+  if (dlc >= 2) busvorrang.tuer(data[0], data[1] & 1);
+}
+
+static void bus_ab_callback(uint8_t dlc, uint8_t *data) {
+  if (dlc >= 1) busvorrang.abmelden(data[0]);
+}
+
+// Gleiches Format wie bei SharkJ1939::bindPGNKnownTable(), Ende mit PGN 0
+static PGN_KNOWN_ENTRY BUS_PGN_TABELLE[] = {
+  {BUS_PGN_POS,  "BUSPOS",  bus_pos_callback},
+  {BUS_PGN_TUER, "BUSTUER", bus_tuer_callback},
+  {BUS_PGN_AB,   "BUSAB",   bus_ab_callback},
+  {0, NULL, NULL}
+};
+
+/* Verteilt einen CAN-Frame an den passenden Callback.
+   Gibt true zurück wenn die PGN in der Tabelle steht. */
+inline bool busvorrang_verteilen(uint32_t can_id, uint8_t dlc, uint8_t *data) {
+  uint32_t pgn = j1939_pgn(can_id);
+  for (PGN_KNOWN_ENTRY *e = BUS_PGN_TABELLE; e->pgn != 0; e++) {
+    if (e->pgn != pgn) continue;
+    if (e->pgnCallback) e->pgnCallback(dlc, data);
+    return true;
+  }
+  return false;
+}
+
+#endif
@@ -0,0 +1,132 @@
+/* =====================================================
+   DETEKTORÜBERWACHUNG MIT RÜCKFALL AUF DAUERANFORDERUNG
+   =====================================================
+
+   Ein toter HC-SR04 liefert nur noch "kein Echo" - die
+   Zufahrt gilt als leer und bekommt nachts nie wieder Grün.
+   Ein verdeckter Sensor (Laub, Schnee, Spinnennetz) misst
+   immer denselben Abstand - die Zufahrt fordert ewig an.
+
+   Ein DetektorWaechter pro Zufahrt zählt über ein Fenster von
+   DETEKTOR_FENSTER Sweeps, in konstantem Speicher:
+     kein Echo   Anteil der Pings ohne Echo (nur wenn der Sensor
+                 ohne Fahrzeug die Gegenseite sieht,
+                 DETEKTOR_HINTERGRUND im Sketch)
+     klebt       belegt mit demselben Wert (+-DETEKTOR_KLEBT_CM)
+                 über DETEKTOR_KLEBT_SWEEPS Sweeps am Stück
+     flattert    Wechsel frei/belegt im Fenster
+     springt     Einzelausreißer: ein Wert weit weg von seinen
+                 beiden Nachbarn, die sich einig sind
+
+   Fällt ein Fenster auf, gilt der Detektor als gestört: der
+   Sketch behandelt die Zufahrt als dauernd angefordert, mit
+   gedeckelter Grünzeit (Festzeit-Rückfall), und meldet das.
+   Erst nach DETEKTOR_ERHOLUNG sauberen Fenstern am Stück
+   zählt er wieder.
+
+   Durchsatz mit einem toten bzw. klebenden Sensor, mit und
+   ohne Überwachung: host/zeitlinie.sh --verkehr.
+
+   Header-only, wird nur eingebunden wenn
+   DETEKTOR_UEBERWACHUNG=1.
+   ===================================================== */
+
+#ifndef DETEKTOREN_H
+#define DETEKTOREN_H
+
+#include <Arduino.h>
+
+#define DETEKTOR_FENSTER          120   // Sweeps pro Bewertung (bei 500 ms: eine Minute)
+#define DETEKTOR_KEIN_ECHO_PROZENT 90   // ab so viel Prozent ohne Echo: ausgefallen
+#define DETEKTOR_KLEBT_SWEEPS     600   // 5 Minuten belegt, ohne dass sich etwas rührt
+#define DETEKTOR_KLEBT_CM         2     // Messrauschen eines stehenden Ziels
+#define DETEKTOR_FLATTERN_MAX     24    // Wechsel frei/belegt pro Fenster
+#define DETEKTOR_SPRUNG_CM        80    // Ausreißer: so weit weg von beiden Nachbarn
+#define DETEKTOR_NACHBAR_CM       10    // ...die höchstens so weit auseinander liegen
+#define DETEKTOR_SPRUENGE_MAX     12    // Ausreißer pro Fenster
+#define DETEKTOR_ERHOLUNG         5     // saubere Fenster bis zur Rückkehr
+
+enum DetektorFehler : uint8_t {
+  DETEKTOR_OK        = 0,
+  DETEKTOR_KEIN_ECHO = 0x01,
+  DETEKTOR_KLEBT     = 0x02,
+  DETEKTOR_FLATTERT  = 0x04,
+  DETEKTOR_SPRINGT   = 0x08,
+};
+
+class DetektorWaechter {
+public:
+  explicit DetektorWaechter(bool hintergrund = true) : _hintergrund(hintergrund) {}
+
+  // Nach jedem Ping mit dem Rohwert (0 = kein Echo) und ob er
+  // als Fahrzeug zählt; true, wenn sich gestoert() geändert hat
+  bool messung(uint16_t cm, bool belegt) {
+    if (!cm) _kein_echo++;
+    if (belegt != _belegt && _gemessen) _wechsel++;
+    _belegt = belegt;
+    _gemessen = true;
+
+    if (cm && _letzter && _vorletzter && abstand(_letzter, _vorletzter) > DETEKTOR_SPRUNG_CM &&
+        abstand(_letzter, cm) > DETEKTOR_SPRUNG_CM && abstand(cm, _vorletzter) <= DETEKTOR_NACHBAR_CM) {
+      _spruenge++;
+    }
+    _vorletzter = _letzter;
+    _letzter = cm;
+
+    if (belegt && cm && abstand(cm, _klebt_wert) <= DETEKTOR_KLEBT_CM) {
+      if (_klebt < DETEKTOR_KLEBT_SWEEPS) _klebt++;
+    } else {
+      _klebt = 0;
+      _klebt_wert = cm;
+    }
+
+    if (++_sweeps < DETEKTOR_FENSTER) return false;
+    return fenster_bewerten();
+  }
+
+  bool gestoert() const { return _grund != DETEKTOR_OK; }
+  uint8_t grund() const { return _grund; }                     // DetektorFehler, verodert
+  uint8_t kein_echo_prozent() const { return _quote; }         // letztes Fenster
+  uint16_t stoerungen() const { return _stoerungen; }          // seit dem Start
+
+private:
+  static uint16_t abstand(uint16_t a, uint16_t b) { return a > b ? a - b : b - a; }
+
+  bool fenster_bewerten() {
+    uint8_t fehler = DETEKTOR_OK;
+    _quote = (uint16_t)_kein_echo * 100 / _sweeps;
+    if (_hintergrund && _quote >= DETEKTOR_KEIN_ECHO_PROZENT) fehler |= DETEKTOR_KEIN_ECHO;
+    if (_klebt >= DETEKTOR_KLEBT_SWEEPS) fehler |= DETEKTOR_KLEBT;
+    if (_wechsel > DETEKTOR_FLATTERN_MAX) fehler |= DETEKTOR_FLATTERT;
+    if (_spruenge > DETEKTOR_SPRUENGE_MAX) fehler |= DETEKTOR_SPRINGT;
+    _sweeps = _kein_echo = _wechsel = _spruenge = 0;
+
+    bool vorher = gestoert();
+    if (fehler) {
+      _grund = fehler;
+      _sauber = 0;
+      if (!vorher) _stoerungen++;
+    } else if (vorher && ++_sauber >= DETEKTOR_ERHOLUNG) {
+      _grund = DETEKTOR_OK;
+    }
+    return gestoert() != vorher;
+  }
+
+  bool _hintergrund;
+  uint16_t _letzter = 0;
+  uint16_t _vorletzter = 0;
+  uint16_t _klebt_wert = 0;
+  uint16_t _klebt = 0;
+  uint8_t _sweeps = 0;
+  uint8_t _kein_echo = 0;
+  uint8_t _wechsel = 0;
+  uint8_t _spruenge = 0;
+  bool _belegt = false;
+  bool _gemessen = false;
+  uint8_t _grund = DETEKTOR_OK;
+  uint8_t _sauber = 0;
+  uint8_t _quote = 0;
+  uint16_t _stoerungen = 0;
+};
+
+#endif
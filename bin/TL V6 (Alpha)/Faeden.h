@@ -0,0 +1,64 @@
+/* =====================================================
+   KOOPERATIVE FÄDEN: LATENZ PRO AUFGABE (lib/Scheduler)
+   =====================================================
+
+   Mit KOOP_FAEDEN laufen Sensoren, Telemetrie und HMI
+   (Taster, Spur, Statusschild) in eigenen Fäden neben der
+   Phasen-Loop. Jeder Faden ist gerader Code, der mit
+   yield()/delay() abgibt - warten() und der Sensor-Sweep
+   müssen nicht mehr selbst Taster, Bahn und Vorrang abfragen.
+
+   Eine FadenUhr misst den Abstand zwischen zwei Durchläufen
+   einer Aufgabe. Das ist die längste Zeit, die z.B. eine
+   Tasterflanke auf ihre Verarbeitung warten kann. Gemessen
+   wird an denselben Stellen mit und ohne Fäden, so lassen
+   sich beide Varianten direkt vergleichen (LATENZ_MESSUNG).
+
+   Stackbedarf: lib/Scheduler füllt jeden Faden-Stack vor,
+   Scheduler.stackUnused() zeigt, wie viel davon nie benutzt
+   wurde. Die Statusausgabe zeigt "genutzt/Größe" - nach einem
+   langen Lauf FADEN_STACK_... auf genutzt + Reserve setzen.
+
+   Header-only, wird nur mit KOOP_FAEDEN oder LATENZ_MESSUNG
+   eingebunden.
+   ===================================================== */
+
+#ifndef FAEDEN_H
+#define FAEDEN_H
+
+#include <Arduino.h>
+
+class FadenUhr {
+public:
+  // Am Anfang jedes Durchlaufs aufrufen
+  void runde() {
+    uint32_t jetzt = micros();
+    if (_runden) {
+      uint32_t abstand = jetzt - _letzte;
+      _summe_us += abstand;
+      if (abstand > _max_us) _max_us = abstand;
+    }
+    _letzte = jetzt;
+    _runden++;
+  }
+
+  uint32_t runden() const { return _runden; }
+  uint32_t max_us() const { return _max_us; }
+  uint32_t mittel_us() const { return _runden > 1 ? _summe_us / (_runden - 1) : 0; }
+
+  // Nach jeder Statusausgabe neu anfangen, damit das Maximum
+  // zum letzten Intervall gehört und die Summe nicht überläuft
+  void zuruecksetzen() {
+    _runden = _runden ? 1 : 0;
+    _summe_us = 0;
+    _max_us = 0;
+  }
+
+private:
+  uint32_t _letzte = 0;
+  uint32_t _runden = 0;
+  uint32_t _summe_us = 0;
+  uint32_t _max_us = 0;
+};
+
+#endif
@@ -0,0 +1,66 @@
+/* =====================================================
+   IO-TREIBER (lib/IoAbstraction)
+   =====================================================
+
+   Lampen über eine BasicIoAbstraction statt direkt an GPIOs:
+     - ShiftRegisterIoAbstraction  74HC595-Kette (bis 4 Stück)
+     - MCP23017IoAbstraction       16 Pins pro I2C-Expander
+     - MultiIoAbstraction          mehrere davon hintereinander
+
+   Lampe n liegt auf Pin erster_pin + n der Abstraktion, die
+   Lampen müssen also fortlaufend verdrahtet sein.
+
+   Gebündelt: ausgeben() setzt nur die geänderten Bits im
+   Puffer der Abstraktion (writeValue) und ruft dann EINMAL
+   sync() auf. Die Multi-Abstraktion synct jedes Gerät genau
+   einmal -> ein Phasenwechsel kostet einen SPI-/I2C-Burst
+   pro Gerät statt einzelner Pin-Zugriffe. Die Dauer von
+   sync() wird mit micros() gemessen (letzte/maximale).
+
+   Header-only, wird nur eingebunden wenn LAMPEN_IOEXPANDER=1.
+   ===================================================== */
+
+#ifndef IO_TREIBER_H
+#define IO_TREIBER_H
+
+#include <Arduino.h>
+#include <IoAbstraction.h>
+#include "LampenAusgabe.h"
+
+class IoTreiber : public LampenTreiber {
+public:
+  IoTreiber(BasicIoAbstraction &io, pinid_t erster_pin)
+    : _io(io), _erster_pin(erster_pin) {}
+
+  void starten() {
+    for (uint8_t i = 0; i < ANZAHL_LAMPEN; i++) {
+      _io.pinDirection(_erster_pin + i, OUTPUT);
+    }
+  }
+
+  void ausgeben(LampenBild bild, LampenBild geaendert) {
+    for (uint8_t i = 0; i < ANZAHL_LAMPEN; i++) {
+      if (geaendert & ((LampenBild)1 << i)) {
+        _io.writeValue(_erster_pin + i, (bild >> i) & 1 ? HIGH : LOW);
+      }
+    }
+
+    uint32_t start = micros();
+    if (!_io.sync()) _fehler++;
+    _sync_dauer = micros() - start;
+    if (_sync_dauer > _sync_max) _sync_max = _sync_dauer;
+  }
+
+  uint16_t sync_dauer_us() const { return _sync_dauer; }
+  uint16_t sync_max_us() const { return _sync_max; }
+  uint16_t fehler() const { return _fehler; }   // fehlgeschlagene I2C-Übertragungen
+
+private:
+  BasicIoAbstraction &_io;
+  pinid_t _erster_pin;
+  uint16_t _sync_dauer = 0;
+  uint16_t _sync_max = 0;
+  uint16_t _fehler = 0;
+};
+
+#endif
@@ -0,0 +1,282 @@
+/* =====================================================
+   KALENDER: WOCHENPLAN NACH RTC (lib/TaskManagerIO)
+   =====================================================
+
+   Feste Termine in Ortszeit (MEZ/MESZ): Wochentage, Stunde,
+   Minute, Aktion - z.B. werktags 5:30 Tagesprogramm, 22:00
+   Nachtprogramm, sonntags Selbsttest der Detektoren. Die
+   Tabelle liegt im PROGMEM, die Uhr ist eine Funktion, die
+   UTC-Sekunden seit 1970 liefert (DS3231 läuft in UTC, die
+   Umstellung rechnet der Kalender selbst).
+
+   Kein Abfragen pro Loop: ein einziges TmLongSchedule-Ereignis
+   wird nach jedem Termin auf den nächsten gestellt, höchstens
+   aber KALENDER_MAX_SCHLAF_S weit. Beim Aufwachen liest der
+   Kalender die RTC neu, so kann millis() gegen die RTC laufen
+   oder überlaufen, ohne dass ein Termin mehr als den Gang
+   einer Stunde zu spät kommt.
+
+   Sommerzeit (EU): letzter Sonntag im März bis letzter Sonntag
+   im Oktober, jeweils 01:00 UTC.
+     - Termin in der Lücke (März, 02:00-03:00): läuft zur
+       Umstellung, also um 03:00 MESZ
+     - Termin in der doppelten Stunde (Oktober): nur beim
+       ersten Mal, noch in MESZ
+
+   Feiertage zählen als Sonntag (bundesweite: Neujahr, Karfreitag,
+   Ostermontag, 1. Mai, Himmelfahrt, Pfingstmontag, 3. Oktober,
+   1./2. Weihnachtstag), außer bei KALENDER_OHNE_FEIERTAG.
+
+   Beim Start (Stromausfall) spielt starten() von jeder Aktion
+   das letzte Auftreten der vergangenen KALENDER_NACHHOLEN_S
+   nach, in zeitlicher Reihenfolge und mit nachgeholt = true.
+
+   Header-only, wird nur mit KALENDER_AKTIV eingebunden.
+   Prüfung gegen die Zeitzonendatenbank: host/KalenderSim.cpp.
+   ===================================================== */
+
+#ifndef KALENDER_H
+#define KALENDER_H
+
+#include <Arduino.h>
+#include <TaskManagerIO.h>
+#include <TmLongSchedule.h>
+
+// Wochentage für KalenderEintrag::tage
+#define KALENDER_MO            0x01
+#define KALENDER_DI            0x02
+#define KALENDER_MI            0x04
+#define KALENDER_DO            0x08
+#define KALENDER_FR            0x10
+#define KALENDER_SA            0x20
+#define KALENDER_SO            0x40
+#define KALENDER_WERKTAGS      0x1F
+#define KALENDER_WOCHENENDE    0x60
+#define KALENDER_TAEGLICH      0x7F
+#define KALENDER_OHNE_FEIERTAG 0x80   // Feiertage wie ihr Wochentag behandeln
+
+#define KALENDER_TAG_S         86400UL
+#define KALENDER_MAX_SCHLAF_S  3600UL                   // spätestens dann RTC neu lesen
+#define KALENDER_NACHHOLEN_S   (7 * KALENDER_TAG_S)     // beim Start nachspielen
+#define KALENDER_SUCHE_TAGE    15                       // Wochentermin + Feiertage
+#define KALENDER_MAX_AKTIONEN  8                        // verschiedene Aktionen beim Nachholen
+#define KALENDER_NIE           0xFFFFFFFFUL
+
+struct KalenderEintrag {
+  uint8_t tage;      // KALENDER_MO..KALENDER_SO, verodert
+  uint8_t stunde;    // Ortszeit
+  uint8_t minute;
+  uint8_t aktion;
+};
+
+class Kalender : public Executable {
+public:
+  typedef uint32_t (*UhrFunktion)();    // UTC, Sekunden seit 1970
+  typedef void (*AktionFunktion)(uint8_t aktion, bool nachgeholt);
+
+  // tabelle im PROGMEM
+  Kalender(const KalenderEintrag *tabelle, uint8_t anzahl)
+      : _tabelle(tabelle), _anzahl(anzahl), _ereignis(KALENDER_MAX_SCHLAF_S * 1000UL, this) {}
+
+  void starten(UhrFunktion uhr, AktionFunktion aktion) {
+    _uhr = uhr;
+    _aktion = aktion;
+    uint32_t jetzt = _uhr();
+    nachholen(jetzt);
+    _zuletzt = jetzt;
+    zielen(jetzt);
+    taskManager.registerEvent(&_ereignis);
+  }
+
+  // Nach dem Stellen der RTC: übersprungene Termine nicht
+  // nachspielen, nur den nächsten neu anpeilen
+  void uhr_gestellt() {
+    _zuletzt = _uhr();
+    zielen(_zuletzt);
+  }
+
+  // Vom TmLongSchedule: alle Termine in (zuletzt, jetzt] der
+  // Reihe nach, dann den nächsten anpeilen
+  void exec() override {
+    _weckrufe++;
+    uint32_t jetzt = _uhr();
+    if (jetzt < _zuletzt) _zuletzt = jetzt;   // RTC ohne uhr_gestellt() zurückgestellt
+    uint32_t termin;
+    while ((termin = naechster_nach(_zuletzt)) <= jetzt) {
+      for (uint8_t i = 0; i < _anzahl; i++) {
+        if (termin_nach(i, _zuletzt) == termin) {
+          _ausgeloest++;
+          _aktion(eintrag(i).aktion, false);
+        }
+      }
+      _zuletzt = termin;
+    }
+    _zuletzt = jetzt;
+    zielen(jetzt);
+  }
+
+  uint32_t naechster() const { return _naechster; }    // UTC, KALENDER_NIE bei leerer Tabelle
+  uint32_t weckrufe() const { return _weckrufe; }
+  uint32_t ausgeloest() const { return _ausgeloest; }
+
+  // -------------------------
+  // ZEITRECHNUNG (auch für die Simulation)
+  // -------------------------
+  static bool sommerzeit(uint32_t utc) {
+    int16_t jahr;
+    uint8_t monat, tag;
+    datum(utc / KALENDER_TAG_S, jahr, monat, tag);
+    uint32_t beginn = letzter_sonntag(jahr, 3) * KALENDER_TAG_S + 3600;
+    uint32_t ende = letzter_sonntag(jahr, 10) * KALENDER_TAG_S + 3600;
+    return utc >= beginn && utc < ende;
+  }
+
+  // Ortszeit als Sekunden seit 1970 (wie UTC gezählt)
+  static uint32_t ortszeit(uint32_t utc) {
+    return utc + (sommerzeit(utc) ? 7200 : 3600);
+  }
+
+  static uint32_t utc_aus_ortszeit(uint32_t ort) {
+    uint32_t utc = ort - 7200;
+    if (sommerzeit(utc)) return utc;      // MESZ, in der doppelten Stunde das erste Mal
+    utc = ort - 3600;
+    if (!sommerzeit(utc)) return utc;     // MEZ
+    return utc - utc % 3600;              // Lücke: zur Umstellung
+  }
+
+  // Tage seit 1970 <-> Datum (gregorianisch, H. Hinnant)
+  static int32_t tage(int16_t jahr, uint8_t monat, uint8_t tag) {
+    jahr -= monat <= 2;
+    int32_t ara = (jahr >= 0 ? jahr : jahr - 399) / 400;
+    uint32_t jahr_in_ara = jahr - ara * 400;
+    uint32_t tag_im_jahr = (153 * (monat > 2 ? monat - 3 : monat + 9) + 2) / 5 + tag - 1;
+    uint32_t tag_in_ara = jahr_in_ara * 365 + jahr_in_ara / 4 - jahr_in_ara / 100 + tag_im_jahr;
+    return ara * 146097 + (int32_t)tag_in_ara - 719468;
+  }
+
+  static void datum(int32_t tage_seit_1970, int16_t &jahr, uint8_t &monat, uint8_t &tag) {
+    int32_t z = tage_seit_1970 + 719468;
+    int32_t ara = (z >= 0 ? z : z - 146096) / 146097;
+    uint32_t tag_in_ara = z - ara * 146097;
+    uint32_t jahr_in_ara = (tag_in_ara - tag_in_ara / 1460 + tag_in_ara / 36524 - tag_in_ara / 146096) / 365;
+    uint32_t tag_im_jahr = tag_in_ara - (365 * jahr_in_ara + jahr_in_ara / 4 - jahr_in_ara / 100);
+    uint8_t m = (5 * tag_im_jahr + 2) / 153;
+    tag = tag_im_jahr - (153 * m + 2) / 5 + 1;
+    monat = m < 10 ? m + 3 : m - 9;
+    jahr = jahr_in_ara + ara * 400 + (monat <= 2);
+  }
+
+  // 0 = Montag ... 6 = Sonntag (1.1.1970 war ein Donnerstag)
+  static uint8_t wochentag(int32_t tage_seit_1970) {
+    return (tage_seit_1970 + 3) % 7;
+  }
+
+  // Ostersonntag nach der Gaußschen Osterformel (gregorianisch)
+  static int32_t ostern(int16_t jahr) {
+    int16_t a = jahr % 19;
+    int16_t b = jahr / 100;
+    int16_t c = jahr % 100;
+    int16_t d = (19 * a + b - b / 4 - (b - (b + 8) / 25 + 1) / 3 + 15) % 30;
+    int16_t e = (32 + 2 * (b % 4) + 2 * (c / 4) - d - c % 4) % 7;
+    int16_t f = d + e - 7 * ((a + 11 * d + 22 * e) / 451) + 114;
+    return tage(jahr, f / 31, f % 31 + 1);
+  }
+
+  static bool feiertag(int32_t tage_seit_1970) {
+    int16_t jahr;
+    uint8_t monat, tag;
+    datum(tage_seit_1970, jahr, monat, tag);
+    uint16_t mmtt = monat * 100 + tag;
+    if (mmtt == 101 || mmtt == 501 || mmtt == 1003 || mmtt == 1225 || mmtt == 1226) return true;
+    int32_t abstand = tage_seit_1970 - ostern(jahr);
+    return abstand == -2 || abstand == 1 || abstand == 39 || abstand == 50;
+  }
+
+private:
+  static int32_t letzter_sonntag(int16_t jahr, uint8_t monat) {   // März und Oktober: 31 Tage
+    int32_t letzter = tage(jahr, monat, 31);
+    return letzter - (wochentag(letzter) + 1) % 7;
+  }
+
+  KalenderEintrag eintrag(uint8_t i) const {
+    KalenderEintrag e;
+    memcpy_P(&e, &_tabelle[i], sizeof(e));
+    return e;
+  }
+
+  static bool passt(uint8_t tage_maske, int32_t tag) {
+    uint8_t bit = (tage_maske & KALENDER_OHNE_FEIERTAG) || !feiertag(tag) ? 1 << wochentag(tag) : KALENDER_SO;
+    return tage_maske & bit;
+  }
+
+  // Nächstes Auftreten von Eintrag i echt nach utc
+  uint32_t termin_nach(uint8_t i, uint32_t utc) const {
+    KalenderEintrag e = eintrag(i);
+    int32_t tag = ortszeit(utc) / KALENDER_TAG_S;
+    for (uint8_t d = 0; d < KALENDER_SUCHE_TAGE; d++) {
+      if (!passt(e.tage, tag + d)) continue;
+      uint32_t termin = utc_aus_ortszeit((tag + d) * KALENDER_TAG_S + e.stunde * 3600UL + e.minute * 60UL);
+      if (termin > utc) return termin;
+    }
+    return KALENDER_NIE;
+  }
+
+  uint32_t naechster_nach(uint32_t utc) const {
+    uint32_t naechster = KALENDER_NIE;
+    for (uint8_t i = 0; i < _anzahl; i++) {
+      uint32_t termin = termin_nach(i, utc);
+      if (termin < naechster) naechster = termin;
+    }
+    return naechster;
+  }
+
+  // Ereignis auf den nächsten Termin stellen, höchstens KALENDER_MAX_SCHLAF_S
+  void zielen(uint32_t jetzt) {
+    _naechster = naechster_nach(jetzt);
+    uint32_t sekunden = _naechster - jetzt;
+    if (_naechster == KALENDER_NIE || sekunden > KALENDER_MAX_SCHLAF_S) sekunden = KALENDER_MAX_SCHLAF_S;
+    _ereignis.reschedule(sekunden * 1000UL);
+  }
+
+  // Letztes Auftreten jeder Aktion in den vergangenen KALENDER_NACHHOLEN_S
+  void nachholen(uint32_t jetzt) {
+    struct { uint32_t zeit; uint8_t aktion; } letzte[KALENDER_MAX_AKTIONEN];
+    uint8_t anzahl = 0;
+    uint32_t termin = jetzt - KALENDER_NACHHOLEN_S;
+    while ((termin = naechster_nach(termin)) <= jetzt) {
+      for (uint8_t i = 0; i < _anzahl; i++) {
+        if (termin_nach(i, termin - 1) != termin) continue;
+        uint8_t aktion = eintrag(i).aktion;
+        uint8_t k = 0;
+        while (k < anzahl && letzte[k].aktion != aktion) k++;
+        if (k == anzahl) {
+          if (anzahl == KALENDER_MAX_AKTIONEN) continue;
+          anzahl++;
+        }
+        letzte[k].zeit = termin;
+        letzte[k].aktion = aktion;
+      }
+    }
+    // Ältestes zuerst (Einfügen, höchstens KALENDER_MAX_AKTIONEN)
+    for (uint8_t k = 1; k < anzahl; k++) {
+      for (uint8_t j = k; j > 0 && letzte[j].zeit < letzte[j - 1].zeit; j--) {
+        auto tausch = letzte[j];
+        letzte[j] = letzte[j - 1];
+        letzte[j - 1] = tausch;
+      }
+    }
+    for (uint8_t k = 0; k < anzahl; k++) _aktion(letzte[k].aktion, true);
+  }
+
+  const KalenderEintrag *_tabelle;
+  uint8_t _anzahl;
+  TmLongSchedule _ereignis;
+  UhrFunktion _uhr = NULL;
+  AktionFunktion _aktion = NULL;
+  uint32_t _zuletzt = 0;
+  uint32_t _naechster = KALENDER_NIE;
+  uint32_t _weckrufe = 0;
+  uint32_t _ausgeloest = 0;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "LampenAusgabe.h"
+
+LampenAusgabe lampen;
+
+// =====================================================
+// GPIO-TREIBER
+// =====================================================
+GpioTreiber::GpioTreiber(const uint8_t *ampel_pins, const uint8_t *fussg_pins)
+  : _ampel_pins(ampel_pins), _fussg_pins(fussg_pins) {}
+
+uint8_t GpioTreiber::pin(uint8_t lampe) const {
+  if (lampe < ANZAHL_AMPELLAMPEN) return _ampel_pins[lampe];
+  return _fussg_pins[lampe - ANZAHL_AMPELLAMPEN];
+}
+
+void GpioTreiber::starten() {
+  for (uint8_t i = 0; i < ANZAHL_LAMPEN; i++) {
+    pinMode(pin(i), OUTPUT);
+  }
+}
+
+void GpioTreiber::ausgeben(LampenBild bild, LampenBild geaendert) {
+  // Nur geänderte Pins anfassen
+  for (uint8_t i = 0; i < ANZAHL_LAMPEN; i++) {
+    if (geaendert & ((LampenBild)1 << i)) {
+      digitalWrite(pin(i), (bild >> i) & 1 ? HIGH : LOW);
+    }
+  }
+}
+
+// =====================================================
+// LAMPENBILD
+// =====================================================
+void LampenAusgabe::starten(LampenTreiber &treiber) {
+  _treiber = &treiber;
+  _treiber->starten();
+  _erstes_bild = true;
+}
+
+void LampenAusgabe::setzen(uint8_t lampe, bool an) {
+  if (an) {
+    if (lampe < ANZAHL_AMPELLAMPEN && lampe % 3 == FARBE_GELB && !lesen(lampe)) _gelb_an[lampe / 3] = millis();
+    _bild |= ((LampenBild)1 << lampe);
+  } else {
+    _bild &= ~((LampenBild)1 << lampe);
+  }
+}
+
+bool LampenAusgabe::lesen(uint8_t lampe) const {
+  return (_bild >> lampe) & 1;
+}
+
+bool LampenAusgabe::ausgeben() {
+  if (!_treiber) return false;
+  _treiber->bearbeiten();
+
+  LampenBild bild = _bild;
+  LampenBild geaendert = bild ^ _gezeigt;
+  if (_erstes_bild) {
+    // Nach dem Start einmal alles schreiben
+    geaendert = ((LampenBild)1 << ANZAHL_LAMPEN) - 1;
+    _erstes_bild = false;
+  }
+  if (!geaendert) return false;
+
+  _treiber->ausgeben(bild, geaendert);
+  _gezeigt = bild;
+  if (_beobachter) _beobachter(bild);
+  return true;
+}
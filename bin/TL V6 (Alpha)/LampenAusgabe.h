@@ -0,0 +1,108 @@
+/* =====================================================
+   LAMPENAUSGABE
+   =====================================================
+
+   Alle Lampen der Kreuzung als ein Bild (1 Bit pro Lampe).
+   Die Logik setzt nur Bits, ausgegeben wird gesammelt:
+   lampen.ausgeben() schickt das ganze Bild in EINEM Rutsch
+   an den Treiber - und nur wenn sich etwas geändert hat.
+
+   Lampennummern:
+     0..11  Hauptampeln   richtung*3 + farbe (Rot, Gelb, Grün)
+     12..19 Fußgänger     12 + richtung*2 + (Rot, Grün)
+
+   Treiber:
+     GpioTreiber      - eine Lampe pro Pin (Standard)
+     NeoPixelTreiber  - WS2812-Kette, siehe NeoPixelTreiber.h
+     IoTreiber        - Schieberegister/Portexpander, siehe IoTreiber.h
+   ===================================================== */
+
+#ifndef LAMPEN_AUSGABE_H
+#define LAMPEN_AUSGABE_H
+
+#include <Arduino.h>
+
+// Bis 6 Zufahrten passt das Bild in 32 Bit, bis 12 in 64 Bit
+// (z.B. 8 Zufahrten mit Fußgängerköpfen = 40 Lampen)
+#ifndef ANZAHL_RICHTUNGEN
+#define ANZAHL_RICHTUNGEN   4
+#endif
+#define ANZAHL_AMPELLAMPEN  (ANZAHL_RICHTUNGEN * 3)
+#define ANZAHL_FUSSGLAMPEN  (ANZAHL_RICHTUNGEN * 2)
+#define ANZAHL_LAMPEN       (ANZAHL_AMPELLAMPEN + ANZAHL_FUSSGLAMPEN)
+
+#if ANZAHL_LAMPEN <= 32
+typedef uint32_t LampenBild;   // Bit n = Lampe n an
+#else
+typedef uint64_t LampenBild;
+#endif
+
+// Farbindex innerhalb eines Ampelkopfs (wie AMPELN[][])
+enum LampenFarbe { FARBE_ROT, FARBE_GELB, FARBE_GRUEN };
+
+inline uint8_t lampe_ampel(uint8_t richtung, uint8_t farbe) {
+  return richtung * 3 + farbe;
+}
+
+inline uint8_t lampe_fussg(uint8_t richtung, bool gruen) {
+  return ANZAHL_AMPELLAMPEN + richtung * 2 + (gruen ? 1 : 0);
+}
+
+// -------------------------
+// TREIBER-SCHNITTSTELLE
+// -------------------------
+class LampenTreiber {
+public:
+  virtual void starten() = 0;
+  // Komplettes Bild ausgeben, "geaendert" markiert die Bits die sich
+  // seit der letzten Ausgabe geändert haben
+  virtual void ausgeben(LampenBild bild, LampenBild geaendert) = 0;
+  // Wird jede Loop aufgerufen (z.B. für Helligkeitsnachführung)
+  virtual void bearbeiten() {}
+};
+
+// -------------------------
+// GPIO-TREIBER (1 PIN PRO LAMPE)
+// -------------------------
+class GpioTreiber : public LampenTreiber {
+public:
+  // ampel_pins: [4][3] Rot/Gelb/Grün, fussg_pins: [4][2] Rot/Grün
+  GpioTreiber(const uint8_t *ampel_pins, const uint8_t *fussg_pins);
+  void starten();
+  void ausgeben(LampenBild bild, LampenBild geaendert);
+  uint8_t pin(uint8_t lampe) const;
+
+private:
+  const uint8_t *_ampel_pins;
+  const uint8_t *_fussg_pins;
+};
+
+// -------------------------
+// LAMPENBILD
+// -------------------------
+class LampenAusgabe {
+public:
+  void starten(LampenTreiber &treiber);
+  void setzen(uint8_t lampe, bool an);
+  bool lesen(uint8_t lampe) const;
+  LampenBild bild() const { return _bild; }
+  // Wie lange das Gelb der Richtung schon an ist (ms), für
+  // Vorrang/Bahnübergang: ein laufendes Gelb nicht abkürzen
+  uint32_t gelb_seit(uint8_t richtung) const { return millis() - _gelb_an[richtung]; }
+  // Gibt das Bild aus falls geändert - true wenn ausgegeben wurde
+  bool ausgeben();
+  // Wird nach jeder Ausgabe mit dem neuen Bild aufgerufen (z.B. Blackbox.h)
+  void beobachten(void (*beobachter)(LampenBild bild)) { _beobachter = beobachter; }
+
+private:
+  LampenTreiber *_treiber = NULL;
+  void (*_beobachter)(LampenBild bild) = NULL;
+  volatile LampenBild _bild = 0;
+  LampenBild _gezeigt = 0;
+  bool _erstes_bild = true;
+  uint32_t _gelb_an[ANZAHL_RICHTUNGEN] = {};
+};
+
+extern LampenAusgabe lampen;
+
+#endif
@@ -0,0 +1,107 @@
+/* =====================================================
+   NEOPIXEL-TREIBER (lib/Adafruit_NeoPixel)
+   =====================================================
+
+   Alle 20 Lampen als EINE WS2812-Kette an einem Pin:
+     Pixel n = Lampe n (Reihenfolge wie in LampenAusgabe.h)
+
+   - Das ganze Kreuzungsbild wird im Pixelpuffer gebaut und
+     mit einem einzigen show() rausgeschickt
+   - Helligkeit folgt dem Umgebungslicht (LDR am Analogpin),
+     umgerechnet über die Gamma-Tabelle der Library
+   - show() wird mit micros() gemessen (letzte/maximale Dauer).
+     Richtwert: 30 µs pro Pixel -> ca. 0.6 ms für 20 Pixel
+
+   Header-only, wird nur eingebunden wenn LAMPEN_NEOPIXEL=1.
+   ===================================================== */
+
+#ifndef NEOPIXEL_TREIBER_H
+#define NEOPIXEL_TREIBER_H
+
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include "LampenAusgabe.h"
+
+#define NEOPIXEL_HELL_MIN      40     // Nachts nicht ganz dunkel (Sichtbarkeit)
+#define NEOPIXEL_HELL_MAX      255
+#define NEOPIXEL_HELL_SCHRITT  8      // Hysterese gegen Flackern
+#define NEOPIXEL_LICHT_UPDATE  1000   // LDR-Abfrageintervall (ms)
+
+class NeoPixelTreiber : public LampenTreiber {
+public:
+  NeoPixelTreiber(uint8_t daten_pin, uint8_t lichtsensor_pin)
+    : _kette(ANZAHL_LAMPEN, daten_pin, NEO_GRB + NEO_KHZ800),
+      _lichtsensor_pin(lichtsensor_pin) {}
+
+  void starten() {
+    _kette.begin();
+    _helligkeit = helligkeit_messen();
+    _licht_geglaettet = _helligkeit;
+  }
+
+  void ausgeben(LampenBild bild, LampenBild) {
+    _bild = bild;
+    zeigen();
+  }
+
+  void bearbeiten() {
+    if (millis() - _letzte_lichtmessung < NEOPIXEL_LICHT_UPDATE) return;
+    _letzte_lichtmessung = millis();
+
+    // Exponentiell glätten (3/4 alt, 1/4 neu), dann mit Hysterese übernehmen
+    _licht_geglaettet = (_licht_geglaettet * 3 + helligkeit_messen()) / 4;
+    int16_t diff = (int16_t)_licht_geglaettet - _helligkeit;
+    if (diff >= NEOPIXEL_HELL_SCHRITT || diff <= -NEOPIXEL_HELL_SCHRITT) {
+      _helligkeit = _licht_geglaettet;
+      zeigen();
+    }
+  }
+
+  uint8_t helligkeit() const { return _helligkeit; }
+  uint16_t show_dauer_us() const { return _show_dauer; }
+  uint16_t show_max_us() const { return _show_max; }
+
+private:
+  // LDR gegen GND, Pullup-Widerstand: hell = niedriger Wert
+  uint8_t helligkeit_messen() {
+    uint16_t roh = analogRead(_lichtsensor_pin);
+    return map(1023 - roh, 0, 1023, NEOPIXEL_HELL_MIN, NEOPIXEL_HELL_MAX);
+  }
+
+  uint32_t lampenfarbe(uint8_t lampe) const {
+    uint8_t farbe;
+    if (lampe < ANZAHL_AMPELLAMPEN) {
+      farbe = lampe % 3;                  // 0 Rot, 1 Gelb, 2 Grün
+    } else {
+      farbe = (lampe - ANZAHL_AMPELLAMPEN) % 2 ? 2 : 0;   // Rot / Grün
+    }
+    // Lineare Helligkeit skalieren, dann gammakorrigieren
+    uint8_t h = _helligkeit;
+    switch (farbe) {
+      case 0:  return Adafruit_NeoPixel::gamma32(Adafruit_NeoPixel::Color(h, 0, 0));
+      case 1:  return Adafruit_NeoPixel::gamma32(Adafruit_NeoPixel::Color(h, (uint16_t)h * 160 / 255, 0));
+      default: return Adafruit_NeoPixel::gamma32(Adafruit_NeoPixel::Color(0, h, 0));
+    }
+  }
+
+  void zeigen() {
+    for (uint8_t i = 0; i < ANZAHL_LAMPEN; i++) {
+      _kette.setPixelColor(i, (_bild >> i) & 1 ? lampenfarbe(i) : 0);
+    }
+    uint32_t start = micros();
+    _kette.show();
+    _show_dauer = micros() - start;
+    if (_show_dauer > _show_max) _show_max = _show_dauer;
+  }
+
+  Adafruit_NeoPixel _kette;
+  uint8_t _lichtsensor_pin;
+  LampenBild _bild = 0;
+  uint8_t _helligkeit = NEOPIXEL_HELL_MAX;
+  uint16_t _licht_geglaettet = NEOPIXEL_HELL_MAX;
+  uint32_t _letzte_lichtmessung = 0;
+  uint16_t _show_dauer = 0;
+  uint16_t _show_max = 0;
+};
+
+#endif
@@ -0,0 +1,158 @@
+/* =====================================================
+   PHASENPLAN: SIGNALBILDER ALS KONSTANTE TABELLE
+   =====================================================
+
+   Ein Signalplan ist eine Folge von Phasen, jede Phase ein
+   Signalbild (Rot/Gelb/Grün pro Signalgruppe) mit Dauer:
+
+     constexpr PlanPhase PLAN[] PROGMEM = {
+       //          Dauer  Nord        Süd         Ost         West
+       plan_phase(10000, PLAN_GRUEN, PLAN_GRUEN, PLAN_ROT,   PLAN_ROT),
+       plan_phase( 3000, PLAN_GELB,  PLAN_GELB,  PLAN_ROT,   PLAN_ROT),
+       ...
+     };
+
+   Die Tabelle liegt im Flash (3 Byte pro Phase), die
+   Steuerung liest pro Loop genau einen Eintrag - feste
+   Laufzeit, egal wie lang der Plan ist.
+
+   Weil die Tabelle constexpr ist, prüft der Compiler sie
+   (static_assert im Sketch), der Plan läuft zyklisch:
+     plan_gruen_vertraeglich  nie Grün für feindliche Gruppen
+                              in derselben Phase
+     plan_gelb_vollstaendig   Grün endet nur über Gelb, das
+                              mindestens gelb_min dauert, und
+                              Gelb geht nicht zurück auf Grün
+     plan_zwischenzeiten      vom Ende eines Grüns bis zum
+                              Grün einer feindlichen Gruppe
+                              mindestens zwischenzeit_min
+
+   Feindliche Gruppen als 4x4-Bitmatrix, z.B.
+     plan_feindlich(0, 2) | plan_feindlich(1, 3) | ...
+
+   Geprüft wird der Plan, wie er in der Tabelle steht;
+   Umlaufoptimierung, Busvorrang und AT+FORCE verschieben nur
+   Grünzeiten und lassen Gelb und Reihenfolge unangetastet.
+
+   Nur C++11-constexpr (ein return pro Funktion), damit es
+   auch mit dem avr-gcc der Arduino-IDE geht.
+   ===================================================== */
+
+#ifndef PHASENPLAN_H
+#define PHASENPLAN_H
+
+#include <Arduino.h>
+
+#define PLAN_GRUPPEN 4   // Signalgruppen, je 2 Bit im Signalbild
+
+// Werte wie LICHTZUSTAND im Sketch
+enum PlanSignal : uint8_t {
+  PLAN_ROT   = 0,
+  PLAN_GELB  = 1,
+  PLAN_GRUEN = 2,
+};
+
+struct PlanPhase {
+  uint8_t bild;     // Gruppe g in Bit 2g..2g+1
+  uint16_t dauer;   // ms
+};
+
+constexpr PlanPhase plan_phase(uint16_t dauer, PlanSignal g0, PlanSignal g1, PlanSignal g2, PlanSignal g3) {
+  return PlanPhase{(uint8_t)(g0 | g1 << 2 | g2 << 4 | g3 << 6), dauer};
+}
+
+constexpr uint8_t plan_signal(uint8_t bild, uint8_t gruppe) {
+  return bild >> (2 * gruppe) & 3;
+}
+
+// Phase aus dem Flash
+inline uint8_t plan_bild_lesen(const PlanPhase *plan, uint8_t phase) {
+  return pgm_read_byte(&plan[phase].bild);
+}
+
+inline uint16_t plan_dauer_lesen(const PlanPhase *plan, uint8_t phase) {
+  return pgm_read_word(&plan[phase].dauer);
+}
+
+// -------------------------
+// STATISCHE PRÜFUNG
+// -------------------------
+constexpr uint16_t plan_feindlich(uint8_t a, uint8_t b) {
+  return 1 << (4 * a + b) | 1 << (4 * b + a);
+}
+
+// Gruppen, die gegen die Gruppe feindlich sind (Bitmaske)
+constexpr uint8_t plan_feinde(uint16_t feindlich, uint8_t gruppe) {
+  return feindlich >> (4 * gruppe) & 0x0F;
+}
+
+// Gruppen mit Grün im Signalbild (Bitmaske)
+constexpr uint8_t plan_gruen(uint8_t bild) {
+  return (plan_signal(bild, 0) == PLAN_GRUEN) | (plan_signal(bild, 1) == PLAN_GRUEN) << 1 |
+         (plan_signal(bild, 2) == PLAN_GRUEN) << 2 | (plan_signal(bild, 3) == PLAN_GRUEN) << 3;
+}
+
+constexpr bool plan_bild_vertraeglich(uint8_t gruen, uint16_t feindlich, uint8_t g = 0) {
+  return g >= PLAN_GRUPPEN ||
+         ((!(gruen >> g & 1) || !(gruen & plan_feinde(feindlich, g))) &&
+          plan_bild_vertraeglich(gruen, feindlich, g + 1));
+}
+
+template <size_t N>
+constexpr bool plan_gruen_vertraeglich(const PlanPhase (&plan)[N], uint16_t feindlich, size_t i = 0) {
+  return i >= N ||
+         (plan_bild_vertraeglich(plan_gruen(plan[i].bild), feindlich) &&
+          plan_gruen_vertraeglich(plan, feindlich, i + 1));
+}
+
+// Wie lange Gruppe g ab Phase i am Stück Gelb zeigt (zyklisch)
+template <size_t N>
+constexpr uint32_t plan_gelbzeit(const PlanPhase (&plan)[N], size_t i, uint8_t g, size_t schritte = N) {
+  return schritte == 0 || plan_signal(plan[i].bild, g) != PLAN_GELB
+             ? 0
+             : plan[i].dauer + plan_gelbzeit(plan, (i + 1) % N, g, schritte - 1);
+}
+
+template <size_t N>
+constexpr bool plan_uebergang_ok(const PlanPhase (&plan)[N], size_t i, uint8_t g, uint16_t gelb_min) {
+  return plan_signal(plan[i].bild, g) == PLAN_GRUEN
+             ? plan_signal(plan[(i + 1) % N].bild, g) == PLAN_GRUEN ||
+                   plan_gelbzeit(plan, (i + 1) % N, g) >= gelb_min
+             : plan_signal(plan[i].bild, g) != PLAN_GELB ||
+                   plan_signal(plan[(i + 1) % N].bild, g) != PLAN_GRUEN;
+}
+
+template <size_t N>
+constexpr bool plan_gelb_vollstaendig(const PlanPhase (&plan)[N], uint16_t gelb_min, size_t i = 0, uint8_t g = 0) {
+  return i >= N ||
+         (g >= PLAN_GRUPPEN ? plan_gelb_vollstaendig(plan, gelb_min, i + 1)
+                            : plan_uebergang_ok(plan, i, g, gelb_min) &&
+                                  plan_gelb_vollstaendig(plan, gelb_min, i, g + 1));
+}
+
+// Zeit ab Phase i, bis eine der Gruppen in feinde Grün bekommt
+template <size_t N>
+constexpr uint32_t plan_bis_gruen(const PlanPhase (&plan)[N], size_t i, uint8_t feinde, size_t schritte = N) {
+  return schritte == 0 || (plan_gruen(plan[i].bild) & feinde)
+             ? 0
+             : plan[i].dauer + plan_bis_gruen(plan, (i + 1) % N, feinde, schritte - 1);
+}
+
+template <size_t N>
+constexpr bool plan_zwischenzeit_ok(const PlanPhase (&plan)[N], size_t i, uint8_t g, uint16_t feindlich,
+                                    uint16_t zwischenzeit_min) {
+  return plan_signal(plan[i].bild, g) != PLAN_GRUEN || plan_signal(plan[(i + 1) % N].bild, g) == PLAN_GRUEN ||
+         !plan_feinde(feindlich, g) ||
+         plan_bis_gruen(plan, (i + 1) % N, plan_feinde(feindlich, g)) >= zwischenzeit_min;
+}
+
+template <size_t N>
+constexpr bool plan_zwischenzeiten(const PlanPhase (&plan)[N], uint16_t feindlich, uint16_t zwischenzeit_min,
+                                   size_t i = 0, uint8_t g = 0) {
+  return i >= N ||
+         (g >= PLAN_GRUPPEN ? plan_zwischenzeiten(plan, feindlich, zwischenzeit_min, i + 1)
+                            : plan_zwischenzeit_ok(plan, i, g, feindlich, zwischenzeit_min) &&
+                                  plan_zwischenzeiten(plan, feindlich, zwischenzeit_min, i, g + 1));
+}
+
+#endif
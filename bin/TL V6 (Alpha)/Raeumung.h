@@ -0,0 +1,84 @@
+/* =====================================================
+   GELBBILD VOR EINEM VORRANG
+   =====================================================
+
+   Gemeinsam für Vorrang.h und Bahnuebergang.h: welche
+   Zufahrten vor dem Vorrang Gelb zeigen müssen und wie
+   lange.
+
+     - Grün, das nicht bleiben darf -> volle Gelbzeit
+     - schon laufendes Gelb (z.B. aus dem Tagesplan oder
+       einem Vorrang davor) läuft nur noch seinen Rest bis
+       zur vollen Gelbzeit, wird aber nie abgekürzt
+     - Grün, das bleiben darf, bleibt Grün
+
+   Jede Zufahrt wird Rot, sobald ihr Gelb abgelaufen ist.
+   Das Bild ändert sich also auch mitten im Gelb, der
+   Aufrufer setzt es dafür in jeder Loop neu.
+
+   Header-only.
+   ===================================================== */
+
+#ifndef RAEUMUNG_H
+#define RAEUMUNG_H
+
+#include <Arduino.h>
+#include "LampenAusgabe.h"
+
+class Raeumung {
+public:
+  /* Nimmt das aktuelle Lampenbild auf. gruen_bleibt: Bit pro
+     Richtung, die ihr Grün behalten darf. Gibt true zurück
+     wenn eine Zufahrt Grün oder Gelb zeigt, die Rot werden muss. */
+  bool aufnehmen(uint8_t gruen_bleibt, uint16_t gelbzeit);
+
+  // Farbe der Hauptampel im Gelbbild (FARBE_...)
+  uint8_t farbe(uint8_t richtung) const;
+
+  // Alles Gelb abgelaufen
+  bool fertig() const { return millis() - _start >= _dauer; }
+
+  // Bit pro Richtung, die Grün oder Gelb zeigte und Rot wird
+  uint8_t offen() const { return _offen; }
+  // Bit pro Richtung, die Grün behält
+  uint8_t gruen() const { return _gruen; }
+
+private:
+  uint8_t _offen = 0;
+  uint8_t _gruen = 0;
+  uint16_t _gelb[ANZAHL_RICHTUNGEN] = {};   // Gelb ab _start (ms)
+  uint16_t _dauer = 0;
+  uint32_t _start = 0;
+};
+
+inline bool Raeumung::aufnehmen(uint8_t gruen_bleibt, uint16_t gelbzeit) {
+  _offen = 0;
+  _gruen = 0;
+  _dauer = 0;
+  _start = millis();
+  for (uint8_t r = 0; r < ANZAHL_RICHTUNGEN; r++) {
+    _gelb[r] = 0;
+    if (lampen.lesen(lampe_ampel(r, FARBE_GELB))) {
+      uint32_t an = lampen.gelb_seit(r);
+      _gelb[r] = an < gelbzeit ? gelbzeit - an : 0;
+      _offen |= 1 << r;
+    } else if (lampen.lesen(lampe_ampel(r, FARBE_GRUEN))) {
+      if (gruen_bleibt & (1 << r)) {
+        _gruen |= 1 << r;
+      } else {
+        _gelb[r] = gelbzeit;
+        _offen |= 1 << r;
+      }
+    }
+    if (_gelb[r] > _dauer) _dauer = _gelb[r];
+  }
+  return _offen != 0;
+}
+
+inline uint8_t Raeumung::farbe(uint8_t richtung) const {
+  if (millis() - _start < _gelb[richtung]) return FARBE_GELB;
+  if (_gruen & (1 << richtung)) return FARBE_GRUEN;
+  return FARBE_ROT;
+}
+
+#endif
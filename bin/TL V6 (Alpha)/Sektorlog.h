@@ -0,0 +1,298 @@
+/* =====================================================
+   SEKTORLOG: VORBELEGTE DATEI, ROHE SEKTOREN (lib/SdFat_-_Adafruit_Fork)
+   =====================================================
+
+   Über File.write() muss die FAT bei jedem neuen Cluster
+   suchen und ihren Cache zurückschreiben; billige Karten
+   stehen dabei 100 ms und länger, und ein Stromausfall
+   mitten drin kann die Datei zerstören.
+
+   Hier wird die Datei einmal in voller Größe angelegt
+   (FsFile::preAllocate, liegt damit am Stück) und nur ihr
+   Sektorbereich gemerkt (contiguousRange). Danach geht jeder
+   Sektor direkt mit SdCard::writeSector() auf die Karte - die
+   FAT wird nicht mehr angefasst. Geschrieben wird nur, wenn
+   die Karte nicht mehr programmiert (isBusy), sonst im
+   nächsten Aufruf: die Loop wartet nie auf die Karte.
+   Dafür muss das Projekt mit dem Build-Flag
+     -DCHECK_FLASH_PROGRAMMING=0
+   gebaut werden (arduino-cli: --build-property
+   "compiler.cpp.extra_flags=-DCHECK_FLASH_PROGRAMMING=0"),
+   sonst wartet writeSector() selbst, bis der Sektor
+   programmiert ist. SdFatConfig.h bleibt ab Werk auf 1.
+   Der Preis: writeSector() meldet dann nur Fehler bei der
+   Übertragung, ein Fehler beim Programmieren fällt erst dem
+   Leser auf (Folgenummer/CRC). Und manche Karten gehen ohne
+   die Prüfung nicht in den Schlafmodus - mit Sparbetrieb
+   (NACHT_SPARBETRIEB) den Strom der Karte nachmessen.
+
+   Sektor (512 Byte):
+     "SLG1"          Kennung
+     uint32 lauf     pro Datei neu (alter Lauf + 1 bzw. Uhr)
+     uint32 folge    0, 1, 2, ...
+     uint16 laenge   belegte Nutzbytes
+     uint16 frei
+     uint32 crc      CRC-32 über Kopf (ohne crc) und Nutzbytes
+     492 Byte Nutzdaten (ein Bytestrom über die Sektoren)
+   Die Datei enthält hinter dem letzten geschriebenen Sektor
+   alte Daten der Karte. Der Leser hört beim ersten Sektor auf,
+   dessen Kennung, Lauf, Folgenummer oder CRC nicht passt:
+   nach einem Stromausfall bleibt alles bis zum letzten ganz
+   geschriebenen Sektor lesbar, verloren ist nur, was noch im
+   RAM stand (höchstens zwei Sektoren bzw. seit flush()).
+
+   Ein nicht voller Sektor wird bei flush() versiegelt und
+   nie wieder beschrieben, also flush() nicht zu oft.
+   Schlägt writeSector() fehl, bleibt der Sektor im Puffer und
+   wird beim nächsten Aufruf auf denselben Kartensektor neu
+   geschrieben: keine Lücke, an der der Leser aufhören würde.
+
+   Header-only, wird nur eingebunden wenn SPUR_SEKTOREN=1.
+   ===================================================== */
+
+#ifndef SEKTORLOG_H
+#define SEKTORLOG_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+
+#if CHECK_FLASH_PROGRAMMING
+#warning "Sektorlog.h: SdFat mit CHECK_FLASH_PROGRAMMING, writeSector() wartet aufs Programmieren (Build-Flag -DCHECK_FLASH_PROGRAMMING=0)"
+#elif NACHT_SPARBETRIEB
+#warning "Sektorlog.h: ohne CHECK_FLASH_PROGRAMMING schlafen manche Karten nicht, Kartenstrom im Sparbetrieb nachmessen"
+#endif
+
+#define SEKTOR_BYTES      512
+#define SEKTOR_KOPF       20
+#define SEKTOR_NUTZBYTES  (SEKTOR_BYTES - SEKTOR_KOPF)
+#define SEKTOR_PUFFER     2      // versiegelt + in Arbeit
+#define SEKTOR_STOPP_MS   500    // close(): so lange auf die Karte warten
+
+static const char SEKTOR_KENNUNG[4] = {'S', 'L', 'G', '1'};
+
+struct SektorKopf {
+  char kennung[4];
+  uint32_t lauf;
+  uint32_t folge;
+  uint16_t laenge;
+  uint16_t frei;
+  uint32_t crc;
+};
+
+// CRC-32 (wie Ethernet/zip), halbbyteweise: 64 Byte Tabelle
+inline uint32_t sektor_crc(uint32_t crc, const uint8_t *daten, uint16_t n) {
+  static const uint32_t TABELLE[16] PROGMEM = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+  };
+  crc = ~crc;
+  while (n--) {
+    crc ^= *daten++;
+    crc = pgm_read_dword(&TABELLE[crc & 0x0F]) ^ (crc >> 4);
+    crc = pgm_read_dword(&TABELLE[crc & 0x0F]) ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+inline uint32_t sektor_crc(const uint8_t *sektor) {
+  const SektorKopf *kopf = (const SektorKopf *)sektor;
+  uint32_t crc = sektor_crc(0, sektor, SEKTOR_KOPF - 4);
+  return sektor_crc(crc, sektor + SEKTOR_KOPF, min(kopf->laenge, (uint16_t)SEKTOR_NUTZBYTES));
+}
+
+// -------------------------
+// SCHREIBEN
+// -------------------------
+class SektorSchreiber {
+public:
+  // Datei neu anlegen und vorbelegen, danach keine FAT-Zugriffe mehr
+  bool anlegen(SdFs &sd, const char *name, uint32_t bytes) {
+    FsFile datei;
+    _karte = NULL;
+    sd.remove(name);
+    if (!datei.open(name, O_RDWR | O_CREAT | O_TRUNC)) return false;
+    bool ok = datei.preAllocate(bytes) && datei.contiguousRange(&_sektor, &_ende);
+    datei.close();
+    if (!ok) return false;
+    _karte = sd.card();
+    // Vorbelegt wird mit dem, was vorher in den Clustern stand.
+    // Liegt dort der Anfang einer alten Aufnahme, weiterzählen:
+    // nach dem Einschalten ist micros() jedes Mal fast gleich.
+    const SektorKopf *alt = (const SektorKopf *)_puffer[0];
+    if (_karte->readSector(_sektor, _puffer[0]) && !memcmp(alt->kennung, SEKTOR_KENNUNG, 4)) {
+      _lauf = alt->lauf + 1;
+    } else {
+      _lauf = micros() ^ _sektor ^ ((uint32_t)millis() << 16);
+    }
+    _folge = 0;
+    _fuellen = 0;
+    _belegt = 0;
+    _offen = 0;
+    return true;
+  }
+
+  size_t write(const uint8_t *daten, size_t n) {
+    size_t geschrieben = 0;
+    while (_karte && geschrieben < n) {
+      if (_belegt == SEKTOR_PUFFER) {
+        // Karte kommt nicht hinterher bzw. Datei voll
+        _verloren += n - geschrieben;
+        break;
+      }
+      uint16_t stueck = min((size_t)(SEKTOR_NUTZBYTES - _offen), n - geschrieben);
+      memcpy(_puffer[_fuellen] + SEKTOR_KOPF + _offen, daten + geschrieben, stueck);
+      _offen += stueck;
+      geschrieben += stueck;
+      if (_offen == SEKTOR_NUTZBYTES) versiegeln();
+    }
+    bearbeiten();
+    return geschrieben;
+  }
+
+  // Angefangenen Sektor abschließen (er wird nicht mehr ergänzt)
+  void flush() {
+    if (_offen && _belegt < SEKTOR_PUFFER) versiegeln();
+    bearbeiten();
+  }
+
+  // Höchstens einen versiegelten Sektor schreiben, nie warten
+  void bearbeiten() {
+    if (!_karte || !_belegt) return;
+    if (_sektor > _ende) {
+      _voll = true;
+      return;
+    }
+    if (_karte->isBusy()) {
+      _aufgeschoben++;
+      return;
+    }
+    uint8_t fertig = (_fuellen + SEKTOR_PUFFER - _belegt) % SEKTOR_PUFFER;
+    uint32_t start = micros();
+    if (_karte->writeSector(_sektor, _puffer[fertig])) {
+      _sektor++;
+      _sektoren++;
+      _belegt--;
+    } else {
+      _fehler++;   // bleibt belegt, nächster Aufruf schreibt denselben Sektor neu
+    }
+    uint32_t dauer = micros() - start;
+    if (dauer > _max_us) _max_us = dauer;
+  }
+
+  // Rest schreiben; wartet (begrenzt) auf die Karte
+  void close() {
+    flush();
+    uint32_t start = millis();
+    while (_karte && _belegt && !_voll && millis() - start < SEKTOR_STOPP_MS) bearbeiten();
+    _karte = NULL;
+  }
+
+  operator bool() const { return _karte != NULL; }
+
+  uint32_t sektoren() const { return _sektoren; }
+  uint32_t max_us() const { return _max_us; }            // längster writeSector()
+  uint32_t aufgeschoben() const { return _aufgeschoben; }  // Karte war noch belegt
+  uint32_t verloren() const { return _verloren; }          // Bytes ohne Platz
+  uint16_t fehler() const { return _fehler; }           // fehlgeschlagene, wiederholte writeSector()
+  bool voll() const { return _voll; }
+
+private:
+  void versiegeln() {
+    SektorKopf *kopf = (SektorKopf *)_puffer[_fuellen];
+    memcpy(kopf->kennung, SEKTOR_KENNUNG, 4);
+    kopf->lauf = _lauf;
+    kopf->folge = _folge++;
+    kopf->laenge = _offen;
+    kopf->frei = 0;
+    // Rest nullen: keine alten Bytes unter die CRC
+    memset(_puffer[_fuellen] + SEKTOR_KOPF + _offen, 0, SEKTOR_NUTZBYTES - _offen);
+    kopf->crc = sektor_crc(_puffer[_fuellen]);
+    _fuellen = (_fuellen + 1) % SEKTOR_PUFFER;
+    _belegt++;
+    _offen = 0;
+  }
+
+  SdCard *_karte = NULL;
+  uint8_t _puffer[SEKTOR_PUFFER][SEKTOR_BYTES];
+  uint8_t _fuellen = 0;      // Puffer, der gerade gefüllt wird
+  uint8_t _belegt = 0;       // versiegelt, noch nicht auf der Karte
+  uint16_t _offen = 0;       // Nutzbytes im Puffer _fuellen
+  uint32_t _sektor = 0;      // nächster Kartensektor
+  uint32_t _ende = 0;        // letzter Sektor der Datei
+  uint32_t _lauf = 0;
+  uint32_t _folge = 0;
+  uint32_t _sektoren = 0;
+  uint32_t _max_us = 0;
+  uint32_t _aufgeschoben = 0;
+  uint32_t _verloren = 0;
+  uint16_t _fehler = 0;
+  bool _voll = false;
+};
+
+// -------------------------
+// LESEN
+// -------------------------
+// Ebenfalls roh über die Karte: exFAT meldet vorbelegte
+// Dateien als leer, FsFile::read() käme nicht an die Daten.
+class SektorLeser {
+public:
+  bool oeffnen(SdFs &sd, const char *name) {
+    FsFile datei;
+    _karte = NULL;
+    if (!datei.open(name, O_RDONLY)) return false;
+    bool ok = datei.contiguousRange(&_sektor, &_ende);
+    datei.close();
+    if (!ok) return false;
+    _karte = sd.card();
+    _folge = 0;
+    _laenge = _gelesen = 0;
+    return laden();
+  }
+
+  // Nutzbytes in Folge, 0 nach dem letzten gültigen Sektor
+  int read(void *ziel, uint16_t n) {
+    uint8_t *z = (uint8_t *)ziel;
+    uint16_t gelesen = 0;
+    while (gelesen < n && (_gelesen < _laenge || laden())) {
+      uint16_t stueck = min((uint16_t)(n - gelesen), (uint16_t)(_laenge - _gelesen));
+      memcpy(z + gelesen, _puffer + SEKTOR_KOPF + _gelesen, stueck);
+      _gelesen += stueck;
+      gelesen += stueck;
+    }
+    return gelesen;
+  }
+
+  void close() { _karte = NULL; }
+  operator bool() const { return _karte != NULL; }
+
+  uint32_t sektoren() const { return _folge; }   // gültige bisher
+
+private:
+  bool laden() {
+    const SektorKopf *kopf = (const SektorKopf *)_puffer;
+    if (!_karte || _sektor > _ende || !_karte->readSector(_sektor, _puffer)) return false;
+    if (memcmp(kopf->kennung, SEKTOR_KENNUNG, 4) || kopf->laenge > SEKTOR_NUTZBYTES ||
+        (_folge && kopf->lauf != _lauf) || kopf->folge != _folge || kopf->crc != sektor_crc(_puffer)) {
+      _sektor = _ende + 1;   // Ende der Aufnahme
+      _laenge = _gelesen = 0;
+      return false;
+    }
+    _lauf = kopf->lauf;
+    _folge++;
+    _sektor++;
+    _laenge = kopf->laenge;
+    _gelesen = 0;
+    return true;
+  }
+
+  SdCard *_karte = NULL;
+  uint8_t _puffer[SEKTOR_BYTES];
+  uint32_t _sektor = 0;
+  uint32_t _ende = 0;
+  uint32_t _lauf = 0;
+  uint32_t _folge = 0;
+  uint16_t _laenge = 0;
+  uint16_t _gelesen = 0;
+};
+
+#endif
@@ -0,0 +1,252 @@
+/* =====================================================
+   SENSORSPUR: AUFNAHME UND WIEDERGABE (lib/SD)
+   =====================================================
+
+   Zum Einstellen der Erkennung ohne neben der Kreuzung zu
+   stehen: ein echter Tag Verkehr wird aufgenommen und kann
+   danach beliebig oft in die Steuerung eingespielt werden.
+
+   Aufnahme (SpurSchreiber):
+     - rohe Echozeit jedes Pings pro Zufahrt (µs, 0 = kein Echo)
+     - jede Tasterflanke (Fußgänger 0..3, Modustaster 4)
+     Die ISRs schreiben nur in einen Ringpuffer im RAM,
+     bearbeiten() leert ihn in der Loop auf die SD-Karte
+     (flush höchstens einmal pro SPUR_SYNC_MS).
+
+   Wiedergabe (SpurLeser):
+     - echo() ersetzt den Ping: steht das Echo der Zufahrt
+       als nächstes in der Spur an, wird bis dahin gewartet
+       (wie beim echten Ping). Sonst - der Algorithmus pingt
+       zu anderen Zeiten als bei der Aufnahme - kommt die
+       zuletzt aufgenommene Echozeit der Zufahrt. So taktet
+       die Loop wie bei der Aufnahme.
+     - fällige Tasterflanken gehen an einen Callback
+     Auf dem Mega läuft das in Echtzeit, auf dem PC (host/)
+     mit virtueller Uhr so schnell wie die CPU kann.
+
+   Dateiformat: "SPR1", dann Einträge zu 8 Byte:
+     uint32 Abstand zum vorigen Eintrag (µs)
+     uint8  Art (SPUR_ECHO / SPUR_TASTER)
+     uint8  Kanal (Zufahrt bzw. Taster)
+     uint16 Wert (Echozeit in µs bzw. Pegel)
+   Durch die Abstände läuft nichts über, auch nicht nach
+   71 Minuten, wenn micros() überläuft.
+
+   Mit SPUR_SEKTOREN=1 geht derselbe Bytestrom nicht über
+   SD/File, sondern in eine vorbelegte Datei aus rohen
+   Sektoren mit Folgenummer und CRC (Sektorlog.h): keine
+   FAT-Wartezeiten in der Loop, nach Stromausfall lesbar bis
+   zum letzten ganzen Sektor.
+
+   Header-only, wird nur eingebunden wenn SENSOR_SPUR != 0.
+   ===================================================== */
+
+#ifndef SENSOR_SPUR_H
+#define SENSOR_SPUR_H
+
+#include <Arduino.h>
+#if SPUR_SEKTOREN
+#include "Sektorlog.h"
+typedef SektorSchreiber SpurZiel;
+typedef SektorLeser SpurQuelle;
+#define SPUR_SYNC_MS  5000    // jeder Flush versiegelt einen Sektor (492 Byte Platz)
+#else
+#include <SD.h>
+typedef File SpurZiel;
+typedef File SpurQuelle;
+#define SPUR_SYNC_MS  1000    // SD-Flush höchstens so oft
+#endif
+
+#define SPUR_PUFFER   32      // Einträge im RAM (je 8 Byte)
+#define SPUR_KANAELE  4       // Zufahrten
+#define SPUR_PING_VORLAUF_US 5800   // so lange braucht der HC-SR04 max. bis zum Senden
+
+enum SpurArt : uint8_t { SPUR_ECHO = 1, SPUR_TASTER = 2 };
+
+struct SpurEintrag {
+  uint32_t abstand_us;
+  uint8_t art;
+  uint8_t kanal;
+  uint16_t wert;
+};
+
+static const char SPUR_KENNUNG[4] = {'S', 'P', 'R', '1'};
+
+// -------------------------
+// AUFNAHME
+// -------------------------
+class SpurSchreiber {
+public:
+#if SPUR_SEKTOREN
+  bool starten(SdFs &sd, const char *name, uint32_t bytes) {
+    _datei.anlegen(sd, name, bytes);
+    return beginnen();
+  }
+#else
+  bool starten(File datei) {
+    _datei = datei;
+    return beginnen();
+  }
+#endif
+
+  // Aus der Loop
+  void echo(uint8_t zufahrt, uint16_t echo_us) {
+    noInterrupts();
+    eintragen(SPUR_ECHO, zufahrt, echo_us);
+    interrupts();
+  }
+
+  // Aus einer ISR (Interrupts sind dort schon gesperrt)
+  void taster(uint8_t taster, uint8_t pegel) {
+    eintragen(SPUR_TASTER, taster, pegel);
+  }
+
+  // Puffer auf die Karte schreiben, einmal pro Loop aufrufen
+  void bearbeiten() {
+    if (!_datei) return;
+    while (_ende != _kopf) {
+      noInterrupts();
+      SpurEintrag e = _puffer[_ende];
+      interrupts();
+      _datei.write((const uint8_t *)&e, sizeof(e));
+      _ende = (_ende + 1) % SPUR_PUFFER;
+      _eintraege++;
+    }
+    if (millis() - _letzter_sync >= SPUR_SYNC_MS) {
+      _datei.flush();
+      _letzter_sync = millis();
+    }
+#if SPUR_SEKTOREN
+    _datei.bearbeiten();   // höchstens ein Sektor, nur wenn die Karte frei ist
+#endif
+  }
+
+  // In eine neue Datei weiterschreiben (z.B. eine pro Woche),
+  // was noch im Puffer steht, kommt in die alte
+#if SPUR_SEKTOREN
+  bool wechseln(SdFs &sd, const char *name, uint32_t bytes) {
+    bearbeiten();
+    _datei.close();
+    return starten(sd, name, bytes);
+  }
+#else
+  bool wechseln(File datei) {
+    bearbeiten();
+    _datei.close();
+    return starten(datei);
+  }
+#endif
+
+  uint32_t eintraege() const { return _eintraege; }
+  uint16_t verloren() const { return _verloren; }   // Puffer war voll
+  const SpurZiel &datei() const { return _datei; }
+
+private:
+  bool beginnen() {
+    if (!_datei || _datei.write((const uint8_t *)SPUR_KENNUNG, 4) != 4) return false;
+    _zeit = micros();
+    _letzter_sync = millis();
+    return true;
+  }
+
+  void eintragen(uint8_t art, uint8_t kanal, uint16_t wert) {
+    uint8_t naechster = (_kopf + 1) % SPUR_PUFFER;
+    if (naechster == _ende) {
+      // Zeit nicht weiterzählen, der nächste Abstand enthält die Lücke
+      _verloren++;
+      return;
+    }
+    uint32_t jetzt = micros();
+    _puffer[_kopf] = {jetzt - _zeit, art, kanal, wert};
+    _zeit = jetzt;
+    _kopf = naechster;
+  }
+
+  SpurZiel _datei;
+  SpurEintrag _puffer[SPUR_PUFFER];
+  volatile uint8_t _kopf = 0;
+  volatile uint8_t _ende = 0;
+  uint32_t _zeit = 0;
+  uint32_t _letzter_sync = 0;
+  uint32_t _eintraege = 0;
+  volatile uint16_t _verloren = 0;
+};
+
+// -------------------------
+// WIEDERGABE
+// -------------------------
+class SpurLeser {
+public:
+  typedef void (*TasterFunktion)(uint8_t taster, uint8_t pegel);
+
+#if SPUR_SEKTOREN
+  bool starten(SdFs &sd, const char *name, TasterFunktion taster) {
+    _datei.oeffnen(sd, name);
+    return beginnen(taster);
+  }
+#else
+  bool starten(File datei, TasterFunktion taster) {
+    _datei = datei;
+    return beginnen(taster);
+  }
+#endif
+
+  // Alle fälligen Einträge anwenden, einmal pro Loop aufrufen
+  void bearbeiten() {
+    while (_gueltig && micros() - _zeit >= _naechster.abstand_us) {
+      _zeit += _naechster.abstand_us;
+      if (_naechster.art == SPUR_ECHO && _naechster.kanal < SPUR_KANAELE) {
+        _echo[_naechster.kanal] = _naechster.wert;
+      } else if (_naechster.art == SPUR_TASTER && _taster) {
+        _taster(_naechster.kanal, _naechster.wert);
+      }
+      _gueltig = lesen();
+    }
+  }
+
+  // Ersatz für NewPing::ping(): blockiert so lange wie der Ping
+  uint16_t echo(uint8_t zufahrt, uint16_t max_us) {
+    if (zufahrt >= SPUR_KANAELE) return 0;
+    bearbeiten();
+    uint32_t rest = _naechster.abstand_us - (micros() - _zeit);
+    if (_gueltig && _naechster.art == SPUR_ECHO && _naechster.kanal == zufahrt &&
+        rest <= (uint32_t)max_us + SPUR_PING_VORLAUF_US) {
+      // Das aufgenommene Echo dieses Pings
+      warten(rest);
+      bearbeiten();
+    } else {
+      warten(_echo[zufahrt] ? _echo[zufahrt] : max_us);
+    }
+    return _echo[zufahrt];
+  }
+
+  bool beendet() const { return !_gueltig; }
+
+private:
+  bool beginnen(TasterFunktion taster) {
+    char kennung[4];
+    _taster = taster;
+    if (!_datei || _datei.read(kennung, 4) != 4 || memcmp(kennung, SPUR_KENNUNG, 4)) return false;
+    _zeit = micros();
+    _gueltig = lesen();
+    return true;
+  }
+
+  static void warten(uint32_t us) {
+    delay(us / 1000);
+    delayMicroseconds(us % 1000);
+  }
+
+  bool lesen() {
+    return _datei.read(&_naechster, sizeof(_naechster)) == sizeof(_naechster);
+  }
+
+  SpurQuelle _datei;
+  TasterFunktion _taster = NULL;
+  SpurEintrag _naechster;
+  bool _gueltig = false;
+  uint32_t _zeit = 0;
+  uint16_t _echo[SPUR_KANAELE] = {0};
+};
+
+#endif
@@ -0,0 +1,119 @@
+/* =====================================================
+   STROMSPARENDER NACHT-BLINKBETRIEB (lib/TaskScheduler)
+   =====================================================
+
+   Für Solaranlagen: solange nachts nur gelb geblinkt wird,
+   dreht die Loop nicht mehr alle 10 ms, sondern ein
+   TaskScheduler mit _TASK_SLEEP_ON_IDLE_RUN übernimmt:
+
+     - Task "blinken":  jede BLINK_INTERVALL eine Flanke
+     - Task "messen":   Sensor-Sweep, Intervall adaptiv:
+         SENSOR_UPDATE, nach SPAR_RUHE_SWEEPS leeren Sweeps
+         wird es pro leerem Sweep verdoppelt bis
+         SPAR_SENSOR_MAX, bei einem Fahrzeug geht es zurück
+     - Task "status":   Statusausgabe nur alle SPAR_STATUS_MS
+
+   Zwischen den Tasks schläft der Mega in SLEEP_MODE_IDLE.
+   Jeder Interrupt weckt ihn: Timer0 (millis) spätestens
+   nach ~1 ms, die Taster-ISRs sofort. Nach jedem Durchlauf
+   wird abbruch() gefragt, ein Tastendruck beendet den
+   Sparbetrieb also innerhalb eines Durchlaufs.
+
+   Die Ultraschallsensoren haben keinen Interrupt - ein
+   Fahrzeug wird erst beim nächsten Sweep erkannt, im
+   Rückfall also nach bis zu SPAR_SENSOR_MAX.
+
+   Header-only, wird nur eingebunden wenn NACHT_SPARBETRIEB=1.
+   TaskScheduler.h enthält Definitionen und darf nur einmal
+   eingebunden werden, deshalb steht es hier.
+   ===================================================== */
+
+#ifndef SPARBETRIEB_H
+#define SPARBETRIEB_H
+
+#define _TASK_SLEEP_ON_IDLE_RUN
+#include <TaskScheduler.h>
+#include <avr/sleep.h>
+
+#define SPAR_RUHE_SWEEPS   20      // so viele leere Sweeps mit normaler Rate
+#define SPAR_SENSOR_MAX    4000    // längstes Sweep-Intervall (ms)
+#define SPAR_STATUS_MS     10000   // Statusausgabe im Sparbetrieb (ms)
+
+class Sparbetrieb {
+public:
+  typedef void (*Aktion)();
+  typedef bool (*Messung)();       // true = Fahrzeug erkannt
+  typedef bool (*Abbruch)();
+
+  void starten(Aktion blinken, Messung messen, Aktion status,
+               uint16_t blink_ms, uint16_t sensor_ms) {
+    _instanz = this;
+    _messen = messen;
+    _sensor_ms = sensor_ms;
+    _blinken.set(blink_ms, TASK_FOREVER, blinken);
+    _sweep.set(sensor_ms, TASK_FOREVER, sweep);
+    _status.set(SPAR_STATUS_MS, TASK_FOREVER, status);
+    _planer.addTask(_blinken);
+    _planer.addTask(_sweep);
+    _planer.addTask(_status);
+    _planer.setSleepMethod(schlafen);
+  }
+
+  // Blockiert, bis abbruch() true liefert.
+  // naechste_flanke_ms: wann die Loop das nächste Mal geblinkt hätte
+  void laufen(Abbruch abbruch, uint16_t naechste_flanke_ms) {
+    _leer = 0;
+    _sweep.setInterval(_sensor_ms);
+    _blinken.enableDelayed(naechste_flanke_ms);
+    _sweep.enableDelayed(_sensor_ms);
+    _status.enableDelayed(SPAR_STATUS_MS);
+    while (!abbruch()) {
+      uint32_t start = micros();   // pro Durchlauf, läuft nachts nicht über
+      _planer.execute();
+      _lauf_us += micros() - start;
+    }
+    _planer.disableAll();
+  }
+
+  uint16_t sensor_intervall() { return _sweep.getInterval(); }
+  // Anteil der Sparbetriebszeit im Schlaf (Promille)
+  uint16_t schlaf_promille() const { return _lauf_us ? (uint64_t)_schlaf_us * 1000 / _lauf_us : 0; }
+
+private:
+  static void sweep() {
+    Sparbetrieb &s = *_instanz;
+    if (s._messen()) {
+      s._leer = 0;
+      s._sweep.setInterval(s._sensor_ms);
+    } else if (s._leer < SPAR_RUHE_SWEEPS) {
+      s._leer++;
+    } else {
+      s._sweep.setInterval(min(s._sweep.getInterval() * 2, (unsigned long)SPAR_SENSOR_MAX));
+    }
+  }
+
+  // Nur wenn der Durchlauf nichts zu tun hatte (TaskScheduler ruft das auf)
+  static void schlafen(unsigned long) {
+    uint32_t start = micros();
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    sleep_mode();                // weckt der nächste Interrupt
+    sleep_disable();
+    _instanz->_schlaf_us += micros() - start;
+  }
+
+  static Sparbetrieb *_instanz;
+  Scheduler _planer;
+  Task _blinken;
+  Task _sweep;
+  Task _status;
+  Messung _messen = NULL;
+  uint16_t _sensor_ms = 0;
+  uint8_t _leer = 0;
+  uint64_t _schlaf_us = 0;
+  uint64_t _lauf_us = 0;
+};
+
+Sparbetrieb *Sparbetrieb::_instanz = NULL;
+
+#endif
@@ -0,0 +1,221 @@
+/* =====================================================
+   LCD-STATUSSEITE (lib/LiquidCrystal_I2C)
+   =====================================================
+
+   20x4-Zeichen-LCD am PCF8574 (I2C, 100 kHz): billig, aber
+   langsam. Jedes Zeichen sind zwei Halbbytes mit Enable-Puls,
+   auch gebündelt noch ~0,6 ms auf dem Bus - die ganze Seite
+   kostet ~50 ms, viel zu viel für einen Loop-Durchlauf.
+
+   Deshalb zwei Schattenbilder im RAM (je 80 Byte):
+     - soll: die Seite, wie der Sketch sie zeichnet (Print,
+       setzen(spalte, zeile) statt setCursor)
+     - ist:  was gerade auf dem LCD steht
+   bearbeiten() schickt nur Zeichen, die sich unterscheiden,
+   und davon höchstens so viele wie übergeben (ein paar ms pro
+   Aufruf); der Rest kommt beim nächsten Mal. Ändert sich nur
+   die Uhrzeit, ist das ein setCursor und ein, zwei Zeichen.
+
+   setCursor nur, wo der Adresszähler des LCD nicht schon
+   steht. Er läuft nach jedem Zeichen selbst weiter, auch von
+   Zeile 0 nach 2, 2 nach 1, 1 nach 3 und 3 nach 0 (so liegen
+   die Zeilen im DDRAM) - die Schattenbilder sind in dieser
+   Reihenfolge abgelegt, gesucht wird ab dem Zähler. Ein
+   einzelnes gleiches Zeichen zwischen zwei geänderten wird
+   mitgeschickt, das kostet nicht mehr als ein setCursor.
+
+   Balken wie lib/LcdBarGraphX: Glyphen 1..4 (createChar) mit
+   1..4 Pixelspalten, das volle Zeichen 0xFF aus dem LCD-ROM,
+   also 5 Stufen pro Zeichen.
+
+   Zeichnet der Sketch neu, während ein Bild noch unterwegs
+   ist, steht kurz ein Mischbild da - für eine Statusseite egal.
+
+   Antwortet das LCD nicht (abgezogen, Bus gestört), bricht
+   bearbeiten() ab und zählt fehler() hoch. Ins Schattenbild
+   kommt nur, was die Bibliothek wirklich übertragen hat, der
+   Adresszähler gilt als unbekannt: ist das LCD wieder da,
+   geht es dort weiter, wo es stehen geblieben ist.
+
+   Benutzung:
+     LiquidCrystal_I2C lcd(0x27, 20, 4);
+     LcdSeite seite(lcd);
+     seite.starten();
+     ...
+     seite.leeren();                    // nur RAM
+     seite.setzen(0, 0);
+     seite.print(F("TAG"));
+     seite.balken(1, 1, 5, cm, 300);
+     seite.bearbeiten(5);               // jede Loop
+   ===================================================== */
+
+#ifndef STATUS_LCD_H
+#define STATUS_LCD_H
+
+#include <Arduino.h>
+#include <LiquidCrystal_I2C.h>
+
+#define LCD_SPALTEN     20
+#define LCD_ZEILEN      4
+#define LCD_ZELLEN      (LCD_SPALTEN * LCD_ZEILEN)
+#define LCD_LUECKE      1       // so viele gleiche Zeichen lieber mitschicken als setCursor
+#define LCD_UNBEKANNT   0xFF    // Adresszähler nicht im DDRAM (nach createChar)
+#define LCD_VOLL        0xFF    // volles Kästchen im Zeichen-ROM (A00 und A02)
+
+class LcdSeite : public Print {
+public:
+  LcdSeite(LiquidCrystal_I2C &lcd) : _lcd(lcd) {}
+
+  void starten() {
+    _lcd.init();   // löscht das LCD
+    _lcd.backlight();
+    uint8_t glyphe[8];
+    for (uint8_t spalten = 1; spalten <= 4; spalten++) {
+      memset(glyphe, (0x1F << (5 - spalten)) & 0x1F, sizeof(glyphe));
+      _lcd.createChar(spalten, glyphe);
+    }
+    fehler_pruefen();
+    memset(_ist, ' ', LCD_ZELLEN);
+    _adresse = LCD_UNBEKANNT;
+    leeren();
+  }
+
+  // -------------------------
+  // ZEICHNEN (NUR RAM)
+  // -------------------------
+  void leeren() {
+    memset(_soll, ' ', LCD_ZELLEN);
+    setzen(0, 0);
+  }
+
+  void setzen(uint8_t spalte, uint8_t zeile) {
+    _spalte = spalte;
+    _zeile = zeile % LCD_ZEILEN;
+  }
+
+  // Am Zeilenende wird abgeschnitten, nicht umgebrochen
+  size_t write(uint8_t zeichen) {
+    if (_spalte < LCD_SPALTEN) _soll[zelle(_spalte++, _zeile)] = zeichen;
+    return 1;
+  }
+  using Print::write;
+
+  // Balken über breite Zeichen, wert von 0..max
+  void balken(uint8_t spalte, uint8_t zeile, uint8_t breite, uint16_t wert, uint16_t max) {
+    uint16_t pixel = max ? (uint32_t)min(wert, max) * breite * 5 / max : 0;
+    setzen(spalte, zeile);
+    for (uint8_t i = 0; i < breite; i++) {
+      if (pixel >= 5) {
+        write(LCD_VOLL);
+        pixel -= 5;
+      } else {
+        write(pixel ? pixel : ' ');   // Glyphe 1..4
+        pixel = 0;
+      }
+    }
+  }
+
+  // Rechtsbündig in breite Zeichen, z.B. "  7"
+  void zahl(uint32_t wert, uint8_t breite, char fuellung = ' ') {
+    char ziffern[10];
+    uint8_t n = 0;
+    do {
+      ziffern[n++] = '0' + wert % 10;
+      wert /= 10;
+    } while (wert && n < sizeof(ziffern));
+    while (breite > n) {
+      write(fuellung);
+      breite--;
+    }
+    while (n) write(ziffern[--n]);
+  }
+
+  // -------------------------
+  // AUSGABE
+  // -------------------------
+  // Schickt höchstens budget Zeichen bzw. setCursor, gibt
+  // zurück, wie viele es waren (0: LCD ist aktuell)
+  uint8_t bearbeiten(uint8_t budget) {
+    uint32_t start = micros();
+    uint8_t gesendet = 0;
+    uint8_t lauf[LCD_ZELLEN];
+    budget = min(budget, (uint8_t)LCD_ZELLEN);
+    while (gesendet < budget) {
+      uint8_t ab = _adresse == LCD_UNBEKANNT ? 0 : _adresse;
+      uint8_t n = 0;
+      while (n < LCD_ZELLEN && _soll[(ab + n) % LCD_ZELLEN] == _ist[(ab + n) % LCD_ZELLEN]) n++;
+      if (n == LCD_ZELLEN) break;
+      uint8_t anfang = (ab + n) % LCD_ZELLEN;
+      if (anfang != _adresse) {
+        _lcd.setCursor(anfang % LCD_SPALTEN, zeilenfolge(anfang / LCD_SPALTEN));
+        if (fehler_pruefen()) break;
+        _adresse = anfang;
+        _setcursor++;
+        if (++gesendet == budget) break;
+      }
+      // Lauf bis zum letzten geänderten Zeichen vor einer Lücke
+      uint8_t laenge = 0, ende = 0;
+      while (gesendet + laenge < budget && laenge < LCD_ZELLEN && laenge - ende <= LCD_LUECKE) {
+        uint8_t z = (anfang + laenge) % LCD_ZELLEN;
+        lauf[laenge++] = _soll[z];
+        if (_soll[z] != _ist[z]) ende = laenge;
+      }
+      uint8_t geschickt = _lcd.write(lauf, ende);
+      for (uint8_t i = 0; i < geschickt; i++) _ist[(anfang + i) % LCD_ZELLEN] = lauf[i];
+      _adresse = (anfang + geschickt) % LCD_ZELLEN;
+      _zeichen += geschickt;
+      gesendet += geschickt;
+      if (fehler_pruefen()) break;
+    }
+    uint32_t dauer = micros() - start;
+    if (dauer > _max_us) _max_us = dauer;
+    return gesendet;
+  }
+
+  // Alles neu schicken (z.B. falls das LCD gestört wurde),
+  // verteilt über die nächsten Aufrufe von bearbeiten()
+  void auffrischen() {
+    memset(_ist, 0, LCD_ZELLEN);   // 0 zeichnet der Sketch nie
+    _adresse = LCD_UNBEKANNT;
+  }
+
+  bool aktuell() const { return !memcmp(_soll, _ist, LCD_ZELLEN); }
+  uint8_t zeichen_an(uint8_t spalte, uint8_t zeile) const { return _soll[zelle(spalte, zeile)]; }
+
+  uint32_t zeichen() const { return _zeichen; }
+  uint32_t setcursor() const { return _setcursor; }
+  uint32_t max_us() const { return _max_us; }          // längstes bearbeiten()
+  uint32_t fehler() const { return _fehler; }          // abgebrochene Übertragungen (LCD antwortet nicht)
+
+private:
+  // Fehler der Bibliothek abholen: der Adresszähler des LCD
+  // ist danach unbekannt
+  bool fehler_pruefen() {
+    if (!_lcd.transmissionError()) return false;
+    _lcd.clearTransmissionError();
+    _adresse = LCD_UNBEKANNT;
+    _fehler++;
+    return true;
+  }
+
+  // Zeile 0, 2, 1, 3 liegen im DDRAM am Stück - 1 und 2
+  // tauschen, das übersetzt in beide Richtungen
+  static uint8_t zeilenfolge(uint8_t i) { return i == 1 || i == 2 ? 3 - i : i; }
+
+  static uint8_t zelle(uint8_t spalte, uint8_t zeile) {
+    return zeilenfolge(zeile) * LCD_SPALTEN + spalte;
+  }
+
+  LiquidCrystal_I2C &_lcd;
+  uint8_t _soll[LCD_ZELLEN];
+  uint8_t _ist[LCD_ZELLEN];
+  uint8_t _spalte = 0;
+  uint8_t _zeile = 0;
+  uint8_t _adresse = LCD_UNBEKANNT;   // Zelle, auf die der Zähler des LCD zeigt
+  uint32_t _zeichen = 0;
+  uint32_t _setcursor = 0;
+  uint32_t _max_us = 0;
+  uint32_t _fehler = 0;
+};
+
+#endif
@@ -0,0 +1,144 @@
+/* =====================================================
+   E-PAPER STATUSSCHILD (lib/Adafruit_EPD)
+   =====================================================
+
+   Stromsparende Statusanzeige für abgelegene Kreuzungen
+   (z.B. Solarbetrieb im Nachtblinkmodus).
+
+   - Refresh NUR bei Modus- oder Planwechsel, nicht bei
+     jedem Phasenwechsel
+   - Änderungen werden gesammelt: höchstens EIN Refresh
+     pro SCHILD_INTERVALL, egal wie viele Wechsel kommen
+   - Teil-Refresh (displayPartial) wenn das Panel ihn
+     kann, sonst voller Refresh. In lib/Adafruit_EPD haben
+     ihn nur die UC8151D-, IL0373- und SSD1681-Treiber, z.B.
+     ThinkInk_290_Mono_M06 (UC8151D), nicht die SSD1680-Panels
+   - Framebuffer im SRAM des Breakouts (SRAM_CS), sonst legt
+     der Treiber ihn im RAM an (2,9": 296x128 Bit = 4,7 KB,
+     mehr als die Hälfte des Mega)
+   - Nach jedem Refresh geht das Panel in Deep-Sleep,
+     zwischen den Updates zieht es praktisch keinen Strom
+
+   Benutzung:
+     EPaperSchild<ThinkInk_290_Mono_M06> schild(DC, RST, CS, SRAM_CS, BUSY);
+     schild.starten(zeichne_schild, 60000);
+     ...
+     schild.melden(modus, plan);   // darf jede Loop aufgerufen werden
+     schild.bearbeiten();          // refresht nur wenn fällig
+   ===================================================== */
+
+#ifndef STATUS_SCHILD_H
+#define STATUS_SCHILD_H
+
+#include <Arduino.h>
+#include <Adafruit_ThinkInk.h>
+
+// Nach so vielen Teil-Refreshes einmal voll refreshen (gegen Ghosting)
+#define SCHILD_MAX_TEILUPDATES 20
+
+// Zeichenfunktion des Sketches: malt Modus/Plan in den Framebuffer
+typedef void (*SchildZeichner)(Adafruit_GFX &gfx, uint8_t modus, uint8_t plan);
+
+// -------------------------
+// PANEL-FÄHIGKEITEN
+// -------------------------
+// Nicht jeder Treiber hat displayPartial() - per SFINAE erkennen,
+// damit das Schild mit jedem ThinkInk-Panel kompiliert.
+// displayPartial() nimmt Endkoordinaten (einschließlich).
+template <class PANEL>
+auto schild_teilrefresh(PANEL &panel, int16_t b, int16_t h, int)
+    -> decltype(panel.displayPartial(0, 0, 0, 0), bool()) {
+  panel.displayPartial(0, 0, b - 1, h - 1);
+  return true;
+}
+
+template <class PANEL>
+bool schild_teilrefresh(PANEL &, int16_t, int16_t, long) {
+  return false;
+}
+
+// Für static_assert im Sketch: schild_kann_teilrefresh<PANEL>(0)
+template <class PANEL>
+constexpr auto schild_kann_teilrefresh(int) -> decltype(((PANEL *)0)->displayPartial(0, 0, 0, 0), bool()) {
+  return true;
+}
+
+template <class PANEL>
+constexpr bool schild_kann_teilrefresh(long) {
+  return false;
+}
+
+// -------------------------
+// STATUSSCHILD
+// -------------------------
+template <class PANEL>
+class EPaperSchild : public PANEL {
+public:
+  using PANEL::PANEL;
+
+  void starten(SchildZeichner zeichner, uint32_t intervall) {
+    _zeichner = zeichner;
+    _intervall = intervall;
+    // Teil-Refresh geht nur im Mono-Modus mit Partial-LUT
+    PANEL::begin(THINKINK_MONO);
+    _teil_moeglich = (this->_epd_partial_init_code != NULL);
+    _geaendert = true;        // erstes Bild sofort zeigen,
+    _teilupdates = SCHILD_MAX_TEILUPDATES;   // und voll: Teil-Refresh braucht ein Grundbild
+    _letzter_refresh = millis() - intervall;
+  }
+
+  /* Meldet den aktuellen Zustand. Billig, nur Vergleich -
+     der eigentliche Refresh passiert in bearbeiten(). */
+  void melden(uint8_t modus, uint8_t plan) {
+    if (modus != _modus || plan != _plan) {
+      _modus = modus;
+      _plan = plan;
+      _geaendert = true;
+    }
+  }
+
+  /* Refresht höchstens einmal pro Intervall und nur wenn sich
+     seit dem letzten Bild etwas geändert hat.
+     Gibt true zurück wenn ein Refresh gelaufen ist. */
+  bool bearbeiten() {
+    if (!_geaendert || millis() - _letzter_refresh < _intervall) {
+      return false;
+    }
+
+    // Zwischenstände verwerfen, nur der letzte Zustand zählt
+    _geaendert = false;
+    this->clearBuffer();
+    if (_zeichner) {
+      _zeichner(*this, _modus, _plan);
+    }
+
+    bool teil = _teil_moeglich && _teilupdates < SCHILD_MAX_TEILUPDATES &&
+                schild_teilrefresh(*this, this->width(), this->height(), 0);
+    if (teil) {
+      _teilupdates++;
+      this->powerDown();      // displayPartial() lässt das Panel wach
+    } else {
+      this->display(true);    // voller Refresh, danach Deep-Sleep
+      _teilupdates = 0;
+    }
+
+    _letzter_refresh = millis();
+    _refreshes++;
+    return true;
+  }
+
+  uint32_t refreshes() const { return _refreshes; }
+
+private:
+  SchildZeichner _zeichner = NULL;
+  uint32_t _intervall = 60000;
+  uint32_t _letzter_refresh = 0;
+  uint32_t _refreshes = 0;
+  uint8_t _modus = 0xFF;
+  uint8_t _plan = 0xFF;
+  uint8_t _teilupdates = 0;
+  bool _geaendert = false;
+  bool _teil_moeglich = false;
+};
+
+#endif
@@ -0,0 +1,29 @@
+/* =====================================================
+   TASTERFLANKEN
+   =====================================================
+
+   Die Taster-ISRs (und die ADC-ISR der Widerstandsleiter,
+   TasterLeiter.h) legen Flanken nur in einem gemeinsamen
+   Ringpuffer ab, verarbeitet wird in der Loop. So gehen
+   gleichzeitige Drücke nicht verloren und die Anforderungen
+   gehören allein der Loop. Mehrere ISRs dürfen gleichzeitig
+   ablegen (lib/SimpleCollections, MpscEventRing).
+
+   Header-only.
+   ===================================================== */
+
+#ifndef TASTER_FLANKE_H
+#define TASTER_FLANKE_H
+
+#include <Arduino.h>
+#include <SCLockFree.h>
+
+struct TasterFlanke {
+  uint8_t taster;
+  uint8_t pegel;  // LOW = gedrückt
+  uint32_t ms;    // Zeit der Flanke: die Loop kann Sekunden später abholen (E-Paper-Refresh)
+};
+
+typedef tccollection::MpscEventRing<TasterFlanke> TasterFlanken;
+
+#endif
@@ -0,0 +1,223 @@
+/* =====================================================
+   TASTER ALS WIDERSTANDSLEITER AN EINEM ANALOGPIN
+   =====================================================
+
+   Bis zu 8 Taster an einem ADC-Kanal (wie der Schalter-
+   prototyp in TL V0 an A0): ein Pull-up zieht den Pin
+   hoch, jede Taste schaltet einen anderen Widerstand nach
+   GND. Damit bleiben die fünf Interrupt-Pins frei.
+
+   Abtastung:
+     Der ADC läuft selbständig (LEITER_FREILAUF=1: Freilauf,
+     ~9,6 kHz bei Vorteiler 128; 0: bei jedem Timer0-Überlauf,
+     ~1 kHz - weckt den Sparbetrieb nicht zusätzlich).
+     Linksbündig, die ISR liest nur ADCH (8 Bit).
+
+   Dekodierung in der ISR:
+     - Schwellentabelle im PROGMEM: Obergrenze pro Taste,
+       aufsteigend, darüber = keine Taste. Gedrückt sein
+       kann nur eine Taste (die niedrigste gewinnt).
+     - Entprellen pro Taste mit Zeitstempel: ein Wechsel
+       zählt erst, wenn der Rohwert der Taste
+       LEITER_ENTPRELL_MS lang stabil war.
+     - Ergebnis als TasterFlanke in denselben Ringpuffer
+       wie die Taster-ISRs (TasterFlanke.h), mit der Zeit
+       der ersten Rohflanke: die Loop holt alle Flanken an
+       einer Stelle ab (Taste, Pegel: LOW = gedrückt).
+
+   Gemessen:
+     - Rechenzeit pro Abtastung (jede LEITER_MESSTEILER-te,
+       mit micros(); der Mittelwert ist trotz 4 µs Auflösung
+       erwartungstreu, ohne Ein-/Austritt der ISR)
+     - Latenz: erste Rohflanke bis Ringpuffer (Entprellen)
+
+   analogRead() geht nicht mehr, solange die Leiter läuft.
+
+   Header-only, wird nur eingebunden wenn TASTER_LEITER=1.
+   ===================================================== */
+
+#ifndef TASTER_LEITER_H
+#define TASTER_LEITER_H
+
+#include <Arduino.h>
+#include "TasterFlanke.h"
+
+#ifndef LEITER_FREILAUF
+#define LEITER_FREILAUF     1
+#endif
+#define LEITER_MAX_TASTEN   8
+#define LEITER_ENTPRELL_MS  20      // Rohwert so lange stabil
+#define LEITER_MESSTEILER   16      // jede n-te Abtastung messen (Zweierpotenz)
+#define LEITER_KEINE        0xFF
+
+class TasterLeiter {
+public:
+  TasterLeiter(const uint8_t *schwellen, uint8_t anzahl)
+    : _schwellen(schwellen), _anzahl(anzahl < LEITER_MAX_TASTEN ? anzahl : LEITER_MAX_TASTEN) {}
+
+  // flanken: gemeinsamer Ringpuffer, den die Loop abholt
+  void starten(uint8_t pin, TasterFlanken &flanken);
+
+  // Eine Abtastung (8 Bit), aus der ADC-ISR bzw. dem Simulator
+  void abtasten(uint8_t wert);
+
+  uint8_t dekodieren(uint8_t wert) const {
+    for (uint8_t i = 0; i < _anzahl; i++) {
+      if (wert < pgm_read_byte(&_schwellen[i])) return i;
+    }
+    return LEITER_KEINE;
+  }
+
+  uint32_t abtastungen() const;
+  // Mittlere Rechenzeit pro Abtastung in ns
+  uint16_t abtast_ns() const;
+  uint32_t latenz_letzte_us() const;
+  uint32_t latenz_max_us() const;
+  uint16_t verloren() const { return _verloren; }   // Ringpuffer war voll (zählt auch dort in dropped())
+
+  // Für die ADC-ISR. Als Funktion, damit der Header auch in
+  // mehreren Übersetzungseinheiten stehen darf (host/Zeitlinie.cpp)
+  static TasterLeiter *&instanz() {
+    static TasterLeiter *zeiger = NULL;
+    return zeiger;
+  }
+
+private:
+  void eintragen(uint8_t taste, bool gedrueckt);
+
+  const uint8_t *_schwellen;
+  uint8_t _anzahl;
+  TasterFlanken *_flanken = NULL;
+
+  // Nur in der ISR
+  uint8_t _roh = LEITER_KEINE;
+  uint8_t _entprellt = 0;           // Bitmaske gedrückter Tasten
+  uint32_t _seit[LEITER_MAX_TASTEN] = {0};       // letzter Rohwechsel (ms)
+  uint32_t _flanke_us[LEITER_MAX_TASTEN] = {0};  // erste Rohflanke nach einer Ruhezeit
+  uint32_t _flanke_ms[LEITER_MAX_TASTEN] = {0};  // dieselbe, für TasterFlanke::ms
+
+  volatile uint16_t _verloren = 0;
+  volatile uint32_t _abtastungen = 0;
+  volatile uint32_t _mess_summe_us = 0;
+  volatile uint16_t _messungen = 0;
+  volatile uint32_t _latenz_letzte = 0;
+  volatile uint32_t _latenz_max = 0;
+};
+
+// =====================================================
+// IMPLEMENTIERUNG
+// =====================================================
+inline void TasterLeiter::starten(uint8_t pin, TasterFlanken &flanken) {
+  _flanken = &flanken;
+  instanz() = this;
+#ifdef __AVR__
+  uint8_t kanal = pin >= A0 ? pin - A0 : pin;
+  // AVcc als Referenz, linksbündig -> ADCH reicht
+  ADMUX = _BV(REFS0) | _BV(ADLAR) | (kanal & 0x07);
+  ADCSRB = 0;                                    // ADTS = 0: Freilauf
+#ifdef MUX5
+  if (kanal & 0x08) ADCSRB |= _BV(MUX5);
+#endif
+#if !LEITER_FREILAUF
+  ADCSRB |= _BV(ADTS2);                          // Auslöser Timer0-Überlauf
+#endif
+  if (kanal < 8) DIDR0 |= _BV(kanal);            // digitalen Eingang abschalten
+  ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+#else
+  (void)pin;
+#endif
+}
+
+inline void TasterLeiter::abtasten(uint8_t wert) {
+  bool messen = (++_abtastungen & (LEITER_MESSTEILER - 1)) == 0;
+  uint16_t start = messen ? (uint16_t)micros() : 0;
+
+  uint8_t taste = dekodieren(wert);
+  uint32_t jetzt = millis();
+  if (taste != _roh) {
+    // Rohwechsel betrifft höchstens zwei Tasten: die alte und die neue
+    uint8_t geaendert = 0;
+    if (_roh != LEITER_KEINE) geaendert |= 1 << _roh;
+    if (taste != LEITER_KEINE) geaendert |= 1 << taste;
+    uint8_t roh_vorher = _roh == LEITER_KEINE ? 0 : 1 << _roh;
+    while (geaendert) {
+      uint8_t t = __builtin_ctz(geaendert);
+      geaendert &= geaendert - 1;
+      // Abweichung vom entprellten Zustand nach einer Ruhezeit:
+      // Latenz ab hier (Prellen setzt sie nicht neu)
+      bool abweichung = !((roh_vorher ^ _entprellt) & (1 << t));
+      if (abweichung && jetzt - _seit[t] >= LEITER_ENTPRELL_MS) {
+        _flanke_us[t] = micros();
+        _flanke_ms[t] = jetzt;
+      }
+      _seit[t] = jetzt;
+    }
+    _roh = taste;
+  }
+
+  // Nur Tasten, deren Rohwert vom entprellten Zustand abweicht
+  uint8_t offen = (taste == LEITER_KEINE ? 0 : 1 << taste) ^ _entprellt;
+  while (offen) {
+    uint8_t t = __builtin_ctz(offen);
+    offen &= offen - 1;
+    if (jetzt - _seit[t] >= LEITER_ENTPRELL_MS) {
+      _entprellt ^= 1 << t;
+      eintragen(t, _entprellt & (1 << t));
+    }
+  }
+
+  if (messen) {
+    _mess_summe_us += (uint16_t)((uint16_t)micros() - start);
+    if (++_messungen == 0x8000) {
+      // Halbieren statt überlaufen, der Mittelwert bleibt
+      _messungen >>= 1;
+      _mess_summe_us >>= 1;
+    }
+  }
+}
+
+inline void TasterLeiter::eintragen(uint8_t taste, bool gedrueckt) {
+  if (!_flanken || !_flanken->put(TasterFlanke{taste, (uint8_t)(gedrueckt ? LOW : HIGH), _flanke_ms[taste]})) {
+    _verloren++;
+    return;
+  }
+  _latenz_letzte = micros() - _flanke_us[taste];
+  if (_latenz_letzte > _latenz_max) _latenz_max = _latenz_letzte;
+}
+
+inline uint32_t TasterLeiter::latenz_letzte_us() const {
+  noInterrupts();
+  uint32_t l = _latenz_letzte;
+  interrupts();
+  return l;
+}
+
+inline uint32_t TasterLeiter::latenz_max_us() const {
+  noInterrupts();
+  uint32_t l = _latenz_max;
+  interrupts();
+  return l;
+}
+
+inline uint32_t TasterLeiter::abtastungen() const {
+  noInterrupts();
+  uint32_t n = _abtastungen;
+  interrupts();
+  return n;
+}
+
+inline uint16_t TasterLeiter::abtast_ns() const {
+  noInterrupts();
+  uint32_t summe = _mess_summe_us;
+  uint16_t n = _messungen;
+  interrupts();
+  return n ? summe * 1000 / n : 0;
+}
+
+#ifdef __AVR__
+ISR(ADC_vect) {
+  TasterLeiter::instanz()->abtasten(ADCH);
+}
+#endif
+
+#endif
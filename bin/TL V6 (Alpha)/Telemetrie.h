@@ -0,0 +1,59 @@
+/* =====================================================
+   TELEMETRIE-FRAME (nRF24L01, lib/RF24)
+   =====================================================
+
+   Kompakter Zustandsbericht einer Kreuzung an den
+   Sammler auf dem Linux-Rechner (host/Telemetrie.cpp).
+   Passt in eine RF24-Nutzlast (max. 32 Byte) und ist auf
+   AVR und x86/ARM gleich aufgebaut (packed, little endian).
+
+   Ein Frame pro TELEMETRIE_INTERVALL und Kreuzung. Die
+   Zähler laufen seit dem letzten Frame, so fehlt bei einem
+   verlorenen Frame nur dessen Zeitraum - die Lücke ist an
+   der Folgenummer zu sehen.
+
+   Funkadressen wie im multiceiverDemo: 6 Pipes am Sammler,
+   jede Pipe wird von mehreren Kreuzungen geteilt
+   (Kreuzung % 6), die Kreuzung steht im Frame.
+   ===================================================== */
+
+#ifndef TELEMETRIE_H
+#define TELEMETRIE_H
+
+#include <stdint.h>
+
+#define TELEMETRIE_VERSION     1
+#define TELEMETRIE_INTERVALL   1000     // ms zwischen zwei Frames
+#define TELEMETRIE_KREUZUNGEN  256      // Kreuzungsnummer ist ein Byte
+
+// Bits in TelemetrieFrame::ereignisse
+#define TEL_FUSSGAENGER  0x01   // Fußgängerphase lief
+#define TEL_VORRANG      0x02   // Einsatzfahrzeug-Vorrang lief
+#define TEL_BAHN         0x04   // Bahnübergang gesperrt
+#define TEL_BUS          0x08   // ÖPNV-Bevorrechtigung
+#define TEL_SENSORFEHLER 0x10   // mind. ein Detektor gestört
+
+struct __attribute__((packed)) TelemetrieFrame {
+  uint8_t version;           // TELEMETRIE_VERSION
+  uint8_t kreuzung;          // 0..255
+  uint16_t folge;            // +1 pro Frame
+  uint32_t zeit_ms;          // millis() der Steuerung
+  uint8_t modus;             // MODI (TAG/NACHT)
+  uint8_t phase;             // aktuelle_phase
+  uint8_t plan;              // PLAENE
+  uint8_t ereignisse;        // TEL_... seit dem letzten Frame
+  uint16_t fahrzeuge[4];     // erkannte Fahrzeuge seit dem letzten Frame
+  uint16_t umlauf_ds;        // Umlaufzeit (1/10 s)
+  uint16_t auslastung;       // Y in Promille (Umlauf.h), sonst 0
+  uint16_t latenz_max_us;    // größte Vorrang-Latenz seit dem letzten Frame
+  uint16_t reserve;
+};
+
+static_assert(sizeof(TelemetrieFrame) <= 32, "Frame passt nicht in eine RF24-Nutzlast");
+
+static const uint64_t TELEMETRIE_ADRESSEN[6] = {
+  0x7878787878LL, 0xB3B4B5B6F1LL, 0xB3B4B5B6CDLL,
+  0xB3B4B5B6A3LL, 0xB3B4B5B60FLL, 0xB3B4B5B605LL
+};
+
+#endif
@@ -0,0 +1,141 @@
+/* =====================================================
+   UMLAUFOPTIMIERUNG NACH WEBSTER
+   =====================================================
+
+   Statt fester TAGES_PHASEN werden Umlaufzeit und
+   Grünaufteilung aus den gezählten Fahrzeugen berechnet:
+
+     q   Verkehrsstärke pro Zufahrt (Fz/h), gleitender
+         Mittelwert über die letzten Umläufe
+     y   q / Sättigungsverkehrsstärke, pro Achse zählt die
+         stärkere Zufahrt, Y = Summe beider Achsen
+     C0  = (1,5 * L + 5 s) / (1 - Y)     L = Verlustzeit
+     g   = (C0 - L) * y / Y              effektive Grünzeit
+
+   Einmal pro Umlauf (umlauf_beendet()), nur Ganzzahlen und
+   immer dieselben Rechenschritte (keine datenabhängigen
+   Schleifen) -> feste Rechenzeit, gemessen mit micros().
+
+   Der neue Plan wird nicht sofort geschaltet: jede Grünzeit
+   geht pro Umlauf höchstens UMLAUF_SCHRITT weiter in
+   Richtung Ziel. Gelbzeiten bleiben wie im Startplan.
+
+   Phasen wie im Tagesprogramm:
+     0 = N/S Grün, 1 = N/S Gelb, 2 = O/W Grün, 3 = O/W Gelb
+   Zufahrten: 0 = Nord, 1 = Süd, 2 = Ost, 3 = West
+
+   Header-only, wird nur eingebunden wenn UMLAUF_OPTIMIERUNG=1.
+   ===================================================== */
+
+#ifndef UMLAUF_H
+#define UMLAUF_H
+
+#include <Arduino.h>
+
+#define UMLAUF_SAETTIGUNG   1800    // Fz/h Grün pro Fahrstreifen
+#define UMLAUF_VERLUST      4000    // Verlustzeit pro Phase: Anfahren + Räumen (ms)
+#define UMLAUF_MIN          30000   // kürzeste Umlaufzeit (ms)
+#define UMLAUF_MAX          90000   // längste Umlaufzeit (ms)
+#define UMLAUF_MIN_GRUEN    5000    // kein Grün wird kürzer (ms)
+#define UMLAUF_MAX_GRUEN    60000   // und keins länger (passt in uint16_t)
+#define UMLAUF_SCHRITT      2000    // max. Änderung pro Grünzeit und Umlauf (ms)
+#define UMLAUF_Y_MAX        900     // Sättigung deckeln (Promille), sonst C0 -> unendlich
+#define UMLAUF_GLAETTUNG    2       // gleitender Mittelwert: neuer Umlauf zählt 1/2^n
+
+class UmlaufOptimierer {
+public:
+  explicit UmlaufOptimierer(const uint16_t *startplan) {
+    for (uint8_t p = 0; p < 4; p++) _plan[p] = startplan[p];
+    _ziel[0] = _plan[0];
+    _ziel[1] = _plan[2];
+  }
+
+  // Ein Fahrzeug an der Zufahrt erkannt
+  void fahrzeug(uint8_t zufahrt) {
+    // Deckel, damit zaehler * 3600000 nicht überläuft
+    if (zufahrt < 4 && _zaehler[zufahrt] < 1000) _zaehler[zufahrt]++;
+  }
+
+  // Am Ende jedes Umlaufs (Wechsel auf Phase 0) aufrufen
+  void umlauf_beendet(uint32_t umlauf_ms) {
+    uint32_t start = micros();
+    if (umlauf_ms == 0) return;
+
+    // Verkehrsstärke pro Zufahrt schätzen und glätten
+    for (uint8_t z = 0; z < 4; z++) {
+      int32_t neu = min((uint32_t)_zaehler[z] * 3600000UL / umlauf_ms, 0xFFFFUL);
+      if (_umlaeufe == 0) _fluss[z] = neu;
+      else _fluss[z] += (neu - _fluss[z]) >> UMLAUF_GLAETTUNG;
+      _zaehler[z] = 0;
+    }
+    if (_umlaeufe < 0xFFFF) _umlaeufe++;
+
+    // Maßgebende Belastung pro Achse (Promille)
+    uint32_t y[2];
+    for (uint8_t g = 0; g < 2; g++) {
+      uint32_t q = max(_fluss[g * 2], _fluss[g * 2 + 1]);
+      y[g] = q * 1000 / UMLAUF_SAETTIGUNG;
+    }
+    uint32_t summe = y[0] + y[1];
+    if (summe > UMLAUF_Y_MAX) {
+      // Überlastet: Verhältnis behalten, Summe deckeln
+      y[0] = y[0] * UMLAUF_Y_MAX / summe;
+      y[1] = UMLAUF_Y_MAX - y[0];
+      summe = UMLAUF_Y_MAX;
+    }
+    _auslastung = summe;
+
+    // Webster
+    const uint32_t verlust = 2UL * UMLAUF_VERLUST;
+    uint32_t umlauf = (verlust * 3 / 2 + 5000) * 1000 / (1000 - summe);
+    umlauf = constrain(umlauf, (uint32_t)UMLAUF_MIN, (uint32_t)UMLAUF_MAX);
+    _ziel_umlauf = umlauf;
+
+    // Effektive Grünzeit aufteilen, dann in Signalzeit umrechnen:
+    // Grün + Gelb = effektives Grün + Verlustzeit
+    uint32_t effektiv = umlauf - verlust;
+    uint32_t g0 = summe ? effektiv * y[0] / summe : effektiv / 2;
+    _ziel[0] = gruenzeit(g0, _plan[1]);
+    _ziel[1] = gruenzeit(effektiv - g0, _plan[3]);
+
+    // Begrenzt in Richtung Ziel gehen
+    _plan[0] = schritt(_plan[0], _ziel[0]);
+    _plan[2] = schritt(_plan[2], _ziel[1]);
+
+    _rechenzeit = micros() - start;
+    if (_rechenzeit > _rechenzeit_max) _rechenzeit_max = _rechenzeit;
+  }
+
+  uint16_t dauer(uint8_t phase) const { return _plan[phase & 3]; }
+  uint32_t umlauf() const { return (uint32_t)_plan[0] + _plan[1] + _plan[2] + _plan[3]; }
+  uint32_t ziel_umlauf() const { return _ziel_umlauf; }
+  uint16_t ziel_gruen(uint8_t achse) const { return _ziel[achse & 1]; }
+  uint16_t fluss(uint8_t zufahrt) const { return _fluss[zufahrt & 3]; }   // Fz/h
+  uint16_t auslastung() const { return _auslastung; }                      // Y in Promille
+  uint16_t rechenzeit_us() const { return _rechenzeit; }
+  uint16_t rechenzeit_max_us() const { return _rechenzeit_max; }
+
+private:
+  static uint16_t gruenzeit(uint32_t effektiv, uint16_t gelb) {
+    int32_t gruen = (int32_t)effektiv + UMLAUF_VERLUST - gelb;
+    return constrain(gruen, (int32_t)UMLAUF_MIN_GRUEN, (int32_t)UMLAUF_MAX_GRUEN);
+  }
+
+  static uint16_t schritt(uint16_t ist, uint16_t ziel) {
+    if (ziel > ist + UMLAUF_SCHRITT) return ist + UMLAUF_SCHRITT;
+    if (ziel + UMLAUF_SCHRITT < ist) return ist - UMLAUF_SCHRITT;
+    return ziel;
+  }
+
+  uint16_t _plan[4];
+  uint16_t _ziel[2];
+  uint16_t _zaehler[4] = {0};
+  int32_t _fluss[4] = {0};
+  uint16_t _umlaeufe = 0;
+  uint16_t _auslastung = 0;
+  uint32_t _ziel_umlauf = 0;
+  uint16_t _rechenzeit = 0;
+  uint16_t _rechenzeit_max = 0;
+};
+
+#endif
@@ -0,0 +1,290 @@
+/* =====================================================
+   VORRANG FÜR EINSATZFAHRZEUGE (433 MHz, lib/rc-switch)
+   =====================================================
+
+   Ein Einsatzfahrzeug sendet einen Code per 433-MHz-Funk.
+   Ist der Code in der Freigabeliste, fährt die Kreuzung
+   auf kürzestem sicheren Weg Grün für seine Zufahrt:
+
+     1. Fußgänger sofort Rot
+     2. Feindliche Zufahrten die Grün zeigen -> Gelb, ein
+        schon laufendes Gelb (auch der Zielachse) läuft nur
+        zu Ende (Raeumung.h)
+        (entfällt wenn keine Zufahrt offen ist)
+     3. Alles-Rot-Räumzeit
+        (entfällt wenn die Zielachse schon Grün hat)
+     4. Zielachse Grün, solange Codes kommen + Haltezeit
+     5. Auslauf: Gelb, dann Alles-Rot -> Normalbetrieb
+
+   Latenz: vom Eintreffen des Codes bis zur Ausgabe des
+   ersten Räumbilds, gemessen in µs (letzte/max/Anzahl
+   über VORRANG_LATENZ_MAX_US). Eingetroffen ist der Code
+   in der Empfangs-ISR von RCSwitch, nicht erst beim
+   Abholen - die Wartezeit bis zur nächsten Abfrage
+   (z.B. während eines Sensor-Sweeps) zählt mit.
+
+   Header-only, wird nur eingebunden wenn VORRANG_AKTIV=1.
+
+   Empfänger:
+     RcEmpfaenger  - echter 433-MHz-Empfänger über RCSwitch
+     SimEmpfaenger - Software-Ersatz, Codes kommen per
+                     einspeisen() wie aus einer ISR (auf dem PC
+                     aus dem Uhrtakt, host/Zeitlinie.cpp; aus
+                     dem seriellen Monitor erst beim Lesen)
+   ===================================================== */
+
+#ifndef VORRANG_H
+#define VORRANG_H
+
+#include <Arduino.h>
+#include <RCSwitch.h>
+#include "LampenAusgabe.h"
+#include "Raeumung.h"
+
+#define VORRANG_GELBZEIT       3000    // Gelb für feindliche Zufahrten (ms)
+#define VORRANG_RAEUMZEIT      2000    // Alles-Rot (ms)
+#define VORRANG_HALTEZEIT      20000   // Grün halten nach letztem Code (ms)
+#define VORRANG_LATENZ_MAX_US  100000UL
+
+// Eintrag der Freigabeliste (liegt im PROGMEM)
+struct VorrangFreigabe {
+  uint32_t code;
+  uint8_t bits;
+  uint8_t richtung;
+};
+
+// -------------------------
+// EMPFÄNGER
+// -------------------------
+class VorrangEmpfaenger {
+public:
+  // Holt einen empfangenen Code ab, zeit_us = Empfangszeitpunkt
+  virtual bool abholen(uint32_t &code, uint8_t &bits, uint32_t &zeit_us) = 0;
+};
+
+class RcEmpfaenger : public VorrangEmpfaenger {
+public:
+  void starten(uint8_t pin) { _rc.enableReceive(digitalPinToInterrupt(pin)); }
+
+  bool abholen(uint32_t &code, uint8_t &bits, uint32_t &zeit_us) {
+    if (!_rc.available()) return false;
+    noInterrupts();   // Wert, Länge und Zeit vom selben Code
+    code = _rc.getReceivedValue();
+    bits = _rc.getReceivedBitlength();
+    zeit_us = _rc.getReceivedMicros();
+    _rc.resetAvailable();
+    interrupts();
+    return true;
+  }
+
+private:
+  RCSwitch _rc;
+};
+
+class SimEmpfaenger : public VorrangEmpfaenger {
+public:
+  // Eintreffen = jetzt, also wie die ISR aufrufen
+  void einspeisen(uint32_t code, uint8_t bits = 24) {
+    _code = code;
+    _bits = bits;
+    _zeit = micros();
+    _neu = true;
+  }
+
+  bool abholen(uint32_t &code, uint8_t &bits, uint32_t &zeit_us) {
+    if (!_neu) return false;
+    _neu = false;
+    code = _code;
+    bits = _bits;
+    zeit_us = _zeit;
+    return true;
+  }
+
+private:
+  volatile bool _neu = false;
+  uint32_t _code = 0;
+  uint8_t _bits = 0;
+  uint32_t _zeit = 0;
+};
+
+// -------------------------
+// VORRANGSTEUERUNG
+// -------------------------
+class Vorrang {
+public:
+  // fussg_phasen: Bit pro Richtung, solange die Fußgänger dort
+  // Grün haben oder noch räumen (Warnblinken)
+  Vorrang(const VorrangFreigabe *liste, uint8_t anzahl, const uint8_t &fussg_phasen)
+    : _liste(liste), _anzahl(anzahl), _fussg_phasen(fussg_phasen) {}
+
+  void starten(VorrangEmpfaenger &empfaenger) { _empfaenger = &empfaenger; }
+
+  /* Fragt den Empfänger ab. Billig genug für jede Loop und für
+     Warteschleifen. Gibt true zurück wenn eine GÜLTIGE Anforderung
+     neu eingetroffen ist. */
+  bool pruefen();
+
+  /* Treibt die Lampen solange Vorrang läuft.
+     Gibt false zurück sobald der Normalbetrieb wieder dran ist. */
+  bool bearbeiten();
+
+  bool aktiv() const { return _zustand != AUS; }
+  uint8_t richtung() const { return _richtung; }
+
+  uint32_t latenz_letzte_us() const { return _latenz_letzte; }
+  uint32_t latenz_max_us() const { return _latenz_max; }
+  uint16_t ueberschreitungen() const { return _ueberschreitungen; }
+  uint16_t abgelehnt() const { return _abgelehnt; }
+
+private:
+  enum Zustand { AUS, GELB, RAEUMEN, GRUEN, AUSLAUF_GELB, AUSLAUF_ROT };
+
+  int8_t richtung_fuer(uint32_t code, uint8_t bits) const;
+  void einleiten();
+  void wechseln(Zustand neu);
+  void bild_setzen();
+
+  const VorrangFreigabe *_liste;
+  uint8_t _anzahl;
+  const uint8_t &_fussg_phasen;
+  VorrangEmpfaenger *_empfaenger = NULL;
+
+  Zustand _zustand = AUS;
+  uint8_t _richtung = 0;
+  Raeumung _raeumung;             // Gelbbild vor dem Grün der Zielachse
+  uint32_t _zustand_seit = 0;
+  uint32_t _letzter_code = 0;
+
+  bool _messen = false;
+  uint32_t _empfang_us = 0;
+  uint32_t _latenz_letzte = 0;
+  uint32_t _latenz_max = 0;
+  uint16_t _ueberschreitungen = 0;
+  uint16_t _abgelehnt = 0;
+};
+
+// =====================================================
+// IMPLEMENTIERUNG
+// =====================================================
+inline int8_t Vorrang::richtung_fuer(uint32_t code, uint8_t bits) const {
+  for (uint8_t i = 0; i < _anzahl; i++) {
+    VorrangFreigabe f;
+    memcpy_P(&f, &_liste[i], sizeof(f));
+    if (f.code == code && f.bits == bits) return f.richtung;
+  }
+  return -1;
+}
+
+inline bool Vorrang::pruefen() {
+  uint32_t code, zeit;
+  uint8_t bits;
+  if (!_empfaenger || !_empfaenger->abholen(code, bits, zeit)) return false;
+
+  int8_t r = richtung_fuer(code, bits);
+  if (r < 0) {
+    _abgelehnt++;
+    return false;
+  }
+
+  _letzter_code = millis();
+  if (aktiv() && _zustand != AUSLAUF_GELB && _zustand != AUSLAUF_ROT && r == _richtung) {
+    return false;   // Wiederholung verlängert nur die Haltezeit
+  }
+
+  _richtung = r;
+  _empfang_us = zeit;
+  _messen = true;
+  einleiten();
+  return true;
+}
+
+// Kürzesten sicheren Weg zum Grün der Zielachse bestimmen
+inline void Vorrang::einleiten() {
+  uint8_t achse = _richtung & 0xFE;   // 0/1 = Nord/Süd, 2/3 = Ost/West
+  bool achse_gruen = lampen.lesen(lampe_ampel(_richtung, FARBE_GRUEN));
+  // Nicht das Lampenbild: im Warnblinken ist Fußgängergrün mal aus
+  bool fussg_gruen = _fussg_phasen != 0;
+
+  // Grün der Zielachse bleibt, jedes Gelb läuft zu Ende
+  if (_raeumung.aufnehmen(3 << achse, VORRANG_GELBZEIT)) {
+    wechseln(GELB);
+  } else if (achse_gruen && !fussg_gruen) {
+    wechseln(GRUEN);
+  } else {
+    wechseln(RAEUMEN);
+  }
+}
+
+inline void Vorrang::wechseln(Zustand neu) {
+  _zustand = neu;
+  _zustand_seit = millis();
+  if (neu == AUS) return;
+
+  bild_setzen();
+  lampen.ausgeben();
+
+  if (_messen) {
+    _messen = false;
+    _latenz_letzte = micros() - _empfang_us;
+    if (_latenz_letzte > _latenz_max) _latenz_max = _latenz_letzte;
+    if (_latenz_letzte > VORRANG_LATENZ_MAX_US) _ueberschreitungen++;
+  }
+}
+
+inline void Vorrang::bild_setzen() {
+  uint8_t achse = _richtung & 0xFE;
+  for (uint8_t r = 0; r < ANZAHL_RICHTUNGEN; r++) {
+    lampen.setzen(lampe_fussg(r, true), false);
+    lampen.setzen(lampe_fussg(r, false), true);
+
+    uint8_t farbe = FARBE_ROT;
+    bool ziel = (r & 0xFE) == achse;
+    switch (_zustand) {
+      case GELB:
+        farbe = _raeumung.farbe(r);
+        break;
+      case GRUEN:
+        if (ziel) farbe = FARBE_GRUEN;
+        break;
+      case AUSLAUF_GELB:
+        if (ziel) farbe = FARBE_GELB;
+        break;
+      default:
+        break;
+    }
+    lampen.setzen(lampe_ampel(r, FARBE_ROT), farbe == FARBE_ROT);
+    lampen.setzen(lampe_ampel(r, FARBE_GELB), farbe == FARBE_GELB);
+    lampen.setzen(lampe_ampel(r, FARBE_GRUEN), farbe == FARBE_GRUEN);
+  }
+}
+
+inline bool Vorrang::bearbeiten() {
+  uint32_t dauer = millis() - _zustand_seit;
+  switch (_zustand) {
+    case AUS:
+      return false;
+    case GELB:
+      if (_raeumung.fertig()) {
+        wechseln(RAEUMEN);
+      } else {
+        bild_setzen();   // jede Zufahrt wird Rot, sobald ihr Gelb um ist
+        lampen.ausgeben();
+      }
+      break;
+    case RAEUMEN:
+      if (dauer >= VORRANG_RAEUMZEIT) wechseln(GRUEN);
+      break;
+    case GRUEN:
+      if (millis() - _letzter_code >= VORRANG_HALTEZEIT) wechseln(AUSLAUF_GELB);
+      break;
+    case AUSLAUF_GELB:
+      if (dauer >= VORRANG_GELBZEIT) wechseln(AUSLAUF_ROT);
+      break;
+    case AUSLAUF_ROT:
+      if (dauer >= VORRANG_RAEUMZEIT) wechseln(AUS);
+      break;
+  }
+  return _zustand != AUS;
+}
+
+#endif
@@ -0,0 +1,67 @@
+/* Host-Ersatz für lib/Adafruit_NeoPixel, nur was NeoPixelTreiber.h
+   braucht: Pixelpuffer, Color(), gamma32() (Gamma 2,6 wie die
+   Tabelle der Library) und show().
+
+   - show() blockiert wie die WS2812-Ausgabe am Mega mit
+     gesperrten Interrupts: HOST_NEOPIXEL_PIXEL_US pro Pixel
+     plus HOST_NEOPIXEL_RESET_US Latch, die virtuelle Zeit
+     läuft so weit
+   - nach jedem show() bekommt host_neopixel_gezeigt (falls
+     gesetzt) die Kette, wie sie jetzt leuchtet
+   - host_neopixel_shows zählt mit */
+
+#ifndef HOST_ADAFRUIT_NEOPIXEL_H
+#define HOST_ADAFRUIT_NEOPIXEL_H
+
+#include <Arduino.h>
+#include <math.h>
+#include <vector>
+
+#define HOST_NEOPIXEL_PIXEL_US 30    // 24 Bit bei 800 kHz
+#define HOST_NEOPIXEL_RESET_US 50
+
+#define NEO_GRB    ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+
+typedef uint16_t neoPixelType;
+
+inline void (*host_neopixel_gezeigt)(const uint32_t *pixel, uint16_t anzahl) = NULL;
+inline uint32_t host_neopixel_shows = 0;
+
+class Adafruit_NeoPixel {
+public:
+  Adafruit_NeoPixel(uint16_t n, int16_t pin, neoPixelType typ) : _pixel(n, 0) {
+    (void)pin;
+    (void)typ;
+  }
+
+  void begin() {}
+
+  void setPixelColor(uint16_t n, uint32_t farbe) {
+    if (n < _pixel.size()) _pixel[n] = farbe;
+  }
+  uint32_t getPixelColor(uint16_t n) const { return n < _pixel.size() ? _pixel[n] : 0; }
+  uint16_t numPixels() const { return _pixel.size(); }
+
+  void show() {
+    host_zeit_vorstellen(_pixel.size() * HOST_NEOPIXEL_PIXEL_US + HOST_NEOPIXEL_RESET_US);
+    host_neopixel_shows++;
+    if (host_neopixel_gezeigt) host_neopixel_gezeigt(_pixel.data(), _pixel.size());
+  }
+
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+
+  static uint8_t gamma8(uint8_t x) { return pow(x / 255.0, 2.6) * 255.0 + 0.5; }
+
+  static uint32_t gamma32(uint32_t x) {
+    return (uint32_t)gamma8(x >> 24) << 24 | (uint32_t)gamma8(x >> 16) << 16 |
+           (uint32_t)gamma8(x >> 8) << 8 | gamma8(x);
+  }
+
+private:
+  std::vector<uint32_t> _pixel;
+};
+
+#endif
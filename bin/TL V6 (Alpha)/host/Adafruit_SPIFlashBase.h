@@ -0,0 +1,147 @@
+/* Host-Ersatz für Adafruit_SPIFlashBase.h, nur was Blackbox.h
+   braucht: ein NOR-Flash im RAM (host_flash, Standard 2 MB,
+   gelöscht = 0xFF) mit dem Zeitverhalten eines W25Q16:
+
+     - eraseSector() gibt das Kommando und kehrt zurück, das
+       Flash ist danach host_flash_loeschen_us beschäftigt
+     - writeBuffer() programmiert seitenweise (nur 1 -> 0),
+       danach HOST_FLASH_SEITE_US beschäftigt
+     - beide und readBuffer() warten vorher wie die echte Bibliothek
+       (waitUntilReady), dann läuft die virtuelle Zeit weiter und
+       host_flash_gewartet zählt mit
+     - SPI-Übertragung HOST_FLASH_BYTE_US pro Byte
+
+   Für Simulationen: Löschungen pro Sektor, programmierte
+   Bytes, nicht gelöschte überschriebene Bytes,
+   host_flash_schreibfehler (die nächsten Seiten schlagen fehl),
+   host_flash_abschalten() (Strom weg mitten in einem
+   Kommando: die Seite bzw. der Sektor bleibt halb fertig). */
+
+#ifndef HOST_SPIFLASHBASE_H
+#define HOST_SPIFLASHBASE_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <vector>
+
+enum {
+  SFLASH_BLOCK_SIZE = 64 * 1024UL,
+  SFLASH_SECTOR_SIZE = 4 * 1024,
+  SFLASH_PAGE_SIZE = 256,
+};
+
+#define HOST_FLASH_SEITE_US 700   // Page Program (typisch 0,7 ms)
+#define HOST_FLASH_BYTE_US  1     // 8 MHz SPI
+
+inline std::vector<uint8_t> host_flash(2UL * 1024 * 1024, 0xFF);
+inline std::vector<uint32_t> host_flash_loeschungen(2UL * 1024 * 1024 / SFLASH_SECTOR_SIZE, 0);
+inline uint32_t (*host_flash_loeschen_us)() = NULL;   // Standard 45 ms
+inline uint64_t host_flash_programmiert = 0;          // Bytes
+inline uint32_t host_flash_gewartet = 0;              // Kommandos, die warten mussten
+inline uint32_t host_flash_ungeloescht = 0;           // Bytes, programmiert ohne vorher gelöscht zu sein
+inline uint32_t host_flash_schreibfehler = 0;         // so viele Seiten schlagen noch fehl (SPI gestört)
+
+struct HostFlashKommando {
+  uint64_t belegt_bis = 0;
+  bool loeschen = false;
+  uint32_t adresse = 0;
+  uint32_t laenge = 0;
+  uint8_t alt[SFLASH_PAGE_SIZE];
+};
+inline HostFlashKommando host_flash_kommando;
+
+// Strom weg: ein laufendes Kommando bleibt halb fertig
+inline void host_flash_abschalten(uint32_t zufall) {
+  HostFlashKommando &k = host_flash_kommando;
+  if (host_zeit_us >= k.belegt_bis) return;
+  if (k.loeschen) {
+    // Halb gelöscht: ein Teil der Bits noch 0
+    for (uint32_t i = 0; i < SFLASH_SECTOR_SIZE; i += 1 + zufall % 7) {
+      host_flash[k.adresse + i] &= (uint8_t)(zufall >> (i % 24));
+    }
+  } else {
+    // Halb programmiert: ab einer Stelle noch der alte Inhalt
+    for (uint32_t i = zufall % (k.laenge + 1); i < k.laenge; i++) host_flash[k.adresse + i] = k.alt[i];
+  }
+  k.belegt_bis = 0;
+}
+
+class Adafruit_FlashTransport {};
+
+class Adafruit_FlashTransport_SPI : public Adafruit_FlashTransport {
+public:
+  Adafruit_FlashTransport_SPI(uint8_t ss, SPIClass &spi) { (void)ss; (void)spi; }
+};
+
+class Adafruit_SPIFlashBase {
+public:
+  Adafruit_SPIFlashBase() {}
+  Adafruit_SPIFlashBase(Adafruit_FlashTransport *transport) { (void)transport; }
+
+  bool begin() { return true; }
+  uint32_t size() { return host_flash.size(); }
+
+  bool isReady() {
+    host_zeit_vorstellen(2 * HOST_FLASH_BYTE_US);   // Read Status
+    return host_zeit_us >= host_flash_kommando.belegt_bis;
+  }
+
+  void waitUntilReady() {
+    if (host_zeit_us >= host_flash_kommando.belegt_bis) return;
+    host_flash_gewartet++;
+    host_zeit_vorstellen(host_flash_kommando.belegt_bis - host_zeit_us);
+  }
+
+  bool eraseSector(uint32_t sektor) {
+    waitUntilReady();
+    uint32_t adresse = sektor * SFLASH_SECTOR_SIZE;
+    if (adresse + SFLASH_SECTOR_SIZE > host_flash.size()) return false;
+    host_zeit_vorstellen(5 * HOST_FLASH_BYTE_US);
+    memset(&host_flash[adresse], 0xFF, SFLASH_SECTOR_SIZE);
+    host_flash_loeschungen[sektor]++;
+    host_flash_kommando.loeschen = true;
+    host_flash_kommando.adresse = adresse;
+    host_flash_kommando.belegt_bis = host_zeit_us + (host_flash_loeschen_us ? host_flash_loeschen_us() : 45000);
+    return true;
+  }
+
+  uint32_t writeBuffer(uint32_t adresse, const uint8_t *quelle, uint32_t n) {
+    uint32_t rest = n;
+    while (rest) {
+      waitUntilReady();
+      if (host_flash_schreibfehler) {
+        // wie writeMemory() == false: Abbruch, nichts programmiert
+        host_flash_schreibfehler--;
+        break;
+      }
+      uint32_t stueck = min(rest, (uint32_t)(SFLASH_PAGE_SIZE - adresse % SFLASH_PAGE_SIZE));
+      if (adresse + stueck > host_flash.size()) break;
+      host_zeit_vorstellen((4 + stueck) * HOST_FLASH_BYTE_US);
+      HostFlashKommando &k = host_flash_kommando;
+      memcpy(k.alt, &host_flash[adresse], stueck);
+      for (uint32_t i = 0; i < stueck; i++) {
+        if (host_flash[adresse + i] != 0xFF) host_flash_ungeloescht++;
+        host_flash[adresse + i] &= quelle[i];
+      }
+      host_flash_programmiert += stueck;
+      k.loeschen = false;
+      k.adresse = adresse;
+      k.laenge = stueck;
+      k.belegt_bis = host_zeit_us + HOST_FLASH_SEITE_US;
+      adresse += stueck;
+      quelle += stueck;
+      rest -= stueck;
+    }
+    return n - rest;
+  }
+
+  uint32_t readBuffer(uint32_t adresse, uint8_t *ziel, uint32_t n) {
+    waitUntilReady();
+    if (adresse + n > host_flash.size()) return 0;
+    host_zeit_vorstellen((4 + n) * HOST_FLASH_BYTE_US);
+    memcpy(ziel, &host_flash[adresse], n);
+    return n;
+  }
+};
+
+#endif
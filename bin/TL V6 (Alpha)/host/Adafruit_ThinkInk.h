@@ -0,0 +1,102 @@
+/* Host-Ersatz für lib/Adafruit_EPD (Adafruit_ThinkInk.h), nur was
+   StatusSchild.h und zeichne_schild() brauchen: ein 2,9"-Panel
+   (296x128, UC8151D wie ThinkInk_290_Mono_M06) mit einem
+   Adafruit_GFX, das nur den Textcursor mitführt.
+
+   - display() und displayPartial() blockieren wie am Mega
+     (busy_wait auf den BUSY-Pin), die virtuelle Zeit läuft um
+     HOST_EPD_VOLL_MS bzw. HOST_EPD_TEIL_MS weiter (Richtwerte)
+   - displayPartial() nimmt wie der Treiber Endkoordinaten
+     (x2, y2 einschließlich); liegen sie außerhalb des Panels
+     oder steht Text über den Rand, zählt host_epd_fehler
+   - ohne SRAM_CS (-1) zählt host_epd_ram_bytes den Framebuffer,
+     den der Treiber im RAM des Mega anlegen würde */
+
+#ifndef HOST_ADAFRUIT_THINKINK_H
+#define HOST_ADAFRUIT_THINKINK_H
+
+#include <Arduino.h>
+
+#define HOST_EPD_VOLL_MS 2000
+#define HOST_EPD_TEIL_MS 500
+
+enum { EPD_WHITE, EPD_BLACK, EPD_RED, EPD_GRAY, EPD_DARK, EPD_LIGHT };
+
+typedef enum { THINKINK_MONO, THINKINK_TRICOLOR, THINKINK_GRAYSCALE4, THINKINK_MONO_PARTIAL } thinkinkmode_t;
+
+inline uint32_t host_epd_voll = 0;
+inline uint32_t host_epd_teil = 0;
+inline uint32_t host_epd_fehler = 0;
+inline uint32_t host_epd_ram_bytes = 0;
+
+class Adafruit_GFX : public Print {
+public:
+  Adafruit_GFX(int16_t b, int16_t h) : _breite(b), _hoehe(h) {}
+
+  int16_t width() const { return _breite; }
+  int16_t height() const { return _hoehe; }
+  void setTextColor(uint16_t farbe) { (void)farbe; }
+  void setTextSize(uint8_t groesse) { _groesse = groesse ? groesse : 1; }
+  void setCursor(int16_t x, int16_t y) {
+    _x = x;
+    _y = y;
+  }
+
+  // Klassischer 5x7-Font: 6x8 Pixel pro Zeichen und Textgröße
+  size_t write(uint8_t c) {
+    if (c == '\n') {
+      _x = 0;
+      _y += 8 * _groesse;
+    } else if (c != '\r') {
+      if (_x < 0 || _y < 0 || _x + 6 * _groesse > _breite || _y + 8 * _groesse > _hoehe) host_epd_fehler++;
+      _x += 6 * _groesse;
+    }
+    return 1;
+  }
+  using Print::write;
+
+private:
+  int16_t _breite, _hoehe;
+  int16_t _x = 0, _y = 0;
+  uint8_t _groesse = 1;
+};
+
+class ThinkInk_290_Mono_M06 : public Adafruit_GFX {
+public:
+  ThinkInk_290_Mono_M06(int16_t dc, int16_t rst, int16_t cs, int16_t srcs, int16_t busy = -1)
+      : Adafruit_GFX(296, 128) {
+    (void)dc;
+    (void)rst;
+    (void)cs;
+    (void)busy;
+    if (srcs < 0) host_epd_ram_bytes += 296 * 128 / 8;
+  }
+
+  void begin(thinkinkmode_t mode = THINKINK_MONO) {
+    (void)mode;
+    _epd_partial_init_code = PARTIAL_INIT;
+  }
+
+  void clearBuffer() {}
+  void powerDown() {}
+
+  void display(bool schlafen = false) {
+    (void)schlafen;
+    host_epd_voll++;
+    host_zeit_vorstellen(HOST_EPD_VOLL_MS * 1000ULL);
+  }
+
+  void displayPartial(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
+    if (x1 > x2 || y1 > y2 || x2 >= (uint16_t)width() || y2 >= (uint16_t)height()) host_epd_fehler++;
+    host_epd_teil++;
+    host_zeit_vorstellen(HOST_EPD_TEIL_MS * 1000ULL);
+  }
+
+protected:
+  const uint8_t *_epd_partial_init_code = NULL;
+
+private:
+  static constexpr uint8_t PARTIAL_INIT[1] = {0};
+};
+
+#endif
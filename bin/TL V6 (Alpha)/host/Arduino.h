@@ -0,0 +1,294 @@
+/* =====================================================
+   HOST-ERSATZ FÜR Arduino.h
+   =====================================================
+
+   Damit die Module der Kreuzung (LampenAusgabe, Busvorrang,
+   ...) auch auf dem PC laufen - für Replays, Benchmarks
+   und Simulation. Die Arduino-IDE ignoriert diesen Ordner.
+
+   - Zeit ist virtuell: millis()/micros() zählen nur, wenn
+     host_zeit_vorstellen() oder delay() aufgerufen wird.
+     Wartet Code aktiv auf die Uhr (while millis() - start...),
+     rückt sie nach HOST_LEERLAUF_LESUNGEN Abfragen ohne
+     Fortschritt um 1 ms vor. host_ms_takt wird für jede
+     verstrichene Millisekunde aufgerufen. Mit Fäden
+     (host/Scheduler.h) gibt delay() ab, statt vorzustellen.
+   - Pins sind ein Array (host_pins / host_analog), optional
+     über ein HostPinBoard umgeleitet. attachInterrupt() merkt
+     sich die ISR, host_flanke() löst sie aus.
+   - Serial schreibt auf stdout (host_serial_stumm schaltet ab)
+     und liest aus host_serial_eingabe, Serial1 hat keine
+     Gegenstelle
+
+   Benutzung: mit -I host kompilieren, dann findet
+   #include <Arduino.h> diese Datei. Braucht C++17.
+   ===================================================== */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <type_traits>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+#define CHANGE        1
+#define FALLING       2
+#define RISING        3
+#define DEC           10
+#define HEX           16
+
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+
+#define PROGMEM
+#define F(s) (s)
+#define pgm_read_byte(a)  (*(const uint8_t *)(a))
+#define pgm_read_word(a)  (*(const uint16_t *)(a))
+#define pgm_read_dword(a) (*(const uint32_t *)(a))
+#define memcpy_P memcpy
+#define noInterrupts()
+#define interrupts()
+#define digitalPinToInterrupt(p) (p)
+
+// Als Templates statt Makros, sonst kollidiert es mit <chrono> & Co.
+// (Rückgabe als Wert: decltype(a < b ? a : b) wäre eine Referenz auf a/b)
+template <class A, class B> inline typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+template <class A, class B> inline typename std::common_type<A, B>::type max(A a, B b) { return a > b ? a : b; }
+#define bitRead(wert, bit)            (((wert) >> (bit)) & 0x01)
+#define bitSet(wert, bit)             ((wert) |= (1UL << (bit)))
+#define bitClear(wert, bit)           ((wert) &= ~(1UL << (bit)))
+#define bitWrite(wert, bit, bitwert)  ((bitwert) ? bitSet(wert, bit) : bitClear(wert, bit))
+#define constrain(x, a, b) ((x) < (a) ? (a) : ((x) > (b) ? (b) : (x)))
+
+// Aus binary.h nur die, die eingebundene Bibliotheken brauchen
+#define B00000001 1
+#define B00000010 2
+#define B00000100 4
+
+// -------------------------
+// VIRTUELLE ZEIT
+// -------------------------
+#define HOST_LEERLAUF_LESUNGEN 64
+
+inline uint64_t host_zeit_us = 0;
+inline uint16_t host_leerlauf = 0;
+inline void (*host_ms_takt)(uint32_t ms) = NULL;
+
+inline void host_zeit_vorstellen(uint64_t us) {
+  uint64_t ziel = host_zeit_us + us;
+  host_leerlauf = 0;
+  if (!host_ms_takt) {
+    host_zeit_us = ziel;
+    return;
+  }
+  // Millisekunde für Millisekunde, damit der Takt nichts verpasst
+  while (host_zeit_us / 1000 < ziel / 1000) {
+    host_zeit_us = (host_zeit_us / 1000 + 1) * 1000;
+    host_ms_takt((uint32_t)(host_zeit_us / 1000));
+  }
+  host_zeit_us = ziel;
+}
+
+inline void host_uhr_gelesen() {
+  if (++host_leerlauf >= HOST_LEERLAUF_LESUNGEN) host_zeit_vorstellen(1000);
+}
+
+inline unsigned long millis() { host_uhr_gelesen(); return (unsigned long)(uint32_t)(host_zeit_us / 1000); }
+inline unsigned long micros() { host_uhr_gelesen(); return (unsigned long)(uint32_t)host_zeit_us; }
+// Mit Fäden (host/Scheduler.h) wechseln yield() und delay() zum
+// nächsten Faden, delay() wartet dann wie der SAM-Core auf die Uhr
+inline void (*host_yield)() = NULL;
+inline void yield() { if (host_yield) host_yield(); }
+inline void delay(unsigned long ms) {
+  if (!host_yield) {
+    host_zeit_vorstellen((uint64_t)ms * 1000);
+    return;
+  }
+  uint32_t start = millis();
+  while (millis() - start < ms) host_yield();
+}
+inline void delayMicroseconds(unsigned int us) { host_zeit_vorstellen(us); }
+
+// -------------------------
+// PINS
+// -------------------------
+#define HOST_PINS 70
+
+// Umleitung der Digitalpins, z.B. auf IoAbstraction-Mocks
+class HostPinBoard {
+public:
+  virtual void modus(uint8_t pin, uint8_t modus) = 0;
+  virtual void schreiben(uint8_t pin, uint8_t wert) = 0;
+  virtual uint8_t lesen(uint8_t pin) = 0;
+};
+
+inline HostPinBoard *host_board = NULL;
+inline uint8_t host_pins[HOST_PINS] = {0};
+inline uint16_t host_analog[HOST_PINS] = {0};
+inline void (*host_isr[HOST_PINS])() = {NULL};
+inline uint8_t host_isr_modus[HOST_PINS] = {0};
+
+inline void pinMode(uint8_t pin, uint8_t modus) {
+  if (host_board) host_board->modus(pin, modus);
+}
+inline void digitalWrite(uint8_t pin, uint8_t wert) {
+  if (host_board) host_board->schreiben(pin, wert);
+  else if (pin < HOST_PINS) host_pins[pin] = wert;
+}
+inline int digitalRead(uint8_t pin) {
+  if (host_board) return host_board->lesen(pin);
+  return pin < HOST_PINS ? host_pins[pin] : LOW;
+}
+inline int analogRead(uint8_t pin) { return pin < HOST_PINS ? host_analog[pin] : 0; }
+inline void analogWrite(uint8_t pin, int wert) { digitalWrite(pin, wert > 0); }
+
+inline void attachInterrupt(uint8_t pin, void (*isr)(), int modus) {
+  if (pin >= HOST_PINS) return;
+  host_isr[pin] = isr;
+  host_isr_modus[pin] = modus;
+}
+inline void detachInterrupt(uint8_t pin) { if (pin < HOST_PINS) host_isr[pin] = NULL; }
+
+// Eingangsflanke von außen: ISR auslösen wie die Hardware
+inline void host_flanke(uint8_t pin, uint8_t alt, uint8_t neu) {
+  if (pin >= HOST_PINS || !host_isr[pin] || alt == neu) return;
+  uint8_t modus = host_isr_modus[pin];
+  if (modus == CHANGE || (modus == FALLING && !neu) || (modus == RISING && neu)) host_isr[pin]();
+}
+
+// Portregister gibt es nicht, writePort()/readPort() landen hier
+inline uint8_t host_port = 0;
+#define digitalPinToPort(p)       (p)
+#define portOutputRegister(p)     (&host_port)
+#define portInputRegister(p)      (&host_port)
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+inline void shiftOut(uint8_t daten, uint8_t takt, uint8_t reihenfolge, uint8_t wert) {
+  for (uint8_t i = 0; i < 8; i++) {
+    digitalWrite(daten, reihenfolge == LSBFIRST ? (wert >> i) & 1 : (wert >> (7 - i)) & 1);
+    digitalWrite(takt, HIGH);
+    digitalWrite(takt, LOW);
+  }
+}
+
+inline uint8_t shiftIn(uint8_t daten, uint8_t takt, uint8_t reihenfolge) {
+  uint8_t wert = 0;
+  for (uint8_t i = 0; i < 8; i++) {
+    digitalWrite(takt, HIGH);
+    if (reihenfolge == LSBFIRST) wert |= digitalRead(daten) << i;
+    else wert |= digitalRead(daten) << (7 - i);
+    digitalWrite(takt, LOW);
+  }
+  return wert;
+}
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// -------------------------
+// SERIAL -> STDOUT
+// -------------------------
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *puffer, size_t n) {
+    for (size_t i = 0; i < n; i++) write(puffer[i]);
+    return n;
+  }
+  virtual int availableForWrite() { return 0; }   // 0 = unbekannt, wie beim Arduino-Print
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(long n, int basis = DEC) { return zahl(n < 0, n < 0 ? -(unsigned long)n : n, basis); }
+  size_t print(unsigned long n, int basis = DEC) { return zahl(false, n, basis); }
+  size_t print(int n, int basis = DEC) { return print((long)n, basis); }
+  size_t print(unsigned int n, int basis = DEC) { return print((unsigned long)n, basis); }
+  size_t print(double d, int stellen = 2) {
+    char puffer[32];
+    snprintf(puffer, sizeof(puffer), "%.*f", stellen, d);
+    return print(puffer);
+  }
+  template <class T> size_t println(T wert) { size_t n = print(wert); return n + println(); }
+  template <class T> size_t println(T wert, int b) { size_t n = print(wert, b); return n + println(); }
+  size_t println() { return write('\n'); }
+
+private:
+  size_t zahl(bool negativ, unsigned long n, int basis) {
+    char puffer[40];
+    char *p = &puffer[sizeof(puffer) - 1];
+    *p = 0;
+    do {
+      uint8_t ziffer = n % basis;
+      *--p = ziffer < 10 ? '0' + ziffer : 'A' + ziffer - 10;
+      n /= basis;
+    } while (n);
+    if (negativ) *--p = '-';
+    return print(p);
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+inline bool host_serial_stumm = false;
+
+// Eingabe für Serial, z.B. AT-Befehle ("AT+PHASE?\r\n")
+inline const char *host_serial_eingabe = NULL;
+
+class HostSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  int available() { return host_serial_eingabe ? strlen(host_serial_eingabe) : 0; }
+  int read() { return available() ? (uint8_t)*host_serial_eingabe++ : -1; }
+  int peek() { return available() ? (uint8_t)*host_serial_eingabe : -1; }
+  void flush() { fflush(stdout); }
+  size_t write(uint8_t c) {
+    if (host_serial_stumm) return 1;
+    return fputc(c, stdout) == EOF ? 0 : 1;
+  }
+  using Print::write;
+  operator bool() { return true; }
+};
+
+inline HostSerial Serial;
+
+// Zweiter Port ohne Gegenstelle (z.B. ESP32-Begleiter): liest
+// nichts, schreibt ins Leere und zählt nur die Bytes
+class HostPort : public Stream {
+public:
+  void begin(unsigned long) {}
+  int available() { return 0; }
+  int read() { return -1; }
+  int peek() { return -1; }
+  size_t write(uint8_t) { gesendet++; return 1; }
+  using Print::write;
+  int availableForWrite() { return 63; }   // Leitung ist sofort wieder leer
+  operator bool() { return true; }
+  uint32_t gesendet = 0;
+};
+
+inline HostPort Serial1;
+
+#endif
@@ -0,0 +1,280 @@
+/* =====================================================
+   SIMULATION: ESP32-BEGLEITER ÜBER 1 MBAUD
+   =====================================================
+
+   Beide Enden der Verbindung aus Begleiter.h (SerialLink aus
+   lib/SerialCom) an einer simulierten UART, virtuelle Zeit:
+
+     - 1 MBaud, 8N1: ein Byte alle 10 us pro Richtung
+     - Sende- und Empfangspuffer 63 Bytes wie HardwareSerial
+       auf dem Mega; was bei vollem Empfangspuffer ankommt,
+       ist weg
+     - Bitfehler mit einstellbarer Rate
+     - der Mega ruft begleiter_bearbeiten() alle MEGA_TAKT_US
+       auf, mit "Sweep" steht er alle 500 ms für 70 ms (vier
+       Sonare ohne Echo), der ESP32 alle ESP_TAKT_US
+
+   Gemessen für jede Fenstergröße (Spalten: wdh = wiederholte
+   Frames, voll = Bytes in vollen Empfangspuffer, block = Bytes,
+   für die write() auf dem Mega gewartet hätte):
+     durchsatz  Mega schickt Berichte, sobald das Fenster Platz
+                hat - Nutzdaten gegen 100 kB/s auf der Leitung
+     umlauf     ESP32 schickt einen Auftrag, wartet auf den
+                Bericht dazu, dann den nächsten (Round Trip)
+   Geprüft wird, dass jede Nachricht genau einmal und in
+   Reihenfolge ankommt, auch bei Bitfehlern und Überlauf.
+
+   Bauen (aus diesem Ordner):
+     g++ -std=c++17 -O2 -I. -I.. -I../../../lib/SerialCom/src BegleiterSim.cpp -o begleiter_sim
+
+   Aufruf:
+     ./begleiter_sim [sekunden]
+   ===================================================== */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include "Begleiter.h"
+
+#define BYTE_US         10     // 1 MBaud, Start + 8 + Stopp
+#define UART_PUFFER     63     // HardwareSerial: 64er-Ring, ein Platz bleibt frei
+#define MEGA_TAKT_US    200
+#define ESP_TAKT_US     50
+#define SWEEP_ALLE_MS   500
+#define SWEEP_DAUER_MS  70
+
+// Wie im Sketch
+#define BEGLEITER_WIEDERHOLEN    20
+#define BEGLEITER_BYTES_PRO_TICK 40
+
+static uint32_t zufall_zustand = 1;
+static uint32_t zufall() {
+  zufall_zustand = zufall_zustand * 1664525UL + 1013904223UL;
+  return zufall_zustand >> 8;
+}
+
+// Eine Richtung der UART: Sendepuffer, Draht, Empfangspuffer
+struct Leitung {
+  std::deque<std::pair<uint64_t, uint8_t>> unterwegs;   // Ende des Stoppbits, Byte
+  std::deque<uint8_t> empfangen;
+  uint64_t frei_ab = 0;
+  uint32_t bitfehler_ppm = 0;   // pro Bit
+  uint32_t ueberlauf = 0;
+
+  uint32_t im_sendepuffer() const {
+    return frei_ab > host_zeit_us ? (frei_ab - host_zeit_us + BYTE_US - 1) / BYTE_US : 0;
+  }
+
+  void senden(uint8_t c) {
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      if (zufall() % 1000000 < bitfehler_ppm) c ^= 1 << bit;
+    }
+    frei_ab = max(frei_ab, host_zeit_us) + BYTE_US;
+    unterwegs.push_back({frei_ab, c});
+  }
+
+  void ankommen() {
+    while (!unterwegs.empty() && unterwegs.front().first <= host_zeit_us) {
+      if (empfangen.size() < UART_PUFFER) empfangen.push_back(unterwegs.front().second);
+      else ueberlauf++;
+      unterwegs.pop_front();
+    }
+  }
+};
+
+// Serial1 aus Sicht eines Boards
+class Anschluss : public Stream {
+public:
+  Anschluss(Leitung &rein, Leitung &raus) : _rein(rein), _raus(raus) {}
+  int available() {
+    _rein.ankommen();
+    return _rein.empfangen.size();
+  }
+  int read() {
+    if (!available()) return -1;
+    uint8_t c = _rein.empfangen.front();
+    _rein.empfangen.pop_front();
+    return c;
+  }
+  int peek() { return available() ? _rein.empfangen.front() : -1; }
+  size_t write(uint8_t c) {
+    // Auf dem Mega würde write() hier warten, bis Platz ist
+    if (_raus.im_sendepuffer() >= UART_PUFFER) blockiert++;
+    _raus.senden(c);
+    return 1;
+  }
+  using Print::write;
+  int availableForWrite() { return UART_PUFFER - min(_raus.im_sendepuffer(), (uint32_t)UART_PUFFER); }
+
+  uint32_t blockiert = 0;   // Bytes, für die write() gewartet hätte
+
+private:
+  Leitung &_rein;
+  Leitung &_raus;
+};
+
+struct Szenario {
+  const char *name;
+  bool umlauf;          // sonst Durchsatz
+  bool sweep;
+  uint32_t bitfehler_ppm;
+};
+
+struct Ergebnis {
+  uint32_t nachrichten;     // beim ESP32 angekommene Berichte
+  uint32_t auftraege;       // beim Mega angekommene Aufträge
+  uint32_t fehler;          // verloren, doppelt oder vertauscht
+  std::vector<uint32_t> rtt_us;
+  uint32_t wiederholt;
+  uint32_t crc;
+  uint32_t ueberlauf;
+  uint32_t blockiert;
+};
+
+template <uint8_t FENSTER>
+Ergebnis lauf(const Szenario &sz, uint32_t dauer_ms) {
+  host_zeit_us = 0;
+  zufall_zustand = 1;
+
+  Leitung zum_esp, zum_mega;
+  zum_esp.bitfehler_ppm = zum_mega.bitfehler_ppm = sz.bitfehler_ppm;
+  Anschluss mega_port(zum_mega, zum_esp);
+  Anschluss esp_port(zum_esp, zum_mega);
+
+  BegleiterAuftrag auftrag = {};
+  BegleiterBericht bericht = {};
+  SerialLink<BegleiterAuftrag, BegleiterBericht, FENSTER> mega(mega_port, auftrag, BEGLEITER_WIEDERHOLEN);
+  SerialLink<BegleiterBericht, BegleiterAuftrag, FENSTER> esp(esp_port, bericht, BEGLEITER_WIEDERHOLEN);
+
+  Ergebnis e = {};
+  // Mega
+  uint32_t mega_zaehler = 0;
+  uint16_t mega_erwartet = 1;
+  bool mega_offen = false;
+  uint16_t mega_antwort = 0;
+  // ESP32
+  uint32_t esp_erwartet = 1;
+  uint16_t esp_nummer = 0;
+  bool esp_wartet = false;
+  uint64_t esp_gesendet_us = 0;
+
+  BegleiterBericht aus = {};
+  uint64_t ende = (uint64_t)dauer_ms * 1000;
+  uint64_t mega_naechst = 0, esp_naechst = 0;
+  while (host_zeit_us < ende) {
+    if (host_zeit_us >= mega_naechst) {
+      mega_naechst += MEGA_TAKT_US;
+      bool steht = sz.sweep && (host_zeit_us / 1000) % SWEEP_ALLE_MS < SWEEP_DAUER_MS;
+      if (!steht) {
+        // wie begleiter_bearbeiten()
+        if (mega.update(BEGLEITER_BYTES_PRO_TICK)) {
+          if (auftrag.nummer != mega_erwartet) e.fehler++;
+          mega_erwartet = auftrag.nummer + 1;
+          e.auftraege++;
+          mega_antwort = auftrag.nummer;
+          mega_offen = true;
+        }
+        if (mega_offen) {
+          if (mega.canSend()) {
+            aus.antwort_auf = mega_antwort;
+            aus.sensor_sweeps = ++mega_zaehler;
+            mega.send(aus);
+            mega_offen = false;
+          }
+        } else if (!sz.umlauf) {
+          while (mega.canSend()) {
+            aus.antwort_auf = 0;
+            aus.sensor_sweeps = ++mega_zaehler;
+            mega.send(aus);
+          }
+        }
+      }
+    }
+
+    if (host_zeit_us >= esp_naechst) {
+      esp_naechst += ESP_TAKT_US;
+      while (esp.update(256)) {
+        if (bericht.sensor_sweeps != esp_erwartet) e.fehler++;
+        esp_erwartet = bericht.sensor_sweeps + 1;
+        e.nachrichten++;
+        if (esp_wartet && bericht.antwort_auf == esp_nummer) {
+          e.rtt_us.push_back(host_zeit_us - esp_gesendet_us);
+          esp_wartet = false;
+        }
+      }
+      if (sz.umlauf && !esp_wartet) {
+        BegleiterAuftrag a = {};
+        a.nummer = esp_nummer + 1;
+        a.art = AUFTRAG_BERICHT;
+        if (esp.send(a)) {
+          esp_nummer = a.nummer;
+          esp_gesendet_us = host_zeit_us;
+          esp_wartet = true;
+        }
+      }
+    }
+
+    host_zeit_vorstellen(BYTE_US);
+  }
+
+  e.wiederholt = mega.stats().retransmitted + esp.stats().retransmitted;
+  e.crc = mega.stats().crcErrors + esp.stats().crcErrors;
+  e.ueberlauf = zum_esp.ueberlauf + zum_mega.ueberlauf;
+  e.blockiert = mega_port.blockiert;
+  return e;
+}
+
+static void ausgeben(const Szenario &sz, uint8_t fenster, const Ergebnis &e, uint32_t dauer_ms) {
+  printf("%-18s %2u %8.0f %7.1f", sz.name, fenster, e.nachrichten * 1000.0 / dauer_ms,
+         e.nachrichten * (double)sizeof(BegleiterBericht) / dauer_ms);
+  if (e.rtt_us.empty()) {
+    printf(" %22s", "-");
+  } else {
+    std::vector<uint32_t> r = e.rtt_us;
+    std::sort(r.begin(), r.end());
+    uint64_t summe = 0;
+    for (uint32_t x : r) summe += x;
+    printf(" %6lu %7lu %7lu", (unsigned long)(summe / r.size()), (unsigned long)r[r.size() * 99 / 100],
+           (unsigned long)r.back());
+  }
+  printf(" %6lu %5lu %6lu %6lu %6lu\n", (unsigned long)e.wiederholt, (unsigned long)e.crc,
+         (unsigned long)e.ueberlauf, (unsigned long)e.blockiert, (unsigned long)e.fehler);
+}
+
+template <uint8_t FENSTER>
+static uint32_t messen(const Szenario &sz, uint32_t dauer_ms) {
+  Ergebnis e = lauf<FENSTER>(sz, dauer_ms);
+  ausgeben(sz, FENSTER, e, dauer_ms);
+  return e.fehler;
+}
+
+int main(int argc, char **argv) {
+  uint32_t dauer_ms = (argc > 1 ? strtoul(argv[1], NULL, 10) : 10) * 1000;
+  host_serial_stumm = true;
+
+  const Szenario SZENARIEN[] = {
+    {"durchsatz",          false, false, 0},
+    {"durchsatz 1e-5",     false, false, 10},
+    {"durchsatz 1e-4",     false, false, 100},
+    {"umlauf",             true,  false, 0},
+    {"umlauf 1e-4",        true,  false, 100},
+    {"umlauf sweep",       true,  true,  0},
+  };
+
+  printf("1 MBaud, Bericht %u Bytes (+8 Rahmen), Auftrag %u Bytes, Mega alle %u us, ESP32 alle %u us, %lu s\n",
+         (unsigned)sizeof(BegleiterBericht), (unsigned)sizeof(BegleiterAuftrag), MEGA_TAKT_US, ESP_TAKT_US,
+         (unsigned long)(dauer_ms / 1000));
+  printf("%-18s %2s %8s %7s %6s %7s %7s %6s %5s %6s %6s %6s\n", "szenario", "F", "msg/s", "kB/s", "rtt_us",
+         "p99", "max", "wdh", "crc", "voll", "block", "fehler");
+  uint32_t fehler = 0;
+  for (const Szenario &sz : SZENARIEN) {
+    fehler += messen<1>(sz, dauer_ms);
+    fehler += messen<2>(sz, dauer_ms);
+    fehler += messen<4>(sz, dauer_ms);
+    fehler += messen<8>(sz, dauer_ms);
+  }
+  printf(fehler ? "%lu Nachrichten verloren, doppelt oder vertauscht\n" : "alle Nachrichten genau einmal, in Reihenfolge\n",
+         (unsigned long)fehler);
+  return fehler ? 1 : 0;
+}
@@ -0,0 +1,388 @@
+/* =====================================================
+   SIMULATION: BLACKBOX IM SPI-FLASH
+   =====================================================
+
+   Blackbox.h auf dem Flash aus host/Adafruit_SPIFlashBase.h
+   (W25Q16: Löschen 45..400 ms, Seite 0,7 ms), in virtueller
+   Zeit über zwei Tage:
+
+     - tagsüber Festzeitprogramm mit Fußgängern, nachts
+       Gelbblinken, dazwischen wechselnde Fahrzeugerkennung
+       und Tasterflanken, wie der Sketch sie einträgt
+     - ab und zu ein Neustart (Watchdog) bzw. ein Stromausfall
+       mitten in einem Löschen oder Programmieren
+     - ab und zu gestörte Seitenkommandos (writeBuffer()
+       schreibt nichts): jedes muss in fehler() auftauchen,
+       verloren gehen darf dabei nichts
+     - AT+BBOX während der Aufnahme: ein paar Einträge pro
+       Loop, nur wenn das Flash frei ist
+
+   Jeder gelesene Eintrag muss genau dem eingetragenen
+   entsprechen, in Reihenfolge. Verloren gehen darf nur das
+   Ende eines Laufs, und nur was in den letzten
+   VERLUST_MAX_MS vor dem Neustart kam. Die letzte Stunde muss
+   immer im Ring stehen.
+
+   Dazu Kompression (gegen Zeit + Wert pro Eintrag),
+   Schreibverstärkung und Lebensdauer des Flashs - auch für
+   Adafruit_FlashCache, das bei jedem sync() den ganzen
+   Sektor löscht und neu schreibt.
+
+   Bauen (aus diesem Ordner):
+     g++ -std=c++17 -O2 -I. -I.. BlackboxSim.cpp -o blackbox_sim
+
+   Aufruf:
+     ./blackbox_sim
+   ===================================================== */
+
+#include <Arduino.h>
+#include <Adafruit_SPIFlashBase.h>
+#include <random>
+#include <vector>
+#include "Blackbox.h"
+
+#define SIM_DAUER_MS    (48 * 3600000UL)
+#define LOOP_US         10000
+#define RING_BYTES      (256UL * 1024)   // wie BLACKBOX_BYTES im Sketch
+#define NEUSTART_MS     (2 * 3600000UL)  // im Mittel zwischen zwei Neustarts
+#define VERLUST_MAX_MS  (BLACKBOX_SYNC_MS + 500)   // Sync + ein langes Löschen
+#define LESEN_AB_MS     (40 * 3600000UL) // AT+BBOX während der Aufnahme
+#define LESEN_PRO_LOOP  4                // wie BLACKBOX_ZEILEN_PRO_TICK
+#define ZYKLEN          100000UL         // Lösch-/Programmierzyklen pro Sektor
+#define STOERUNG_LOOPS  200000UL         // im Mittel so viele Loops zwischen zwei gestörten Schreibversuchen
+
+// Signalprogramm (ms)
+#define GRUEN_MS        20000
+#define GELB_MS         3000
+#define ROT_MS          1000
+#define BLINK_MS        1000
+#define SENSOR_MS       500
+
+static std::mt19937 zufall(7);
+
+// -------------------------
+// WAHRHEIT
+// -------------------------
+struct Wahr {
+  uint16_t lauf;
+  uint32_t zeit_ms;
+  uint8_t art;
+  LampenBild bild;
+  uint8_t erkannt;
+  uint8_t taster;
+  uint8_t pegel;
+};
+
+static std::vector<Wahr> wahrheit;
+static std::vector<uint32_t> lauf_ende;   // millis() beim Neustart
+static uint16_t lauf = 0;
+static LampenBild bild = 0;
+static uint8_t erkannt = 0;
+
+static void eintragen(uint8_t art, uint8_t taster = 0, uint8_t pegel = 0) {
+  wahrheit.push_back({lauf, (uint32_t)millis(), art, bild, erkannt, taster, pegel});
+}
+
+static void lampen_zeigen(Blackbox &bb, LampenBild neu) {
+  if (neu == bild) return;
+  bild = neu;
+  bb.lampen(bild);
+  eintragen(BB_LAMPEN);
+}
+
+// -------------------------
+// SIGNALPROGRAMM
+// -------------------------
+static LampenBild ampel(uint8_t richtung, uint8_t farbe) {
+  return (LampenBild)1 << lampe_ampel(richtung, farbe);
+}
+
+static LampenBild fussg(uint8_t richtung, bool gruen) {
+  return (LampenBild)1 << lampe_fussg(richtung, gruen);
+}
+
+// Tag: Nord/Süd, dann Ost/West; Fußgänger parallel auf Anforderung
+static LampenBild tagbild(uint32_t t, const bool *anforderung) {
+  const uint32_t halb = GRUEN_MS + GELB_MS + ROT_MS;
+  uint8_t achse = t % (2 * halb) / halb;   // 0 = Nord/Süd
+  uint32_t in = t % halb;
+  LampenBild b = 0;
+  for (uint8_t r = 0; r < 4; r++) {
+    bool frei = r / 2 == achse;
+    uint8_t farbe = !frei || in >= GRUEN_MS + GELB_MS ? FARBE_ROT : in >= GRUEN_MS ? FARBE_GELB : FARBE_GRUEN;
+    b |= ampel(r, farbe);
+    b |= fussg(r, frei && in < GRUEN_MS / 2 && anforderung[r]);
+  }
+  return b;
+}
+
+static LampenBild nachtbild(uint32_t t) {
+  LampenBild b = 0;
+  if (t / BLINK_MS % 2) {
+    for (uint8_t r = 0; r < 4; r++) b |= ampel(r, FARBE_GELB);
+  }
+  return b;
+}
+
+static bool ist_tag(uint32_t t) {
+  uint32_t stunde = t / 3600000UL % 24;
+  return stunde >= 6 && stunde < 22;
+}
+
+// -------------------------
+// PRÜFEN
+// -------------------------
+static bool gleich(const BlackboxEintrag &e, const Wahr &w) {
+  if (e.zeit_ms != w.zeit_ms || e.art != w.art || e.bild != w.bild || e.erkannt != w.erkannt) return false;
+  return e.art != BB_TASTER || (e.taster == w.taster && e.pegel == w.pegel);
+}
+
+// Gelesene Einträge gegen die Wahrheit bis bis_index: ab dem
+// ersten gelesenen lückenlos, Sprung nur an einem Neustart und
+// nur über das Ende des vorigen Laufs
+static bool pruefen(const char *name, const std::vector<BlackboxEintrag> &gelesen, size_t bis_index,
+                    uint32_t *verloren, uint32_t *aelteste_ms) {
+  size_t j = 0;
+  bool angefangen = false;
+  *verloren = 0;
+  for (size_t i = 0; i < gelesen.size(); i++) {
+    const BlackboxEintrag &e = gelesen[i];
+    if (e.art == BB_ANFANG) {
+      if (!angefangen || !e.neustart) continue;
+      // Rest des vorigen Laufs ist verloren, der nächste Lauf fängt an
+      uint16_t naechster = wahrheit[j - 1].lauf + 1;
+      for (; j < bis_index && wahrheit[j].lauf < naechster; j++) {
+        if (wahrheit[j].zeit_ms + VERLUST_MAX_MS < lauf_ende[wahrheit[j].lauf]) {
+          printf("  %s: Eintrag %zu (%u ms) fehlt, Lauf endete erst %u ms\n", name, j, wahrheit[j].zeit_ms,
+                 lauf_ende[wahrheit[j].lauf]);
+          return false;
+        }
+        (*verloren)++;
+      }
+      continue;
+    }
+    if (!angefangen) {
+      // Der Ring fängt irgendwo an: erster gelesener Eintrag
+      while (j < bis_index && !gleich(e, wahrheit[j])) j++;
+      *aelteste_ms = e.zeit_ms;
+      angefangen = true;
+    }
+    if (j >= bis_index || !gleich(e, wahrheit[j])) {
+      printf("  %s: gelesener Eintrag %zu (%u ms, Art %u) passt nicht zu Eintrag %zu\n", name, i, e.zeit_ms, e.art, j);
+      return false;
+    }
+    j++;
+  }
+  if (j != bis_index) {
+    printf("  %s: nach %zu gelesenen Einträgen fehlen %zu am Ende\n", name, gelesen.size(), bis_index - j);
+    return false;
+  }
+  return true;
+}
+
+// -------------------------
+// LAUF
+// -------------------------
+struct Lesen {
+  bool laeuft = false;
+  std::vector<BlackboxEintrag> eintraege;
+  size_t bis_index = 0;   // Wahrheit beim Ende des Lesens
+  bool fertig = false;
+};
+
+int main() {
+  Adafruit_FlashTransport_SPI transport(10, SPI);
+  Adafruit_SPIFlashBase flash(&transport);
+  host_flash_loeschen_us = []() -> uint32_t { return zufall() % 20 ? 45000 + zufall() % 20000 : 400000; };
+  flash.begin();
+
+  Blackbox *bb = NULL;
+  Lesen lesen;
+  uint32_t naechster_neustart = 0, stromausfaelle = 0, neustarts = 0;
+  uint32_t beim_loeschen = 0;
+  uint8_t ausfall = 0;   // 1 = im nächsten Kommando, 2 = im nächsten Löschen
+  bool abgeschaltet = false;
+  uint32_t max_us = 0, belegt = 0, syncs_cache = 0, gewartet_loop = 0;
+  uint32_t eintraege = 0, bytes = 0, bytes_roh = 0, programmiert = 0, seiten = 0, loeschungen = 0, verloren = 0;
+  uint32_t fehler = 0, gestoert = 0;
+  uint32_t letzter_sensor = 0, letzter_sync_cache = 0, bytes_beim_sync = 0;
+  bool anforderung[4] = {false};
+
+  while (millis() < SIM_DAUER_MS) {
+    if (bb && !ausfall && millis() >= naechster_neustart && zufall() % 2) {
+      ausfall = 1 + zufall() % 2;   // Strom weg, sobald das Flash gerade arbeitet
+    }
+    if (!bb || abgeschaltet || (!ausfall && millis() >= naechster_neustart)) {
+      if (bb) {
+        // Zähler des Laufs sichern, RAM ist weg
+        eintraege += bb->eintraege();
+        bytes += bb->bytes();
+        bytes_roh += bb->bytes_roh();
+        programmiert += bb->programmiert();
+        seiten += bb->seiten();
+        loeschungen += bb->loeschungen();
+        verloren += bb->verloren();
+        belegt += bb->belegt();
+        fehler += bb->fehler();
+        max_us = max(max_us, bb->max_us());
+        lauf_ende.push_back(millis());
+        lauf++;
+        if (abgeschaltet) {
+          stromausfaelle++;
+        } else {
+          neustarts++;   // das Flash löscht ggf. noch weiter
+        }
+        delete bb;
+      }
+      bb = new Blackbox();
+      uint32_t gewartet = host_flash_gewartet;
+      bb->starten(flash, 0, RING_BYTES);
+      host_flash_gewartet = gewartet;   // setup() darf warten
+      bild = 0;
+      erkannt = 0;
+      naechster_neustart = millis() + NEUSTART_MS / 2 + zufall() % NEUSTART_MS;
+      ausfall = 0;
+      abgeschaltet = false;
+      lesen.laeuft = false;
+    }
+    uint32_t t = millis();
+    uint64_t start = host_zeit_us;
+
+    // Wie der Sketch: Taster, Sensoren, Lampen
+    if (zufall() % 3000 == 0) {
+      uint8_t taster = zufall() % 5;
+      for (uint8_t pegel = 0; pegel < 2; pegel++) {
+        bb->taster(taster, pegel);
+        eintragen(BB_TASTER, taster, pegel);
+      }
+      if (taster < 4) anforderung[taster] = true;
+    }
+    if (t - letzter_sensor >= SENSOR_MS) {
+      letzter_sensor = t;
+      uint8_t neu = erkannt;
+      for (uint8_t i = 0; i < 4; i++) {
+        if (zufall() % (ist_tag(t) ? 20 : 200) == 0) neu ^= 1 << i;
+      }
+      if (neu != erkannt) {
+        erkannt = neu;
+        bb->erkannt(erkannt);
+        eintragen(BB_ERKANNT);
+      }
+    }
+    LampenBild neu = ist_tag(t) ? tagbild(t, anforderung) : nachtbild(t);
+    if (ist_tag(t) && t % (GRUEN_MS + GELB_MS + ROT_MS) == GRUEN_MS / 2) {
+      for (bool &a : anforderung) a = false;
+    }
+    lampen_zeigen(*bb, neu);
+
+    // AT+BBOX
+    if (!lesen.laeuft && !lesen.fertig && t >= LESEN_AB_MS) {
+      bb->lesen_starten();
+      lesen.laeuft = true;
+      lesen.eintraege.clear();
+    }
+    if (lesen.laeuft && bb->lesbar()) {
+      BlackboxEintrag e;
+      for (uint8_t i = 0; i < LESEN_PRO_LOOP && lesen.laeuft; i++) {
+        if (bb->naechster(e)) {
+          lesen.eintraege.push_back(e);
+        } else {
+          lesen.laeuft = false;
+          lesen.fertig = true;
+          lesen.bis_index = wahrheit.size();
+        }
+      }
+    }
+
+    if (zufall() % STOERUNG_LOOPS == 0) {
+      uint32_t n = 1 + zufall() % 3;
+      host_flash_schreibfehler += n;
+      gestoert += n;
+    }
+    uint32_t gewartet = host_flash_gewartet;
+    bb->bearbeiten();
+    gewartet_loop += host_flash_gewartet - gewartet;
+    if (ausfall && host_zeit_us < host_flash_kommando.belegt_bis && (ausfall == 1 || host_flash_kommando.loeschen)) {
+      beim_loeschen += host_flash_kommando.loeschen;
+      host_flash_abschalten(zufall());
+      abgeschaltet = true;
+    }
+
+    // Adafruit_FlashCache: sync() jede Sekunde mit neuen Daten
+    // löscht den Sektor und schreibt ihn ganz
+    uint32_t bytes_jetzt = bytes + bb->bytes();
+    if (t - letzter_sync_cache >= BLACKBOX_SYNC_MS) {
+      if (bytes_jetzt != bytes_beim_sync) syncs_cache++;
+      bytes_beim_sync = bytes_jetzt;
+      letzter_sync_cache = t;
+    }
+
+    uint64_t dauer = host_zeit_us - start;
+    if (dauer < LOOP_US) host_zeit_vorstellen(LOOP_US - dauer);
+  }
+
+  eintraege += bb->eintraege();
+  bytes += bb->bytes();
+  bytes_roh += bb->bytes_roh();
+  programmiert += bb->programmiert();
+  seiten += bb->seiten();
+  loeschungen += bb->loeschungen();
+  verloren += bb->verloren();
+  belegt += bb->belegt();
+  fehler += bb->fehler();
+  max_us = max(max_us, bb->max_us());
+
+  printf("%lu h, Ring %lu KB (%lu Sektoren), %u Neustarts, %u Stromausfälle (%u beim Löschen):\n",
+         SIM_DAUER_MS / 3600000UL, RING_BYTES / 1024, RING_BYTES / BLACKBOX_SEKTOR, neustarts, stromausfaelle,
+         beim_loeschen);
+  printf("  %u Einträge, %u Byte kodiert, %u Byte roh: Kompression %.1f:1\n", eintraege, bytes, bytes_roh,
+         (double)bytes_roh / bytes);
+  printf("  bearbeiten() max %u us, Flash belegt %ux, in der Loop gewartet %ux, verloren %u, ungelöscht programmiert %u\n",
+         max_us, belegt, gewartet_loop, verloren, host_flash_ungeloescht);
+
+  gestoert -= host_flash_schreibfehler;   // noch nicht aufgetreten
+  printf("  %u gestörte Schreibversuche, fehler() %u\n", gestoert, fehler);
+
+  // Lesen am Ende (wie AT+BBOX nach dem Unfall)
+  bool ok = !verloren && !gewartet_loop && !host_flash_ungeloescht && gestoert && fehler == gestoert;
+  std::vector<BlackboxEintrag> gelesen;
+  BlackboxEintrag e;
+  bb->lesen_starten();
+  while (bb->naechster(e)) gelesen.push_back(e);
+  uint32_t fehlend, aelteste = 0;
+  if (pruefen("am Ende", gelesen, wahrheit.size(), &fehlend, &aelteste)) {
+    double stunden = (millis() - aelteste) / 3600000.0;
+    printf("  am Ende gelesen: %zu Einträge, %.1f h zurück, %u an Neustarts verloren\n", gelesen.size(), stunden,
+           fehlend);
+    if (stunden < 1) {
+      printf("  weniger als eine Stunde im Ring\n");
+      ok = false;
+    }
+  } else {
+    ok = false;
+  }
+  if (!lesen.fertig || !pruefen("während der Aufnahme", lesen.eintraege, lesen.bis_index, &fehlend, &aelteste)) {
+    ok = false;
+  } else {
+    printf("  während der Aufnahme gelesen: %zu Einträge\n", lesen.eintraege.size());
+  }
+
+  // Schreibverstärkung und Lebensdauer
+  uint32_t max_loeschungen = 0;
+  for (uint32_t s = 0; s < RING_BYTES / BLACKBOX_SEKTOR; s++) max_loeschungen = max(max_loeschungen, host_flash_loeschungen[s]);
+  double jahre = SIM_DAUER_MS / (365.25 * 24 * 3600000.0);
+  double sektoren = RING_BYTES / BLACKBOX_SEKTOR;
+  double cache_programmiert = (double)syncs_cache * BLACKBOX_SEKTOR;
+  printf("\nSchreibverstärkung (Flash-Bytes pro Nutzbyte):\n");
+  printf("  Blackbox.h          programmiert %5.2f  gelöscht %6.2f  %8u Seitenkommandos  Lebensdauer %7.0f Jahre\n",
+         (double)programmiert / bytes, (double)loeschungen * BLACKBOX_SEKTOR / bytes, seiten,
+         ZYKLEN * sektoren / (loeschungen / jahre));
+  printf("  Adafruit_FlashCache programmiert %5.2f  gelöscht %6.2f  %8u Sektoren neu   Lebensdauer %7.1f Jahre\n",
+         cache_programmiert / bytes, cache_programmiert / bytes, syncs_cache,
+         ZYKLEN * sektoren / (syncs_cache / jahre));
+  printf("  (höchste Löschzahl eines Sektors: %u, FlashCache wartet pro sync() ein Löschen + 16 Seiten)\n",
+         max_loeschungen);
+
+  printf("%s\n", ok ? "ok" : "FEHLER");
+  return ok ? 0 : 1;
+}
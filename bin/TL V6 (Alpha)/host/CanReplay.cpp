@@ -0,0 +1,109 @@
+/* =====================================================
+   CAN-LOG-REPLAY FÜR DIE ÖPNV-BEVORRECHTIGUNG
+   =====================================================
+
+   Spielt ein candump-Log (Format "(zeit) can0 ID#DATEN")
+   durch Busvorrang.h und misst den Durchsatz des
+   Dekoders auf dem PC. Zeit läuft virtuell mit den
+   Zeitstempeln aus dem Log, pro Frame wird wie in der
+   Loop einmal phasendauer() abgefragt.
+
+   Bauen (aus diesem Ordner):
+     g++ -std=c++17 -O2 -I. -I.. -I../../../lib/SharkJ1939/src \
+         CanReplay.cpp -o can_replay
+
+   Aufruf:
+     ./can_replay bus_beispiel.log [durchläufe]
+   ===================================================== */
+
+#include <Arduino.h>
+#include <chrono>
+#include <vector>
+#include "Busvorrang.h"
+
+struct LogFrame {
+  uint64_t zeit_us;
+  uint32_t can_id;
+  uint8_t dlc;
+  uint8_t data[8];
+};
+
+static bool zeile_lesen(const char *zeile, LogFrame &f) {
+  double sekunden;
+  char id[16], daten[32] = "";
+  if (sscanf(zeile, " (%lf) %*s %15[0-9A-Fa-f]#%31[0-9A-Fa-f]", &sekunden, id, daten) < 2) return false;
+
+  f.zeit_us = (uint64_t)(sekunden * 1e6);
+  f.can_id = strtoul(id, NULL, 16);
+  f.dlc = 0;
+  for (size_t i = 0; daten[i * 2] && daten[i * 2 + 1] && i < 8; i++) {
+    char byte_text[3] = {daten[i * 2], daten[i * 2 + 1], 0};
+    f.data[f.dlc++] = strtoul(byte_text, NULL, 16);
+  }
+  return true;
+}
+
+// Tagesprogramm wie im Sketch
+static const uint16_t TAGES_PHASEN[4] = {10000, 3000, 10000, 3000};
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    printf("Aufruf: %s <candump.log> [durchläufe]\n", argv[0]);
+    return 1;
+  }
+  FILE *datei = fopen(argv[1], "r");
+  if (!datei) {
+    perror(argv[1]);
+    return 1;
+  }
+  uint32_t durchlaeufe = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000;
+
+  std::vector<LogFrame> log;
+  char zeile[256];
+  while (fgets(zeile, sizeof(zeile), datei)) {
+    LogFrame f;
+    if (zeile_lesen(zeile, f)) log.push_back(f);
+  }
+  fclose(datei);
+  if (log.empty()) {
+    printf("Keine Frames im Log\n");
+    return 1;
+  }
+
+  uint64_t log_dauer = log.back().zeit_us - log.front().zeit_us + 100000;
+  uint32_t erkannt = 0;
+  uint8_t phase = 0;
+  uint32_t phasen_start = 0;
+  uint32_t pruefsumme = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t d = 0; d < durchlaeufe; d++) {
+    for (const LogFrame &vorlage : log) {
+      LogFrame f = vorlage;
+      host_zeit_us = d * log_dauer + (f.zeit_us - log.front().zeit_us);
+
+      if (busvorrang_verteilen(f.can_id, f.dlc, f.data)) erkannt++;
+
+      // Phasensteuerung wie tagesmodus_logik()
+      uint16_t dauer = busvorrang.phasendauer(phase, TAGES_PHASEN[phase],
+                                              TAGES_PHASEN[(phase + 1) % 4], TAGES_PHASEN[phase ^ 2],
+                                              millis() - phasen_start);
+      pruefsumme += dauer;
+      if (millis() - phasen_start >= dauer) {
+        busvorrang.phase_beendet(phase);
+        phase = (phase + 1) % 4;
+        phasen_start = millis();
+      }
+    }
+  }
+  double sekunden = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  uint64_t frames = (uint64_t)log.size() * durchlaeufe;
+  printf("Frames:          %llu (%u erkannt)\n", (unsigned long long)frames, erkannt);
+  printf("Durchsatz:       %.0f Frames/s\n", frames / sekunden);
+  printf("Pro Frame:       %.1f ns\n", sekunden * 1e9 / frames);
+  printf("Verlängerungen:  %u\n", busvorrang.verlaengerungen());
+  printf("Verkürzungen:    %u\n", busvorrang.verkuerzungen());
+  printf("(Prüfsumme %u)\n", pruefsumme);
+  return 0;
+}
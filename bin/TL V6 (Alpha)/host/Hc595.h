@@ -0,0 +1,60 @@
+/* 74HC595-Kette (Schieberegister mit Ausgangslatch) an drei
+   Digitalpins, für Ausgänge über IoAbstraction
+   (outputOnlyFromShiftRegister).
+
+   Wie im Datenblatt: steigende Flanke an SRCLK schiebt SER in
+   Q0 des ersten Bausteins, Q7' läuft in den nächsten; steigende
+   Flanke an RCLK übernimmt das Schieberegister in die Ausgänge.
+   Dazwischen ändern sich die Ausgänge nicht, egal was auf
+   SER/SRCLK passiert.
+
+   Ausgang Nr. 8 * baustein + q (baustein 0 hängt am Mega).
+   host_hc595_latches zählt die Übernahmen.
+
+   Benutzung (der Board-Ersatz leitet die drei Pins um):
+     HostHc595 kette(SR_DATEN_PIN, SR_TAKT_PIN, SR_LATCH_PIN, SR_ANZAHL);
+     if (kette.schreiben(pin, wert)) return;   // Pin gehört zur Kette
+     kette.ausgang(n) */
+
+#ifndef HOST_HC595_H
+#define HOST_HC595_H
+
+#include <Arduino.h>
+
+inline uint32_t host_hc595_latches = 0;
+
+class HostHc595 {
+public:
+  HostHc595(uint8_t ser, uint8_t srclk, uint8_t rclk, uint8_t bausteine)
+    : _ser_pin(ser), _srclk_pin(srclk), _rclk_pin(rclk), _bausteine(bausteine) {}
+
+  bool gehoert(uint8_t pin) const { return pin == _ser_pin || pin == _srclk_pin || pin == _rclk_pin; }
+
+  bool schreiben(uint8_t pin, uint8_t wert) {
+    if (pin == _ser_pin) {
+      _ser = wert;
+    } else if (pin == _srclk_pin) {
+      if (wert && !_srclk) _schiebe = _schiebe << 1 | _ser;
+      _srclk = wert;
+    } else if (pin == _rclk_pin) {
+      if (wert && !_rclk) {
+        _ausgaenge = _schiebe;
+        host_hc595_latches++;
+      }
+      _rclk = wert;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  bool ausgang(uint8_t n) const { return n < 8 * _bausteine && (_ausgaenge >> n & 1); }
+
+private:
+  uint8_t _ser_pin, _srclk_pin, _rclk_pin, _bausteine;
+  uint8_t _ser = LOW, _srclk = LOW, _rclk = LOW;
+  uint32_t _schiebe = 0;     // bis 4 Bausteine
+  uint32_t _ausgaenge = 0;
+};
+
+#endif
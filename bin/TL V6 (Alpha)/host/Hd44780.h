@@ -0,0 +1,123 @@
+/* HD44780-Zeichen-LCD hinter einem PCF8574 (wie die üblichen
+   I2C-Rucksäcke: P0 RS, P1 RW, P2 E, P3 Licht, P4..P7 D4..D7)
+   als Gerät für host/Wire.h.
+
+   Der Controller übernimmt Daten bei fallendem E, startet im
+   8-Bit-Modus und rechnet nach "Function Set 4 Bit" in
+   Halbbytes. DDRAM im zweizeiligen Modus wie im Datenblatt:
+   0x00..0x27 und 0x40..0x67, der Adresszähler springt von
+   0x27 auf 0x40 und von 0x67 auf 0x00. Kommt eine E-Flanke,
+   solange der letzte Befehl noch läuft (37 us, Daten 41 us,
+   Clear/Home 1,52 ms), zählt zu_frueh - das echte LCD würde
+   sie verschlucken.
+
+   Benutzung:
+     HostHd44780 lcd_modell;
+     host_i2c_geraete[0x27] = &lcd_modell;
+     ...
+     lcd_modell.zeichen(spalte, zeile)   // was gerade zu sehen ist */
+
+#ifndef HOST_HD44780_H
+#define HOST_HD44780_H
+
+#include <Wire.h>
+
+class HostHd44780 : public HostI2cGeraet {
+public:
+  HostHd44780() {
+    memset(_ddram, 0, sizeof(_ddram));
+    memset(_cgram, 0, sizeof(_cgram));
+  }
+
+  void empfangen(uint8_t port) {
+    if ((_port & 0x04) && !(port & 0x04)) flanke(_port);
+    _port = port;
+  }
+
+  uint8_t zeichen(uint8_t spalte, uint8_t zeile) const {
+    static const uint8_t ZEILEN[4] = {0x00, 0x40, 0x14, 0x54};
+    return _ddram[(ZEILEN[zeile & 3] + spalte) & 0x7F];
+  }
+  const uint8_t *glyphe(uint8_t nummer) const { return &_cgram[(nummer & 7) * 8]; }
+
+  uint32_t zu_frueh = 0;
+  uint32_t befehle = 0;   // ohne Zeichen
+  uint32_t daten = 0;     // Zeichen und Glyphenzeilen
+
+private:
+  void flanke(uint8_t port) {
+    if (host_zeit_us < _belegt_bis) zu_frueh++;
+    uint8_t halbbyte = port & 0xF0;
+    if (!_vier_bit) {
+      befehl(halbbyte);   // D0..D3 hängen im 4-Bit-Anschluss auf 0
+      return;
+    }
+    if (!_zweite_haelfte) {
+      _hoch = halbbyte;
+      _zweite_haelfte = true;
+      return;
+    }
+    _zweite_haelfte = false;
+    uint8_t wert = _hoch | halbbyte >> 4;
+    if (port & 0x01) {
+      schreiben(wert);
+    } else {
+      befehl(wert);
+    }
+  }
+
+  void befehl(uint8_t b) {
+    befehle++;
+    _belegt_bis = host_zeit_us + 37;
+    if (b & 0x80) {
+      _cg = false;
+      _adresse = b & 0x7F;
+    } else if (b & 0x40) {
+      _cg = true;
+      _adresse = b & 0x3F;
+    } else if (b & 0x20) {
+      _vier_bit = !(b & 0x10);
+      _zweizeilig = b & 0x08;
+    } else if (b == 0x01 || (b & 0xFE) == 0x02) {
+      if (b == 0x01) memset(_ddram, ' ', sizeof(_ddram));
+      _cg = false;
+      _adresse = 0;
+      _belegt_bis = host_zeit_us + 1520;
+    }
+    // Entry Mode, Display an/aus, Schieben: die Bibliothek
+    // bleibt bei links nach rechts ohne Schieben
+  }
+
+  void schreiben(uint8_t wert) {
+    daten++;
+    _belegt_bis = host_zeit_us + 41;
+    if (_cg) {
+      _cgram[_adresse] = wert & 0x1F;
+      _adresse = (_adresse + 1) & 0x3F;
+      return;
+    }
+    _ddram[_adresse] = wert;
+    if (!_zweizeilig) {
+      _adresse = (_adresse + 1) % 0x50;
+    } else if (_adresse == 0x27) {
+      _adresse = 0x40;
+    } else if (_adresse == 0x67) {
+      _adresse = 0x00;
+    } else {
+      _adresse++;
+    }
+  }
+
+  uint8_t _ddram[128];
+  uint8_t _cgram[64];
+  uint8_t _port = 0;
+  uint8_t _hoch = 0;
+  uint8_t _adresse = 0;
+  uint64_t _belegt_bis = 0;
+  bool _vier_bit = false;
+  bool _zweite_haelfte = false;
+  bool _zweizeilig = false;
+  bool _cg = false;
+};
+
+#endif
@@ -0,0 +1,15 @@
+/* Host-Ersatz für IoLogging.h (TaskManagerIO/IoAbstraction):
+   Logging ist auf dem PC abgeschaltet. */
+
+#ifndef HOST_IO_LOGGING_H
+#define HOST_IO_LOGGING_H
+
+#define serlogF(lvl, x)
+#define serlogF2(lvl, x1, x2)
+#define serlogF3(lvl, x1, x2, x3)
+#define serlogF4(lvl, x1, x2, x3, x4)
+#define serlogFHex(lvl, x1, x2)
+#define serlogHexDump(lvl, x1, x2, x3)
+#define serlog3(lvl, x1, x2, x3)
+
+#endif
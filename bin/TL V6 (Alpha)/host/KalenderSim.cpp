@@ -0,0 +1,277 @@
+/* =====================================================
+   SIMULATION: KALENDER GEGEN DIE ZEITZONENDATENBANK
+   =====================================================
+
+   Kalender.h mit dem echten TaskManagerIO (lib/) und der
+   RTC aus host/RTClib.h in virtueller Zeit, wochenlang:
+
+     - die RTC geht um +-100 ppm gegen millis()
+     - millis() läuft mitten im Szenario über
+     - Sommerzeit-Umstellungen, Ostern am Umstellungstag
+       (2027), Feiertage am Samstag, Jahreswechsel
+
+   Soll-Zeitpunkte rechnet die C-Bibliothek (TZ=Europe/Berlin):
+   ein Termin läuft in der ersten UTC-Minute seines Ortsdatums,
+   deren Ortszeit nicht vor der Terminzeit liegt. Feiertage
+   stehen als feste Liste daneben, nicht aus der Osterformel.
+   Jeder Termin muss in Reihenfolge und höchstens TOLERANZ_S
+   nach dem Soll-Zeitpunkt kommen, das Nachholen beim Start
+   muss genau das letzte Auftreten jeder Aktion liefern.
+
+   Bauen (aus diesem Ordner):
+     g++ -std=c++17 -O2 -I. -I.. -I../../../lib/TaskManagerIO/src -I../../../lib/SimpleCollections/src \
+       KalenderSim.cpp ../../../lib/TaskManagerIO/src/[A-Za-z]*.cpp ../../../lib/SimpleCollections/src/[A-Za-z]*.cpp \
+       -o kalender_sim
+
+   Aufruf:
+     ./kalender_sim
+   ===================================================== */
+
+#include <Arduino.h>
+#include <RTClib.h>
+#include <algorithm>
+#include <time.h>
+#include <vector>
+#include "Kalender.h"
+
+#define TOLERANZ_S 2
+#define LOOP_US    10000   // delay(10) in loop()
+
+// Wie KALENDER_PLAN im Sketch, dazu Termine in der Lücke und
+// der doppelten Stunde der Umstellung
+const KalenderEintrag PLAN[] PROGMEM = {
+  {KALENDER_WERKTAGS,                       5, 30, 0},
+  {KALENDER_WERKTAGS,                      22,  0, 1},
+  {KALENDER_WOCHENENDE,                     8,  0, 0},
+  {KALENDER_WOCHENENDE,                    23,  0, 1},
+  {KALENDER_SO | KALENDER_OHNE_FEIERTAG,    3, 15, 2},
+  {KALENDER_MO | KALENDER_OHNE_FEIERTAG,    0,  0, 3},
+  {KALENDER_TAEGLICH,                       2, 30, 4},
+  {KALENDER_SO,                             2,  0, 5},
+  {KALENDER_FR,                            12,  0, 6},
+};
+#define PLAN_ANZAHL (sizeof(PLAN) / sizeof(PLAN[0]))
+
+// Bundesweite Feiertage 2026/2027 (Ortsdatum)
+static const int FEIERTAGE[][3] = {
+  {2026, 1, 1}, {2026, 4, 3}, {2026, 4, 6}, {2026, 5, 1}, {2026, 5, 14}, {2026, 5, 25},
+  {2026, 10, 3}, {2026, 12, 25}, {2026, 12, 26},
+  {2027, 1, 1}, {2027, 3, 26}, {2027, 3, 29}, {2027, 5, 1}, {2027, 5, 6}, {2027, 5, 17},
+  {2027, 10, 3}, {2027, 12, 25}, {2027, 12, 26},
+};
+
+static const int OSTERN[][3] = {
+  {2000, 4, 23}, {2019, 4, 21}, {2024, 3, 31}, {2025, 4, 20}, {2026, 4, 5},
+  {2027, 3, 28}, {2028, 4, 16}, {2030, 4, 21}, {2038, 4, 25}, {2049, 4, 18},
+};
+
+struct Szenario {
+  const char *name;
+  int jahr, monat, tag, stunde;   // Start in UTC
+  uint32_t tage;
+  int32_t ppm;
+  uint32_t ueberlauf_nach_s;       // millis() läuft so lange nach dem Start über
+};
+
+struct Termin {
+  uint32_t utc;
+  uint8_t index;
+  uint8_t aktion;
+  bool operator<(const Termin &t) const { return utc != t.utc ? utc < t.utc : index < t.index; }
+};
+
+struct Aufruf {
+  uint32_t rtc;
+  uint8_t aktion;
+  bool nachgeholt;
+};
+
+static std::vector<Aufruf> aufrufe;
+
+static uint32_t uhr() {
+  return host_rtc_sekunden();
+}
+
+static void aktion(uint8_t a, bool nachgeholt) {
+  aufrufe.push_back({host_rtc_sekunden(), a, nachgeholt});
+}
+
+static uint32_t utc(int jahr, int monat, int tag, int stunde) {
+  struct tm t = {};
+  t.tm_year = jahr - 1900;
+  t.tm_mon = monat - 1;
+  t.tm_mday = tag;
+  t.tm_hour = stunde;
+  return timegm(&t);
+}
+
+static bool ist_feiertag(const struct tm &ort) {
+  for (const auto &f : FEIERTAGE) {
+    if (f[0] == ort.tm_year + 1900 && f[1] == ort.tm_mon + 1 && f[2] == ort.tm_mday) return true;
+  }
+  return false;
+}
+
+// Alle Termine, deren Ortsdatum zwischen von und bis liegt (UTC-Grenzen, großzügig)
+static std::vector<Termin> soll_termine(uint32_t von, uint32_t bis) {
+  std::vector<Termin> termine;
+  for (uint32_t mittag = von - von % 86400 + 43200 - 86400; mittag < bis + 2 * 86400; mittag += 86400) {
+    time_t t = mittag;
+    struct tm ort;
+    localtime_r(&t, &ort);
+    uint8_t wochentag = (ort.tm_wday + 6) % 7;   // 0 = Montag
+    bool feiertag = ist_feiertag(ort);
+    for (uint8_t i = 0; i < PLAN_ANZAHL; i++) {
+      const KalenderEintrag &e = PLAN[i];
+      uint8_t bit = (e.tage & KALENDER_OHNE_FEIERTAG) || !feiertag ? 1 << wochentag : KALENDER_SO;
+      if (!(e.tage & bit)) continue;
+      // Erste UTC-Minute dieses Ortsdatums mit Ortszeit >= Terminzeit
+      for (uint32_t m = mittag - 15 * 3600; m < mittag + 15 * 3600; m += 60) {
+        time_t mt = m;
+        struct tm o;
+        localtime_r(&mt, &o);
+        if (o.tm_mday != ort.tm_mday) continue;
+        if (o.tm_hour * 60 + o.tm_min >= e.stunde * 60 + e.minute) {
+          termine.push_back({m, i, e.aktion});
+          break;
+        }
+      }
+    }
+  }
+  std::sort(termine.begin(), termine.end());
+  return termine;
+}
+
+static uint32_t lauf(const Szenario &sz) {
+  uint32_t fehler = 0;
+  uint32_t start = utc(sz.jahr, sz.monat, sz.tag, sz.stunde);
+  uint32_t ende = start + sz.tage * 86400;
+
+  // millis() so stellen, dass es nach ueberlauf_nach_s überläuft
+  host_zeit_us = ((1ULL << 32) - (uint64_t)sz.ueberlauf_nach_s * 1000) * 1000;
+  host_rtc_ppm = sz.ppm;
+  host_rtc_basis = 0;
+  host_rtc_basis = start - host_rtc_sekunden();
+  aufrufe.clear();
+  taskManager.reset();
+
+  Kalender kalender(PLAN, PLAN_ANZAHL);
+  kalender.starten(uhr, aktion);
+
+  uint32_t schritte = 0;
+  bool uebergelaufen = false;
+  uint32_t vorher = millis();
+  while (host_rtc_sekunden() < ende) {
+    taskManager.runLoop();
+    // Ein Loop-Durchlauf später: reschedule() aus exec() meldet sich
+    // über triggerEvents(), das wertet erst der nächste runLoop() aus
+    host_zeit_vorstellen(LOOP_US);
+    taskManager.runLoop();
+    // Dann bis zur nächsten fälligen Aufgabe vorspulen
+    TimerTask *naechste = taskManager.getFirstTask();
+    uint32_t us = naechste ? naechste->microsFromNow() : 1000000;
+    host_zeit_vorstellen(max(us, (uint32_t)1000));
+    if (millis() < vorher) uebergelaufen = true;
+    vorher = millis();
+    schritte++;
+  }
+
+  std::vector<Termin> soll = soll_termine(start - KALENDER_NACHHOLEN_S, ende);
+
+  // Nachholen: letztes Auftreten jeder Aktion in (start - 7 Tage, start]
+  std::vector<Termin> nachholen;
+  for (const Termin &t : soll) {
+    if (t.utc <= start - KALENDER_NACHHOLEN_S || t.utc > start) continue;
+    auto alt = std::find_if(nachholen.begin(), nachholen.end(), [&](const Termin &n) { return n.aktion == t.aktion; });
+    if (alt != nachholen.end()) nachholen.erase(alt);
+    nachholen.push_back(t);
+  }
+  size_t k = 0;
+  for (; k < aufrufe.size() && aufrufe[k].nachgeholt; k++) {
+    if (k >= nachholen.size() || aufrufe[k].aktion != nachholen[k].aktion) fehler++;
+  }
+  if (k != nachholen.size()) fehler++;
+
+  // Termine im Lauf
+  uint32_t ausgeloest = 0, max_spaet = 0;
+  for (const Termin &t : soll) {
+    if (t.utc <= start || t.utc > ende) continue;
+    if (host_rtc_sekunden() - t.utc < TOLERANZ_S) break;   // kam vielleicht gerade noch nicht
+    if (k >= aufrufe.size() || aufrufe[k].aktion != t.aktion || aufrufe[k].nachgeholt ||
+        aufrufe[k].rtc < t.utc || aufrufe[k].rtc > t.utc + TOLERANZ_S) {
+      time_t tt = t.utc;
+      struct tm o;
+      localtime_r(&tt, &o);
+      printf("  fehlt/falsch: Aktion %u am %02d.%02d. %02d:%02d (Ortszeit)", t.aktion, o.tm_mday, o.tm_mon + 1,
+             o.tm_hour, o.tm_min);
+      if (k < aufrufe.size()) printf(", kam Aktion %u %+ld s", aufrufe[k].aktion, (long)aufrufe[k].rtc - (long)t.utc);
+      printf("\n");
+      fehler++;
+    } else {
+      max_spaet = max(max_spaet, aufrufe[k].rtc - t.utc);
+    }
+    k++;
+    ausgeloest++;
+  }
+  // Mehr als gefordert?
+  for (; k < aufrufe.size(); k++) {
+    if (ende - aufrufe[k].rtc > TOLERANZ_S) fehler++;
+  }
+
+  printf("%-16s %3lu %+5ld %4lu %4lu %9.1f %8.1f %6lu %s\n", sz.name, (unsigned long)sz.tage, (long)sz.ppm,
+         (unsigned long)nachholen.size(), (unsigned long)ausgeloest, schritte / (double)sz.tage,
+         kalender.weckrufe() / (double)sz.tage, (unsigned long)max_spaet, uebergelaufen ? "ja" : "NEIN");
+  if (!uebergelaufen) fehler++;
+  taskManager.reset();
+  return fehler;
+}
+
+int main() {
+  setenv("TZ", "Europe/Berlin", 1);
+  tzset();
+  host_serial_stumm = true;
+  uint32_t fehler = 0;
+
+  for (const auto &o : OSTERN) {
+    int16_t jahr;
+    uint8_t monat, tag;
+    Kalender::datum(Kalender::ostern(o[0]), jahr, monat, tag);
+    if (jahr != o[0] || monat != o[1] || tag != o[2]) {
+      printf("Ostern %d: %02u.%02u. statt %02d.%02d.\n", o[0], tag, monat, o[2], o[1]);
+      fehler++;
+    }
+  }
+  for (int32_t tag = Kalender::tage(2026, 1, 1); tag < Kalender::tage(2028, 1, 1); tag++) {
+    time_t t = tag * 86400L + 43200;
+    struct tm ort;
+    localtime_r(&t, &ort);
+    if (Kalender::feiertag(tag) != ist_feiertag(ort)) {
+      printf("Feiertag falsch: %02d.%02d.%d\n", ort.tm_mday, ort.tm_mon + 1, ort.tm_year + 1900);
+      fehler++;
+    }
+  }
+  // Ortszeit stündlich über zwei Jahre gegen localtime_r
+  for (uint32_t t = utc(2026, 1, 1, 0); t < utc(2028, 1, 1, 0); t += 1800) {
+    time_t tt = t;
+    struct tm ort;
+    localtime_r(&tt, &ort);
+    if (Kalender::ortszeit(t) != t + ort.tm_gmtoff) {
+      printf("Ortszeit falsch bei %lu\n", (unsigned long)t);
+      fehler++;
+    }
+  }
+  printf("Osterdatum, Feiertage, Ortszeit 2026/27: %s\n\n", fehler ? "FEHLER" : "ok");
+
+  const Szenario SZENARIEN[] = {
+    {"fruehjahr 2026", 2026, 3, 25, 11, 14, 100, 36 * 3600},
+    {"ostern 2027",    2027, 3, 22, 12, 10, -100, 4 * 86400},
+    {"herbst 2026",    2026, 9, 28, 12, 33, 100, 20 * 86400},
+    {"jahreswechsel",  2026, 12, 20, 6, 16, -100, 12 * 86400},
+  };
+  printf("Termine in Ortszeit, Weckrufe = exec() des TmLongSchedule, Schritte = Aufgaben von TaskManagerIO\n");
+  printf("%-16s %3s %5s %4s %4s %9s %8s %6s %s\n", "szenario", "tg", "ppm", "nach", "term", "schr/tag", "weck/tag",
+         "spaet", "millis-ueberlauf");
+  for (const Szenario &sz : SZENARIEN) fehler += lauf(sz);
+  printf(fehler ? "%lu Fehler\n" : "alle Termine in Reihenfolge und pünktlich\n", (unsigned long)fehler);
+  return fehler ? 1 : 0;
+}
@@ -0,0 +1,288 @@
+/* =====================================================
+   SIMULATION: STATUS-LCD MIT SCHATTENBILD
+   =====================================================
+
+   StatusLcd.h und lib/LiquidCrystal_I2C am LCD-Modell aus
+   host/Hd44780.h, I2C mit 100 kHz (host/Wire.h), in
+   virtueller Zeit:
+
+     - Kosten pro Zeichen: Bibliothek vorher (sechs
+       Übertragungen und 51 us Pause pro Byte), gebündelt
+       einzeln und als Lauf
+     - eine Stunde Statusseite wie im Sketch (alle 250 ms neu
+       gezeichnet, Loop alle 10 ms, Nachtverkehr an vier
+       Zufahrten): Buszeit pro Stunde, längster Aufruf und wie
+       lange eine Änderung bis aufs LCD braucht - gegen die
+       ganze Seite bei jedem Zeichnen
+     - zufällige Bilder mit zufälligem Budget, auch neu
+       gezeichnet während der Übertragung: sobald das LCD
+       aufgeholt hat, muss das Modell genau das Bild zeigen,
+       und keine E-Flanke darf zu früh kommen
+     - dabei ab und zu das LCD abgezogen (endTransmission()
+       meldet 2): fehler() muss es merken, und wieder
+       angesteckt muss das LCD ohne auffrischen() aufholen
+     - ohne LCD am Bus: schon starten() meldet den Fehler
+
+   Bauen (aus diesem Ordner):
+     g++ -std=c++17 -O2 -DARDUINO=186 -I. -I.. -I../../../lib/LiquidCrystal_I2C \
+       LcdSim.cpp ../../../lib/LiquidCrystal_I2C/LiquidCrystal_I2C.cpp -o lcd_sim
+
+   Aufruf:
+     ./lcd_sim
+   ===================================================== */
+
+#include <Arduino.h>
+#include <Hd44780.h>
+#include <random>
+#include "StatusLcd.h"
+
+#define ADRESSE        0x27
+#define SIM_DAUER_MS   3600000UL
+#define LOOP_US        10000
+#define SEITE_MS       250       // LCD_SEITE_MS
+#define BUDGET         5         // LCD_ZEICHEN_PRO_TICK
+#define MAX_CM         300       // SENSOR_MAX_CM
+#define ZUFALLSBILDER  5000
+
+static std::mt19937 zufall(7);
+static HostHd44780 modell;
+
+// -------------------------
+// KOSTEN PRO ZEICHEN
+// -------------------------
+// So hat LiquidCrystal_I2C vorher jedes Byte geschickt:
+// pro Halbbyte expanderWrite, En an, En aus - jedes eine
+// eigene Übertragung - und 1 + 50 us Pause
+static void alt_schreiben(uint8_t wert, uint8_t modus) {
+  uint8_t halbbytes[2] = {(uint8_t)(wert & 0xF0), (uint8_t)(wert << 4)};
+  for (uint8_t h : halbbytes) {
+    uint8_t daten = h | modus | LCD_BACKLIGHT;
+    const uint8_t folge[3] = {daten, (uint8_t)(daten | En), (uint8_t)(daten & ~En)};
+    for (uint8_t i = 0; i < 3; i++) {
+      Wire.beginTransmission(ADRESSE);
+      Wire.write(folge[i]);
+      Wire.endTransmission();
+      delayMicroseconds(i == 1 ? 1 : i == 2 ? 50 : 0);
+    }
+  }
+}
+
+static void kosten(LiquidCrystal_I2C &lcd) {
+  const char *text = "Festzeit  P  3 N####";
+  uint64_t start = host_zeit_us;
+  lcd.setCursor(0, 0);
+  for (uint8_t i = 0; i < 20; i++) alt_schreiben(text[i], Rs);
+  double alt = (host_zeit_us - start) / 20.0;
+  start = host_zeit_us;
+  lcd.setCursor(0, 1);
+  for (uint8_t i = 0; i < 20; i++) lcd.write((uint8_t)text[i]);
+  double einzeln = (host_zeit_us - start) / 20.0;
+  start = host_zeit_us;
+  lcd.setCursor(0, 2);
+  lcd.write((const uint8_t *)text, 20);
+  double lauf = (host_zeit_us - start) / 20.0;
+  printf("Pro Zeichen bei 100 kHz: vorher %.0f us, einzeln %.0f us, im Lauf %.0f us\n", alt, einzeln, lauf);
+  printf("  ganze Seite (80 Zeichen + 4 setCursor): vorher %.1f ms, jetzt %.1f ms\n", (80 + 4) * alt / 1000,
+         (80 * lauf + 4 * einzeln) / 1000);
+}
+
+// -------------------------
+// STATUSSEITE
+// -------------------------
+struct Zustand {
+  bool nacht = true;
+  uint8_t phase = 0;
+  uint16_t cm[4] = {0, 0, 0, 0};
+  bool fussg[4] = {false, false, false, false};
+};
+
+// Wie lcd_zeichnen() im Sketch
+static void zeichnen(LcdSeite &seite, const Zustand &z, uint32_t ms) {
+  static const char ZUFAHRTEN[] = "NSOW";
+  seite.leeren();
+  seite.print(z.nacht ? "NACHT" : "TAG");
+  seite.setzen(6, 0);
+  seite.print(z.nacht ? "Nacht" : "Festzeit");
+  seite.setzen(16, 0);
+  seite.print('P');
+  seite.zahl(z.phase, 3);
+  for (uint8_t i = 0; i < 4; i++) {
+    uint8_t spalte = i % 2 * 10;
+    uint8_t zeile = 1 + i / 2;
+    seite.setzen(spalte, zeile);
+    seite.print(ZUFAHRTEN[i]);
+    seite.balken(spalte + 1, zeile, 5, z.cm[i], MAX_CM);
+    if (z.cm[i]) {
+      seite.zahl(z.cm[i], 3);
+    } else {
+      seite.print("---");
+    }
+    if (z.cm[i] && z.cm[i] < 150) seite.print('*');
+  }
+  seite.setzen(0, 3);
+  seite.print("Fg ");
+  for (uint8_t i = 0; i < 4; i++) seite.print(z.fussg[i] ? ZUFAHRTEN[i] : '-');
+  uint32_t s = ms / 1000;
+  seite.setzen(11, 3);
+  seite.zahl(s / 3600, 3);
+  seite.print(':');
+  seite.zahl(s / 60 % 60, 2, '0');
+  seite.print(':');
+  seite.zahl(s % 60, 2, '0');
+}
+
+// Nachtverkehr: ab und zu fährt ein Auto von 300 auf 20 cm
+// heran und ist weg; Sweep alle 200 ms, Phasen alle 15 s
+static void verkehr(Zustand &z, uint32_t ms) {
+  if (ms % 200) return;
+  for (uint8_t i = 0; i < 4; i++) {
+    if (z.cm[i]) {
+      z.cm[i] = z.cm[i] > 30 ? z.cm[i] - 10 - zufall() % 10 : 0;
+    } else if (zufall() % 100 == 0) {
+      z.cm[i] = MAX_CM - zufall() % 20;
+    }
+    if (zufall() % 300 == 0) z.fussg[i] = !z.fussg[i];
+  }
+  if (ms % 15000 == 0) z.phase = (z.phase + 1) % 4;
+  if (ms % 1800000 == 0) z.nacht = !z.nacht;
+}
+
+struct Messung {
+  uint64_t bus_us = 0;
+  uint32_t max_us = 0;
+  uint32_t max_nachlauf_ms = 0;   // Zeichnen bis LCD aktuell
+};
+
+// ganz = jedes Zeichnen schickt alle vier Zeilen (setCursor + print)
+static Messung seite_laufen(LcdSeite &seite, LiquidCrystal_I2C &lcd, bool ganz) {
+  Messung m;
+  Zustand z;
+  uint32_t gezeichnet_ms = 0;
+  bool offen = false;
+  for (uint32_t ms = 0; ms < SIM_DAUER_MS; ms += LOOP_US / 1000) {
+    verkehr(z, ms);
+    host_zeit_us = max(host_zeit_us, (uint64_t)ms * 1000);   // ganze Seite: Loop läuft über
+    if (ms % SEITE_MS == 0) {
+      zeichnen(seite, z, ms);
+      if (!offen) gezeichnet_ms = ms;
+      offen = true;
+    }
+    uint64_t start = host_zeit_us;
+    if (ganz) {
+      if (ms % SEITE_MS == 0) {
+        for (uint8_t zeile = 0; zeile < LCD_ZEILEN; zeile++) {
+          uint8_t text[LCD_SPALTEN];
+          for (uint8_t spalte = 0; spalte < LCD_SPALTEN; spalte++) text[spalte] = seite.zeichen_an(spalte, zeile);
+          lcd.setCursor(0, zeile);
+          lcd.write(text, LCD_SPALTEN);
+        }
+      }
+      offen = false;
+    } else {
+      seite.bearbeiten(BUDGET);
+      if (offen && seite.aktuell()) {
+        m.max_nachlauf_ms = max(m.max_nachlauf_ms, ms - gezeichnet_ms);
+        offen = false;
+      }
+    }
+    uint32_t dauer = host_zeit_us - start;
+    m.bus_us += dauer;
+    m.max_us = max(m.max_us, dauer);
+  }
+  return m;
+}
+
+static bool modell_zeigt(const LcdSeite &seite) {
+  for (uint8_t zeile = 0; zeile < LCD_ZEILEN; zeile++) {
+    for (uint8_t spalte = 0; spalte < LCD_SPALTEN; spalte++) {
+      if (modell.zeichen(spalte, zeile) != seite.zeichen_an(spalte, zeile)) return false;
+    }
+  }
+  return true;
+}
+
+// -------------------------
+// ZUFALLSBILDER
+// -------------------------
+static uint8_t zufallszeichen() {
+  switch (zufall() % 4) {
+    case 0: return 1 + zufall() % 4;   // Glyphe
+    case 1: return LCD_VOLL;
+    default: return ' ' + zufall() % 95;
+  }
+}
+
+static uint32_t zufallsbilder(LcdSeite &seite) {
+  uint32_t fehler = 0;
+  for (uint32_t bild = 0; bild < ZUFALLSBILDER; bild++) {
+    // Wenige bis alle Zeichen ändern
+    uint8_t aenderungen = zufall() % 3 ? 1 + zufall() % 6 : zufall() % (LCD_ZELLEN + 1);
+    for (uint8_t i = 0; i < aenderungen; i++) {
+      seite.setzen(zufall() % LCD_SPALTEN, zufall() % LCD_ZEILEN);
+      seite.write(zufallszeichen());
+    }
+    if (zufall() % 50 == 0) seite.auffrischen();
+    // Ab und zu für ein paar Bilder abgezogen
+    if (zufall() % 100 == 0) host_i2c_geraete[ADRESSE] = host_i2c_geraete[ADRESSE] ? NULL : &modell;
+    // Manchmal kommt das nächste Bild, bevor dieses ganz draußen ist
+    uint8_t aufrufe = zufall() % 4 ? 255 : zufall() % 5;
+    while (aufrufe-- && seite.bearbeiten(1 + zufall() % 12)) {
+    }
+    if (seite.aktuell() && !modell_zeigt(seite)) fehler++;
+  }
+  host_i2c_geraete[ADRESSE] = &modell;
+  while (seite.bearbeiten(BUDGET)) {
+  }
+  if (!modell_zeigt(seite)) fehler++;
+  return fehler;
+}
+
+int main() {
+  host_i2c_geraete[ADRESSE] = &modell;
+  LiquidCrystal_I2C lcd(ADRESSE, LCD_SPALTEN, LCD_ZEILEN);
+  LcdSeite seite(lcd);
+  seite.starten();
+
+  bool glyphen_ok = true;
+  for (uint8_t g = 1; g <= 4; g++) {
+    for (uint8_t zeile = 0; zeile < 8; zeile++) {
+      if (modell.glyphe(g)[zeile] != ((0x1F << (5 - g)) & 0x1F)) glyphen_ok = false;
+    }
+  }
+
+  kosten(lcd);
+  seite.auffrischen();   // kosten() hat an der Seite vorbei geschrieben
+
+  printf("\nEine Stunde Statusseite, neu gezeichnet alle %u ms, Loop %u ms, Budget %u:\n", SEITE_MS,
+         LOOP_US / 1000, BUDGET);
+  uint32_t zeichen = seite.zeichen(), setcursor = seite.setcursor();
+  Messung diff = seite_laufen(seite, lcd, false);
+  zeichen = seite.zeichen() - zeichen;
+  setcursor = seite.setcursor() - setcursor;
+  bool seite_ok = modell_zeigt(seite);
+  Messung ganz = seite_laufen(seite, lcd, true);
+  printf("  Schattenbild   Bus %6.1f s/h (%4.2f%%)  max %5u us pro Aufruf  Änderung nach spätestens %u ms auf dem LCD\n",
+         diff.bus_us / 1e6, diff.bus_us / (SIM_DAUER_MS * 10.0), diff.max_us, diff.max_nachlauf_ms);
+  printf("                 %u Zeichen, %u setCursor (%.1f Zeichen pro setCursor)\n", zeichen, setcursor,
+         (double)zeichen / setcursor);
+  printf("  ganze Seite    Bus %6.1f s/h (%4.2f%%)  max %5u us pro Aufruf\n", ganz.bus_us / 1e6,
+         ganz.bus_us / (SIM_DAUER_MS * 10.0), ganz.max_us);
+
+  printf("\n%u Zufallsbilder mit Budget 1..12:\n", ZUFALLSBILDER);
+  seite.auffrischen();
+  uint32_t fehler = zufallsbilder(seite);
+  printf("  %u abweichend, %u E-Flanken zu früh, Glyphen %s, %u Fehler beim Abziehen gemeldet\n", fehler,
+         modell.zu_frueh, glyphen_ok ? "ok" : "falsch", seite.fehler());
+
+  // Kein LCD an der Adresse
+  LiquidCrystal_I2C ohne_lcd(ADRESSE - 1, LCD_SPALTEN, LCD_ZEILEN);
+  LcdSeite ohne(ohne_lcd);
+  ohne.starten();
+  ohne.print("TAG");
+  bool ohne_ok = ohne.fehler() && !ohne.bearbeiten(BUDGET) && ohne.fehler() >= 2;
+  printf("  ohne LCD: starten() und bearbeiten() melden %u Fehler\n", ohne.fehler());
+
+  bool ok = glyphen_ok && seite_ok && !fehler && !modell.zu_frueh && diff.max_us < 4000 && seite.fehler() && ohne_ok;
+  printf("%s\n", ok ? "ok" : "FEHLER");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+/* =====================================================
+   SIMULATION: TASTER AN DER WIDERSTANDSLEITER
+   =====================================================
+
+   Speist TasterLeiter::abtasten() mit synthetischen ADC-
+   Werten in virtueller Zeit, wie die ADC-ISR auf dem Mega:
+
+     - Leiter wie im Sketch (10k Pull-up, LEITER_SCHWELLEN)
+     - jede Flanke prellt PRELL_MS lang zwischen dem Wert der
+       Taste und "keine Taste"
+     - Rauschen +-RAUSCHEN LSB auf jeder Abtastung
+     - kurze Störimpulse, die kein Ereignis auslösen dürfen
+
+   Geprüft wird, dass genau die gedrückten Tasten in der
+   richtigen Reihenfolge im Ringpuffer ankommen (gedrückt und
+   losgelassen), mit der Zeit der ersten Rohflanke. Ausgegeben
+   werden die Latenz (erste Rohflanke bis Ringpuffer, virtuelle
+   Zeit) und die Rechenzeit pro Abtastung auf dem PC.
+
+   Bauen (aus diesem Ordner):
+     g++ -std=c++17 -O2 -I. -I.. -I../../../lib/SimpleCollections/src LeiterSim.cpp \
+         ../../../lib/SimpleCollections/src/SCThreadingSupport.cpp -o leiter_sim
+
+   Aufruf:
+     ./leiter_sim [abtast_us]     (104 = Freilauf, 1024 = Timer0)
+   ===================================================== */
+
+#include <Arduino.h>
+#include <chrono>
+#include <vector>
+#include "TasterLeiter.h"
+
+#define SIM_DAUER_MS   60000
+#define PRELL_MS       5
+#define RAUSCHEN       2
+
+// Wie im Sketch
+static const uint8_t LEITER_SCHWELLEN[] PROGMEM = {16, 48, 77, 110, 140, 170, 205, 239};
+static const uint32_t LEITER_R[8] = {0, 1500, 3300, 5600, 10000, 15000, 27000, 68000};
+
+struct Druck {
+  uint32_t start_ms;
+  uint32_t dauer_ms;
+  uint8_t taste;
+  bool stoerung;       // kürzer als das Entprellen, kein Ereignis
+};
+
+struct Ereignis {
+  uint8_t taste;
+  uint8_t pegel;
+  uint32_t ms;         // erwartet: Beginn des Drucks bzw. Loslassens
+};
+
+static std::vector<Ereignis> empfangen;
+
+static uint32_t zufall_zustand = 1;
+static uint32_t zufall() {
+  zufall_zustand = zufall_zustand * 1664525UL + 1013904223UL;
+  return zufall_zustand >> 8;
+}
+
+static uint8_t spannung(uint8_t taste) {
+  if (taste == LEITER_KEINE) return 255;
+  uint32_t r = LEITER_R[taste];
+  return r * 255 / (r + 10000);
+}
+
+int main(int argc, char **argv) {
+  uint32_t abtast_us = argc > 1 ? strtoul(argv[1], NULL, 10) : 104;
+
+  // Jede Taste mehrmals, mit wechselnden Haltezeiten, dazwischen Störimpulse
+  std::vector<Druck> drucke;
+  uint32_t t = 500;
+  for (uint8_t runde = 0; runde < 6; runde++) {
+    for (uint8_t taste = 0; taste < 8; taste++) {
+      drucke.push_back({t, 60 + (uint32_t)(zufall() % 400), taste, false});
+      t += 700;
+      if ((taste & 3) == runde % 4) {
+        drucke.push_back({t, 1 + (uint32_t)(zufall() % (LEITER_ENTPRELL_MS / 2)), (uint8_t)(zufall() % 8), true});
+        t += 300;
+      }
+    }
+  }
+
+  TasterLeiter leiter(LEITER_SCHWELLEN, sizeof(LEITER_SCHWELLEN));
+  TasterFlanken flanken(8);
+  leiter.starten(A0, flanken);
+  auto abholen = [&]() {
+    TasterFlanke f;
+    while (flanken.get(f)) empfangen.push_back({f.taster, f.pegel, f.ms});
+  };
+
+  std::vector<Ereignis> erwartet;
+  size_t naechster = 0;
+  uint32_t abtastungen = 0;
+  uint64_t rechen_ns = 0;
+  uint32_t letzte_loop = 0;
+
+  while (host_zeit_us < (uint64_t)SIM_DAUER_MS * 1000) {
+    uint32_t jetzt = host_zeit_us / 1000;
+    while (naechster < drucke.size() && jetzt >= drucke[naechster].start_ms + drucke[naechster].dauer_ms + PRELL_MS) {
+      naechster++;
+    }
+
+    // Rohwert: Taste gedrückt, mit Prellen an beiden Flanken
+    uint8_t taste = LEITER_KEINE;
+    if (naechster < drucke.size() && jetzt >= drucke[naechster].start_ms) {
+      const Druck &d = drucke[naechster];
+      uint32_t seit = jetzt - d.start_ms;
+      uint32_t ende = d.dauer_ms;
+      bool prellt = seit < PRELL_MS || (seit >= ende && seit < ende + PRELL_MS);
+      bool gedrueckt = seit < ende;
+      if (prellt) gedrueckt = zufall() & 1;
+      if (gedrueckt) taste = d.taste;
+    }
+    int wert = spannung(taste) + (int)(zufall() % (2 * RAUSCHEN + 1)) - RAUSCHEN;
+    wert = wert < 0 ? 0 : (wert > 255 ? 255 : wert);
+
+    auto a = std::chrono::steady_clock::now();
+    leiter.abtasten(wert);
+    rechen_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - a).count();
+    abtastungen++;
+
+    // Loop etwa jede Millisekunde
+    if (jetzt != letzte_loop) {
+      letzte_loop = jetzt;
+      abholen();
+    }
+    host_zeit_vorstellen(abtast_us);
+  }
+  abholen();
+
+  for (const Druck &d : drucke) {
+    if (d.stoerung) continue;
+    erwartet.push_back({d.taste, LOW, d.start_ms});
+    erwartet.push_back({d.taste, HIGH, d.start_ms + d.dauer_ms});
+  }
+
+  // Die Flankenzeit ist die erste Rohflanke: beim Drücken der
+  // Beginn, beim Loslassen kann sie ins Prellen fallen
+  uint32_t fehler = 0;
+  uint32_t zeit_max = 0;
+  size_t n = max(erwartet.size(), empfangen.size());
+  for (size_t i = 0; i < n; i++) {
+    bool ok = i < erwartet.size() && i < empfangen.size() && erwartet[i].taste == empfangen[i].taste &&
+              erwartet[i].pegel == empfangen[i].pegel;
+    if (ok) {
+      uint32_t abweichung = empfangen[i].ms - erwartet[i].ms;
+      if (abweichung > zeit_max) zeit_max = abweichung;
+      ok = abweichung <= PRELL_MS + abtast_us / 1000 + 1;   // plus eine Abtastung
+    }
+    if (ok) continue;
+    if (fehler++ < 10) {
+      printf("Abweichung bei Ereignis %zu: erwartet ", i);
+      if (i < erwartet.size()) printf("%u/%s", erwartet[i].taste, erwartet[i].pegel == LOW ? "gedrückt" : "los");
+      else printf("-");
+      printf(", bekommen ");
+      if (i < empfangen.size()) printf("%u/%s\n", empfangen[i].taste, empfangen[i].pegel == LOW ? "gedrückt" : "los");
+      else printf("-\n");
+    }
+  }
+
+  printf("Abtastung alle %lu us, %lu Abtastungen, %zu Drücke\n", (unsigned long)abtast_us,
+         (unsigned long)abtastungen, erwartet.size() / 2);
+  printf("Ereignisse: %zu erwartet, %zu bekommen, %lu falsch, %u verloren\n", erwartet.size(),
+         empfangen.size(), (unsigned long)fehler, leiter.verloren());
+  printf("Latenz (Rohflanke bis Ringpuffer): letzte %lu us, max %lu us (Entprellen %u ms)\n",
+         (unsigned long)leiter.latenz_letzte_us(), (unsigned long)leiter.latenz_max_us(), LEITER_ENTPRELL_MS);
+  printf("Flankenzeit: höchstens %lu ms nach Druck bzw. Loslassen (Prellen %u ms)\n", (unsigned long)zeit_max,
+         PRELL_MS);
+  printf("Rechenzeit PC: %.1f ns/Abtastung\n", (double)rechen_ns / abtastungen);
+  return fehler ? 1 : 0;
+}
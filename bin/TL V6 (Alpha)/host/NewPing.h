@@ -0,0 +1,43 @@
+/* Host-Ersatz für NewPing.h: Abstände kommen aus host_sonar_cm[]
+   (Index = Triggerpin). Ein Ping kostet virtuelle Zeit wie in echt:
+   57 µs pro cm Laufweg, ohne Echo bis zur Maximaldistanz. */
+
+#ifndef HOST_NEWPING_H
+#define HOST_NEWPING_H
+
+#include <Arduino.h>
+
+#define US_ROUNDTRIP_CM 57
+
+inline uint16_t host_sonar_cm[HOST_PINS] = {0};   // 0 = kein Echo
+inline uint64_t host_ping_us = 0;                  // Summe aller Pingzeiten (Strommodell)
+
+class NewPing {
+public:
+  NewPing(uint8_t trigger_pin, uint8_t echo_pin, unsigned int max_cm_distance = 500)
+    : _trigger(trigger_pin), _max_cm(max_cm_distance) { (void)echo_pin; }
+
+  // Echozeit in µs, 0 = kein Echo
+  unsigned int ping(unsigned int max_cm_distance = 0) {
+    unsigned int grenze = max_cm_distance ? max_cm_distance : _max_cm;
+    unsigned int cm = _trigger < HOST_PINS ? host_sonar_cm[_trigger] : 0;
+    if (cm > grenze) cm = 0;
+    delayMicroseconds((cm ? cm : grenze) * US_ROUNDTRIP_CM);
+    host_ping_us += (cm ? cm : grenze) * US_ROUNDTRIP_CM;
+    return cm * US_ROUNDTRIP_CM;
+  }
+
+  unsigned long ping_cm(unsigned int max_cm_distance = 0) {
+    return convert_cm(ping(max_cm_distance));
+  }
+
+  static unsigned int convert_cm(unsigned int echo_us) {
+    return echo_us ? max((echo_us + US_ROUNDTRIP_CM / 2) / US_ROUNDTRIP_CM, 1U) : 0;
+  }
+
+private:
+  uint8_t _trigger;
+  unsigned int _max_cm;
+};
+
+#endif
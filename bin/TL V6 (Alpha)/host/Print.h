@@ -0,0 +1,8 @@
+/* Host-Ersatz für Print.h: Print steckt in host/Arduino.h */
+
+#ifndef HOST_PRINT_H
+#define HOST_PRINT_H
+
+#include <Arduino.h>
+
+#endif
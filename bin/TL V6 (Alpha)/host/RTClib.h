@@ -0,0 +1,40 @@
+/* Host-Ersatz für lib/RTClib: die DS3231 zählt ab host_rtc_basis
+   mit der virtuellen Zeit mit, um host_rtc_ppm schneller bzw.
+   langsamer als millis() (Gang eines echten Quarzes gegen den
+   Quarz des Mega). Nur was Kalender.h braucht. */
+
+#ifndef HOST_RTCLIB_H
+#define HOST_RTCLIB_H
+
+#include <Arduino.h>
+
+inline uint32_t host_rtc_basis = 1774436400UL;   // RTC bei host_zeit_us = 0: Mi 25.3.2026 12:00 MEZ
+inline int32_t host_rtc_ppm = 0;
+inline bool host_rtc_strom_weg = false;           // lostPower()
+
+inline uint32_t host_rtc_sekunden() {
+  int64_t us = host_zeit_us + (int64_t)host_zeit_us * host_rtc_ppm / 1000000;
+  return host_rtc_basis + (uint32_t)(us / 1000000);
+}
+
+class DateTime {
+public:
+  DateTime(uint32_t t = 946684800UL) : _t(t) {}
+  uint32_t unixtime() const { return _t; }
+
+private:
+  uint32_t _t;
+};
+
+class RTC_DS3231 {
+public:
+  bool begin() { return true; }
+  bool lostPower() { return host_rtc_strom_weg; }
+  DateTime now() { return DateTime(host_rtc_sekunden()); }
+  void adjust(const DateTime &dt) {
+    host_rtc_basis += dt.unixtime() - host_rtc_sekunden();
+    host_rtc_strom_weg = false;
+  }
+};
+
+#endif
@@ -0,0 +1,61 @@
+/* Host-Ersatz für SD.h: Dateien liegen in einem normalen
+   Ordner (host_sd_ordner, Standard "."), so kann z.B. eine
+   Sensorspur von der Karte auf dem PC abgespielt werden. */
+
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include <Arduino.h>
+#include <string>
+
+#define FILE_READ  0
+#define FILE_WRITE 1   // wie auf der Karte: anhängen
+
+inline const char *host_sd_ordner = ".";
+
+inline std::string host_sd_pfad(const char *name) {
+  return std::string(host_sd_ordner) + "/" + name;
+}
+
+class File : public Stream {
+public:
+  File(FILE *f = NULL) : _f(f) {}
+
+  size_t write(uint8_t c) { return _f && fputc(c, _f) != EOF ? 1 : 0; }
+  size_t write(const uint8_t *puffer, size_t n) { return _f ? fwrite(puffer, 1, n, _f) : 0; }
+  int read() { return _f ? fgetc(_f) : -1; }
+  int read(void *puffer, uint16_t n) { return _f ? (int)fread(puffer, 1, n, _f) : -1; }
+  int peek() {
+    int c = read();
+    if (c != EOF) ungetc(c, _f);
+    return c;
+  }
+  int available() { return peek() != EOF; }
+  void flush() { if (_f) fflush(_f); }
+  void close() {
+    if (_f) fclose(_f);
+    _f = NULL;
+  }
+  operator bool() const { return _f != NULL; }
+
+private:
+  FILE *_f;
+};
+
+class SDClass {
+public:
+  bool begin(uint8_t cs = 0) { (void)cs; return true; }
+  File open(const char *name, uint8_t modus = FILE_READ) {
+    return File(fopen(host_sd_pfad(name).c_str(), modus == FILE_WRITE ? "ab" : "rb"));
+  }
+  bool exists(const char *name) {
+    FILE *f = fopen(host_sd_pfad(name).c_str(), "rb");
+    if (f) fclose(f);
+    return f != NULL;
+  }
+  bool remove(const char *name) { return ::remove(host_sd_pfad(name).c_str()) == 0; }
+};
+
+inline SDClass SD;
+
+#endif
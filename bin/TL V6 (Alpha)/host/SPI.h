@@ -0,0 +1,18 @@
+/* Host-Ersatz für SPI.h: der Sketch bindet ihn nur für die
+   Bausteine am gemeinsamen Bus ein, deren Host-Ersatz selbst
+   kein SPI braucht. */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+class SPIClass {
+public:
+  void begin() {}
+  void end() {}
+};
+
+inline SPIClass SPI;
+
+#endif
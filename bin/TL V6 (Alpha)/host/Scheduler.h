@@ -0,0 +1,125 @@
+/* Host-Ersatz für lib/Scheduler (kooperative Fäden auf ARM):
+   jeder Faden ist ein ucontext mit eigenem Stack, yield() und
+   delay() (über host_yield in Arduino.h) wechseln reihum zum
+   nächsten Faden, loop() ist wie auf dem Due Faden 0.
+
+   Die Stacks werden wie in der Bibliothek vorbelegt, damit
+   stackUnused() funktioniert. x86-64 braucht aber deutlich mehr
+   Stack als ein Cortex-M, daher bekommt jeder Faden mindestens
+   HOST_FADEN_STACK Bytes - die Zahlen taugen zum Vergleichen
+   der Fäden untereinander, nicht zum Dimensionieren. */
+
+#ifndef HOST_SCHEDULER_H
+#define HOST_SCHEDULER_H
+
+#include <Arduino.h>
+#include <ucontext.h>
+#include <vector>
+
+#define SCHEDULER_STACK_FILL 0xA5
+#define HOST_FADEN_STACK     (64 * 1024)
+
+typedef void (*SchedulerTask)(void);
+typedef void (*SchedulerParametricTask)(void *);
+
+struct HostFaden {
+  ucontext_t kontext;
+  uint8_t *stack;
+  uint32_t groesse;
+  uint8_t id;
+  SchedulerParametricTask funktion;
+  void *daten;
+  bool fertig;
+};
+
+inline std::vector<HostFaden *> host_faeden;   // [0] = loop()
+inline size_t host_faden_jetzt = 0;
+inline uint32_t host_faden_wechsel = 0;
+
+inline void host_faden_weiter() {
+  size_t alt = host_faden_jetzt;
+  size_t neu = alt;
+  do {
+    neu = (neu + 1) % host_faeden.size();
+  } while (host_faeden[neu]->fertig && neu != alt);
+  if (neu == alt) return;
+  host_faden_jetzt = neu;
+  host_faden_wechsel++;
+  swapcontext(&host_faeden[alt]->kontext, &host_faeden[neu]->kontext);
+}
+
+inline void host_faden_einstieg() {
+  HostFaden *f = host_faeden[host_faden_jetzt];
+  f->funktion(f->daten);
+  // Fertig: nie wieder einplanen, der Stack bleibt einfach liegen
+  f->fertig = true;
+  host_faden_weiter();
+}
+
+class SchedulerClass {
+public:
+  static uint8_t startLoop(SchedulerTask task, uint32_t stackSize = 1024) {
+    return starten(schleife, (void *)task, stackSize);
+  }
+  static uint8_t start(SchedulerTask task, uint32_t stackSize = 1024) {
+    return starten(einmal, (void *)task, stackSize);
+  }
+  static uint8_t start(SchedulerParametricTask task, void *data, uint32_t stackSize = 1024) {
+    return starten(task, data, stackSize);
+  }
+
+  static void yield() { ::yield(); }
+
+  static uint32_t stackSize(uint8_t taskId) {
+    HostFaden *f = finden(taskId);
+    return f ? f->groesse : 0;
+  }
+  static uint32_t stackUnused(uint8_t taskId) {
+    HostFaden *f = finden(taskId);
+    if (!f || !f->stack) return 0;
+    uint32_t frei = 0;
+    while (frei < f->groesse && f->stack[frei] == SCHEDULER_STACK_FILL) frei++;
+    return frei;
+  }
+  static uint8_t currentTask() { return host_faeden.empty() ? 0 : host_faeden[host_faden_jetzt]->id; }
+  static uint32_t switches() { return host_faden_wechsel; }
+
+private:
+  static void schleife(void *daten) {
+    while (true) ((SchedulerTask)daten)();
+  }
+  static void einmal(void *daten) { ((SchedulerTask)daten)(); }
+
+  static HostFaden *finden(uint8_t id) {
+    for (HostFaden *f : host_faeden) {
+      if (f->id == id && !f->fertig) return f;
+    }
+    return NULL;
+  }
+
+  static uint8_t starten(SchedulerParametricTask funktion, void *daten, uint32_t groesse) {
+    if (host_faeden.empty()) {
+      // Der laufende Kontext (setup/loop) wird Faden 0
+      host_faeden.push_back(new HostFaden{});
+      host_yield = host_faden_weiter;
+    }
+    HostFaden *f = new HostFaden{};
+    f->groesse = max(groesse, (uint32_t)HOST_FADEN_STACK);
+    f->stack = (uint8_t *)malloc(f->groesse);
+    memset(f->stack, SCHEDULER_STACK_FILL, f->groesse);
+    f->id = host_faeden.size();
+    f->funktion = funktion;
+    f->daten = daten;
+    getcontext(&f->kontext);
+    f->kontext.uc_stack.ss_sp = f->stack;
+    f->kontext.uc_stack.ss_size = f->groesse;
+    f->kontext.uc_link = NULL;
+    makecontext(&f->kontext, host_faden_einstieg, 0);
+    host_faeden.push_back(f);
+    return f->id;
+  }
+};
+
+inline SchedulerClass Scheduler;
+
+#endif
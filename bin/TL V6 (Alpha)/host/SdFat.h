@@ -0,0 +1,202 @@
+/* Host-Ersatz für SdFat.h, nur was Sektorlog.h braucht:
+   SdFs (begin, remove, card), FsFile (open, preAllocate,
+   contiguousRange) und eine Karte mit writeSector/readSector
+   und isBusy. Dateien liegen wie bei host/SD.h im Ordner
+   host_sd_ordner, ein Sektor ist ein 512-Byte-Stück der Datei.
+
+   Karte:
+     - Übertragung eines Sektors: HOST_SD_UEBERTRAGUNG_US
+     - danach programmiert sie host_sd_programmieren(sektor) µs
+       (Standard 0) und meldet so lange isBusy()
+     - writeSector() auf eine belegte Karte wartet wie die echte
+       (cardCommand -> waitReady), die virtuelle Zeit läuft weiter
+     - mit CHECK_FLASH_PROGRAMMING (Standard 1 wie SdFatConfig.h,
+       für Sektorlog.h per -DCHECK_FLASH_PROGRAMMING=0 aus) wartet
+       writeSector() danach auch auf das eigene Programmieren
+       (waitReady + CMD13)
+     - host_sd_letzter hält den zuletzt geschriebenen Sektor mit
+       dem alten Inhalt, für Stromausfall-Simulationen
+   host_sd_schreibfehler(sektor) lässt einzelne writeSector()
+   fehlschlagen (Standard nie), der Sektor bleibt dann wie er war.
+   Vorbelegte Dateien enthalten host_sd_altinhalt (alte Daten
+   aus gelöschten Dateien in denselben Clustern), danach
+   host_sd_altdaten (Standard 0xFF wie frisch gelöscht). */
+
+#ifndef HOST_SDFAT_H
+#define HOST_SDFAT_H
+
+#include <Arduino.h>
+#include <fcntl.h>
+#include <string>
+#include <vector>
+
+#ifndef CHECK_FLASH_PROGRAMMING
+#define CHECK_FLASH_PROGRAMMING 1   // wie lib/SdFat_-_Adafruit_Fork/src/SdFatConfig.h
+#endif
+
+#define SHARED_SPI    0
+#define DEDICATED_SPI 1
+#define SD_SCK_MHZ(m) (1000000UL * (m))
+
+#define HOST_SD_UEBERTRAGUNG_US 700   // CMD24 + 512 Byte bei 8 MHz SPI
+#define HOST_SD_SEKTOR_BITS     24    // Sektornummer = Datei << 24 | Sektor in der Datei
+
+typedef int oflag_t;
+
+struct SdSpiConfig {
+  SdSpiConfig(uint8_t cs, uint8_t optionen, uint32_t takt) { (void)cs; (void)optionen; (void)takt; }
+};
+
+inline const char *host_sd_ordner = ".";
+inline uint32_t (*host_sd_programmieren)(uint32_t sektor) = NULL;
+inline bool (*host_sd_schreibfehler)(uint32_t sektor) = NULL;
+inline uint8_t host_sd_altdaten = 0xFF;
+inline std::vector<uint8_t> host_sd_altinhalt;
+
+struct HostSdSektor {
+  std::string pfad;
+  long versatz = -1;   // -1 = noch keiner
+  uint8_t alt[512];
+};
+inline HostSdSektor host_sd_letzter;
+
+// Dateinamen <-> Sektorbereich, pro Prozess
+inline std::vector<std::string> &host_sd_dateien() {
+  static std::vector<std::string> dateien;
+  return dateien;
+}
+
+inline uint32_t host_sd_basis(const std::string &pfad) {
+  std::vector<std::string> &d = host_sd_dateien();
+  for (size_t i = 0; i < d.size(); i++) {
+    if (d[i] == pfad) return (uint32_t)(i + 1) << HOST_SD_SEKTOR_BITS;
+  }
+  d.push_back(pfad);
+  return (uint32_t)d.size() << HOST_SD_SEKTOR_BITS;
+}
+
+class SdCard {
+public:
+  bool isBusy() { return host_zeit_us < _belegt_bis; }
+
+  bool writeSector(uint32_t sektor, const uint8_t *quelle) {
+    if (isBusy()) {
+      _gewartet++;
+      host_zeit_vorstellen(_belegt_bis - host_zeit_us);
+    }
+    if (host_sd_schreibfehler && host_sd_schreibfehler(sektor)) {
+      host_zeit_vorstellen(HOST_SD_UEBERTRAGUNG_US);
+      return false;
+    }
+    FILE *f = oeffnen(sektor, "r+b");
+    if (!f) return false;
+    long versatz = (long)(sektor & ((1UL << HOST_SD_SEKTOR_BITS) - 1)) * 512;
+    host_sd_letzter.pfad = pfad(sektor);
+    host_sd_letzter.versatz = versatz;
+    fseek(f, versatz, SEEK_SET);
+    if (fread(host_sd_letzter.alt, 1, 512, f) != 512) memset(host_sd_letzter.alt, host_sd_altdaten, 512);
+    fseek(f, versatz, SEEK_SET);
+    bool ok = fwrite(quelle, 1, 512, f) == 512;
+    fclose(f);
+    host_zeit_vorstellen(HOST_SD_UEBERTRAGUNG_US);
+    _belegt_bis = host_zeit_us + (host_sd_programmieren ? host_sd_programmieren(sektor) : 0);
+#if CHECK_FLASH_PROGRAMMING
+    if (isBusy()) {
+      _programmiert++;
+      host_zeit_vorstellen(_belegt_bis - host_zeit_us);
+    }
+#endif
+    return ok;
+  }
+
+  bool readSector(uint32_t sektor, uint8_t *ziel) {
+    FILE *f = oeffnen(sektor, "rb");
+    if (!f) return false;
+    fseek(f, (long)(sektor & ((1UL << HOST_SD_SEKTOR_BITS) - 1)) * 512, SEEK_SET);
+    bool ok = fread(ziel, 1, 512, f) == 512;
+    fclose(f);
+    return ok;
+  }
+
+  uint32_t gewartet() const { return _gewartet; }   // writeSector() auf belegte Karte
+  uint32_t programmiert() const { return _programmiert; }   // writeSector() auf das eigene Programmieren
+
+private:
+  static std::string pfad(uint32_t sektor) {
+    uint32_t datei = sektor >> HOST_SD_SEKTOR_BITS;
+    std::vector<std::string> &d = host_sd_dateien();
+    return datei && datei <= d.size() ? d[datei - 1] : std::string();
+  }
+
+  static FILE *oeffnen(uint32_t sektor, const char *modus) {
+    std::string p = pfad(sektor);
+    return p.empty() ? NULL : fopen(p.c_str(), modus);
+  }
+
+  uint64_t _belegt_bis = 0;
+  uint32_t _gewartet = 0;
+  uint32_t _programmiert = 0;
+};
+
+class FsFile {
+public:
+  bool open(const char *name, oflag_t flags = O_RDONLY) {
+    _pfad = std::string(host_sd_ordner) + "/" + name;
+    FILE *f = fopen(_pfad.c_str(), (flags & O_TRUNC) ? "w+b" : (flags & O_CREAT) ? "a+b" : "rb");
+    if (!f) return false;
+    fclose(f);
+    _offen = true;
+    return true;
+  }
+
+  // Wie auf der Karte: volle Größe, Inhalt sind alte Daten
+  bool preAllocate(uint64_t bytes) {
+    FILE *f = fopen(_pfad.c_str(), "r+b");
+    if (!f) return false;
+    uint64_t n = std::min<uint64_t>(host_sd_altinhalt.size(), bytes);
+    fwrite(host_sd_altinhalt.data(), 1, (size_t)n, f);
+    std::vector<uint8_t> alt(65536, host_sd_altdaten);
+    for (; n < bytes; n += alt.size()) {
+      fwrite(alt.data(), 1, (size_t)std::min<uint64_t>(alt.size(), bytes - n), f);
+    }
+    fclose(f);
+    return true;
+  }
+
+  bool contiguousRange(uint32_t *erster, uint32_t *letzter) {
+    FILE *f = fopen(_pfad.c_str(), "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long groesse = ftell(f);
+    fclose(f);
+    if (groesse < 512) return false;
+    *erster = host_sd_basis(_pfad);
+    *letzter = *erster + groesse / 512 - 1;
+    return true;
+  }
+
+  bool close() {
+    _offen = false;
+    return true;
+  }
+  operator bool() const { return _offen; }
+
+private:
+  std::string _pfad;
+  bool _offen = false;
+};
+
+class SdFs {
+public:
+  bool begin(SdSpiConfig konfiguration) {
+    (void)konfiguration;
+    return true;
+  }
+  bool remove(const char *name) { return ::remove((std::string(host_sd_ordner) + "/" + name).c_str()) == 0; }
+  SdCard *card() { return &_karte; }
+
+private:
+  SdCard _karte;
+};
+
+#endif
@@ -0,0 +1,270 @@
+/* =====================================================
+   SIMULATION: SENSORSPUR ALS ROHE SEKTOREN
+   =====================================================
+
+   SensorSpur.h mit SPUR_SEKTOREN=1 (Sektorlog.h) auf der
+   Karte aus host/SdFat.h, in virtueller Zeit:
+
+     - eine Stunde Aufnahme wie im Sketch: ein Ping pro Loop
+       (LOOP_US), ab und zu eine Tasterflanke
+     - die Karte programmiert jeden Sektor 0,2..1,5 ms, ab und
+       zu räumt sie intern auf und ist 100..250 ms belegt
+     - Vergleich: dieselbe Datenrate über SD/File, das bei
+       jedem flush() auch den Verzeichniseintrag schreibt und
+       dafür auf die Karte wartet
+     - Stromausfall an zufälligen Stellen, der letzte Sektor
+       teils halb geschrieben, in Clustern mit einer alten
+       Aufnahme. Gelesen werden muss genau ein Anfang des
+       geschriebenen Bytestroms, verloren höchstens, was noch
+       im RAM stand, plus der zerrissene Sektor.
+     - in jedem dritten Lauf schlagen einzelne writeSector()
+       fehl: wiederholt, also ohne Lücke im Strom
+
+   Bauen (aus diesem Ordner):
+     g++ -std=c++17 -O2 -DCHECK_FLASH_PROGRAMMING=0 -I. -I.. SektorlogSim.cpp -o sektorlog_sim
+   Das Build-Flag wie im Sketch (Sektorlog.h). Ohne, also wie
+   SdFat ab Werk, wartet jeder writeSector() aufs Programmieren
+   (Warnung aus Sektorlog.h, Ergebnis FEHLER).
+
+   Aufruf:
+     ./sektorlog_sim
+   ===================================================== */
+
+#define SPUR_SEKTOREN 1
+
+#include <Arduino.h>
+#include <random>
+#include <stdlib.h>
+#include <vector>
+#include "SensorSpur.h"
+
+#define SIM_DAUER_MS   3600000UL
+#define LOOP_US        10000     // Ping + Auswertung pro Loop
+#define DATEI_BYTES    (4UL * 1048576)
+#define AUFRAEUMEN     300       // jeder soundsovielte Sektor: 100..250 ms belegt
+#define AUSFAELLE      200
+#define AUSFALL_MS     600000UL  // Aufnahme bis zum Stromausfall höchstens
+#define SCHREIBFEHLER  50        // jeder soundsovielte writeSector() schlägt fehl (jeder dritte Ausfall)
+
+static std::mt19937 zufall;
+
+static uint32_t karte_programmieren(uint32_t sektor) {
+  (void)sektor;
+  if (zufall() % AUFRAEUMEN == 0) return 100000 + zufall() % 150001;
+  return 200 + zufall() % 1301;
+}
+
+static bool karte_schreibfehler(uint32_t sektor) {
+  (void)sektor;
+  return zufall() % SCHREIBFEHLER == 0;
+}
+
+struct Messung {
+  uint32_t max_us = 0;
+  uint32_t ueber_1ms = 0;
+  uint32_t ueber_10ms = 0;
+  uint64_t summe_us = 0;
+  uint32_t loops = 0;
+
+  void zaehlen(uint64_t us) {
+    if (us > max_us) max_us = us;
+    if (us > 1000) ueber_1ms++;
+    if (us > 10000) ueber_10ms++;
+    summe_us += us;
+    loops++;
+  }
+
+  void drucken(const char *name) const {
+    printf("  %-22s max %7u us  >1 ms %6u  >10 ms %5u  Summe %8.1f ms\n", name, max_us, ueber_1ms, ueber_10ms,
+           summe_us / 1000.0);
+  }
+};
+
+// Eine Loop der Aufnahme: Ping, ab und zu ein Taster
+static void spur_loop(SpurSchreiber &spur, uint32_t i) {
+  spur.echo(i % 4, zufall() % 3 ? 0 : 600 + zufall() % 20000);
+  if (zufall() % 2000 == 0) spur.taster(zufall() % 5, i & 1);
+}
+
+// -------------------------
+// LATENZ
+// -------------------------
+static Messung latenz_sektoren(SdFs &sd, SpurSchreiber &spur) {
+  Messung m;
+  zufall.seed(1);
+  spur.starten(sd, "SPUR.BIN", DATEI_BYTES);
+  for (uint32_t i = 0; (uint64_t)i * LOOP_US < SIM_DAUER_MS * 1000ULL; i++) {
+    spur_loop(spur, i);
+    uint64_t start = host_zeit_us;
+    spur.bearbeiten();
+    uint64_t dauer = host_zeit_us - start;
+    m.zaehlen(dauer);
+    if (dauer < LOOP_US) host_zeit_vorstellen(LOOP_US - dauer);
+  }
+  return m;
+}
+
+// Zum Vergleich wie SD/File: volle Sektoren sofort, flush()
+// schreibt den angefangenen Sektor und den Verzeichniseintrag,
+// jeder neue Cluster (64 Sektoren) einen FAT-Sektor. Jeder
+// writeSector() wartet, bis die Karte den vorigen programmiert hat.
+static Messung latenz_wartend(SdFs &sd) {
+  Messung m;
+  zufall.seed(1);
+  FsFile datei;
+  uint32_t sektor, ende;
+  sd.remove("WARTEND.BIN");
+  datei.open("WARTEND.BIN", O_RDWR | O_CREAT | O_TRUNC);
+  datei.preAllocate(DATEI_BYTES);
+  datei.contiguousRange(&sektor, &ende);
+  datei.close();
+  uint32_t fat = ende, verzeichnis = ende - 1;   // stehen hier für die Verwaltungssektoren
+  uint8_t puffer[SEKTOR_BYTES] = {0};
+  uint16_t offen = 0;
+  uint32_t letzter_sync = millis();
+  for (uint32_t i = 0; (uint64_t)i * LOOP_US < SIM_DAUER_MS * 1000ULL; i++) {
+    uint64_t start = host_zeit_us;
+    offen += sizeof(SpurEintrag);
+    if (zufall() % 2000 == 0) offen += sizeof(SpurEintrag);
+    if (offen >= SEKTOR_BYTES) {
+      sd.card()->writeSector(sektor++, puffer);
+      offen -= SEKTOR_BYTES;
+      if (sektor % 64 == 0) sd.card()->writeSector(fat, puffer);
+    }
+    if (millis() - letzter_sync >= 1000) {
+      sd.card()->writeSector(sektor, puffer);
+      sd.card()->writeSector(verzeichnis, puffer);
+      letzter_sync = millis();
+    }
+    uint64_t dauer = host_zeit_us - start;
+    m.zaehlen(dauer);
+    if (dauer < LOOP_US) host_zeit_vorstellen(LOOP_US - dauer);
+  }
+  return m;
+}
+
+// -------------------------
+// STROMAUSFALL
+// -------------------------
+static uint8_t strom_byte(uint32_t i, uint8_t lauf) {
+  return (uint8_t)(i * 2654435761UL >> 24) ^ lauf;
+}
+
+// Aufnahme mit bekanntem Bytestrom bis zum Ausfall nach ms;
+// liefert, wie viele Bytes write() angenommen hat
+static uint32_t strom_aufnahme(SektorSchreiber &schreiber, uint32_t ms, uint8_t lauf) {
+  uint32_t gegeben = 0;
+  uint32_t letzter_flush = millis();
+  uint8_t eintrag[sizeof(SpurEintrag)];
+  for (uint32_t t = 0; t < ms; t += LOOP_US / 1000) {
+    for (uint8_t k = 0; k < sizeof(eintrag); k++) eintrag[k] = strom_byte(gegeben + k, lauf);
+    gegeben += schreiber.write(eintrag, sizeof(eintrag));
+    if (millis() - letzter_flush >= SPUR_SYNC_MS) {
+      schreiber.flush();
+      letzter_flush = millis();
+    }
+    host_zeit_vorstellen(LOOP_US);
+  }
+  return gegeben;
+}
+
+static bool stromausfall(uint32_t *max_verlust) {
+  uint32_t fehler = 0;
+  uint32_t gerissen = 0;
+  uint32_t schreibfehler = 0;
+  *max_verlust = 0;
+
+  // Alte, längere Aufnahme in denselben Clustern, anderer Inhalt
+  std::vector<uint8_t> alte_aufnahme(DATEI_BYTES);
+  host_sd_altinhalt.clear();
+  {
+    SdFs sd;
+    SektorSchreiber alt;
+    host_zeit_us = 5000000;
+    alt.anlegen(sd, "STROM.BIN", DATEI_BYTES);
+    strom_aufnahme(alt, AUSFALL_MS + 60000, 0x5A);
+    alt.close();
+    FILE *f = fopen((std::string(host_sd_ordner) + "/STROM.BIN").c_str(), "rb");
+    fread(alte_aufnahme.data(), 1, DATEI_BYTES, f);
+    fclose(f);
+  }
+
+  for (uint32_t n = 0; n < AUSFAELLE; n++) {
+    // Neustart: gleiche Uhrzeit wie bei der alten Aufnahme
+    SdFs sd;
+    SektorSchreiber schreiber;
+    host_zeit_us = 5000000;
+    if (n % 4 == 3) {
+      host_sd_altinhalt.clear();
+    } else {
+      host_sd_altinhalt = alte_aufnahme;
+    }
+    schreiber.anlegen(sd, "STROM.BIN", DATEI_BYTES);
+    host_sd_schreibfehler = n % 3 == 2 ? karte_schreibfehler : NULL;
+    uint32_t gegeben = strom_aufnahme(schreiber, 1000 + zufall() % AUSFALL_MS, 0);
+    host_sd_schreibfehler = NULL;
+    schreibfehler += schreiber.fehler();
+    if (schreiber.verloren()) fehler++;
+
+    // Strom weg mitten im Programmieren: vorne neu, hinten alt
+    if (n % 2 && host_sd_letzter.versatz >= 0) {
+      FILE *f = fopen(host_sd_letzter.pfad.c_str(), "r+b");
+      uint16_t schnitt = 1 + zufall() % (SEKTOR_BYTES - 1);
+      fseek(f, host_sd_letzter.versatz + schnitt, SEEK_SET);
+      fwrite(host_sd_letzter.alt + schnitt, 1, SEKTOR_BYTES - schnitt, f);
+      fclose(f);
+      gerissen++;
+    }
+
+    SektorLeser leser;
+    uint8_t puffer[100];
+    uint32_t gelesen = 0;
+    bool anfang = leser.oeffnen(sd, "STROM.BIN");
+    int k;
+    while (anfang && (k = leser.read(puffer, sizeof(puffer))) > 0) {
+      for (int j = 0; j < k; j++) {
+        if (puffer[j] != strom_byte(gelesen + j, 0)) anfang = false;
+      }
+      gelesen += k;
+    }
+    uint32_t verlust = gelesen < gegeben ? gegeben - gelesen : 0;
+    if (!anfang || gelesen > gegeben || verlust > (SEKTOR_PUFFER + 1) * SEKTOR_NUTZBYTES) {
+      printf("  Ausfall %u: %u Byte geschrieben, %u gelesen%s\n", n, gegeben, gelesen,
+             anfang ? "" : ", kein Anfang des Stroms");
+      fehler++;
+    }
+    if (verlust > *max_verlust) *max_verlust = verlust;
+  }
+  printf("  %u Ausfälle, davon %u mit zerrissenem Sektor, %u mit alter Aufnahme in den Clustern\n", AUSFAELLE,
+         gerissen, AUSFAELLE - AUSFAELLE / 4);
+  printf("  %u fehlgeschlagene writeSector() wiederholt\n", schreibfehler);
+  return fehler == 0;
+}
+
+int main() {
+  char ordner[] = "/tmp/sektorlog_XXXXXX";
+  host_sd_ordner = mkdtemp(ordner);
+  host_sd_programmieren = karte_programmieren;
+
+  printf("Eine Stunde Spur, Loop %u us, Karte räumt jeden %u. Sektor auf:\n", LOOP_US, AUFRAEUMEN);
+  SdFs sd;
+  SpurSchreiber spur;
+  Messung sektoren = latenz_sektoren(sd, spur);
+  sektoren.drucken("Sektorlog (isBusy)");
+  const SektorSchreiber &d = spur.datei();
+  printf("  %u Sektoren, writeSector max %u us, %u mal Karte belegt, %u Byte verloren, Spur verloren %u\n",
+         d.sektoren(), d.max_us(), d.aufgeschoben(), d.verloren(), spur.verloren());
+  uint32_t gewartet = sd.card()->gewartet() + sd.card()->programmiert();
+  if (gewartet) printf("  writeSector() hat %u mal auf die Karte gewartet\n", gewartet);
+  SdFs sd_wartend;
+  latenz_wartend(sd_wartend).drucken("wartend wie File");
+  printf("\nStromausfall:\n");
+  uint32_t max_verlust;
+  bool ok = stromausfall(&max_verlust) && !gewartet && !d.verloren() && !spur.verloren();
+  printf("  höchstens %u Byte verloren (RAM: %u)\n", max_verlust, SEKTOR_PUFFER * SEKTOR_NUTZBYTES);
+
+  std::string aufraeumen = std::string("rm -rf ") + ordner;
+  system(aufraeumen.c_str());
+  printf("%s\n", ok ? "ok" : "FEHLER");
+  return ok ? 0 : 1;
+}
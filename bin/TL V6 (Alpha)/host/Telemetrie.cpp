@@ -0,0 +1,698 @@
+/* =====================================================
+   TELEMETRIE-SAMMLER FÜR MEHRERE KREUZUNGEN (Linux)
+   =====================================================
+
+   Nimmt TelemetrieFrames (../Telemetrie.h) von vielen
+   Steuerungen an und führt pro Kreuzung gleitende
+   Kennzahlen in einer spaltenweisen Datei (mmap).
+
+   Aufbau:
+     Empfang    ein Thread liest über einen Transport:
+                  Rf24Transport - nRF24L01 wie im
+                    multiceiverDemo (lib/RF24/examples_linux)
+                  UdpTransport  - ein Frame pro Datagramm,
+                    recvmmsg() holt bis zu 64 auf einmal
+                  PipeTransport - Frames am Stück aus einer
+                    Datei/FIFO/stdin
+                und legt jeden Frame in den Ring SEINER
+                Kreuzung (ein Schreiber, ein Leser, ohne Lock).
+                Ist der Ring voll, geht der Frame bei Funk/UDP
+                verloren (zählt als Überlauf), eine Pipe wird
+                dagegen gebremst, bis wieder Platz ist
+     Auswertung ein Thread leert die Ringe und rechnet die
+                Kennzahlen direkt in die gemappte Datei
+
+   Kennzahlen pro Kreuzung (gleitend über KPI_FENSTER_S):
+     Fahrzeuge/h je Zufahrt, Frames, verlorene Frames
+     (Lücken in der Folgenummer), Ringüberläufe, letzter
+     Modus/Phase/Plan, Umlauf, Auslastung, Ereigniszähler,
+     größte Vorrang-Latenz, Empfangszeit des letzten Frames.
+
+   KPI-Datei (spaltenweise, für numpy/pandas per memmap):
+     KpiKopf, dann pro Spalte ein Array über alle
+     TELEMETRIE_KREUZUNGEN, Lage und Typ stehen im Kopf.
+     msync() höchstens einmal pro KPI_SYNC_MS.
+
+   Bauen (aus diesem Ordner):
+     g++ -std=c++17 -O2 -I.. Telemetrie.cpp -o telemetrie -pthread
+   mit Funk (RF24-Linux-Build installiert, siehe lib/RF24):
+     g++ -std=c++17 -O2 -I.. -DTELEMETRIE_RF24 Telemetrie.cpp \
+         -o telemetrie -pthread -lrf24
+
+   Aufruf:
+     ./telemetrie --udp PORT [kpi.bin]
+     ./telemetrie --pipe PFAD|- [kpi.bin]
+     ./telemetrie --rf24 [kpi.bin]
+     ./telemetrie --zeigen kpi.bin
+     ./telemetrie --bench [kreuzungen] [frames] [udp|pipe]
+   ===================================================== */
+
+#include "Telemetrie.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef TELEMETRIE_RF24
+#include <RF24/RF24.h>
+#endif
+
+#define RING_GROESSE   256      // Frames pro Kreuzung (Zweierpotenz)
+#define EMPFANG_STAPEL 64       // Frames pro Transportaufruf
+#define KPI_FENSTER_S  300.0    // Zeitkonstante der gleitenden Mittel
+#define KPI_SYNC_MS    1000
+#define KPI_DATEI      "kpi.bin"
+#define RF24_CE_PIN    22       // wie im multiceiverDemo
+#define RF24_CSN_PIN   0
+
+static std::atomic<bool> laufen(true);
+
+static uint64_t jetzt_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// -------------------------
+// RING PRO KREUZUNG
+// -------------------------
+// Ein Schreiber (Empfang), ein Leser (Auswertung). Jeder
+// Index wird nur von einer Seite geschrieben.
+class FrameRing {
+public:
+  bool rein(const TelemetrieFrame &f, bool zaehlen = true) {
+    uint32_t k = _kopf.load(std::memory_order_relaxed);
+    if (k - _schwanz.load(std::memory_order_acquire) >= RING_GROESSE) {
+      if (zaehlen) _ueberlauf.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    _frames[k & (RING_GROESSE - 1)] = f;
+    _kopf.store(k + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool raus(TelemetrieFrame &f) {
+    uint32_t s = _schwanz.load(std::memory_order_relaxed);
+    if (s == _kopf.load(std::memory_order_acquire)) return false;
+    f = _frames[s & (RING_GROESSE - 1)];
+    _schwanz.store(s + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint32_t ueberlauf() const { return _ueberlauf.load(std::memory_order_relaxed); }
+
+private:
+  alignas(64) std::atomic<uint32_t> _kopf{0};
+  alignas(64) std::atomic<uint32_t> _schwanz{0};
+  std::atomic<uint32_t> _ueberlauf{0};
+  TelemetrieFrame _frames[RING_GROESSE];
+};
+
+static FrameRing ringe[TELEMETRIE_KREUZUNGEN];
+// Bitmaske der Kreuzungen, die schon gesendet haben
+static std::atomic<uint64_t> bekannt[TELEMETRIE_KREUZUNGEN / 64];
+static std::atomic<uint64_t> empfangen_gesamt(0);
+static std::atomic<uint64_t> verworfen_gesamt(0);   // falsche Version/Länge
+
+static void verteilen(const TelemetrieFrame &f, bool warten) {
+  if (f.version != TELEMETRIE_VERSION) {
+    verworfen_gesamt.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  uint64_t bit = 1ULL << (f.kreuzung % 64);
+  if (!(bekannt[f.kreuzung / 64].load(std::memory_order_relaxed) & bit)) {
+    bekannt[f.kreuzung / 64].fetch_or(bit, std::memory_order_release);
+  }
+  if (warten) {
+    while (!ringe[f.kreuzung].rein(f, false)) std::this_thread::yield();
+  } else {
+    ringe[f.kreuzung].rein(f);
+  }
+  empfangen_gesamt.fetch_add(1, std::memory_order_relaxed);
+}
+
+// -------------------------
+// TRANSPORTE
+// -------------------------
+class Transport {
+public:
+  virtual ~Transport() {}
+  // Wartet höchstens ~100 ms, liefert die Zahl gelesener Frames
+  // (0 = nichts da, -1 = Quelle zu Ende)
+  virtual int empfangen(TelemetrieFrame *frames, int max) = 0;
+  // true = die Quelle kann warten (Datei/Pipe), nichts verwerfen
+  virtual bool verlustfrei() const { return false; }
+};
+
+class UdpTransport : public Transport {
+public:
+  bool oeffnen(uint16_t port) {
+    _fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (_fd < 0) return false;
+    int puffer = 4 << 20;
+    setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &puffer, sizeof(puffer));
+    sockaddr_in adr = {};
+    adr.sin_family = AF_INET;
+    adr.sin_port = htons(port);
+    adr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(_fd, (sockaddr *)&adr, sizeof(adr)) < 0) return false;
+    socklen_t laenge = sizeof(adr);
+    getsockname(_fd, (sockaddr *)&adr, &laenge);
+    _port = ntohs(adr.sin_port);
+    return true;
+  }
+
+  uint16_t port() const { return _port; }
+
+  int empfangen(TelemetrieFrame *frames, int max) {
+    pollfd p = {_fd, POLLIN, 0};
+    if (poll(&p, 1, 100) <= 0) return 0;
+    mmsghdr nachrichten[EMPFANG_STAPEL];
+    iovec iov[EMPFANG_STAPEL];
+    if (max > EMPFANG_STAPEL) max = EMPFANG_STAPEL;
+    for (int i = 0; i < max; i++) {
+      iov[i] = {&frames[i], sizeof(TelemetrieFrame)};
+      nachrichten[i] = {};
+      nachrichten[i].msg_hdr.msg_iov = &iov[i];
+      nachrichten[i].msg_hdr.msg_iovlen = 1;
+    }
+    int n = recvmmsg(_fd, nachrichten, max, MSG_DONTWAIT, NULL);
+    if (n <= 0) return 0;
+    // Kurze Datagramme aussortieren
+    int gut = 0;
+    for (int i = 0; i < n; i++) {
+      if (nachrichten[i].msg_len != sizeof(TelemetrieFrame)) {
+        verworfen_gesamt.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      if (gut != i) frames[gut] = frames[i];
+      gut++;
+    }
+    return gut;
+  }
+
+private:
+  int _fd = -1;
+  uint16_t _port = 0;
+};
+
+class PipeTransport : public Transport {
+public:
+  bool oeffnen(const char *pfad) {
+    _fd = strcmp(pfad, "-") ? open(pfad, O_RDONLY) : 0;
+    return _fd >= 0;
+  }
+  void fd_setzen(int fd) { _fd = fd; }
+  bool verlustfrei() const { return true; }
+
+  int empfangen(TelemetrieFrame *frames, int max) {
+    pollfd p = {_fd, POLLIN, 0};
+    if (poll(&p, 1, 100) <= 0) return 0;
+    // Angefangene Frames bleiben in _rest für den nächsten Aufruf
+    uint8_t *ziel = (uint8_t *)frames;
+    memcpy(ziel, _rest, _rest_laenge);
+    ssize_t n = read(_fd, ziel + _rest_laenge, max * sizeof(TelemetrieFrame) - _rest_laenge);
+    if (n <= 0) return n == 0 ? -1 : 0;
+    size_t gesamt = _rest_laenge + n;
+    int anzahl = gesamt / sizeof(TelemetrieFrame);
+    _rest_laenge = gesamt % sizeof(TelemetrieFrame);
+    memcpy(_rest, ziel + anzahl * sizeof(TelemetrieFrame), _rest_laenge);
+    return anzahl;
+  }
+
+private:
+  int _fd = -1;
+  uint8_t _rest[sizeof(TelemetrieFrame)];
+  size_t _rest_laenge = 0;
+};
+
+#ifdef TELEMETRIE_RF24
+// Sammler als RX-Knoten des multiceiverDemo: alle 6 Pipes offen
+class Rf24Transport : public Transport {
+public:
+  Rf24Transport() : _funk(RF24_CE_PIN, RF24_CSN_PIN) {}
+
+  bool oeffnen() {
+    if (!_funk.begin()) return false;
+    _funk.setPALevel(RF24_PA_LOW);
+    _funk.setPayloadSize(sizeof(TelemetrieFrame));
+    for (uint8_t pipe = 0; pipe < 6; pipe++) _funk.openReadingPipe(pipe, TELEMETRIE_ADRESSEN[pipe]);
+    _funk.startListening();
+    return true;
+  }
+
+  int empfangen(TelemetrieFrame *frames, int max) {
+    int n = 0;
+    uint8_t pipe;
+    for (int leer = 0; n < max && leer < 100; ) {
+      if (_funk.available(&pipe)) {
+        _funk.read(&frames[n++], sizeof(TelemetrieFrame));
+      } else if (n) {
+        break;
+      } else {
+        usleep(1000);   // kein IRQ-Pin angeschlossen: pollen
+        leer++;
+      }
+    }
+    return n;
+  }
+
+private:
+  RF24 _funk;
+};
+#endif
+
+static void empfang_laufen(Transport *transport) {
+  TelemetrieFrame frames[EMPFANG_STAPEL];
+  while (laufen.load(std::memory_order_relaxed)) {
+    int n = transport->empfangen(frames, EMPFANG_STAPEL);
+    if (n < 0) break;
+    for (int i = 0; i < n; i++) verteilen(frames[i], transport->verlustfrei());
+  }
+}
+
+// -------------------------
+// SPALTENWEISE KPI-DATEI
+// -------------------------
+enum SpaltenTyp : uint8_t { KPI_U8 = 1, KPI_U16, KPI_U32, KPI_U64, KPI_F32 };
+
+struct SpaltenInfo {
+  char name[14];
+  uint8_t typ;
+  uint8_t breite;            // Byte pro Wert
+  uint32_t versatz;          // ab Dateianfang
+};
+
+#define KPI_SPALTEN 19
+
+struct KpiKopf {
+  char kennung[4];           // "TLK1"
+  uint16_t version;
+  uint16_t spalten;
+  uint32_t zeilen;           // TELEMETRIE_KREUZUNGEN
+  uint32_t reserve;
+  uint64_t aktualisiert_ms;  // Unixzeit
+  uint64_t frames;
+  uint64_t verworfen;
+  SpaltenInfo info[KPI_SPALTEN];
+};
+
+static const char KPI_KENNUNG[4] = {'T', 'L', 'K', '1'};
+
+// Reihenfolge = Lage in der Datei
+enum Spalte {
+  SP_FRAMES, SP_VERLOREN, SP_UEBERLAUF, SP_ZULETZT, SP_MODUS, SP_PHASE, SP_PLAN,
+  SP_FZ_N, SP_FZ_S, SP_FZ_O, SP_FZ_W, SP_UMLAUF, SP_AUSLASTUNG,
+  SP_FUSSG, SP_VORRANG, SP_BAHN, SP_BUS, SP_SENSORFEHLER, SP_LATENZ_MAX
+};
+
+static const struct { const char *name; SpaltenTyp typ; } SPALTEN[KPI_SPALTEN] = {
+  {"frames", KPI_U32}, {"verloren", KPI_U32}, {"ueberlauf", KPI_U32}, {"zuletzt_ms", KPI_U64},
+  {"modus", KPI_U8}, {"phase", KPI_U8}, {"plan", KPI_U8},
+  {"fz_h_nord", KPI_F32}, {"fz_h_sued", KPI_F32}, {"fz_h_ost", KPI_F32}, {"fz_h_west", KPI_F32},
+  {"umlauf_s", KPI_F32}, {"auslastung", KPI_U16},
+  {"fussgaenger", KPI_U32}, {"vorrang", KPI_U32}, {"bahn", KPI_U32}, {"bus", KPI_U32},
+  {"sensorfehler", KPI_U32}, {"latenz_max_us", KPI_U16},
+};
+
+static uint8_t typ_breite(uint8_t typ) {
+  switch (typ) {
+    case KPI_U8: return 1;
+    case KPI_U16: return 2;
+    case KPI_U64: return 8;
+    default: return 4;
+  }
+}
+
+class KpiDatei {
+public:
+  bool oeffnen(const char *pfad, bool schreiben) {
+    int fd = open(pfad, schreiben ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd < 0) return false;
+    size_t groesse = sizeof(KpiKopf);
+    for (uint8_t s = 0; s < KPI_SPALTEN; s++) {
+      groesse = (groesse + 7) & ~(size_t)7;   // jede Spalte 8-Byte-ausgerichtet
+      groesse += (size_t)typ_breite(SPALTEN[s].typ) * TELEMETRIE_KREUZUNGEN;
+    }
+    if (schreiben && ftruncate(fd, groesse) < 0) {
+      close(fd);
+      return false;
+    }
+    if (!schreiben) groesse = lseek(fd, 0, SEEK_END);
+    void *p = mmap(NULL, groesse, schreiben ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED || groesse < sizeof(KpiKopf)) return false;
+    _basis = (uint8_t *)p;
+    _groesse = groesse;
+    if (schreiben) kopf_anlegen();
+    return !memcmp(kopf()->kennung, KPI_KENNUNG, 4);
+  }
+
+  KpiKopf *kopf() { return (KpiKopf *)_basis; }
+
+  template <class T> T &wert(Spalte s, uint8_t kreuzung) {
+    return ((T *)(_basis + kopf()->info[s].versatz))[kreuzung];
+  }
+
+  void sync() { msync(_basis, _groesse, MS_ASYNC); }
+
+private:
+  void kopf_anlegen() {
+    memset(_basis, 0, _groesse);   // Kennzahlen starten bei jedem Lauf neu
+    KpiKopf *k = kopf();
+    memcpy(k->kennung, KPI_KENNUNG, 4);
+    k->version = 1;
+    k->spalten = KPI_SPALTEN;
+    k->zeilen = TELEMETRIE_KREUZUNGEN;
+    size_t versatz = sizeof(KpiKopf);
+    for (uint8_t s = 0; s < KPI_SPALTEN; s++) {
+      versatz = (versatz + 7) & ~(size_t)7;
+      strncpy(k->info[s].name, SPALTEN[s].name, sizeof(k->info[s].name) - 1);
+      k->info[s].typ = SPALTEN[s].typ;
+      k->info[s].breite = typ_breite(SPALTEN[s].typ);
+      k->info[s].versatz = versatz;
+      versatz += (size_t)k->info[s].breite * TELEMETRIE_KREUZUNGEN;
+    }
+  }
+
+  uint8_t *_basis = NULL;
+  size_t _groesse = 0;
+};
+
+// -------------------------
+// AUSWERTUNG
+// -------------------------
+struct KreuzungsZustand {
+  bool gesehen = false;
+  uint16_t folge = 0;
+  uint32_t zeit_ms = 0;
+};
+
+static KreuzungsZustand zustaende[TELEMETRIE_KREUZUNGEN];
+
+static void frame_auswerten(KpiDatei &kpi, const TelemetrieFrame &f, uint64_t empfang_ms) {
+  uint8_t k = f.kreuzung;
+  KreuzungsZustand &z = zustaende[k];
+
+  // Gleitendes Mittel über die Steuerungszeit zwischen zwei Frames
+  uint32_t dt = z.gesehen ? f.zeit_ms - z.zeit_ms : 0;
+  if (z.gesehen) {
+    uint16_t luecke = f.folge - z.folge - 1;
+    if (luecke < 0x8000) kpi.wert<uint32_t>(SP_VERLOREN, k) += luecke;   // sonst Neustart/Duplikat
+  }
+  if (dt > 0 && dt < 3600000UL) {
+    float alpha = 1.0f - expf(-(float)dt / (KPI_FENSTER_S * 1000.0f));
+    for (uint8_t r = 0; r < 4; r++) {
+      float rate = f.fahrzeuge[r] * 3600000.0f / dt;
+      float &mittel = kpi.wert<float>((Spalte)(SP_FZ_N + r), k);
+      mittel += (rate - mittel) * alpha;
+    }
+  }
+  z.gesehen = true;
+  z.folge = f.folge;
+  z.zeit_ms = f.zeit_ms;
+
+  kpi.wert<uint32_t>(SP_FRAMES, k)++;
+  kpi.wert<uint32_t>(SP_UEBERLAUF, k) = ringe[k].ueberlauf();
+  kpi.wert<uint64_t>(SP_ZULETZT, k) = empfang_ms;
+  kpi.wert<uint8_t>(SP_MODUS, k) = f.modus;
+  kpi.wert<uint8_t>(SP_PHASE, k) = f.phase;
+  kpi.wert<uint8_t>(SP_PLAN, k) = f.plan;
+  kpi.wert<float>(SP_UMLAUF, k) = f.umlauf_ds / 10.0f;
+  kpi.wert<uint16_t>(SP_AUSLASTUNG, k) = f.auslastung;
+  static const uint8_t BITS[5] = {TEL_FUSSGAENGER, TEL_VORRANG, TEL_BAHN, TEL_BUS, TEL_SENSORFEHLER};
+  for (uint8_t b = 0; b < 5; b++) {
+    if (f.ereignisse & BITS[b]) kpi.wert<uint32_t>((Spalte)(SP_FUSSG + b), k)++;
+  }
+  uint16_t &latenz = kpi.wert<uint16_t>(SP_LATENZ_MAX, k);
+  if (f.latenz_max_us > latenz) latenz = f.latenz_max_us;
+}
+
+// Leert alle Ringe, gibt die Zahl ausgewerteter Frames zurück
+static uint32_t ringe_leeren(KpiDatei &kpi) {
+  uint32_t n = 0;
+  uint64_t empfang_ms = jetzt_ms();
+  for (uint8_t w = 0; w < TELEMETRIE_KREUZUNGEN / 64; w++) {
+    uint64_t maske = bekannt[w].load(std::memory_order_acquire);
+    while (maske) {
+      uint8_t k = w * 64 + __builtin_ctzll(maske);
+      maske &= maske - 1;
+      TelemetrieFrame f;
+      while (ringe[k].raus(f)) {
+        frame_auswerten(kpi, f, empfang_ms);
+        n++;
+      }
+    }
+  }
+  return n;
+}
+
+static std::atomic<uint64_t> ausgewertet_gesamt(0);
+
+static void auswertung_laufen(KpiDatei *kpi) {
+  uint64_t letzter_sync = jetzt_ms();
+  while (true) {
+    bool ende = !laufen.load(std::memory_order_acquire);
+    uint32_t n = ringe_leeren(*kpi);
+    ausgewertet_gesamt.fetch_add(n, std::memory_order_relaxed);
+    if (ende) break;   // nach dem Stopp noch einmal alles leeren
+    if (!n) usleep(500);
+    uint64_t jetzt = jetzt_ms();
+    if (jetzt - letzter_sync >= KPI_SYNC_MS) {
+      KpiKopf *k = kpi->kopf();
+      k->aktualisiert_ms = jetzt;
+      k->frames = ausgewertet_gesamt.load(std::memory_order_relaxed);
+      k->verworfen = verworfen_gesamt.load(std::memory_order_relaxed);
+      kpi->sync();
+      letzter_sync = jetzt;
+    }
+  }
+  KpiKopf *k = kpi->kopf();
+  k->aktualisiert_ms = jetzt_ms();
+  k->frames = ausgewertet_gesamt.load();
+  k->verworfen = verworfen_gesamt.load();
+  kpi->sync();
+}
+
+static int sammeln(Transport *transport, const char *pfad) {
+  KpiDatei kpi;
+  if (!kpi.oeffnen(pfad, true)) {
+    perror(pfad);
+    return 1;
+  }
+  signal(SIGINT, [](int) { laufen = false; });
+  signal(SIGTERM, [](int) { laufen = false; });
+  std::thread auswertung(auswertung_laufen, &kpi);
+  empfang_laufen(transport);
+  laufen = false;
+  auswertung.join();
+  printf("%llu Frames ausgewertet, %llu verworfen -> %s\n",
+         (unsigned long long)ausgewertet_gesamt.load(), (unsigned long long)verworfen_gesamt.load(), pfad);
+  return 0;
+}
+
+// -------------------------
+// ANZEIGE
+// -------------------------
+static int zeigen(const char *pfad) {
+  KpiDatei kpi;
+  if (!kpi.oeffnen(pfad, false)) {
+    printf("%s: keine KPI-Datei\n", pfad);
+    return 1;
+  }
+  KpiKopf *kopf = kpi.kopf();
+  printf("Stand %llu, %llu Frames, %llu verworfen\n", (unsigned long long)kopf->aktualisiert_ms,
+         (unsigned long long)kopf->frames, (unsigned long long)kopf->verworfen);
+  printf("%4s %8s %6s %6s %2s %2s %7s %7s %7s %7s %6s %5s %6s %6s\n", "Kr.", "Frames", "verl.",
+         "überl.", "M", "P", "Fz/h N", "S", "O", "W", "Uml.s", "Y‰", "Vorr.", "Lat.us");
+  for (uint16_t k = 0; k < TELEMETRIE_KREUZUNGEN; k++) {
+    if (!kpi.wert<uint32_t>(SP_FRAMES, k)) continue;
+    printf("%4u %8u %6u %6u %2u %2u %7.1f %7.1f %7.1f %7.1f %6.1f %5u %6u %6u\n", k,
+           kpi.wert<uint32_t>(SP_FRAMES, k), kpi.wert<uint32_t>(SP_VERLOREN, k),
+           kpi.wert<uint32_t>(SP_UEBERLAUF, k), kpi.wert<uint8_t>(SP_MODUS, k),
+           kpi.wert<uint8_t>(SP_PHASE, k), kpi.wert<float>(SP_FZ_N, k), kpi.wert<float>(SP_FZ_S, k),
+           kpi.wert<float>(SP_FZ_O, k), kpi.wert<float>(SP_FZ_W, k), kpi.wert<float>(SP_UMLAUF, k),
+           kpi.wert<uint16_t>(SP_AUSLASTUNG, k), kpi.wert<uint32_t>(SP_VORRANG, k),
+           kpi.wert<uint16_t>(SP_LATENZ_MAX, k));
+  }
+  return 0;
+}
+
+// -------------------------
+// BENCHMARK
+// -------------------------
+// Simulierte Kreuzungen senden so schnell es geht über den
+// Transport; gemessen wird der Durchsatz bis in die KPI-Datei.
+static void bench_frame(TelemetrieFrame &f, uint8_t kreuzung, uint32_t nummer) {
+  memset(&f, 0, sizeof(f));
+  f.version = TELEMETRIE_VERSION;
+  f.kreuzung = kreuzung;
+  f.folge = nummer;
+  f.zeit_ms = nummer * TELEMETRIE_INTERVALL;
+  f.phase = nummer % 4;
+  f.plan = 0;
+  for (uint8_t r = 0; r < 4; r++) f.fahrzeuge[r] = (nummer + kreuzung + r) % 3 == 0;
+  f.umlauf_ds = 260;
+  f.auslastung = 400 + kreuzung;
+  if (nummer % 100 == 0) f.ereignisse = TEL_FUSSGAENGER;
+}
+
+static double cpu_sekunden() {
+  rusage r;
+  getrusage(RUSAGE_SELF, &r);
+  return r.ru_utime.tv_sec + r.ru_stime.tv_sec + (r.ru_utime.tv_usec + r.ru_stime.tv_usec) / 1e6;
+}
+
+static int bench(uint16_t kreuzungen, uint32_t frames, bool udp) {
+  if (kreuzungen == 0 || kreuzungen > TELEMETRIE_KREUZUNGEN) kreuzungen = 48;
+  const char *pfad = "/tmp/telemetrie_bench.bin";
+  KpiDatei kpi;
+  if (!kpi.oeffnen(pfad, true)) {
+    perror(pfad);
+    return 1;
+  }
+
+  UdpTransport udp_t;
+  PipeTransport pipe_t;
+  Transport *transport;
+  int sender_fd;
+  sockaddr_in ziel = {};
+  if (udp) {
+    if (!udp_t.oeffnen(0)) {
+      perror("udp");
+      return 1;
+    }
+    sender_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ziel.sin_family = AF_INET;
+    ziel.sin_port = htons(udp_t.port());
+    ziel.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    transport = &udp_t;
+  } else {
+    int fds[2];
+    if (pipe(fds) < 0) {
+      perror("pipe");
+      return 1;
+    }
+    fcntl(fds[0], F_SETPIPE_SZ, 1 << 20);
+    pipe_t.fd_setzen(fds[0]);
+    sender_fd = fds[1];
+    transport = &pipe_t;
+  }
+
+  double cpu_start = cpu_sekunden();
+  auto start = std::chrono::steady_clock::now();
+  std::thread auswertung(auswertung_laufen, &kpi);
+  std::thread empfang(empfang_laufen, transport);
+
+  // Sender: reihum alle Kreuzungen, Pipe in Blöcken, UDP einzeln
+  // (sendmmsg, damit der Sender nicht den Sammler ausbremst)
+  uint32_t gesendet = 0;
+  const uint32_t BLOCK = EMPFANG_STAPEL;
+  TelemetrieFrame block[BLOCK];
+  while (gesendet < frames) {
+    uint32_t n = frames - gesendet < BLOCK ? frames - gesendet : BLOCK;
+    for (uint32_t i = 0; i < n; i++) {
+      uint32_t nr = gesendet + i;
+      bench_frame(block[i], nr % kreuzungen, nr / kreuzungen);
+    }
+    if (udp) {
+      mmsghdr nachrichten[BLOCK];
+      iovec iov[BLOCK];
+      for (uint32_t i = 0; i < n; i++) {
+        iov[i] = {&block[i], sizeof(TelemetrieFrame)};
+        nachrichten[i] = {};
+        nachrichten[i].msg_hdr.msg_name = &ziel;
+        nachrichten[i].msg_hdr.msg_namelen = sizeof(ziel);
+        nachrichten[i].msg_hdr.msg_iov = &iov[i];
+        nachrichten[i].msg_hdr.msg_iovlen = 1;
+      }
+      int s = sendmmsg(sender_fd, nachrichten, n, 0);
+      if (s > 0) gesendet += s;
+      // Empfangspuffer nicht überrennen: Abstand begrenzen
+      while (gesendet - empfangen_gesamt.load(std::memory_order_relaxed) > 1000) std::this_thread::yield();
+    } else {
+      ssize_t s = write(sender_fd, block, n * sizeof(TelemetrieFrame));
+      if (s > 0) gesendet += s / sizeof(TelemetrieFrame);
+    }
+  }
+  if (!udp) close(sender_fd);   // Pipe-Ende beendet den Empfang
+
+  // Warten bis alles ausgewertet ist (UDP: höchstens 2 s nach dem letzten Frame)
+  auto letzter_fortschritt = std::chrono::steady_clock::now();
+  uint64_t zuletzt = 0;
+  while (ausgewertet_gesamt.load() + verworfen_gesamt.load() < frames) {
+    uint64_t jetzt = ausgewertet_gesamt.load();
+    if (jetzt != zuletzt) {
+      zuletzt = jetzt;
+      letzter_fortschritt = std::chrono::steady_clock::now();
+    } else if (std::chrono::steady_clock::now() - letzter_fortschritt > std::chrono::seconds(2)) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+  laufen = false;
+  empfang.join();
+  auswertung.join();
+  double sekunden = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double cpu = cpu_sekunden() - cpu_start;
+
+  uint64_t ausgewertet = ausgewertet_gesamt.load();
+  uint64_t ueberlauf = 0;
+  for (uint16_t k = 0; k < kreuzungen; k++) ueberlauf += ringe[k].ueberlauf();
+  printf("%s: %u Kreuzungen, %u Frames gesendet, %llu ausgewertet, %llu Ringüberläufe\n",
+         udp ? "UDP" : "Pipe", kreuzungen, frames, (unsigned long long)ausgewertet,
+         (unsigned long long)ueberlauf);
+  printf("  %.3f s -> %.0f Frames/s, CPU %.3f s (inkl. Sender) = %.2f us/Frame\n",
+         sekunden, ausgewertet / sekunden, cpu, cpu * 1e6 / (ausgewertet ? ausgewertet : 1));
+  return ausgewertet + ueberlauf == frames ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  const char *modus = argc > 1 ? argv[1] : "";
+  if (!strcmp(modus, "--bench")) {
+    uint16_t kreuzungen = argc > 2 ? atoi(argv[2]) : 48;
+    uint32_t frames = argc > 3 ? strtoul(argv[3], NULL, 10) : 200000;
+    bool udp = !(argc > 4 && !strcmp(argv[4], "pipe"));
+    return bench(kreuzungen, frames, udp);
+  }
+  if (!strcmp(modus, "--zeigen") && argc > 2) return zeigen(argv[2]);
+  if (!strcmp(modus, "--udp") && argc > 2) {
+    UdpTransport t;
+    if (!t.oeffnen(atoi(argv[2]))) {
+      perror("udp");
+      return 1;
+    }
+    return sammeln(&t, argc > 3 ? argv[3] : KPI_DATEI);
+  }
+  if (!strcmp(modus, "--pipe") && argc > 2) {
+    PipeTransport t;
+    if (!t.oeffnen(argv[2])) {
+      perror(argv[2]);
+      return 1;
+    }
+    return sammeln(&t, argc > 3 ? argv[3] : KPI_DATEI);
+  }
+#ifdef TELEMETRIE_RF24
+  if (!strcmp(modus, "--rf24")) {
+    Rf24Transport t;
+    if (!t.oeffnen()) {
+      printf("Funkmodul antwortet nicht\n");
+      return 1;
+    }
+    return sammeln(&t, argc > 2 ? argv[2] : KPI_DATEI);
+  }
+#endif
+  printf("Aufruf: %s --udp PORT [kpi.bin] | --pipe PFAD|- [kpi.bin] | --rf24 [kpi.bin]\n"
+         "       %s --zeigen kpi.bin | --bench [kreuzungen] [frames] [udp|pipe]\n", argv[0], argv[0]);
+  return 2;
+}
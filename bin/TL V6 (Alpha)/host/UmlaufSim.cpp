@@ -0,0 +1,159 @@
+/* =====================================================
+   VERKEHRSSIMULATION: FESTES TAGESPROGRAMM VS. WEBSTER
+   =====================================================
+
+   Ein Tag (24 h) Verkehr an der Kreuzung, einmal mit den
+   festen TAGES_PHASEN und einmal mit Umlauf.h. Beide Läufe
+   bekommen exakt dieselben Ankünfte (fester Zufallsstartwert).
+
+   Modell, Schritt 100 ms:
+     - Ankünfte pro Zufahrt zufällig (Poisson) nach dem
+       Stundenprofil TAGESGANG (Fz/h)
+     - Jede Zufahrt ist eine Warteschlange. Abfluss mit
+       Sättigungsverkehrsstärke (1 Fz / 2 s), ab 2 s nach
+       Grünbeginn bis 1 s in die Gelbphase - das entspricht
+       den 4 s Verlustzeit pro Phase in Umlauf.h
+     - Der Detektor zählt jede Ankunft (idealer Zähler)
+     - Wartezeit = Summe der Warteschlangen über die Zeit
+
+   Bauen (aus diesem Ordner):
+     g++ -std=c++17 -O2 -I. -I.. UmlaufSim.cpp -o umlauf_sim
+
+   Aufruf:
+     ./umlauf_sim [startwert]
+   ===================================================== */
+
+#include <Arduino.h>
+#include "Umlauf.h"
+
+#define SCHRITT_MS     100
+#define ABFLUSS_MS     2000   // 1800 Fz/h
+#define ANFAHREN_MS    2000   // Verlust am Grünbeginn
+#define GELB_NUTZUNG   1000   // so viel Gelb wird noch gefahren
+
+// Tagesprogramm wie im Sketch
+static const uint16_t TAGES_PHASEN[4] = {10000, 3000, 10000, 3000};
+
+// Fz/h pro Zufahrt (Nord, Süd, Ost, West) für jede Stunde
+static const uint16_t TAGESGANG[24][4] = {
+  {20, 20, 15, 15}, {20, 20, 15, 15}, {20, 20, 15, 15}, {20, 20, 15, 15},
+  {20, 20, 15, 15}, {40, 40, 30, 30}, {200, 150, 100, 100},
+  {650, 550, 250, 250}, {650, 550, 250, 250},                  // Berufsverkehr N/S
+  {300, 300, 300, 300}, {300, 300, 300, 300}, {300, 300, 300, 300},
+  {350, 350, 350, 350}, {300, 300, 300, 300}, {300, 300, 300, 300},
+  {300, 300, 300, 300},
+  {250, 250, 650, 600}, {250, 250, 650, 600}, {250, 250, 650, 600},   // Feierabend O/W
+  {150, 150, 150, 150}, {150, 150, 150, 150}, {150, 150, 150, 150},
+  {50, 50, 40, 40}, {50, 50, 40, 40}
+};
+
+struct Ergebnis {
+  uint32_t angekommen = 0;
+  uint32_t abgefahren = 0;
+  uint64_t wartezeit_ms = 0;   // Fahrzeug-Millisekunden in der Schlange
+  uint32_t max_schlange = 0;
+  uint32_t umlaeufe = 0;
+};
+
+// Einfacher Zufallsgenerator, damit beide Läufe gleich sind
+static uint32_t zufall_zustand;
+static uint32_t zufall() {
+  zufall_zustand = zufall_zustand * 1664525UL + 1013904223UL;
+  return zufall_zustand >> 8;
+}
+
+static Ergebnis simulieren(UmlaufOptimierer *optimierer, uint32_t startwert, bool protokoll) {
+  Ergebnis e;
+  uint32_t schlange[4] = {0};
+  uint32_t guthaben[4] = {0};
+  uint8_t phase = 0;
+  uint32_t phasen_zeit = 0;
+  uint32_t umlauf_zeit = 0;
+  uint8_t letzte_stunde = 0xFF;
+  zufall_zustand = startwert;
+
+  for (uint32_t t = 0; t < 24UL * 3600 * 1000; t += SCHRITT_MS) {
+    uint8_t stunde = t / 3600000UL;
+
+    // Ankünfte
+    for (uint8_t z = 0; z < 4; z++) {
+      // Wahrscheinlichkeit pro Schritt in 1/2^24
+      uint32_t p = (uint64_t)TAGESGANG[stunde][z] * (1UL << 24) / (3600000UL / SCHRITT_MS);
+      if ((zufall() & 0xFFFFFF) < p) {
+        schlange[z]++;
+        e.angekommen++;
+        if (optimierer) optimierer->fahrzeug(z);
+      }
+    }
+
+    // Abfluss der Achse, die gerade fahren darf
+    uint8_t achse = phase >> 1;
+    bool gelb = phase & 1;
+    bool frei = gelb ? phasen_zeit < GELB_NUTZUNG : phasen_zeit >= ANFAHREN_MS;
+    for (uint8_t z = achse * 2; z < achse * 2 + 2; z++) {
+      if (!frei) continue;
+      guthaben[z] += SCHRITT_MS;
+      if (guthaben[z] >= ABFLUSS_MS) {
+        guthaben[z] -= ABFLUSS_MS;
+        if (schlange[z]) {
+          schlange[z]--;
+          e.abgefahren++;
+        }
+      }
+    }
+
+    for (uint8_t z = 0; z < 4; z++) {
+      e.wartezeit_ms += (uint64_t)schlange[z] * SCHRITT_MS;
+      if (schlange[z] > e.max_schlange) e.max_schlange = schlange[z];
+    }
+
+    // Phasenwechsel wie phasen_wechsel() im Sketch
+    phasen_zeit += SCHRITT_MS;
+    umlauf_zeit += SCHRITT_MS;
+    uint16_t dauer = optimierer ? optimierer->dauer(phase) : TAGES_PHASEN[phase];
+    if (phasen_zeit >= dauer) {
+      phase = (phase + 1) % 4;
+      phasen_zeit = 0;
+      if (!(phase & 1)) {
+        guthaben[phase] = guthaben[phase + 1] = 0;   // neue Grünphase
+      }
+      if (phase == 0) {
+        e.umlaeufe++;
+        if (optimierer) optimierer->umlauf_beendet(umlauf_zeit);
+        umlauf_zeit = 0;
+      }
+    }
+
+    if (protokoll && optimierer && stunde != letzte_stunde) {
+      letzte_stunde = stunde;
+      printf("  %02u:00  Umlauf %6lu ms  Grün N/S %5u  O/W %5u  Y %3u‰  Schlange %lu/%lu/%lu/%lu\n",
+             stunde, (unsigned long)optimierer->umlauf(), optimierer->dauer(0), optimierer->dauer(2),
+             optimierer->auslastung(), (unsigned long)schlange[0], (unsigned long)schlange[1],
+             (unsigned long)schlange[2], (unsigned long)schlange[3]);
+    }
+  }
+  return e;
+}
+
+static void ausgeben(const char *name, const Ergebnis &e) {
+  printf("%-10s %8lu %8lu %8lu %10.1f %8lu %8lu\n", name,
+         (unsigned long)e.angekommen, (unsigned long)e.abgefahren,
+         (unsigned long)(e.angekommen - e.abgefahren),
+         e.abgefahren ? e.wartezeit_ms / 1000.0 / e.abgefahren : 0.0,
+         (unsigned long)e.max_schlange, (unsigned long)e.umlaeufe);
+}
+
+int main(int argc, char **argv) {
+  uint32_t startwert = argc > 1 ? strtoul(argv[1], NULL, 10) : 1;
+
+  printf("Webster-Plan im Tagesverlauf:\n");
+  UmlaufOptimierer optimierer(TAGES_PHASEN);
+  Ergebnis webster = simulieren(&optimierer, startwert, true);
+  Ergebnis fest = simulieren(NULL, startwert, false);
+
+  printf("\n%-10s %8s %8s %8s %10s %8s %8s\n", "Plan", "Ankunft", "Durchs.", "Rest", "Warten s/Fz",
+         "max.Schl", "Umläufe");
+  ausgeben("fest", fest);
+  ausgeben("webster", webster);
+  return 0;
+}
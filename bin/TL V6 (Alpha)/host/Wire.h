@@ -0,0 +1,81 @@
+/* Host-Ersatz für Wire.h (AVR-TwoWire): eine Übertragung kostet
+   virtuelle Zeit wie auf dem Bus, 9 Takte pro Byte plus Start
+   und Stopp (Standard 100 kHz, setClock()). Der Puffer fasst wie
+   beim AVR-Core BUFFER_LENGTH Byte, write() darüber hinaus gibt 0.
+
+   Geräte hängen an host_i2c_geraete[adresse] und bekommen jedes
+   Byte zu dem Zeitpunkt, an dem es auf dem Bus fertig ist; ohne
+   Gerät gibt endTransmission() 2 zurück (Adresse ohne ACK).
+   host_i2c_uebertragungen und host_i2c_bytes zählen mit. */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+#define BUFFER_LENGTH 32
+
+class HostI2cGeraet {
+public:
+  virtual void empfangen(uint8_t byte) = 0;
+};
+
+inline HostI2cGeraet *host_i2c_geraete[128] = {NULL};
+inline uint32_t host_i2c_uebertragungen = 0;
+inline uint64_t host_i2c_bytes = 0;   // mit Adressbyte
+
+class TwoWire : public Print {
+public:
+  void begin() {}
+  void setClock(uint32_t hz) { _takt = hz; }
+
+  void beginTransmission(uint8_t adresse) {
+    _adresse = adresse & 0x7F;
+    _anzahl = 0;
+  }
+
+  size_t write(uint8_t byte) {
+    if (_anzahl >= BUFFER_LENGTH) return 0;
+    _puffer[_anzahl++] = byte;
+    return 1;
+  }
+  using Print::write;
+
+  uint8_t endTransmission(uint8_t stopp = true) {
+    (void)stopp;
+    HostI2cGeraet *geraet = host_i2c_geraete[_adresse];
+    host_i2c_uebertragungen++;
+    takte(1);   // Start
+    takte(9);   // Adresse + ACK
+    host_i2c_bytes++;
+    if (!geraet) {
+      takte(1);
+      return 2;
+    }
+    for (uint8_t i = 0; i < _anzahl; i++) {
+      takte(9);
+      host_i2c_bytes++;
+      geraet->empfangen(_puffer[i]);
+    }
+    takte(1);   // Stopp
+    return 0;
+  }
+
+private:
+  // Auf ns genau, damit 400 kHz (2,5 us pro Takt) nicht abrundet
+  void takte(uint8_t n) {
+    _rest_ns += n * (1000000000UL / _takt);
+    host_zeit_vorstellen(_rest_ns / 1000);
+    _rest_ns %= 1000;
+  }
+
+  uint32_t _takt = 100000;
+  uint32_t _rest_ns = 0;
+  uint8_t _adresse = 0;
+  uint8_t _puffer[BUFFER_LENGTH];
+  uint8_t _anzahl = 0;
+};
+
+inline TwoWire Wire;
+
+#endif
@@ -0,0 +1,1045 @@
+/* =====================================================
+   ZEITLINIEN-AUFNAHME FÜR 6Alpha
+   =====================================================
+
+   Lässt den unveränderten Sketch auf dem PC laufen und
+   zeichnet für feste Szenarien den Zustand aller Ausgänge
+   Millisekunde für Millisekunde auf.
+
+   Die Pins hängen an MockedIoAbstraction-Geräten
+   (lib/IoAbstraction) in einer MultiIoAbstraction:
+     - Ausgänge werden aus getWrittenValue() gelesen
+     - Taster werden per setValueForReading() gedrückt,
+       die ISR des Sketches läuft wie bei einer echten Flanke
+     - Ultraschall-Abstände kommen aus host/NewPing.h
+
+   Jedes Szenario läuft in einem eigenen Prozess (fork),
+   damit globale und statische Variablen des Sketches
+   jedes Mal frisch sind.
+
+   Ausgabe: eine Zeile pro Änderung der Ausgänge
+     <ms> <Pin-Bits in Reihenfolge der Kopfzeile>
+
+   Die Referenzen sind eingecheckt (host/zeitlinien/, pro
+   Bauvariante mit anderer Zeitlinie ein Unterordner) und
+   ändern sich nur mit Commits, die das Verhalten ändern
+   sollen. zeitlinie.sh ohne Argumente prüft dagegen.
+
+   Aufruf (gebaut über zeitlinie.sh):
+     zeitlinie                    Zeitlinien auf stdout
+     zeitlinie --schreiben DIR    Referenz nach DIR/<szenario>.txt
+     zeitlinie --pruefen DIR      mit Referenz vergleichen,
+                                  Exitcode 1 bei Abweichung
+     zeitlinie --strom            Strommodell + Reaktionszeiten
+                                  pro Szenario (siehe STROM_...)
+     zeitlinie --spur DIR         Sensorspur (SensorSpur.h):
+       mit SENSOR_SPUR=1 jedes Szenario nach DIR/<szenario>/
+       aufnehmen, mit SENSOR_SPUR=2 die Spur DIR/SPUR.BIN
+       (z.B. von der SD-Karte) bis zum Ende abspielen
+     zeitlinie --verkehr          Nachtverkehr mit Warteschlangen,
+                                  ein Sensor tot bzw. klebend
+                                  (siehe VERKEHR_...)
+     zeitlinie --blackbox         mit BLACKBOX_AKTIV=1: Lampen-
+                                  Zeitlinie aus dem Flash (Blackbox.h)
+                                  gegen die der Pins prüfen
+     zeitlinie --lcd              mit STATUS_LCD=1: LCD-Modell am
+                                  I2C (host/Hd44780.h) gegen die
+                                  Seite im RAM prüfen (StatusLcd.h)
+     zeitlinie --vorrang          mit VORRANG_AKTIV=1: Latenz vom
+                                  Funkcode bis zum ersten Räumbild
+                                  (Vorrang.h), jedes Szenario mit
+                                  Funk VORRANG_LAEUFE mal, der Code
+                                  kommt jedes Mal etwas später
+   ===================================================== */
+
+#include <Arduino.h>
+#include <MockIoAbstraction.h>
+#include <NewPing.h>
+#include <avr/sleep.h>
+#include <setjmp.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef SENSOR_SPUR
+#define SENSOR_SPUR 0
+#endif
+#ifndef SPUR_SEKTOREN
+#define SPUR_SEKTOREN 0
+#endif
+#if SENSOR_SPUR && SPUR_SEKTOREN
+#include <SdFat.h>
+#elif SENSOR_SPUR
+#include <SD.h>
+#endif
+#ifndef BLACKBOX_AKTIV
+#define BLACKBOX_AKTIV 0
+#endif
+#if BLACKBOX_AKTIV
+#include "Blackbox.h"
+extern Blackbox blackbox;
+extern GpioTreiber lampentreiber;
+#endif
+#ifndef STATUS_LCD
+#define STATUS_LCD 0
+#endif
+#if STATUS_LCD
+#include <Hd44780.h>
+#include "StatusLcd.h"
+extern LcdSeite lcd_seite;
+#endif
+#ifndef STATUS_EPAPER
+#define STATUS_EPAPER 0
+#endif
+#if STATUS_EPAPER
+#include <Adafruit_ThinkInk.h>
+#endif
+#ifndef VORRANG_AKTIV
+#define VORRANG_AKTIV 0
+#endif
+#if VORRANG_AKTIV
+#include "Vorrang.h"
+extern Vorrang vorrang;
+extern SimEmpfaenger vorrang_empfaenger;
+#endif
+#ifndef BUSVORRANG_AKTIV
+#define BUSVORRANG_AKTIV 0
+#endif
+#if BUSVORRANG_AKTIV
+#include <mcp2515.h>
+#include "Busvorrang.h"
+#endif
+#ifndef LAMPEN_NEOPIXEL
+#define LAMPEN_NEOPIXEL 0
+#endif
+#if LAMPEN_NEOPIXEL
+#include <Adafruit_NeoPixel.h>
+#endif
+#ifndef LAMPEN_IOEXPANDER
+#define LAMPEN_IOEXPANDER 0
+#endif
+#if LAMPEN_IOEXPANDER
+#include <Hc595.h>
+#endif
+#ifndef TASTER_LEITER
+#define TASTER_LEITER 0
+#endif
+#if TASTER_LEITER
+#include "TasterLeiter.h"
+extern TasterLeiter leiter;
+#endif
+
+void setup();
+void loop();
+#if SENSOR_SPUR == 2
+bool spur_beendet();
+#endif
+
+// -------------------------
+// SZENARIEN
+// -------------------------
+enum Art { DRUECKEN, LOSLASSEN, ABSTAND, FUNK, BUS, BUS_AB };
+
+struct Ereignis {
+  uint32_t ms;
+  Art art;
+  uint8_t pin;       // Taster- bzw. Triggerpin, bei FUNK und BUS die Zufahrt
+  uint16_t cm;       // bei BUS die ETA in s
+};
+
+struct Szenario {
+  const char *name;
+  uint32_t dauer_ms;
+  const Ereignis *ereignisse;
+  uint8_t anzahl;
+};
+
+// Pins wie in 6Alpha.ino
+#define T_MODUS   2
+#define T_NORD    3
+#define T_OST     19
+#define T_WEST    20
+#define S_NORD    14
+#ifdef SONAR_OST_TRIGGER
+#define S_OST     SONAR_OST_TRIGGER   // mit BEGLEITER umgelegt
+#else
+#define S_OST     18
+#endif
+#define BAHN      37   // Einschaltkontakt (nur mit BAHN_VORRANG)
+#define SR_DATEN  34   // 74HC595-Kette (nur mit LAMPEN_IOEXPANDER)
+#define SR_TAKT   35
+#define SR_LATCH  36
+#define SR_ANZAHL 3
+
+// Widerstandsleiter (nur mit TASTER_LEITER): Taste k wie
+// LEITER_SCHWELLEN in 6Alpha.ino, ADC-Wert mit 10k Pull-up
+static const uint8_t LEITER_TASTEN[] = {T_NORD, 18, T_OST, T_WEST, T_MODUS};
+static const uint8_t LEITER_WERTE[] = {0, 33, 63, 92, 128};
+#define LEITER_OFFEN 255
+
+// Freigegebene Funkcodes: VORRANG_CODE + Zufahrt (VORRANG_FREIGABEN)
+#define VORRANG_CODE 0x5A0F01
+
+// Lampenpins in der Reihenfolge von LampenAusgabe.h (AMPELN,
+// dann FUSSGAENGER_LICHTER)
+static const uint8_t LAMPEN_PINS[] = {22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33,
+                                      6, 7, 8, 9, 10, 11, 12, 13};
+
+// Gelbe Hauptampeln: deren Blinken ist keine Reaktion
+static const uint8_t GELB_PINS[] = {23, 26, 29, 32};
+
+// -------------------------
+// STROMMODELL (Richtwerte, mA)
+// -------------------------
+#define STROM_CPU_AKTIV   16.0   // ATmega2560, 16 MHz, 5 V
+#define STROM_CPU_IDLE    6.0    // SLEEP_MODE_IDLE
+#define STROM_SONAR_RUHE  (4 * 2.0)
+#define STROM_SONAR_PING  15.0   // ein HC-SR04 während des Pings
+#define STROM_LAMPE       20.0   // pro leuchtender LED-Lampe
+
+static const Ereignis FUSSGAENGER[] = {
+  {5000, DRUECKEN, T_NORD, 0}, {5100, LOSLASSEN, T_NORD, 0},
+  {31000, DRUECKEN, T_OST, 0}, {31100, LOSLASSEN, T_OST, 0},
+};
+
+static const Ereignis NACHT_LEER[] = {
+  {1000, DRUECKEN, T_MODUS, 0}, {4500, LOSLASSEN, T_MODUS, 0},
+};
+
+static const Ereignis NACHT_AUTOS[] = {
+  {1000, DRUECKEN, T_MODUS, 0}, {4500, LOSLASSEN, T_MODUS, 0},
+  {6000, ABSTAND, S_NORD, 80},
+  {25000, ABSTAND, S_NORD, 0}, {25000, ABSTAND, S_OST, 100},
+  {45000, ABSTAND, S_OST, 0},
+};
+
+// Lange Nacht ohne Verkehr, dazwischen ein Fußgänger und ein Auto
+static const Ereignis NACHT_SOLAR[] = {
+  {1000, DRUECKEN, T_MODUS, 0}, {4500, LOSLASSEN, T_MODUS, 0},
+  {120000, DRUECKEN, T_NORD, 0}, {120100, LOSLASSEN, T_NORD, 0},
+  {200000, ABSTAND, S_OST, 90},
+  {215000, ABSTAND, S_OST, 0},
+};
+
+// Zug während Ost/West Grün, Kontakt 30 s belegt
+static const Ereignis BAHN_ZUG[] = {
+  {18000, DRUECKEN, BAHN, 0}, {48000, LOSLASSEN, BAHN, 0},
+};
+
+// Zug, während Ost Grün hat und die Fußgänger West im
+// Warnblinken sind (Lampe gerade dunkel)
+static const Ereignis BAHN_FUSSG[] = {
+  {14000, DRUECKEN, T_WEST, 0}, {14100, LOSLASSEN, T_WEST, 0},
+  {24200, DRUECKEN, BAHN, 0}, {44200, LOSLASSEN, BAHN, 0},
+};
+
+// Zug, während Ost/West schon Gelb hat: das Gelb läuft zu
+// Ende, West bekommt kein neues
+static const Ereignis BAHN_GELB[] = {
+  {24000, DRUECKEN, BAHN, 0}, {44000, LOSLASSEN, BAHN, 0},
+};
+
+// Einsatzfahrzeug (nur mit VORRANG_AKTIV). FUNK steht jeweils
+// zuletzt, --vorrang schiebt nur diese Ereignisse nach hinten.
+// Nord während Ost/West Grün
+static const Ereignis VORRANG_TAG[] = {
+  {18000, FUNK, 0, 0},
+};
+
+// Süd, während die Fußgänger Nord im Warnblinken sind
+static const Ereignis VORRANG_FUSSG[] = {
+  {5000, DRUECKEN, T_NORD, 0}, {5100, LOSLASSEN, T_NORD, 0},
+  {15200, FUNK, 1, 0},
+};
+
+// Ost, während Nord nachts Grün hat und die Sensoren pingen
+static const Ereignis VORRANG_NACHT[] = {
+  {1000, DRUECKEN, T_MODUS, 0}, {4500, LOSLASSEN, T_MODUS, 0},
+  {6000, ABSTAND, S_NORD, 80},
+  {12000, FUNK, 2, 0},
+};
+
+// Nord, während Nord/Süd schon Gelb hat: das Gelb läuft
+// zu Ende, erst dann Alles-Rot
+static const Ereignis VORRANG_GELB[] = {
+  {11000, FUNK, 0, 0},
+};
+
+// Busmeldungen (nur mit BUSVORRANG_AKTIV), das Gateway meldet
+// alle 2 s. Nord kurz vor Grünende (Verlängerung), Ost während
+// Nord/Süd Grün hat (Verkürzung)
+static const Ereignis BUS_TAG[] = {
+  {4000, BUS, 0, 8}, {6000, BUS, 0, 6}, {8000, BUS, 0, 4}, {10000, BUS, 0, 2},
+  {12500, BUS_AB, 0, 0},
+  {30000, BUS, 2, 6}, {32000, BUS, 2, 4}, {34000, BUS, 2, 2},
+  {36500, BUS_AB, 2, 0},
+};
+
+static const Ereignis MODUS_ZURUECK[] = {
+  {1000, DRUECKEN, T_MODUS, 0}, {4500, LOSLASSEN, T_MODUS, 0},
+  {12000, ABSTAND, S_NORD, 60},
+  {20000, DRUECKEN, T_MODUS, 0}, {23500, LOSLASSEN, T_MODUS, 0},
+};
+
+#define ANZ(a) (sizeof(a) / sizeof(a[0]))
+
+static const Szenario SZENARIEN[] = {
+  {"tag_zyklus",      60000, NULL, 0},
+  {"tag_fussgaenger", 60000, FUSSGAENGER, ANZ(FUSSGAENGER)},
+  {"nacht_leer",      30000, NACHT_LEER, ANZ(NACHT_LEER)},
+  {"nacht_autos",     60000, NACHT_AUTOS, ANZ(NACHT_AUTOS)},
+  {"modus_zurueck",   40000, MODUS_ZURUECK, ANZ(MODUS_ZURUECK)},
+  {"nacht_solar",     300000, NACHT_SOLAR, ANZ(NACHT_SOLAR)},
+  {"bahn_zug",        90000, BAHN_ZUG, ANZ(BAHN_ZUG)},
+  {"bahn_fussg",      70000, BAHN_FUSSG, ANZ(BAHN_FUSSG)},
+  {"bahn_gelb",       70000, BAHN_GELB, ANZ(BAHN_GELB)},
+  {"vorrang_tag",     60000, VORRANG_TAG, ANZ(VORRANG_TAG)},
+  {"vorrang_fussg",   45000, VORRANG_FUSSG, ANZ(VORRANG_FUSSG)},
+  {"vorrang_nacht",   50000, VORRANG_NACHT, ANZ(VORRANG_NACHT)},
+  {"vorrang_gelb",    45000, VORRANG_GELB, ANZ(VORRANG_GELB)},
+  {"bus_tag",         60000, BUS_TAG, ANZ(BUS_TAG)},
+};
+
+// Wiedergabe einer Spur: Eingänge kommen nur aus der Spur,
+// Dauer 0 = bis die Spur zu Ende ist
+static const Szenario SPUR = {"spur", 0, NULL, 0};
+
+// -------------------------
+// PINBOARD AUS MOCKS
+// -------------------------
+#define MOCKS 4   // 4 x 16 Pins deckt den Mega bis A9 ab
+
+class MockBoard : public HostPinBoard {
+public:
+  MockBoard() : _io(new MultiIoAbstraction(0)) {
+    // Keine echten Arduino-Pins (Bereich 0), alles geht an die Mocks
+    for (uint8_t i = 0; i < MOCKS; i++) {
+      _mock[i] = new MockedIoAbstraction(1);
+      _mock[i]->setValueForReading(0, 0xFFFF);   // Pullups: offen = HIGH
+      _io->addIoExpander(_mock[i], 16);
+    }
+  }
+
+  void modus(uint8_t pin, uint8_t modus) {
+    if (pin >= MOCKS * 16) return;
+#if LAMPEN_IOEXPANDER
+    if (_kette.gehoert(pin)) return;
+#endif
+    _io->pinDirection(pin, modus);
+    if (modus == OUTPUT) _ausgaenge |= 1ULL << pin;
+  }
+  void schreiben(uint8_t pin, uint8_t wert) {
+#if LAMPEN_IOEXPANDER
+    if (_kette.schreiben(pin, wert)) {
+      if (pin == SR_LATCH) kette_zeigen();
+      return;
+    }
+#endif
+    if (pin < MOCKS * 16) _io->writeValue(pin, wert);
+  }
+  uint8_t lesen(uint8_t pin) {
+    return pin < MOCKS * 16 ? _io->readValue(pin) : LOW;
+  }
+
+  // Eingang von außen setzen, mit Flanke für die ISR
+  void eingang(uint8_t pin, uint8_t wert) {
+    uint16_t &lesen = _lesen[pin / 16];
+    uint8_t vorher = bitRead(lesen, pin % 16);
+    bitWrite(lesen, pin % 16, wert);
+    _mock[pin / 16]->setValueForReading(0, lesen);
+    host_flanke(pin, vorher, wert);
+  }
+
+  // Zuletzt geschriebener Pegel eines Ausgangs
+  uint8_t ausgang(uint8_t pin) const {
+    return bitRead(_mock[pin / 16]->getWrittenValue(0), pin % 16);
+  }
+
+  // Alle Ausgänge als Bitfolge (Reihenfolge: aufsteigende Pins)
+  std::string ausgaenge(bool ohne_gelb = false) const {
+    std::string bits;
+    for (uint8_t pin = 0; pin < MOCKS * 16; pin++) {
+      if (!(_ausgaenge >> pin & 1)) continue;
+      if (ohne_gelb && gelb(pin)) continue;
+      bits += ausgang(pin) ? '1' : '0';
+    }
+    return bits;
+  }
+
+  static bool gelb(uint8_t pin) {
+    for (uint8_t g : GELB_PINS) {
+      if (g == pin) return true;
+    }
+    return false;
+  }
+
+  std::string kopf() const {
+    std::string k = "# Pins:";
+    for (uint8_t pin = 0; pin < MOCKS * 16; pin++) {
+      if (_ausgaenge >> pin & 1) k += " " + std::to_string(pin);
+    }
+    return k;
+  }
+
+private:
+  MultiIoAbstraction *_io;   // nie löschen: der Destruktor würde auch internalDigitalIo freigeben
+  MockedIoAbstraction *_mock[MOCKS];
+  uint16_t _lesen[MOCKS] = {0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF};
+  uint64_t _ausgaenge = 0;
+
+#if LAMPEN_IOEXPANDER
+  // Lampe n hängt an dem Ausgang, auf den IoAbstraction Bit n
+  // schiebt: das erste Byte landet im letzten Baustein. Die
+  // Ausgänge erscheinen auf den Lampenpins, die Kette selbst
+  // nicht in der Zeitlinie.
+  void kette_zeigen() {
+    for (uint8_t n = 0; n < sizeof(LAMPEN_PINS); n++) {
+      modus(LAMPEN_PINS[n], OUTPUT);
+      _io->writeValue(LAMPEN_PINS[n], _kette.ausgang(8 * (SR_ANZAHL - 1 - n / 8) + n % 8));
+    }
+  }
+
+  HostHc595 _kette{SR_DATEN, SR_TAKT, SR_LATCH, SR_ANZAHL};
+#endif
+};
+
+// -------------------------
+// AUFNAHME
+// -------------------------
+static MockBoard *board;
+static const Szenario *szenario;
+static uint8_t naechstes;
+static uint32_t funk_versatz_ms = 0;   // --vorrang: FUNK-Ereignisse später
+static std::string zeitlinie;
+static std::string letzte;
+static uint8_t leiter_gedrueckt = 0;   // Bit k = Taste k der Leiter
+
+// NeoPixel-Kette: jedes leuchtende Pixel gilt als der Pin, an
+// dem die Lampe sonst hängt - die Zeitlinie bleibt vergleichbar
+#if LAMPEN_NEOPIXEL
+static void neopixel_gezeigt(const uint32_t *pixel, uint16_t anzahl) {
+  for (uint16_t i = 0; i < anzahl && i < sizeof(LAMPEN_PINS); i++) {
+    board->modus(LAMPEN_PINS[i], OUTPUT);
+    board->schreiben(LAMPEN_PINS[i], pixel[i] ? HIGH : LOW);
+  }
+}
+#endif
+
+// Szenarioende aus dem Takt heraus: loop() kehrt im
+// Sparbetrieb (Sparbetrieb.h) nicht von selbst zurück.
+// Ein normaler Durchlauf darf noch zu Ende laufen.
+#define SZENARIO_NACHLAUF_MS 1000
+static jmp_buf szenario_ende;
+
+// Für --strom
+struct Reaktion {
+  const Ereignis *ereignis;
+  int32_t dauer_ms;          // -1 = (noch) keine Reaktion
+};
+static std::vector<Reaktion> reaktionen;
+static std::string letzte_ohne_gelb;
+static uint64_t lampen_ms = 0;   // Summe leuchtender Lampen pro ms
+
+// -------------------------
+// BLACKBOX (--blackbox)
+// -------------------------
+// Nur die Lampenpins in Lampenreihenfolge, einmal von den
+// Mocks, einmal aus den Einträgen im Flash. Ein Eintrag bei
+// millis() = t erscheint wie jede Ausgabe im Takt t + 1,
+// die aus setup() im ersten Takt danach.
+#if BLACKBOX_AKTIV
+static std::string lampenlinie;
+static std::string letzte_lampen;
+static uint32_t setup_ms;
+static uint32_t setup_eintraege;
+
+static std::string lampen_bits(LampenBild bild) {
+  std::string bits;
+  for (uint8_t i = 0; i < ANZAHL_LAMPEN; i++) bits += bild >> i & 1 ? '1' : '0';
+  return bits;
+}
+
+static void blackbox_takt(uint32_t ms) {
+  std::string bits;
+  for (uint8_t i = 0; i < ANZAHL_LAMPEN; i++) bits += board->ausgang(lampentreiber.pin(i)) ? '1' : '0';
+  if (bits != letzte_lampen) {
+    lampenlinie += std::to_string(ms) + " " + bits + "\n";
+    letzte_lampen = bits;
+  }
+}
+
+// Zeitlinie aus dem Flash; mehrere Bilder in derselben ms
+// sehen die Pins nur als das letzte
+static std::string blackbox_linie() {
+  std::vector<std::pair<uint32_t, std::string>> zeilen;
+  BlackboxEintrag e;
+  uint32_t gelesen = 0;
+  blackbox.lesen_starten();
+  while (blackbox.naechster(e)) {
+    if (e.art != BB_ANFANG) gelesen++;
+    if (e.art != BB_LAMPEN && e.art != BB_ANFANG) continue;
+    uint32_t ms = gelesen <= setup_eintraege ? setup_ms : e.zeit_ms + 1;
+    if (!zeilen.empty() && zeilen.back().first == ms) zeilen.pop_back();
+    std::string bits = lampen_bits(e.bild);
+    if (!zeilen.empty() && zeilen.back().second == bits) continue;
+    zeilen.push_back({ms, bits});
+  }
+  std::string linie;
+  for (const auto &z : zeilen) linie += std::to_string(z.first) + " " + z.second + "\n";
+  return linie;
+}
+#endif
+
+// -------------------------
+// NACHTVERKEHR (--verkehr)
+// -------------------------
+// Pro Zufahrt eine Warteschlange: Ankünfte zufällig (fester
+// Startwert), der Sensor sieht das erste wartende Auto bzw. die
+// Gegenseite, bei Grün fährt alle VERKEHR_ABFLUSS_MS eins ab.
+// Ein Sensor fällt von Anfang an aus: kein Echo mehr oder
+// immer derselbe Abstand.
+#define VERKEHR_DAUER_MS     (30 * 60000UL)
+#define VERKEHR_PRO_STUNDE   60      // Ankünfte pro Zufahrt
+#define VERKEHR_ABFLUSS_MS   2000    // Zeitlücke beim Abfließen
+#define VERKEHR_AUTO_CM      60
+#define VERKEHR_GEGENSEITE   250     // ohne Auto (innerhalb SENSOR_MAX_CM)
+#define VERKEHR_KLEBT_CM     70
+
+static const uint8_t GRUEN_PINS[] = {24, 27, 30, 33};
+static const uint8_t SONAR_PINS[] = {14, 16, 18, 1};
+
+enum Defekt { HEIL, TOT, KLEBT };
+
+struct VerkehrsFall {
+  const char *name;
+  Defekt defekt;   // an Zufahrt 0 (Nord)
+};
+
+static const VerkehrsFall VERKEHRSFAELLE[] = {
+  {"alle_heil", HEIL},
+  {"nord_tot", TOT},
+  {"nord_klebt", KLEBT},
+};
+
+static const Szenario VERKEHR = {"verkehr", VERKEHR_DAUER_MS, NACHT_LEER, ANZ(NACHT_LEER)};
+
+struct Zufahrt {
+  std::deque<uint32_t> schlange;   // Ankunftszeiten
+  uint32_t naechste_ankunft;
+  uint32_t letzte_abfahrt;
+  uint32_t gruen_seit;             // 0 = nicht grün
+  uint32_t abgefahren;
+  uint64_t warten_summe;
+  uint32_t warten_max;
+  uint32_t gruen_ms;
+};
+
+static const VerkehrsFall *verkehrsfall = NULL;
+static Zufahrt zufahrten[4];
+static uint32_t verkehr_zufall = 12345;
+
+// Exponentialverteilte Zwischenankunftszeit (ms)
+static uint32_t verkehr_abstand() {
+  verkehr_zufall = verkehr_zufall * 1664525UL + 1013904223UL;
+  double u = ((verkehr_zufall >> 8) + 1) / 16777217.0;
+  return (uint32_t)(-log(u) * 3600000.0 / VERKEHR_PRO_STUNDE) + 1;
+}
+
+static void verkehr_takt(uint32_t ms) {
+  if (ms < 5000) {
+    // Erst nach dem Wechsel in den Nachtmodus
+    for (Zufahrt &z : zufahrten) z.naechste_ankunft = 5000 + verkehr_abstand();
+  }
+  for (uint8_t i = 0; i < 4; i++) {
+    Zufahrt &z = zufahrten[i];
+    while (ms >= z.naechste_ankunft) {
+      z.schlange.push_back(z.naechste_ankunft);
+      z.naechste_ankunft += verkehr_abstand();
+    }
+    if (board->ausgang(GRUEN_PINS[i])) {
+      z.gruen_ms++;
+      if (!z.gruen_seit) z.gruen_seit = ms;
+      // Das erste Auto fährt nach der Anfahrzeit, dann im Abstand
+      if (!z.schlange.empty() && ms - z.gruen_seit >= VERKEHR_ABFLUSS_MS &&
+          ms - z.letzte_abfahrt >= VERKEHR_ABFLUSS_MS) {
+        uint32_t gewartet = ms - z.schlange.front();
+        z.schlange.pop_front();
+        z.letzte_abfahrt = ms;
+        z.abgefahren++;
+        z.warten_summe += gewartet;
+        z.warten_max = max(z.warten_max, gewartet);
+      }
+    } else {
+      z.gruen_seit = 0;
+    }
+    uint16_t cm = z.schlange.empty() ? VERKEHR_GEGENSEITE : VERKEHR_AUTO_CM;
+    if (i == 0 && verkehrsfall->defekt == TOT) cm = 0;
+    if (i == 0 && verkehrsfall->defekt == KLEBT) cm = VERKEHR_KLEBT_CM;
+    host_sonar_cm[SONAR_PINS[i]] = cm;
+  }
+}
+
+static void verkehr_ausgeben() {
+  printf("%-11s", verkehrsfall->name);
+  uint32_t summe = 0, wartend = 0;
+  for (const Zufahrt &z : zufahrten) {
+    printf("  %3u %5.0f %5u %4u%%", z.abgefahren, z.abgefahren ? z.warten_summe / 1000.0 / z.abgefahren : 0.0,
+           max(z.warten_max, z.schlange.empty() ? 0 : (uint32_t)(VERKEHR_DAUER_MS - z.schlange.front())) / 1000,
+           (unsigned)(z.gruen_ms * 100 / VERKEHR_DAUER_MS));
+    summe += z.abgefahren;
+    wartend += z.schlange.size();
+  }
+  printf("  %5u %4u\n", summe, wartend);
+}
+
+// Ereignisse, auf die die Steuerung sichtbar reagieren muss
+static bool braucht_reaktion(const Ereignis &e) {
+  if (e.art == BUS || e.art == BUS_AB) return false;   // Eingriff nur, wenn er passt
+  if (e.art == ABSTAND) return e.cm > 0;
+  if (e.art == FUNK) return true;
+  if (e.pin == T_MODUS) return e.art == LOSLASSEN;
+  return e.art == DRUECKEN;
+}
+
+// -------------------------
+// STATUS-LCD (--lcd)
+// -------------------------
+// Jedes Mal, wenn die Seite im RAM ganz übertragen ist, muss
+// das Modell genau sie zeigen
+#if STATUS_LCD
+static HostHd44780 lcd_modell;
+static uint32_t lcd_pruefungen = 0;
+static uint32_t lcd_fehler = 0;
+
+static void lcd_takt() {
+  if (!lcd_seite.aktuell()) return;
+  lcd_pruefungen++;
+  for (uint8_t zeile = 0; zeile < LCD_ZEILEN; zeile++) {
+    for (uint8_t spalte = 0; spalte < LCD_SPALTEN; spalte++) {
+      if (lcd_modell.zeichen(spalte, zeile) != lcd_seite.zeichen_an(spalte, zeile)) {
+        lcd_fehler++;
+        return;
+      }
+    }
+  }
+}
+
+static void lcd_ausgeben(const Szenario &s) {
+  printf("%-16s %u Prüfungen, %u abweichend, %u Zeichen, %u setCursor, max %u us, %u E-Flanken zu früh\n", s.name,
+         lcd_pruefungen, lcd_fehler, lcd_seite.zeichen(), lcd_seite.setcursor(), lcd_seite.max_us(),
+         lcd_modell.zu_frueh);
+  for (uint8_t zeile = 0; zeile < LCD_ZEILEN; zeile++) {
+    printf("  |");
+    for (uint8_t spalte = 0; spalte < LCD_SPALTEN; spalte++) {
+      uint8_t c = lcd_modell.zeichen(spalte, zeile);
+      putchar(c == LCD_VOLL ? '#' : c >= 1 && c <= 4 ? '|' : c);
+    }
+    printf("|\n");
+  }
+}
+#endif
+
+// -------------------------
+// VORRANG-LATENZ (--vorrang)
+// -------------------------
+// Ein Code pro Szenario, also ein Messwert pro Lauf. Die Läufe
+// eines Szenarios (je ein fork) schreiben in ein gemeinsames Feld.
+#if VORRANG_AKTIV
+#define VORRANG_LAEUFE      40
+#define VORRANG_VERSATZ_MS  13   // geht weder in der Loop (10) noch im Sweep (500) auf
+
+struct VorrangLauf {
+  uint32_t latenz_us;
+  bool reagiert;   // Lampen haben sich nach dem Code geändert
+};
+static VorrangLauf *vorrang_laeufe;
+static uint32_t vorrang_lauf;
+
+static bool hat_funk(const Szenario &s) {
+  for (uint8_t i = 0; i < s.anzahl; i++) {
+    if (s.ereignisse[i].art == FUNK) return true;
+  }
+  return false;
+}
+
+static void vorrang_merken() {
+  VorrangLauf &l = vorrang_laeufe[vorrang_lauf];
+  l.latenz_us = vorrang.latenz_max_us();
+  l.reagiert = false;
+  for (const Reaktion &r : reaktionen) {
+    if (r.ereignis->art == FUNK && r.dauer_ms >= 0) l.reagiert = true;
+  }
+}
+
+static bool vorrang_ausgeben(const Szenario &s) {
+  uint32_t min_us = UINT32_MAX, max_us = 0, ueber = 0, ohne = 0;
+  uint64_t summe = 0;
+  for (uint32_t i = 0; i < VORRANG_LAEUFE; i++) {
+    const VorrangLauf &l = vorrang_laeufe[i];
+    min_us = min(min_us, l.latenz_us);
+    max_us = max(max_us, l.latenz_us);
+    summe += l.latenz_us;
+    if (l.latenz_us > VORRANG_LATENZ_MAX_US) ueber++;
+    if (!l.reagiert) ohne++;
+  }
+  printf("%-16s Latenz min %6u us, Ø %6u us, max %6u us, %u über %lu us, %u ohne Vorrang\n", s.name, min_us,
+         (uint32_t)(summe / VORRANG_LAEUFE), max_us, ueber, VORRANG_LATENZ_MAX_US, ohne);
+  return !ueber && !ohne;
+}
+#endif
+
+// -------------------------
+// BUSMELDUNGEN (J1939)
+// -------------------------
+// Wie vom Gateway: Priorität 6, PDU2, Quelladresse BUS_GATEWAY
+#if BUSVORRANG_AKTIV
+#define BUS_GATEWAY 0x31
+
+static void bus_melden(const Ereignis &e) {
+  can_frame f = {};
+  uint32_t pgn = e.art == BUS ? BUS_PGN_POS : BUS_PGN_AB;
+  f.can_id = CAN_EFF_FLAG | 6UL << 26 | pgn << 8 | BUS_GATEWAY;
+  f.data[0] = e.pin;
+  if (e.art == BUS) {
+    uint16_t meter = e.cm * 10;   // ~36 km/h
+    f.data[1] = meter & 0xFF;
+    f.data[2] = meter >> 8;
+    f.data[3] = e.cm;
+    f.can_dlc = 4;
+  } else {
+    f.can_dlc = 1;
+  }
+  host_can_empfang.push_back(f);
+}
+#endif
+
+// -------------------------
+// WIDERSTANDSLEITER
+// -------------------------
+// Taster, die an der Leiter hängen, ändern nur den ADC-Wert.
+// Abgetastet wird einmal pro Millisekunde wie mit Timer0 als
+// Auslöser (LEITER_FREILAUF 0); feiner läuft die Uhr hier nicht.
+static bool leiter_taste(const Ereignis &e) {
+  if (!TASTER_LEITER) return false;
+  for (uint8_t k = 0; k < sizeof(LEITER_TASTEN); k++) {
+    if (LEITER_TASTEN[k] != e.pin) continue;
+    bitWrite(leiter_gedrueckt, k, e.art == DRUECKEN);
+    return true;
+  }
+  return false;
+}
+
+#if TASTER_LEITER
+// Mehrere Tasten: der kleinste Widerstand gewinnt
+static void leiter_abtasten() {
+  uint8_t wert = leiter_gedrueckt ? LEITER_WERTE[__builtin_ctz(leiter_gedrueckt)] : LEITER_OFFEN;
+  leiter.abtasten(wert);
+}
+#endif
+
+static uint32_t ereignis_ms(const Ereignis &e) {
+  return e.ms + (e.art == FUNK ? funk_versatz_ms : 0);
+}
+
+static void takt(uint32_t ms) {
+  while (naechstes < szenario->anzahl && ereignis_ms(szenario->ereignisse[naechstes]) <= ms) {
+    const Ereignis &e = szenario->ereignisse[naechstes++];
+    if (e.art == ABSTAND) {
+      host_sonar_cm[e.pin] = e.cm;
+    } else if (e.art == FUNK) {
+#if VORRANG_AKTIV
+      // Aus dem Uhrtakt wie aus der Empfangs-ISR: eingetroffen ist
+      // der Code jetzt, abgeholt wird er erst von der Loop
+      vorrang_empfaenger.einspeisen(VORRANG_CODE + e.pin);
+#endif
+    } else if (e.art == BUS || e.art == BUS_AB) {
+#if BUSVORRANG_AKTIV
+      bus_melden(e);
+#endif
+    } else if (!leiter_taste(e)) {
+      board->eingang(e.pin, e.art == DRUECKEN ? LOW : HIGH);
+    }
+    if (braucht_reaktion(e)) reaktionen.push_back({&e, -1});
+  }
+#if TASTER_LEITER
+  leiter_abtasten();
+#endif
+  if (verkehrsfall) verkehr_takt(ms);
+#if BLACKBOX_AKTIV
+  blackbox_takt(ms);
+#endif
+#if STATUS_LCD
+  lcd_takt();
+#endif
+
+  std::string jetzt = board->ausgaenge();
+  if (jetzt != letzte) {
+    zeitlinie += std::to_string(ms) + " " + jetzt + "\n";
+    letzte = jetzt;
+  }
+  for (char c : jetzt) lampen_ms += c == '1';
+
+  // Reaktion = erste Änderung, die nicht nur Gelbblinken ist
+  std::string ohne_gelb = board->ausgaenge(true);
+  if (ohne_gelb != letzte_ohne_gelb) {
+    for (Reaktion &r : reaktionen) {
+      if (r.dauer_ms < 0) r.dauer_ms = ms - ereignis_ms(*r.ereignis);
+    }
+    letzte_ohne_gelb = ohne_gelb;
+  }
+
+  if (szenario->dauer_ms && ms >= szenario->dauer_ms + SZENARIO_NACHLAUF_MS) longjmp(szenario_ende, 1);
+}
+
+static void strom_ausgeben(const Szenario &s) {
+  double dauer_us = host_zeit_us;
+  double schlaf = host_schlaf_us / dauer_us;
+  double ping = host_ping_us / dauer_us;
+  double ma = STROM_CPU_AKTIV * (1 - schlaf) + STROM_CPU_IDLE * schlaf +
+              STROM_SONAR_RUHE + STROM_SONAR_PING * ping +
+              STROM_LAMPE * lampen_ms / (dauer_us / 1000);
+  printf("%-16s Ø %6.1f mA  (CPU schläft %4.1f%%, Pings %4.1f%%, Lampen Ø %.2f)\n",
+         s.name, ma, schlaf * 100, ping * 100, lampen_ms / (dauer_us / 1000));
+  for (const Reaktion &r : reaktionen) {
+    const Ereignis &e = *r.ereignis;
+    printf("  %6u ms  %-9s Pin %2u -> ", e.ms,
+           e.art == ABSTAND ? "Abstand" : e.art == FUNK ? "Funk" : e.art == DRUECKEN ? "Druecken" : "Loslassen",
+           e.pin);
+    if (r.dauer_ms < 0) printf("keine Reaktion\n");
+    else printf("Reaktion nach %d ms\n", r.dauer_ms);
+  }
+}
+
+static std::string aufnehmen(const Szenario &s) {
+  board = new MockBoard();
+  szenario = &s;
+  host_board = board;
+#if LAMPEN_NEOPIXEL
+  host_neopixel_gezeigt = neopixel_gezeigt;
+#endif
+  host_serial_stumm = true;
+#if STATUS_LCD
+  host_i2c_geraete[0x27] = &lcd_modell;   // LCD_ADRESSE
+#endif
+
+  setup();
+#if BLACKBOX_AKTIV
+  setup_ms = millis();
+  setup_eintraege = blackbox.eintraege();
+#endif
+  host_ms_takt = takt;
+  takt(millis());
+#if SENSOR_SPUR == 2
+  if (!s.dauer_ms) {
+    while (!spur_beendet()) loop();
+  }
+#endif
+  if (!setjmp(szenario_ende)) {
+    while (millis() < s.dauer_ms) loop();
+  }
+  host_ms_takt = NULL;
+
+  return board->kopf() + "\n" + zeitlinie;
+}
+
+static bool datei_lesen(const std::string &pfad, std::string &inhalt) {
+  FILE *f = fopen(pfad.c_str(), "r");
+  if (!f) return false;
+  char puffer[4096];
+  size_t n;
+  while ((n = fread(puffer, 1, sizeof(puffer), f)) > 0) inhalt.append(puffer, n);
+  fclose(f);
+  return true;
+}
+
+// Erste abweichende Zeile melden
+static bool vergleichen(const char *name, const std::string &ist, const std::string &soll) {
+  if (ist == soll) return true;
+  size_t a = 0, b = 0;
+  uint32_t zeile = 1;
+  while (true) {
+    size_t ea = ist.find('\n', a), eb = soll.find('\n', b);
+    std::string za = ist.substr(a, ea - a), zb = soll.substr(b, eb - b);
+    if (za != zb || ea == std::string::npos || eb == std::string::npos) {
+      printf("%s: Abweichung in Zeile %u\n  Referenz: %s\n  Jetzt:    %s\n",
+             name, zeile, zb.c_str(), za.c_str());
+      return false;
+    }
+    a = ea + 1;
+    b = eb + 1;
+    zeile++;
+  }
+}
+
+static int szenario_laufen(const Szenario &s, const char *modus, const char *ordner) {
+  std::string ist = aufnehmen(s);
+  std::string pfad = ordner ? std::string(ordner) + "/" + s.name + ".txt" : "";
+
+  if (!modus) {
+    printf("== %s ==\n%s", s.name, ist.c_str());
+    return 0;
+  }
+  if (!strcmp(modus, "--strom")) {
+    strom_ausgeben(s);
+    return 0;
+  }
+  if (!strcmp(modus, "--verkehr")) {
+    verkehr_ausgeben();
+    return 0;
+  }
+#if BLACKBOX_AKTIV
+  if (!strcmp(modus, "--blackbox")) {
+    // "Referenz" sind hier die Pins
+    return vergleichen(s.name, blackbox_linie(), lampenlinie) ? 0 : 1;
+  }
+#endif
+#if STATUS_LCD
+  if (!strcmp(modus, "--lcd")) {
+    lcd_ausgeben(s);
+    return lcd_fehler || lcd_modell.zu_frueh || !lcd_pruefungen ? 1 : 0;
+  }
+#endif
+#if VORRANG_AKTIV
+  if (!strcmp(modus, "--vorrang")) {
+    vorrang_merken();
+    return 0;
+  }
+#endif
+  if (!strcmp(modus, "--schreiben")) {
+    FILE *f = fopen(pfad.c_str(), "w");
+    if (!f) {
+      perror(pfad.c_str());
+      return 2;
+    }
+    fputs(ist.c_str(), f);
+    fclose(f);
+    return 0;
+  }
+
+#if STATUS_EPAPER
+  // Teil-Refresh über den Rand, Text abgeschnitten, Framebuffer im RAM
+  if (host_epd_fehler || host_epd_ram_bytes) {
+    printf("%s: E-Paper %u Fehler, %u Byte Framebuffer im RAM (%u voll, %u Teil)\n", s.name, host_epd_fehler,
+           host_epd_ram_bytes, host_epd_voll, host_epd_teil);
+    return 1;
+  }
+#endif
+  std::string soll;
+  if (!datei_lesen(pfad, soll)) {
+    printf("%s: keine Referenz (%s)\n", s.name, pfad.c_str());
+    return 2;
+  }
+  return vergleichen(s.name, ist, soll) ? 0 : 1;
+}
+
+static int zeitlinie_laufen(int argc, char **argv) {
+#if SENSOR_SPUR
+  if (argc == 3 && !strcmp(argv[1], "--spur")) {
+#if SENSOR_SPUR == 2
+    host_sd_ordner = argv[2];
+    return szenario_laufen(SPUR, NULL, NULL);
+#else
+    mkdir(argv[2], 0777);
+    for (const Szenario &s : SZENARIEN) {
+      std::string ordner = std::string(argv[2]) + "/" + s.name;
+      mkdir(ordner.c_str(), 0777);
+      fflush(stdout);
+      pid_t pid = fork();
+      if (pid == 0) {
+        host_sd_ordner = ordner.c_str();
+        int ergebnis = szenario_laufen(s, NULL, NULL);
+        fflush(NULL);   // auch die noch gepufferte Spur
+        _exit(ergebnis);
+      }
+      waitpid(pid, NULL, 0);
+    }
+    return 0;
+#endif
+  }
+#endif
+
+  if (argc == 2 && !strcmp(argv[1], "--verkehr")) {
+    printf("Nacht, %u Fz/h pro Zufahrt, %lu min; pro Zufahrt N/S/O/W: abgefahren, Ø und max. Wartezeit (s), Grünanteil\n",
+           VERKEHR_PRO_STUNDE, VERKEHR_DAUER_MS / 60000);
+    for (const VerkehrsFall &f : VERKEHRSFAELLE) {
+      fflush(stdout);
+      pid_t pid = fork();
+      if (pid == 0) {
+        verkehrsfall = &f;
+        int ergebnis = szenario_laufen(VERKEHR, "--verkehr", NULL);
+        fflush(stdout);
+        _exit(ergebnis);
+      }
+      waitpid(pid, NULL, 0);
+    }
+    return 0;
+  }
+
+#if VORRANG_AKTIV
+  if (argc == 2 && !strcmp(argv[1], "--vorrang")) {
+    printf("Funkcode bis erstes Räumbild, %u Läufe pro Szenario, Code jeweils %u ms später\n", VORRANG_LAEUFE,
+           VORRANG_VERSATZ_MS);
+    vorrang_laeufe = (VorrangLauf *)mmap(NULL, VORRANG_LAEUFE * sizeof(VorrangLauf), PROT_READ | PROT_WRITE,
+                                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    int fehler = 0;
+    for (const Szenario &s : SZENARIEN) {
+      if (!hat_funk(s)) continue;
+      for (uint32_t lauf = 0; lauf < VORRANG_LAEUFE; lauf++) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+          vorrang_lauf = lauf;
+          funk_versatz_ms = lauf * VORRANG_VERSATZ_MS;
+          _exit(szenario_laufen(s, "--vorrang", NULL));
+        }
+        waitpid(pid, NULL, 0);
+      }
+      if (!vorrang_ausgeben(s)) fehler = 1;
+    }
+    return fehler;
+  }
+#endif
+
+  bool strom = argc == 2 && !strcmp(argv[1], "--strom");
+  bool blackbox_pruefen = BLACKBOX_AKTIV && argc == 2 && !strcmp(argv[1], "--blackbox");
+  bool lcd_pruefen = STATUS_LCD && argc == 2 && !strcmp(argv[1], "--lcd");
+  bool selbst = blackbox_pruefen || lcd_pruefen;   // ohne Referenzordner
+  const char *modus = argc > 2 || strom || selbst ? argv[1] : NULL;
+  const char *ordner = argc > 2 ? argv[2] : NULL;
+  if ((argc == 2 && !strom && !selbst) ||
+      (modus && !strom && !selbst && strcmp(modus, "--schreiben") && strcmp(modus, "--pruefen"))) {
+    printf("Aufruf: %s [--schreiben DIR | --pruefen DIR | --strom | --verkehr | --blackbox | --lcd | --vorrang]\n",
+           argv[0]);
+    return 2;
+  }
+
+  int fehler = 0;
+  for (const Szenario &s : SZENARIEN) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+      int ergebnis = szenario_laufen(s, modus, ordner);
+      fflush(stdout);
+      _exit(ergebnis);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    int ergebnis = WIFEXITED(status) ? WEXITSTATUS(status) : 2;
+    if (modus && !strom) printf("%-16s %s\n", s.name, ergebnis == 0 ? "ok" : "FEHLER");
+    if (ergebnis) fehler = 1;
+  }
+  return fehler;
+}
+
+// Wie am Mega werden die globalen Objekte des Sketches nie
+// zerstört: ~MultiIoAbstraction (LAMPEN_IOEXPANDER) würde den
+// statischen Digital-IO der Library mit löschen
+int main(int argc, char **argv) {
+  int ergebnis = zeitlinie_laufen(argc, argv);
+  fflush(NULL);
+  _exit(ergebnis);
+}
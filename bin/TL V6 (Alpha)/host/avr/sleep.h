@@ -0,0 +1,24 @@
+/* Host-Ersatz für avr/sleep.h: sleep_mode() schläft bis zum
+   nächsten Timer0-Interrupt, also bis zur nächsten vollen
+   Millisekunde der virtuellen Uhr. Die verschlafene Zeit
+   zählt host_schlaf_us (für Strommodelle). */
+
+#ifndef HOST_AVR_SLEEP_H
+#define HOST_AVR_SLEEP_H
+
+#include <Arduino.h>
+
+#define SLEEP_MODE_IDLE 0
+
+inline uint64_t host_schlaf_us = 0;
+
+inline void set_sleep_mode(uint8_t) {}
+inline void sleep_enable() {}
+inline void sleep_disable() {}
+inline void sleep_mode() {
+  uint32_t rest = 1000 - host_zeit_us % 1000;
+  host_schlaf_us += rest;
+  host_zeit_vorstellen(rest);
+}
+
+#endif
@@ -0,0 +1,69 @@
+/* Host-Ersatz für die MCP2515-Bibliothek (autowp/arduino-mcp2515),
+   nur was der Sketch für die ÖPNV-Bevorrechtigung braucht: ein
+   Empfangspuffer, den die Simulation füllt.
+
+   - readMessage() holt den ältesten Frame aus host_can_empfang,
+     ohne Frame ERROR_NOMSG wie beim leeren Empfangsregister
+   - reset(), setBitrate(), setNormalMode() merken sich nur, ob
+     der Controller empfangsbereit ist; vorher bleibt der Puffer
+     liegen (der echte MCP2515 nimmt im Konfigurationsmodus
+     nichts an)
+   - host_can_gelesen zählt die abgeholten Frames */
+
+#ifndef HOST_MCP2515_H
+#define HOST_MCP2515_H
+
+#include <Arduino.h>
+#include <deque>
+
+#define CAN_EFF_FLAG 0x80000000UL   // 29-Bit-ID
+#define CAN_RTR_FLAG 0x40000000UL
+#define CAN_ERR_FLAG 0x20000000UL
+#define CAN_SFF_MASK 0x000007FFUL
+#define CAN_EFF_MASK 0x1FFFFFFFUL
+
+struct can_frame {
+  uint32_t can_id;
+  uint8_t can_dlc;
+  uint8_t data[8];
+};
+
+enum CAN_CLOCK { MCP_20MHZ, MCP_16MHZ, MCP_8MHZ };
+enum CAN_SPEED { CAN_125KBPS, CAN_250KBPS, CAN_500KBPS, CAN_1000KBPS };
+
+inline std::deque<can_frame> host_can_empfang;
+inline uint32_t host_can_gelesen = 0;
+
+class MCP2515 {
+public:
+  enum ERROR { ERROR_OK, ERROR_FAIL, ERROR_ALLTXBUSY, ERROR_FAILINIT, ERROR_FAILTX, ERROR_NOMSG };
+
+  MCP2515(uint8_t cs) { (void)cs; }
+
+  ERROR reset() {
+    _bereit = false;
+    return ERROR_OK;
+  }
+  ERROR setBitrate(CAN_SPEED takt, CAN_CLOCK quarz) {
+    (void)takt;
+    (void)quarz;
+    return ERROR_OK;
+  }
+  ERROR setNormalMode() {
+    _bereit = true;
+    return ERROR_OK;
+  }
+
+  ERROR readMessage(struct can_frame *frame) {
+    if (!_bereit || host_can_empfang.empty()) return ERROR_NOMSG;
+    *frame = host_can_empfang.front();
+    host_can_empfang.pop_front();
+    host_can_gelesen++;
+    return ERROR_OK;
+  }
+
+private:
+  bool _bereit = false;
+};
+
+#endif
@@ -0,0 +1,173 @@
+#!/bin/bash
+# Baut die Zeitlinien-Aufnahme (Zeitlinie.cpp) und startet sie.
+# Ohne Argumente: alle Szenarien gegen die eingecheckten Referenzen
+# in host/zeitlinien/ prüfen (Bauvarianten mit eigener Zeitlinie,
+# z.B. SPAR=1, gegen host/zeitlinien/<variante>/). Sonst gehen alle
+# Argumente an das Programm, z.B.:
+#   ./zeitlinie.sh                              (prüfen, Exitcode 1 bei Abweichung)
+#   ./zeitlinie.sh --schreiben                  (Referenzen neu schreiben: nur wenn
+#                                                sich das Verhalten ändern soll)
+#   ./zeitlinie.sh --pruefen /tmp/referenz      (gegen eigenen Ordner)
+#   ./zeitlinie.sh --zeigen                     (Zeitlinien auf stdout)
+#   SPUR=1 ./zeitlinie.sh --spur /tmp/spuren    (Sensorspuren aufnehmen)
+#   ./zeitlinie.sh --spur /media/sd             (SPUR.BIN abspielen)
+#   SPUR=1 SEKTOREN=1 ./zeitlinie.sh --spur DIR (Spur als rohe Sektoren, host/SdFat.h)
+#   SPAR=1 ./zeitlinie.sh --strom               (Strom mit Sparbetrieb)
+#   BAHN=1 ./zeitlinie.sh                       (mit Bahnübergang/Schranke)
+#   FADEN=1 ./zeitlinie.sh --strom              (kooperative Fäden, host/Scheduler.h)
+#   KONSOLE=1 ./zeitlinie.sh --pruefen DIR      (mit AT-Konsole, ohne Eingabe)
+#   BEGLEITER=1 ./zeitlinie.sh                  (ESP32-Verbindung, ESP32 fehlt; Serial1 braucht
+#                                                TASTER_LEITER und einen umgelegten Sonar Ost)
+#   KALENDER=1 ./zeitlinie.sh --pruefen DIR     (Wochenplan, RTC aus host/RTClib.h)
+#   DETEKTOR=1 ./zeitlinie.sh --verkehr         (Nachtverkehr, Sensor tot/klebt, mit Überwachung)
+#   BLACKBOX=1 ./zeitlinie.sh --blackbox        (Lampen aus dem SPI-Flash gegen die Pins, host/Adafruit_SPIFlashBase.h)
+#   LCD=1 ./zeitlinie.sh --lcd                  (Status-LCD am I2C gegen die Seite im RAM, host/Hd44780.h)
+#   VORRANG=1 ./zeitlinie.sh --vorrang          (Latenz Funkcode -> Räumbild, Codes aus dem Uhrtakt)
+#   EPAPER=1 ./zeitlinie.sh                     (E-Paper-Schild, Refresh blockiert, host/Adafruit_ThinkInk.h)
+#   BUSVORRANG=1 ./zeitlinie.sh                 (ÖPNV-Bevorrechtigung, J1939-Frames über host/mcp2515.h)
+#   NEOPIXEL=1 ./zeitlinie.sh                   (Lampen als WS2812-Kette, Pixel -> Lampenpin, host/Adafruit_NeoPixel.h)
+#   IOEXPANDER=1 ./zeitlinie.sh                 (Lampen über 74HC595-Kette, Ausgang -> Lampenpin, host/Hc595.h)
+#   UMLAUF=1 ./zeitlinie.sh                     (Tagesprogramm passt sich dem gezählten Verkehr an, Umlauf.h)
+#   LEITER=1 ./zeitlinie.sh                     (Taster an der Widerstandsleiter, ADC-Werte aus dem Uhrtakt)
+# Bauverzeichnis über BAU=... änderbar (Standard /tmp/zeitlinie).
+set -e
+
+HIER=$(cd "$(dirname "$0")" && pwd)
+SKETCH=$(dirname "$HIER")
+LIB="$SKETCH/../../lib"
+BAU=${BAU:-/tmp/zeitlinie}
+mkdir -p "$BAU"
+
+# Der Sketchordner enthält Leerzeichen -> Arrays statt Strings.
+# INC: Sketch, Host-Ersatz und Schalter; BIB: Bibliotheken, deren
+# Warnungen hier nicht interessieren (wie geliefert)
+INC=(-I"$HIER" -I"$SKETCH")
+BIB=("$LIB/IoAbstraction/src" "$LIB/TaskManagerIO/src" "$LIB/SimpleCollections/src" "$LIB/TaskScheduler/src"
+     "$LIB/AccelStepper/src")
+QUELLEN=("$LIB/IoAbstraction/src/IoAbstraction.cpp" "$LIB/IoAbstraction/src/arduino/ArduinoDigitalIO.cpp"
+         "$LIB"/TaskManagerIO/src/*.cpp "$LIB"/SimpleCollections/src/*.cpp)
+
+# Referenzen: Bauvarianten, die die Zeitlinie ändern dürfen, haben
+# einen eigenen Ordner (mehrere: z.B. spar+detektor)
+REFERENZ="$HIER/zeitlinien"
+VARIANTE=""
+if [ -n "$BEGLEITER" ]; then
+  LEITER=${LEITER:-1}   # Serial1 liegt auf den Tasterpins 18/19
+fi
+for OPTION in SPAR FADEN BAHN DETEKTOR BLACKBOX LCD VORRANG EPAPER BUSVORRANG NEOPIXEL IOEXPANDER UMLAUF LEITER; do
+  if [ -n "${!OPTION}" ]; then
+    VARIANTE="${VARIANTE:+$VARIANTE+}${OPTION,,}"
+  fi
+done
+if [ -n "$VARIANTE" ]; then
+  REFERENZ="$REFERENZ/$VARIANTE"
+fi
+case "$1" in
+  "")                      set -- --pruefen "$REFERENZ" ;;
+  --pruefen|--schreiben)   if [ $# -eq 1 ]; then set -- "$1" "$REFERENZ"; mkdir -p "$REFERENZ"; fi ;;
+  --zeigen)                shift ;;
+esac
+
+# Sensorspur: --spur spielt ab, außer SPUR=1 (aufnehmen) ist gesetzt
+if [ "$1" = "--spur" ]; then
+  SPUR=${SPUR:-2}
+fi
+if [ -n "$SPUR" ]; then
+  INC+=(-DSENSOR_SPUR="$SPUR")
+fi
+if [ -n "$SEKTOREN" ]; then
+  # 1 MB statt 64 MB pro Szenario, Build-Flag wie Sektorlog.h
+  INC+=(-DSPUR_SEKTOREN="$SEKTOREN" -DSPUR_SEKTOR_MB=1 -DCHECK_FLASH_PROGRAMMING=0)
+fi
+if [ -n "$SPAR" ]; then
+  INC+=(-DNACHT_SPARBETRIEB="$SPAR")
+fi
+if [ -n "$FADEN" ]; then
+  INC+=(-DKOOP_FAEDEN="$FADEN")
+fi
+if [ -n "$KONSOLE" ]; then
+  INC+=(-DAT_KONSOLE="$KONSOLE")
+  BIB+=("$LIB/ATCommands/src")
+  QUELLEN+=("$LIB/ATCommands/src/ATCommands.cpp")
+fi
+if [ -n "$BEGLEITER" ]; then
+  INC+=(-DESP_BEGLEITER="$BEGLEITER" -DSONAR_OST_TRIGGER=41 -DSONAR_OST_ECHO=42)
+  BIB+=("$LIB/SerialCom/src")
+fi
+if [ -n "$DETEKTOR" ]; then
+  INC+=(-DDETEKTOR_UEBERWACHUNG="$DETEKTOR")
+fi
+if [ -n "$KALENDER" ]; then
+  INC+=(-DKALENDER_AKTIV="$KALENDER")
+fi
+if [ -n "$BLACKBOX" ]; then
+  INC+=(-DBLACKBOX_AKTIV="$BLACKBOX")
+fi
+if [ -n "$LCD" ]; then
+  # LiquidCrystal_I2C.cpp nimmt write(const uint8_t *, size_t) nur mit ARDUINO >= 100
+  INC+=(-DSTATUS_LCD="$LCD" -DARDUINO=186)
+  BIB+=("$LIB/LiquidCrystal_I2C")
+  QUELLEN+=("$LIB/LiquidCrystal_I2C/LiquidCrystal_I2C.cpp")
+fi
+if [ -n "$VORRANG" ]; then
+  # Software-Empfänger statt RCSwitch; RCSwitch.h bindet Arduino.h nur mit ARDUINO >= 100 ein
+  INC+=(-DVORRANG_AKTIV="$VORRANG" -DVORRANG_SIMULATION=1 -DARDUINO=186)
+  BIB+=("$LIB/rc-switch")
+  QUELLEN+=("$LIB/rc-switch/RCSwitch.cpp")
+fi
+if [ -n "$EPAPER" ]; then
+  INC+=(-DSTATUS_EPAPER="$EPAPER")
+fi
+if [ -n "$NEOPIXEL" ]; then
+  INC+=(-DLAMPEN_NEOPIXEL="$NEOPIXEL")
+fi
+if [ -n "$IOEXPANDER" ]; then
+  # Nur die 74HC595-Kette (IOEXP_MCP23017 0), die MCP23017 bräuchten IoAbstractionWire
+  INC+=(-DLAMPEN_IOEXPANDER="$IOEXPANDER")
+fi
+if [ -n "$UMLAUF" ]; then
+  INC+=(-DUMLAUF_OPTIMIERUNG="$UMLAUF")
+fi
+if [ -n "$LEITER" ]; then
+  INC+=(-DTASTER_LEITER="$LEITER")
+fi
+if [ -n "$BUSVORRANG" ]; then
+  # Nur die PGN-Tabelle aus SharkJ1939.h, die Frames kommen aus host/mcp2515.h
+  INC+=(-DBUSVORRANG_AKTIV="$BUSVORRANG")
+  BIB+=("$LIB/SharkJ1939/src")
+fi
+if [ -n "$BAHN" ]; then
+  # AccelStepper.h bindet Arduino.h nur mit ARDUINO >= 100 ein
+  INC+=(-DBAHN_VORRANG="$BAHN" -DARDUINO=186)
+  QUELLEN+=("$LIB/AccelStepper/src/AccelStepper.cpp")
+fi
+
+# Wie die Arduino-IDE: Prototypen aller Sketch-Funktionen vor die
+# erste Funktion setzen. Aus dem Präprozessor-Ergebnis, damit
+# abgeschaltete Module (#if ..._AKTIV 0) nicht mitkommen.
+g++ -std=c++17 "${INC[@]}" "${BIB[@]/#/-I}" -x c++ -E "$SKETCH/6Alpha.ino" | awk '
+  /^# [0-9]+ "/ { im_sketch = ($0 ~ /6Alpha\.ino"( [0-9])*$/); zeile = $2; next }
+  im_sketch {
+    if ($0 ~ /^[A-Za-z_][A-Za-z0-9_]* +[A-Za-z_][A-Za-z0-9_]*\(.*\) *\{/) {
+      sig = $0; sub(/ *\{.*$/, ";", sig)
+      print zeile "\t" sig
+    }
+    zeile++
+  }' > "$BAU/prototypen.txt"
+
+ERSTE=$(head -n 1 "$BAU/prototypen.txt" | cut -f 1)
+{
+  head -n $((ERSTE - 1)) "$SKETCH/6Alpha.ino"
+  cut -f 2 "$BAU/prototypen.txt"
+  echo "#line $ERSTE \"$SKETCH/6Alpha.ino\""
+  tail -n +"$ERSTE" "$SKETCH/6Alpha.ino"
+} > "$BAU/6Alpha.cpp"
+
+# Bibliotheken ohne Warnungen, Sketch und Host-Teile mit allen
+mkdir -p "$BAU/bib"
+rm -f "$BAU"/bib/*.o
+(cd "$BAU/bib" && g++ -std=c++17 -O1 -w "${INC[@]}" "${BIB[@]/#/-I}" -c "${QUELLEN[@]}")
+g++ -std=c++17 -O1 -Wall -Wextra "${INC[@]}" "${BIB[@]/#/-isystem}" -o "$BAU/zeitlinie" \
+  "$HIER/Zeitlinie.cpp" "$BAU/6Alpha.cpp" "$SKETCH/LampenAusgabe.cpp" "$BAU"/bib/*.o
+
+exec "$BAU/zeitlinie" "$@"
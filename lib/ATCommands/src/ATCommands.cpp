@@ -18,11 +18,38 @@ ATCommands::ATCommands()
 {
 }
 
-void ATCommands::begin(Stream *stream, const at_command_t *commands, uint32_t size, const uint16_t bufferSize, const char *terminator = "\r\n")
+ATCommands::~ATCommands()
+{
+    if (this->ownsBuffer)
+    {
+        free(this->buffer);
+    }
+}
+
+void ATCommands::begin(Stream *stream, const at_command_t *commands, uint32_t size, const uint16_t bufferSize, const char *terminator)
+{
+    // normally one allocation for the lifetime of the object, a later begin() that needs more replaces it
+    char *own = this->ownsBuffer ? this->buffer : NULL;
+    if (own == NULL || this->bufferSize < bufferSize)
+    {
+        free(own);
+        own = (char *)malloc(bufferSize);
+    }
+    this->ownsBuffer = false; // handed over below, not to be freed there
+    begin(stream, commands, size, own, own ? bufferSize : 0, terminator);
+    this->ownsBuffer = own != NULL;
+}
+
+void ATCommands::begin(Stream *stream, const at_command_t *commands, uint32_t size, char *buffer, const uint16_t bufferSize, const char *terminator)
 {
     this->serial = stream;
     this->term = terminator;
-    this->bufferString.reserve(bufferSize);
+    if (this->ownsBuffer && this->buffer != buffer)
+    {
+        free(this->buffer);
+    }
+    this->ownsBuffer = false;
+    this->buffer = buffer;
     this->bufferSize = bufferSize;
 
     registerCommands(commands, size);
@@ -38,13 +65,16 @@ void ATCommands::begin(Stream *stream, const at_command_t *commands, uint32_t si
  * is compared against the delcared array (atCommands) to find a matching
  * command name.  If a match is found the function is passed to the handler
  * for later execution.
+ *
+ * The command name is terminated in place by overwriting the '=' or '?'
+ * that follows it, so command points straight into the buffer.
  * @return true 
  * @return false 
  */
 bool ATCommands::parseCommand()
 {
     uint16_t pos = 2;
-    uint8_t type;
+    uint8_t type = AT_COMMAND_RUN;
 
     // validate input so that we act only when we have to
     if (this->bufferPos == 0)
@@ -54,58 +84,45 @@ bool ATCommands::parseCommand()
         return true;
     }
 
-    if (!this->bufferString.startsWith("AT"))
+    if (this->bufferPos < 2 || this->buffer[0] != 'A' || this->buffer[1] != 'T')
     {
         return false;
     }
 
-    for (uint16_t i = 2; i < this->bufferSize; i++)
+    for (; pos < this->bufferPos; pos++)
     {
-        // if we reach the null terminator and have not yet reached a state then we
-        // assume this to be a RUN command
-        if (this->bufferString[i] == '\0')
-        {
-            type = AT_COMMAND_RUN;
-            break;
-        }
+        char ch = this->buffer[pos];
 
         // eliminate shenanigans
-        if (isValidCmdChar(this->bufferString[i]) == 0)
+        if (isValidCmdChar(ch) == 0)
         {
             return false;
         }
 
         // determine command type
-        if (this->bufferString[i] == '=')
+        if (ch == '=')
         {
             // Is this a TEST or a WRITE command?
-            if (this->bufferString[i + 1] == '?')
-            {
-                type = AT_COMMAND_TEST;
-                break;
-            }
-            else
-            {
-                type = AT_COMMAND_WRITE;
-                break;
-            }
+            type = this->buffer[pos + 1] == '?' ? AT_COMMAND_TEST : AT_COMMAND_WRITE;
+            break;
         }
-        if (this->bufferString[i] == '?')
+        if (ch == '?')
         {
             type = AT_COMMAND_READ;
             break;
         }
-
-        pos++;
     }
-    this->command = this->bufferString.substring(2, pos);
+    // if we reach the end without finding '=' or '?' this is a RUN command,
+    // the terminator written by writeToBuffer ends the name
+    this->buffer[pos] = '\0';
+    this->command = &this->buffer[2];
     this->AT_COMMAND_TYPE = type;
-    int8_t cmdNumber = -1;
+    int16_t cmdNumber = -1;
 
     // search for matching command in array
-    for (uint8_t i = 0; i < this->numberOfCommands; i++)
+    for (uint16_t i = 0; i < this->numberOfCommands; i++)
     {
-        if (command.equals(atCommands[i].at_cmdName))
+        if (strcmp(this->command, atCommands[i].at_cmdName) == 0)
         {
             cmdNumber = i;
             break;
@@ -115,7 +132,6 @@ bool ATCommands::parseCommand()
     // if we did not find a match there's no point in continuing
     if (cmdNumber == -1)
     {
-        clearBuffer();
         return false;
     }
 
@@ -124,92 +140,74 @@ bool ATCommands::parseCommand()
     {
     case AT_COMMAND_RUN:
         setDefaultHandler(this->atCommands[cmdNumber].at_runCmd);
-        goto process;
+        break;
     case AT_COMMAND_READ:
         setDefaultHandler(this->atCommands[cmdNumber].at_readCmd);
-        goto process;
+        break;
     case AT_COMMAND_TEST:
         setDefaultHandler(this->atCommands[cmdNumber].at_testCmd);
-        goto process;
+        break;
     case AT_COMMAND_WRITE:
-        if (parseParameters(pos))
+        if (!parseParameters(pos))
         {
-            setDefaultHandler(this->atCommands[cmdNumber].at_writeCmd);
-            goto process;
+            return false;
         }
-        return false;
-
-    process:
-        // future placeholder
-        return true;
+        setDefaultHandler(this->atCommands[cmdNumber].at_writeCmd);
+        break;
     }
 
-    return true;
+    // a command type the table has no handler for is an error, not silence
+    return this->defaultHandler != NULL;
 }
 
 /**
  * @brief parseParameters
  * Called mainly by parseCommand as an extention to tokenize parameters
- * usually supplied in WRITE (eg AT+COMMAND=param1,param2) commands.  It makes
- * use of malloc so check above in parseCommand where we free it to keep things
- * neat.
- * @param pos 
+ * usually supplied in WRITE (eg AT+COMMAND=param1,param2) commands.  The
+ * parameters stay where they are in the buffer, next() splits them.
+ * @param pos position of the '='
  * @return true 
  * @return false 
  */
 bool ATCommands::parseParameters(uint16_t pos)
 {
-
-    this->bufferString = this->bufferString.substring(pos + 1, this->bufferSize - pos + 1);
-
+    this->tokenPos = pos + 1;
+    this->paramEnd = this->bufferPos;
     return true;
 }
 
 boolean ATCommands::hasNext()
 {
-    if (tokenPos < bufferSize)
-    {
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    return tokenPos < paramEnd;
 }
 
 /**
  * @brief next
  * This is called by user functions to iterate through the tokenized parameters.
- * Returns NULL when there is nothing more.  Subsequent calls pretty much ensure
- * this goes in a loop but it is expected the user knows their own parameters so there
- * would be no need to exceed boundaries.
+ * Each call terminates the next parameter in place by overwriting its comma.
+ * Returns an empty string when there is nothing more.  Subsequent calls pretty
+ * much ensure this goes in a loop but it is expected the user knows their own
+ * parameters so there would be no need to exceed boundaries.
  * @return char* 
  */
-String ATCommands::next()
+char *ATCommands::next()
 {
-    // if we have reached the boundaries return null so
+    // if we have reached the boundaries return an empty string so
     // that the caller knows not to expect anything
-    if (tokenPos >= this->bufferSize)
+    if (tokenPos >= paramEnd)
     {
-        tokenPos = bufferSize;
-        return "";
+        tokenPos = paramEnd;
+        return &this->buffer[paramEnd];
     }
 
-    String result = "";
-    int delimiterIndex = this->bufferString.indexOf(",", tokenPos);
-
-    if (delimiterIndex == -1)
-    {
-        result = this->bufferString.substring(tokenPos);
-        tokenPos = this->bufferSize;
-        return result;
-    }
-    else
+    char *result = &this->buffer[tokenPos];
+    while (tokenPos < paramEnd && this->buffer[tokenPos] != ',')
     {
-        result = this->bufferString.substring(tokenPos, delimiterIndex);
-        tokenPos = delimiterIndex + 1;
-        return result;
+        tokenPos++;
     }
+    this->buffer[tokenPos] = '\0';
+    tokenPos++;
+    return result;
 }
 
 /**
@@ -217,17 +215,20 @@ String ATCommands::next()
  * Main function called by the loop.  Reads in available charactrers and writes
  * to the buffer.  When the line terminator is found continues to parse and eventually
  * process the command.
+ * @param budget most bytes to read in this call
  * @return AT_COMMANDS_ERRORS 
  */
-AT_COMMANDS_ERRORS ATCommands::update()
+AT_COMMANDS_ERRORS ATCommands::update(uint16_t budget)
 {
-    if (serial == NULL)
+    if (serial == NULL || buffer == NULL)
     {
         return AT_COMMANDS_ERROR_NO_SERIAL;
     }
 
-    while (serial->available() > 0)
+    AT_COMMANDS_ERRORS result = AT_COMMANDS_SUCCESS;
+    while (budget > 0 && serial->available() > 0)
     {
+        budget--;
         int ch = serial->read();
 
 #ifdef AT_COMMANDS_DEBUG
@@ -255,17 +256,19 @@ AT_COMMANDS_ERRORS ATCommands::update()
             continue;
         }
 
-        if (bufferPos < this->bufferSize)
+        // keep one byte for the NUL terminator
+        if (bufferPos < this->bufferSize - 1)
         {
             writeToBuffer(ch);
         }
-        else
+        else if (ch != 13 && ch != 10 && !overflowed)
         {
 #ifdef AT_COMMANDS_DEBUG
             Serial.println(F("--BUFFER OVERFLOW--"));
 #endif
-            clearBuffer();
-            return AT_COMMANDS_ERROR_BUFFER_FULL;
+            // drop the rest of the line, otherwise its tail is parsed as a command
+            overflowed = true;
+            result = AT_COMMANDS_ERROR_BUFFER_FULL;
         }
 
         if (term[termPos] != ch)
@@ -276,13 +279,26 @@ AT_COMMANDS_ERRORS ATCommands::update()
 
         if (term[++termPos] == 0)
         {
+            if (overflowed)
+            {
+                this->error();
+                clearBuffer();
+                continue;
+            }
 
-#ifdef AT_COMMANDS_DEBUG
-            Serial.print(F("Received: ["));
-            for (uint32_t n = 0; n < this->bufferSize; n++)
+            // CR and LF never reach the buffer, any other terminator characters did
+            for (uint16_t i = 0; term[i] != 0 && bufferPos > 0; i++)
             {
-                Serial.print(this->bufferString[n]);
+                if (term[i] != 13 && term[i] != 10)
+                {
+                    bufferPos--;
+                }
             }
+            this->buffer[bufferPos] = '\0';
+
+#ifdef AT_COMMANDS_DEBUG
+            Serial.print(F("Received: ["));
+            Serial.print(this->buffer);
             Serial.println(F("]"));
 #endif
 
@@ -290,7 +306,8 @@ AT_COMMANDS_ERRORS ATCommands::update()
             {
                 this->error();
                 clearBuffer();
-                return;
+                result = AT_COMMANDS_ERROR_SYNTAX;
+                continue;
             }
 
             // process the command
@@ -300,6 +317,7 @@ AT_COMMANDS_ERRORS ATCommands::update()
             clearBuffer();
         }
     }
+    return result;
 }
 
 /**
@@ -312,8 +330,7 @@ void ATCommands::writeToBuffer(int data)
     // we don't write EOL to the buffer
     if ((char)data != 13 && (char)data != 10)
     {
-        this->bufferString += (char)data;
-        bufferPos++;
+        this->buffer[bufferPos++] = (char)data;
     }
 }
 
@@ -334,6 +351,7 @@ void ATCommands::setDefaultHandler(bool (*function)(ATCommands *))
 void ATCommands::processCommand()
 {
     if (defaultHandler != NULL)
+    {
         if ((*defaultHandler)(this))
         {
             this->ok();
@@ -342,6 +360,7 @@ void ATCommands::processCommand()
         {
             this->error();
         }
+    }
 }
 
 /**
@@ -349,10 +368,8 @@ void ATCommands::processCommand()
  * Registers the user-supplied command array for use later in parseCommand
  * @param commands 
  * @param size 
- * @return true 
- * @return false 
  */
-bool ATCommands::registerCommands(const at_command_t *commands, uint32_t size)
+void ATCommands::registerCommands(const at_command_t *commands, uint32_t size)
 {
     atCommands = commands;
     numberOfCommands = (uint16_t)(size / sizeof(at_command_t));
@@ -364,11 +381,16 @@ bool ATCommands::registerCommands(const at_command_t *commands, uint32_t size)
  */
 void ATCommands::clearBuffer()
 {
-    //for (uint16_t i = 0; i < this->buffer->size; i++)
-    this->bufferString = "";
+    if (this->buffer != NULL)
+    {
+        this->buffer[0] = '\0';
+    }
+    this->command = "";
+    overflowed = false;
     termPos = 0;
     bufferPos = 0;
     tokenPos = 0;
+    paramEnd = 0;
 }
 
 /**
@@ -378,7 +400,7 @@ void ATCommands::clearBuffer()
  */
 void ATCommands::ok()
 {
-    this->serial->println("OK");
+    this->serial->println(F(AT_SUCCESS));
 }
 
 /**
@@ -388,7 +410,7 @@ void ATCommands::ok()
  */
 void ATCommands::error()
 {
-    this->serial->println("ERROR");
+    this->serial->println(F(AT_ERROR));
 }
 
 /**
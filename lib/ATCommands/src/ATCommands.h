@@ -40,25 +40,13 @@ typedef enum
     AT_COMMAND_RUN
 } AT_COMMAND_TYPE;
 
-/**
- * @brief at_parse_t
- * 
- * used to hold a parsed AT command
- * 
- */
-typedef struct
-{
-    char *prefix; // the 'AT' prefix
-
-} at_parse_t;
-
 /**
  * @brief at_command_t struct
  *  borrowed verbatim from esp-at and is used to define an AT command 
 */
 typedef struct
 {
-    char *at_cmdName;                  // command name
+    const char *at_cmdName;            // command name
     bool (*at_runCmd)(ATCommands *);   // RUN command function pointer
     bool (*at_testCmd)(ATCommands *);  // TEST command function pointer
     bool (*at_readCmd)(ATCommands *);  // READ command function pointer
@@ -66,12 +54,11 @@ typedef struct
 
 } at_command_t;
 
-typedef struct
-{
-    String buffer; // the working buffer
-    size_t size;   // the buffer size
-} at_buffer_t;
-
+/**
+ * Commands are parsed in place in the working buffer: the command name and every
+ * parameter are NUL terminated slices of the line that was received, nothing is
+ * copied and nothing is allocated after begin().
+ */
 class ATCommands
 {
 private:
@@ -79,24 +66,25 @@ private:
     uint16_t numberOfCommands;
     const at_command_t *atCommands;
 
-    // input buffers
-    String bufferString = "";
+    // input buffer, either supplied by the caller or allocated once in begin()
+    char *buffer = NULL;
     uint16_t bufferSize = 0;
+    bool ownsBuffer = false; // buffer was allocated by begin() and is freed when replaced
     uint16_t bufferPos = 0; // keeps track of the buffer so that we don't overflow based on bufferSize above
+    bool overflowed = false; // the current line did not fit, it is dropped up to the next terminator
     const char *term;
     void writeToBuffer(int data);
 
     // input validation
     static int isValidCmdChar(const char c);
-    static uint8_t ATCommands::hexToChar(const char ch);
 
     // registers command array
-    bool registerCommands(const at_command_t *commands, uint32_t size);
+    void registerCommands(const at_command_t *commands, uint32_t size);
 
     // command parsing
     uint8_t AT_COMMAND_TYPE; // the type of command (see enum declaration)
-    //char *params;            // command parameters in the case of a WRITE
-    uint16_t tokenPos = 0; // position of token used when splitting parameters
+    uint16_t tokenPos = 0; // position of the next parameter when splitting parameters
+    uint16_t paramEnd = 0; // end of the parameters
     uint16_t termPos = 0;
     bool parseCommand();                // determines the command and command type
     bool parseParameters(uint16_t pos); // parses parameters in the case of a WRITE command
@@ -111,18 +99,32 @@ public:
 
     // initialize
     ATCommands();
+    ~ATCommands();
 
-    // register serial port, commands and buffers
+    /**
+     * @brief register serial port, commands and a working buffer allocated once here
+     * @param bufferSize the longest line expected, including the "AT"
+     * Calling begin() again reuses the buffer if it is large enough, otherwise it is replaced.
+     */
     void begin(Stream *serial, const at_command_t *commands, uint32_t size, const uint16_t bufferSize, const char *terminator = "\r\n");
 
+    /**
+     * @brief register serial port, commands and a caller owned working buffer, no heap is used at all
+     * @param buffer the working buffer, one byte of it is needed for the NUL terminator
+     * @param bufferSize the size of buffer in bytes
+     */
+    void begin(Stream *serial, const at_command_t *commands, uint32_t size, char *buffer, const uint16_t bufferSize, const char *terminator = "\r\n");
+
     // command parsing
-    String command; // the command (eg: +TEST in AT+TEST)
+    const char *command = ""; // the command (eg: +TEST in AT+TEST), points into the working buffer
 
     /**
 	 * @brief Checks the Serial port, reads the input buffer and calls a matching command handler.
-	 * @return SERIAL_COMMANDS_SUCCESS when successful or SERIAL_COMMANDS_ERROR_XXXX on error.
+	 * @param budget the most bytes to read in this call, so that a flood of input cannot stall the
+	 * caller. A command shorter than the budget is answered in the same call that reads its terminator.
+	 * @return AT_COMMANDS_SUCCESS when successful or AT_COMMANDS_ERROR_XXXX on error.
 	 */
-    AT_COMMANDS_ERRORS update();
+    AT_COMMANDS_ERRORS update(uint16_t budget = 0xFFFF);
 
     /**
 	 * @brief Clears the buffer, and resets the indexes.
@@ -130,11 +132,12 @@ public:
     void clearBuffer();
 
     /**
-     * @brief retrieves next token
+     * @brief retrieves next comma separated parameter of a WRITE command
      * 
-     * @return String 
+     * @return char* the parameter, NUL terminated inside the working buffer, "" when there are no more.
+     * Only valid until the handler returns.
      */
-    String next();
+    char *next();
 
     /**
      * @brief indicates if there are more tokens in the buffer
@@ -8,8 +8,14 @@
 
 #define printIIC(args)	Wire.write(args)
 inline size_t LiquidCrystal_I2C::write(uint8_t value) {
-	send(value, Rs);
-	return 1;
+	return sendBytes(&value, 1, Rs);
+}
+
+// Runs of characters (print() of strings and numbers) share I2C
+// transmissions: about 0.6ms per character at 100kHz instead of 1.3ms.
+// Returns how many made it onto the bus, less than size after an error.
+size_t LiquidCrystal_I2C::write(const uint8_t *buffer, size_t size) {
+	return sendBytes(buffer, size, Rs);
 }
 
 #else
@@ -50,6 +56,7 @@ LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t lcd_Addr,uint8_t lcd_cols,uint8_t l
   _cols = lcd_cols;
   _rows = lcd_rows;
   _backlightval = LCD_NOBACKLIGHT;
+  _error = 0;
 }
 
 void LiquidCrystal_I2C::init(){
@@ -209,9 +216,7 @@ void LiquidCrystal_I2C::noAutoscroll(void) {
 void LiquidCrystal_I2C::createChar(uint8_t location, uint8_t charmap[]) {
 	location &= 0x7; // we only have 8 locations 0-7
 	command(LCD_SETCGRAMADDR | (location << 3));
-	for (int i=0; i<8; i++) {
-		write(charmap[i]);
-	}
+	sendBytes(charmap, 8, Rs);
 }
 
 // Turn the (optional) backlight off/on
@@ -238,10 +243,36 @@ inline void LiquidCrystal_I2C::command(uint8_t value) {
 
 // write either command or data
 void LiquidCrystal_I2C::send(uint8_t value, uint8_t mode) {
-	uint8_t highnib=value&0xf0;
-	uint8_t lownib=(value<<4)&0xf0;
-       write4bits((highnib)|mode);
-	write4bits((lownib)|mode); 
+	sendBytes(&value, 1, mode);
+}
+
+// Both nibbles of each byte go out as data, data|En, data in one
+// transmission. Every expander byte takes 90us on the bus at 100kHz
+// (22us at 400kHz), which covers the 450ns enable pulse and the 37us
+// the LCD needs per command, so no delays are required between them.
+// clear() and home() still wait for themselves.
+// Stops at the first failed transmission and returns the number of
+// bytes sent; the Wire error is kept for transmissionError().
+size_t LiquidCrystal_I2C::sendBytes(const uint8_t *values, size_t size, uint8_t mode) {
+	size_t sent = 0;
+	while (size) {
+		uint8_t chunk = size < LCD_I2C_TRANSMISSION / 6 ? size : LCD_I2C_TRANSMISSION / 6;
+		Wire.beginTransmission(_Addr);
+		for (uint8_t i=0; i<chunk; i++) {
+			uint8_t nibbles[2] = { (uint8_t)(values[i] & 0xf0), (uint8_t)(values[i] << 4) };
+			for (uint8_t n=0; n<2; n++) {
+				uint8_t data = nibbles[n] | mode | _backlightval;
+				printIIC((int)data);
+				printIIC((int)(data | En));
+				printIIC((int)data);
+			}
+		}
+		if (!latchError(Wire.endTransmission())) break;
+		values += chunk;
+		size -= chunk;
+		sent += chunk;
+	}
+	return sent;
 }
 
 void LiquidCrystal_I2C::write4bits(uint8_t value) {
@@ -252,7 +283,22 @@ void LiquidCrystal_I2C::write4bits(uint8_t value) {
 void LiquidCrystal_I2C::expanderWrite(uint8_t _data){                                        
 	Wire.beginTransmission(_Addr);
 	printIIC((int)(_data) | _backlightval);
-	Wire.endTransmission();   
+	latchError(Wire.endTransmission());
+}
+
+// Keeps the first error until clearTransmissionError(), so a display
+// that is missing or drops off the bus stays visible to the sketch
+bool LiquidCrystal_I2C::latchError(uint8_t error){
+	if (error && !_error) _error = error;
+	return !error;
+}
+
+uint8_t LiquidCrystal_I2C::transmissionError(){
+	return _error;
+}
+
+void LiquidCrystal_I2C::clearTransmissionError(){
+	_error = 0;
 }
 
 void LiquidCrystal_I2C::pulseEnable(uint8_t _data){
@@ -52,6 +52,13 @@
 #define Rw B00000010  // Read/Write bit
 #define Rs B00000001  // Register select bit
 
+// Expander bytes per I2C transmission. Every LCD byte takes six
+// (two nibbles: data, data|En, data), so 30 moves five characters
+// at once and still fits the 32 byte Wire buffer of the AVR core.
+#ifndef LCD_I2C_TRANSMISSION
+#define LCD_I2C_TRANSMISSION 30
+#endif
+
 class LiquidCrystal_I2C : public Print {
 public:
   LiquidCrystal_I2C(uint8_t lcd_Addr,uint8_t lcd_cols,uint8_t lcd_rows);
@@ -80,11 +87,15 @@ public:
   void setCursor(uint8_t, uint8_t); 
 #if defined(ARDUINO) && ARDUINO >= 100
   virtual size_t write(uint8_t);
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  using Print::write;
 #else
   virtual void write(uint8_t);
 #endif
   void command(uint8_t);
   void init();
+  uint8_t transmissionError();      // first Wire.endTransmission() error (2 = no display), 0 = ok
+  void clearTransmissionError();
 
 ////compatibility API function aliases
 void blink_on();						// alias for blink()
@@ -110,8 +121,10 @@ void draw_vertical_graph(uint8_t row, uint8_t column, uint8_t len,  uint8_t pixe
 private:
   void init_priv();
   void send(uint8_t, uint8_t);
+  size_t sendBytes(const uint8_t *, size_t, uint8_t);
   void write4bits(uint8_t);
   void expanderWrite(uint8_t);
+  bool latchError(uint8_t);
   void pulseEnable(uint8_t);
   uint8_t _Addr;
   uint8_t _displayfunction;
@@ -121,6 +134,7 @@ private:
   uint8_t _cols;
   uint8_t _rows;
   uint8_t _backlightval;
+  uint8_t _error;
 };
 
 #endif
@@ -0,0 +1,76 @@
+/*
+ Stack and Switch Time
+
+ Measures what a task switch costs and how much of its stack
+ each task really uses, so that stack sizes can be chosen from
+ measurements instead of guesses.
+
+ Three tasks do nothing but yield. loop() counts how long a
+ full round through all of them takes, divides by the number of
+ switches and prints the result together with the stack high
+ water mark of each task. Start with generous stacks, run the
+ real application for a while, then shrink each stack to its
+ high water mark plus a safety margin.
+
+ Hardware required :
+ * none, results are printed on the serial port
+
+ This example code is in the public domain
+*/
+
+#include <Scheduler.h>
+
+uint8_t tasks[3];
+volatile uint32_t spins[3];
+
+// A task using a bit of stack, to show up in the high water mark
+void busyTask(uint8_t n) {
+  char buffer[64];
+  for (uint8_t i = 0; i < sizeof(buffer); i++)
+    buffer[i] = i * n;
+  spins[n] += buffer[n];
+  yield();
+}
+
+void task1() { busyTask(0); }
+void task2() { busyTask(1); }
+void task3() { yield(); spins[2]++; }
+
+void setup() {
+  Serial.begin(9600);
+  while (!Serial);
+
+  tasks[0] = Scheduler.startLoop(task1, 1024);
+  tasks[1] = Scheduler.startLoop(task2, 1024);
+  tasks[2] = Scheduler.startLoop(task3, 512);
+}
+
+void loop() {
+  // time a number of full rounds through all tasks
+  const uint32_t rounds = 10000;
+  uint32_t switchesBefore = Scheduler.switches();
+  uint32_t start = micros();
+  for (uint32_t i = 0; i < rounds; i++)
+    yield();
+  uint32_t took = micros() - start;
+  uint32_t switches = Scheduler.switches() - switchesBefore;
+
+  Serial.print("Switches: ");
+  Serial.print(switches);
+  Serial.print(" in ");
+  Serial.print(took);
+  Serial.print("us, ");
+  Serial.print((float)took * 1000 / switches);
+  Serial.println("ns per switch");
+
+  for (uint8_t i = 0; i < 3; i++) {
+    uint32_t size = Scheduler.stackSize(tasks[i]);
+    Serial.print("Task ");
+    Serial.print(tasks[i]);
+    Serial.print(": stack ");
+    Serial.print(size);
+    Serial.print(", used ");
+    Serial.println(size - Scheduler.stackUnused(tasks[i]));
+  }
+  delay(2000);
+}
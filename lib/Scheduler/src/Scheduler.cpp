@@ -23,14 +23,19 @@ extern "C" {
 typedef struct CoopTask {
 	uint32_t regs[NUM_REGS];
 	void* stackPtr;
+	uint32_t stackSize;
+	uint8_t id;
 	struct CoopTask* next;
 	struct CoopTask* prev;
 } CoopTask;
 
 static CoopTask *cur = 0;
+static uint8_t lastId = 0;
+static uint32_t switchCount = 0;
 
 static CoopTask* __attribute__((noinline)) coopSchedule(char taskDied) {
 	CoopTask* next = cur->next;
+	switchCount++;
 
 	if (taskDied) {
 		// Halt if last task died.
@@ -135,15 +140,18 @@ static int coopInit(void) {
 	task->next = task;
 	task->prev = task;
 	task->stackPtr = 0;
+	task->stackSize = 0;
+	task->id = 0;
 	cur = task;
 
 	return 1;
 }
 
-static int coopSpawn(SchedulerParametricTask taskF, void* taskData, uint32_t stackSz) {
+static uint8_t coopSpawn(SchedulerParametricTask taskF, void* taskData, uint32_t stackSz) {
 	uint8_t *stack = (uint8_t*)malloc(stackSz);
 	if (!stack)
 		return 0;
+	memset(stack, SCHEDULER_STACK_FILL, stackSz);
 
 	CoopTask *task = reinterpret_cast<CoopTask *>(malloc(sizeof(CoopTask)));
 	if (!task) {
@@ -151,6 +159,10 @@ static int coopSpawn(SchedulerParametricTask taskF, void* taskData, uint32_t sta
 		return 0;
 	}
 	task->stackPtr = stack;
+	task->stackSize = stackSz;
+	if (++lastId == 0)
+		lastId = 1;
+	task->id = lastId;
 	task->regs[0] = (uint32_t) taskF;
 	task->regs[1] = (uint32_t) taskData;
 	task->regs[8] = ((uint32_t)(stack + stackSz)) & ~7;
@@ -168,7 +180,17 @@ static int coopSpawn(SchedulerParametricTask taskF, void* taskData, uint32_t sta
 	if (stackSz == 0xFFFFFFFE)
 		coopSchedule(1);
 
-	return 1;
+	return task->id;
+}
+
+static CoopTask* coopFind(uint8_t id) {
+	CoopTask* task = cur;
+	do {
+		if (task->id == id)
+			return task;
+		task = task->next;
+	} while (task != cur);
+	return 0;
 }
 
 void yield(void) {
@@ -187,8 +209,8 @@ static void startLoopHelper(void *taskData) {
 		task();
 }
 
-void SchedulerClass::startLoop(SchedulerTask task, uint32_t stackSize) {
-	coopSpawn(startLoopHelper, reinterpret_cast<void *>(task), stackSize);
+uint8_t SchedulerClass::startLoop(SchedulerTask task, uint32_t stackSize) {
+	return coopSpawn(startLoopHelper, reinterpret_cast<void *>(task), stackSize);
 }
 
 static void startTaskHelper(void *taskData) {
@@ -196,12 +218,37 @@ static void startTaskHelper(void *taskData) {
 	task();
 }
 
-void SchedulerClass::start(SchedulerTask task, uint32_t stackSize) {
-	coopSpawn(startTaskHelper, reinterpret_cast<void *>(task), stackSize);
+uint8_t SchedulerClass::start(SchedulerTask task, uint32_t stackSize) {
+	return coopSpawn(startTaskHelper, reinterpret_cast<void *>(task), stackSize);
+}
+
+uint8_t SchedulerClass::start(SchedulerParametricTask task, void *taskData, uint32_t stackSize) {
+	return coopSpawn(task, taskData, stackSize);
+}
+
+uint32_t SchedulerClass::stackSize(uint8_t taskId) {
+	CoopTask* task = coopFind(taskId);
+	return task ? task->stackSize : 0;
+}
+
+uint32_t SchedulerClass::stackUnused(uint8_t taskId) {
+	CoopTask* task = coopFind(taskId);
+	if (!task || !task->stackPtr)
+		return 0;
+	// the stack grows down, count untouched bytes from the bottom up
+	const uint8_t* stack = (const uint8_t*)task->stackPtr;
+	uint32_t unused = 0;
+	while (unused < task->stackSize && stack[unused] == SCHEDULER_STACK_FILL)
+		unused++;
+	return unused;
+}
+
+uint8_t SchedulerClass::currentTask() {
+	return cur->id;
 }
 
-void SchedulerClass::start(SchedulerParametricTask task, void *taskData, uint32_t stackSize) {
-	coopSpawn(task, taskData, stackSize);
+uint32_t SchedulerClass::switches() {
+	return switchCount;
 }
 
 SchedulerClass Scheduler;
@@ -24,14 +24,31 @@ extern "C" {
 	typedef void (*SchedulerParametricTask)(void *);
 }
 
+// Every new task stack is filled with this byte, so that the deepest
+// point a task has reached can be found later (see stackUnused).
+#define SCHEDULER_STACK_FILL 0xA5
+
 class SchedulerClass {
 public:
 	SchedulerClass();
-	static void startLoop(SchedulerTask task, uint32_t stackSize = 1024);
-	static void start(SchedulerTask task, uint32_t stackSize = 1024);
-	static void start(SchedulerParametricTask task, void *data, uint32_t stackSize = 1024);
+	// All start functions return a task id (1, 2, ...) or 0 if there was not
+	// enough memory. The id is only needed for the stack functions below.
+	static uint8_t startLoop(SchedulerTask task, uint32_t stackSize = 1024);
+	static uint8_t start(SchedulerTask task, uint32_t stackSize = 1024);
+	static uint8_t start(SchedulerParametricTask task, void *data, uint32_t stackSize = 1024);
 
 	static void yield() { ::yield(); };
+
+	// Stack size the task was started with, 0 for loop() or a finished task.
+	static uint32_t stackSize(uint8_t taskId);
+	// Bytes at the bottom of the task's stack that were never written: the
+	// high water mark is stackSize() - stackUnused(). Scans the stack, so
+	// call it now and then, not in every loop.
+	static uint32_t stackUnused(uint8_t taskId);
+	// Id of the running task, 0 for loop().
+	static uint8_t currentTask();
+	// Number of task switches since start, for measuring yield overhead.
+	static uint32_t switches();
 };
 
 extern SchedulerClass Scheduler;
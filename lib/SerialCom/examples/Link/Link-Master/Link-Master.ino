@@ -0,0 +1,44 @@
+#include <Arduino.h>
+#include "SerialLink.h"
+
+// Same layout on both boards: fixed width types, packed for AVR <-> 32 bit
+struct __attribute__((packed)) Request {
+	uint16_t id;
+	uint8_t led;
+};
+
+struct __attribute__((packed)) Response {
+	uint16_t id;
+	uint32_t uptime;
+};
+
+Response response;
+SerialLink<Response, Request> serialLink(Serial1, response);
+
+uint16_t nextId = 1;
+bool waiting = false;
+unsigned long sentAt = 0;
+
+void setup() {
+	Serial.begin(115200);
+	Serial1.begin(1000000);
+}
+
+void loop() {
+	if (serialLink.update()) {
+		if (waiting && response.id == nextId - 1) {
+			Serial.print("round trip [us]: ");
+			Serial.println(micros() - sentAt);
+			waiting = false;
+		}
+	}
+
+	if (!waiting) {
+		Request request = {nextId, (uint8_t)(nextId & 1)};
+		if (serialLink.send(request)) {
+			sentAt = micros();
+			waiting = true;
+			nextId++;
+		}
+	}
+}
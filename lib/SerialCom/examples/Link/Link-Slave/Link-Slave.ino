@@ -0,0 +1,29 @@
+#include <Arduino.h>
+#include "SerialLink.h"
+
+struct __attribute__((packed)) Request {
+	uint16_t id;
+	uint8_t led;
+};
+
+struct __attribute__((packed)) Response {
+	uint16_t id;
+	uint32_t uptime;
+};
+
+Request request;
+SerialLink<Request, Response> serialLink(Serial1, request);
+
+void setup() {
+	pinMode(LED_BUILTIN, OUTPUT);
+	Serial1.begin(1000000);
+}
+
+void loop() {
+	// never blocks, the rest of the loop keeps running
+	if (serialLink.update()) {
+		digitalWrite(LED_BUILTIN, request.led ? HIGH : LOW);
+		Response response = {request.id, millis()};
+		serialLink.send(response);
+	}
+}
@@ -2,5 +2,6 @@
 #define SerialCom_h
 
 # include "SerialManager.h"
+# include "SerialLink.h"
 
 #endif
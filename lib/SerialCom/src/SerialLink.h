@@ -0,0 +1,369 @@
+#ifndef SERIALLINK_H
+#define SERIALLINK_H
+#include <Arduino.h>
+#ifdef __AVR__
+#include <util/crc16.h>
+#endif
+
+/*
+ * Reliable typed link between two boards, the non blocking sibling of SerialManager.
+ *
+ * Like SerialManager it moves one receiveT in and one sendT out, and like SerialManager the structs go over the wire
+ * as they are in memory: no field by field packing, the payload bytes land directly in a receiveT. Both boards must
+ * therefore agree on the layout, use fixed width types and __attribute__((packed)) when an AVR talks to a 32 bit
+ * board (ESP32, SAMD), which would otherwise pad differently.
+ *
+ * On top of that every frame carries a CRC and a sequence number. Up to `window` frames may be in flight, the
+ * receiver acknowledges cumulatively and anything not acknowledged within retransmitMs is sent again (go-back-N).
+ * Frames arrive exactly once and in order, as long as the other side keeps calling update(). The timeout doubles
+ * with every timeout in a row (up to 16 x retransmitMs), so a missing peer costs little line time.
+ *
+ * Frame layout:
+ *
+ *     0xAA 0x55 | type | session | seq | len | payload (len bytes) | crc lo | crc hi
+ *
+ *   type     LINK_DATA carries one struct, LINK_ACK none. LINK_SYN marks the first frame of a session.
+ *   session  DATA: session of the sender. ACK: session being acknowledged, so a stale ack can never confirm frames
+ *            of a newer session.
+ *   seq      DATA: sequence number (wraps at 256). ACK: next sequence number expected.
+ *   crc      CRC-16 (reflected CCITT polynomial, start 0xFFFF) over type..payload, the same as avr-libc's
+ *            _crc_ccitt_update().
+ *
+ * A new session starts with the first send() and whenever the peer stopped acknowledging for maxRetries timeouts
+ * in a row, which is how a restarted peer is picked up again. The receiver only synchronises on LINK_SYN frames.
+ *
+ * Writing never blocks either, as long as the stream reports its free transmit buffer through availableForWrite()
+ * (HardwareSerial on AVR, ESP32 and SAMD does): a frame that does not fit stays queued until the next update().
+ * A frame larger than the whole buffer is written once the buffer is empty. Streams that always report 0
+ * (SoftwareSerial) are written straight away, like SerialManager does.
+ */
+
+const uint8_t link_sync_1 = 0xAA;
+const uint8_t link_sync_2 = 0x55;
+
+enum SerialLinkType : uint8_t {
+	LINK_DATA = 0x01,
+	LINK_ACK = 0x02,
+	LINK_SYN = 0x80,
+};
+
+struct SerialLinkStats {
+	uint32_t sent;          // DATA frames sent for the first time
+	uint32_t retransmitted; // DATA frames sent again after a timeout
+	uint32_t received;      // DATA frames delivered to receiveData
+	uint32_t duplicates;    // DATA frames dropped as already delivered or out of order
+	uint32_t crcErrors;     // frames dropped because of a bad CRC or length
+	uint32_t sessions;      // sessions started by this side
+};
+
+template<typename receiveT, typename sendT, uint8_t window = 4>
+class SerialLink {
+	static_assert(window >= 1 && window <= 64 && (window & (window - 1)) == 0, "window must be a power of two up to 64");
+	static_assert(sizeof(receiveT) <= 255 && sizeof(sendT) <= 255, "payload must fit in 255 bytes");
+
+public:
+	/*
+	 * Init the SerialLink.
+	 *
+	 * @param serial        -   Stream to talk over, usually a HardwareSerial already started with begin()
+	 * @param receiveData   -   Data, which is overwritten each time update() returns true
+	 * @param retransmitMs  -   time in [ms] without ack after which everything in flight is sent again, a few frame
+	 *                          times plus the peer's longest pause between two update() calls
+	 * @param maxRetries    -   timeouts in a row after which a new session is started
+	 */
+	SerialLink(Stream& serial, receiveT& receiveData, uint16_t retransmitMs = 20, uint8_t maxRetries = 8);
+
+	/*
+	 * Queue a copy of data and send it. The copy is kept until the peer acknowledged it.
+	 *
+	 * @return false if the window is full, nothing was sent
+	 */
+	bool send(const sendT& data);
+
+	/*
+	 * Read at most budget bytes, acknowledge and retransmit. Never waits for data.
+	 *
+	 * @param budget  -   bytes to read at most in this call
+	 * @return true if a new receiveData arrived. Reading stops there, so no message is overwritten before the
+	 *         caller saw it.
+	 */
+	bool update(uint16_t budget = 64);
+
+	bool canSend() const { return (uint8_t)(_next - _base) < window; }
+	uint8_t pending() const { return (uint8_t)(_next - _base); }
+	const SerialLinkStats& stats() const { return _stats; }
+
+private:
+	enum State : uint8_t { WAIT_SYNC_1, WAIT_SYNC_2, HEADER, PAYLOAD, CRC_LO, CRC_HI };
+
+	static uint16_t crcUpdate(uint16_t crc, uint8_t data);
+	void transmit(uint8_t type, uint8_t session, uint8_t seq, const uint8_t* payload, uint8_t len);
+	void transmitData(uint8_t seq);
+	bool canWrite(uint8_t len);
+	void flush();
+	bool frameReceived();
+	void newSession();
+
+	Stream& _serial;
+	receiveT& _indata;
+	uint16_t _retransmitMs;
+	uint8_t _maxRetries;
+	SerialLinkStats _stats;
+
+	// sending side
+	sendT _window[window];
+	uint8_t _session;
+	uint8_t _sessionStart;  // first sequence number of the session, sent with LINK_SYN
+	uint8_t _base;          // oldest unacknowledged sequence number
+	uint8_t _tx;            // next sequence number to write, _base.._next
+	uint8_t _next;          // sequence number of the next send()
+	uint8_t _high;          // first sequence number never written, to tell retransmissions apart
+	int _txRoom;            // most free transmit buffer seen, i.e. the buffer is empty
+	uint8_t _retries;
+	unsigned long _timer;
+
+	// receiving side
+	receiveT _rx;
+	uint8_t _header[4];     // type, session, seq, len
+	uint8_t _pos;
+	State _state;
+	uint16_t _crc;
+	uint8_t _peerSession;   // 0 = not synchronised
+	uint8_t _expected;
+	bool _ackPending;
+};
+
+template<typename receiveT, typename sendT, uint8_t window>
+SerialLink<receiveT, sendT, window>::SerialLink(Stream& serial, receiveT& receiveData, uint16_t retransmitMs, uint8_t maxRetries) :
+	_serial(serial),
+	_indata(receiveData),
+	_retransmitMs(retransmitMs),
+	_maxRetries(maxRetries),
+	_stats(),
+	_session(0),
+	_sessionStart(0),
+	_base(0),
+	_tx(0),
+	_next(0),
+	_high(0),
+	_txRoom(0),
+	_retries(0),
+	_timer(0),
+	_pos(0),
+	_state(WAIT_SYNC_1),
+	_crc(0xFFFF),
+	_peerSession(0),
+	_expected(0),
+	_ackPending(false)
+{
+
+}
+
+template<typename receiveT, typename sendT, uint8_t window>
+uint16_t SerialLink<receiveT, sendT, window>::crcUpdate(uint16_t crc, uint8_t data) {
+#ifdef __AVR__
+	return _crc_ccitt_update(crc, data);
+#else
+	data ^= (uint8_t)crc;
+	data ^= data << 4;
+	return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+#endif
+}
+
+template<typename receiveT, typename sendT, uint8_t window>
+void SerialLink<receiveT, sendT, window>::transmit(uint8_t type, uint8_t session, uint8_t seq, const uint8_t* payload, uint8_t len) {
+	uint8_t head[6] = {link_sync_1, link_sync_2, type, session, seq, len};
+	uint16_t crc = 0xFFFF;
+	for (uint8_t i = 2; i < sizeof(head); i++) {
+		crc = crcUpdate(crc, head[i]);
+	}
+	for (uint8_t i = 0; i < len; i++) {
+		crc = crcUpdate(crc, payload[i]);
+	}
+	uint8_t tail[2] = {(uint8_t)crc, (uint8_t)(crc >> 8)};
+
+	_serial.write(head, sizeof(head));
+	if (len) {
+		_serial.write(payload, len);
+	}
+	_serial.write(tail, sizeof(tail));
+}
+
+template<typename receiveT, typename sendT, uint8_t window>
+void SerialLink<receiveT, sendT, window>::transmitData(uint8_t seq) {
+	uint8_t type = LINK_DATA;
+	if (seq == _sessionStart) {
+		type |= LINK_SYN;
+	}
+	transmit(type, _session, seq, (const uint8_t*)&_window[seq % window], sizeof(sendT));
+}
+
+template<typename receiveT, typename sendT, uint8_t window>
+bool SerialLink<receiveT, sendT, window>::canWrite(uint8_t len) {
+	int room = _serial.availableForWrite();
+	if (room > _txRoom) {
+		_txRoom = room;
+	}
+	return room >= (int)len + 8 || room == _txRoom;
+}
+
+template<typename receiveT, typename sendT, uint8_t window>
+void SerialLink<receiveT, sendT, window>::flush() {
+	while (_tx != _next && canWrite(sizeof(sendT))) {
+		transmitData(_tx);
+		if (_tx == _high) {
+			_high++;
+			_stats.sent++;
+		}
+		else {
+			_stats.retransmitted++;
+		}
+		_tx++;
+	}
+}
+
+template<typename receiveT, typename sendT, uint8_t window>
+void SerialLink<receiveT, sendT, window>::newSession() {
+	// Differs from the previous session, never 0 (= not synchronised on the receiving side)
+	uint8_t session = _session + 1 + (uint8_t)(micros() & 0x3F);
+	_session = session ? session : 1;
+	_sessionStart = _base;
+	_retries = 0;
+	_stats.sessions++;
+}
+
+template<typename receiveT, typename sendT, uint8_t window>
+bool SerialLink<receiveT, sendT, window>::send(const sendT& data) {
+	if (!canSend()) {
+		return false;
+	}
+	if (_session == 0) {
+		newSession();
+	}
+	if (_next == _base) {
+		_timer = millis();
+	}
+	_window[_next % window] = data;
+	_next++;
+	flush();
+	return true;
+}
+
+template<typename receiveT, typename sendT, uint8_t window>
+bool SerialLink<receiveT, sendT, window>::update(uint16_t budget) {
+	bool delivered = false;
+
+	while (!delivered && budget > 0 && _serial.available() > 0) {
+		budget--;
+		uint8_t c = (uint8_t)_serial.read();
+
+		switch (_state) {
+		case WAIT_SYNC_1:
+			if (c == link_sync_1) {
+				_state = WAIT_SYNC_2;
+			}
+			break;
+		case WAIT_SYNC_2:
+			if (c == link_sync_2) {
+				_state = HEADER;
+				_pos = 0;
+				_crc = 0xFFFF;
+			}
+			else if (c != link_sync_1) {
+				_state = WAIT_SYNC_1;
+			}
+			break;
+		case HEADER:
+			_header[_pos++] = c;
+			_crc = crcUpdate(_crc, c);
+			if (_pos == sizeof(_header)) {
+				uint8_t type = _header[0] & ~LINK_SYN;
+				uint8_t len = _header[3];
+				if ((type == LINK_DATA && len == sizeof(receiveT)) || (type == LINK_ACK && len == 0)) {
+					_pos = 0;
+					_state = len ? PAYLOAD : CRC_LO;
+				}
+				else {
+					_stats.crcErrors++;
+					_state = WAIT_SYNC_1;
+				}
+			}
+			break;
+		case PAYLOAD:
+			((uint8_t*)&_rx)[_pos++] = c;
+			_crc = crcUpdate(_crc, c);
+			if (_pos == sizeof(receiveT)) {
+				_state = CRC_LO;
+			}
+			break;
+		case CRC_LO:
+			_crc ^= c;
+			_state = CRC_HI;
+			break;
+		case CRC_HI:
+			_crc ^= (uint16_t)c << 8;
+			_state = WAIT_SYNC_1;
+			if (_crc != 0) {
+				_stats.crcErrors++;
+				break;
+			}
+			delivered = frameReceived();
+			break;
+		}
+	}
+
+	if (_ackPending && canWrite(0)) {
+		transmit(LINK_ACK, _peerSession, _expected, NULL, 0);
+		_ackPending = false;
+	}
+
+	// Nothing acknowledged in time: go back to the oldest frame and send the whole window again
+	if (_next != _base && millis() - _timer >= ((unsigned long)_retransmitMs << (_retries < 4 ? _retries : 4))) {
+		if (++_retries > _maxRetries) {
+			newSession();
+		}
+		_tx = _base;
+		_timer = millis();
+	}
+	flush();
+
+	return delivered;
+}
+
+template<typename receiveT, typename sendT, uint8_t window>
+bool SerialLink<receiveT, sendT, window>::frameReceived() {
+	uint8_t type = _header[0];
+	uint8_t session = _header[1];
+	uint8_t seq = _header[2];
+
+	if ((type & ~LINK_SYN) == LINK_ACK) {
+		// Cumulative: everything before seq arrived, if it belongs to our session and is in flight
+		uint8_t acked = (uint8_t)(seq - _base);
+		if (session == _session && acked > 0 && acked <= pending()) {
+			if ((uint8_t)(_tx - _base) < acked) {
+				_tx = seq;
+			}
+			_base = seq;
+			_retries = 0;
+			_timer = millis();
+		}
+		return false;
+	}
+
+	_ackPending = true;
+	if ((type & LINK_SYN) && session != _peerSession) {
+		// Peer started over (or we did): take its numbering from here
+		_peerSession = session;
+		_expected = seq;
+	}
+	if (session != _peerSession || seq != _expected) {
+		_stats.duplicates++;
+		return false;
+	}
+	_expected++;
+	_indata = _rx;
+	_stats.received++;
+	return true;
+}
+
+#endif
@@ -96,7 +96,7 @@ int8_t SerialManager<receiveT, sendT>::receive(unsigned long timeout) {
 	{
 		receive_size = (int)sizeof(receiveT) + 4;
 	}
-	if (_input == FAST)
+	if (_input == SECURE)
 	{
 		receive_size = (int)sizeof(receiveT) + 5;
 	}
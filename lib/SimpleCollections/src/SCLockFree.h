@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry)
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef SIMPLECOLLECTIONS_SCLOCKFREE_H
+#define SIMPLECOLLECTIONS_SCLOCKFREE_H
+
+#include <string.h>
+#include <inttypes.h>
+#include <SCThreadingSupport.h>
+
+/**
+ * @file SCLockFree.h
+ * @brief lock free building blocks for sharing state between interrupts, threads and cores without losing updates.
+ *
+ * Both classes are built on the same casAtomic/readAtomic primitives as the circular buffers, so they work on every
+ * board that SCThreadingSupport.h supports, from AVR (where interrupts are the only concurrency) up to the two cores
+ * of an ESP32, and on a desktop OS when SC_HOST_THREADS is defined.
+ */
+
+namespace tccollection {
+
+    /** Removes volatile from the position type so that local copies can be kept in registers */
+    template<class T> struct ScPlainType { typedef T type; };
+    template<class T> struct ScPlainType<volatile T> { typedef T type; };
+    typedef ScPlainType<position_t>::type position_value_t;
+
+    /** true when the modular difference between two positions is "negative", IE the first is behind the second */
+    inline bool positionBehind(position_value_t diff) { return diff > (position_value_t)(~(position_value_t)0) >> 1; }
+
+    /**
+     * A seqlock protected snapshot of a multi-word value. There must be exactly one writer (one interrupt, one task or
+     * one core), any number of readers can take consistent copies at the same time. The writer never waits, a reader
+     * retries when the writer was part way through an update. Use this for state that is written often and read as a
+     * whole, for example all sensor readings of one sweep.
+     *
+     * T must be trivially copyable. Readers that can preempt the writer (IE an ISR reading state that loop() writes)
+     * must use tryRead, because spinning there would never let the writer finish.
+     */
+    template<class T> class SeqLockSnapshot {
+    private:
+        position_t sequence;
+        T data;
+    public:
+        SeqLockSnapshot() : sequence(0), data() { }
+
+        /**
+         * Publish a new value, only ever call from the single writer.
+         * @param value the value to copy into the snapshot
+         */
+        void write(const T& value) {
+            position_value_t seq = readAtomic(&sequence);
+            sequence = seq + 1;         // odd: update in progress
+            scMemoryBarrier();
+            memcpy(&data, &value, sizeof(T));
+            scMemoryBarrier();
+            sequence = seq + 2;
+        }
+
+        /**
+         * Try once to take a consistent copy.
+         * @param out where to copy the value, may be partly written even when false is returned
+         * @return true if the copy is consistent, false if the writer was active, try again later.
+         */
+        bool tryRead(T& out) const {
+            position_value_t before = readAtomic(const_cast<position_ptr_t>(&sequence));
+            if(before & 1) return false;
+            scMemoryBarrier();
+            memcpy(&out, &data, sizeof(T));
+            scMemoryBarrier();
+            return readAtomic(const_cast<position_ptr_t>(&sequence)) == before;
+        }
+
+        /**
+         * Take a consistent copy, retrying until the writer is not active. Do not call from a context that can
+         * preempt the writer.
+         */
+        T read() const {
+            T out;
+            while(!tryRead(out)) { }
+            return out;
+        }
+
+        /** @return the number of completed writes, useful to see if anything changed since the last read */
+        position_value_t version() const { return readAtomic(const_cast<position_ptr_t>(&sequence)) >> 1; }
+    };
+
+    /**
+     * A bounded multiple producer, single consumer queue of events. Any number of interrupts, threads or cores can
+     * put at the same time, exactly one context takes the events off with get(). Unlike GenericCircularBuffer it never
+     * overwrites: when it is full, put returns false and the event is counted in dropped(), so nothing is lost without
+     * it being visible.
+     *
+     * Each slot has its own sequence number: a producer reserves a slot by a CAS on the write position, copies the
+     * event in and then publishes the slot. The consumer only ever sees fully written events. The size must be a power
+     * of two.
+     */
+    template<class T> class MpscEventRing {
+    private:
+        position_t writerPosition;
+        position_t readerPosition;
+        position_t droppedEvents;
+        const position_value_t mask;
+        position_t *const slotSequence;
+        T *const buffer;
+
+    public:
+        /**
+         * @param size the number of events the ring can hold, must be a power of two.
+         */
+        explicit MpscEventRing(uint16_t size) : writerPosition(0), readerPosition(0), droppedEvents(0), mask(size - 1),
+                                                slotSequence(new position_t[size]), buffer(new T[size]) {
+            atomicInitialisationSupport();
+            for(uint16_t i = 0; i < size; i++) slotSequence[i] = i;
+        }
+        ~MpscEventRing() {
+            delete[] slotSequence;
+            delete[] buffer;
+        }
+
+        /**
+         * Add an event, safe from any number of interrupts, threads and cores at once.
+         * @param item the event to copy in
+         * @return true if it was queued, false if the ring was full and the event was dropped.
+         */
+        bool put(const T& item) {
+            position_value_t pos = readAtomic(&writerPosition);
+            while(true) {
+                position_value_t diff = readAtomic(&slotSequence[pos & mask]) - pos;
+                if(diff == 0) {
+                    if(casAtomic(&writerPosition, pos, pos + 1)) break;
+                    pos = readAtomic(&writerPosition);
+                }
+                else {
+                    // either another producer took the slot (the position moved on, try again) or the slot is not
+                    // yet free (full, or the consumer is part way through releasing it), then give up rather than
+                    // spin, as we may have interrupted the consumer.
+                    position_value_t now = readAtomic(&writerPosition);
+                    if(now == pos || positionBehind(diff)) {
+                        markDropped();
+                        return false;
+                    }
+                    pos = now;
+                }
+            }
+            buffer[pos & mask] = item;
+            scMemoryBarrier();
+            slotSequence[pos & mask] = pos + 1;
+            return true;
+        }
+
+        /**
+         * Take the oldest event, only ever call from the single consumer.
+         * @param out where the event is copied to
+         * @return true if an event was available
+         */
+        bool get(T& out) {
+            position_value_t pos = readerPosition;
+            if(readAtomic(&slotSequence[pos & mask]) != (position_value_t)(pos + 1)) return false;
+            scMemoryBarrier();
+            out = buffer[pos & mask];
+            scMemoryBarrier();
+            slotSequence[pos & mask] = pos + mask + 1;
+            readerPosition = pos + 1;
+            return true;
+        }
+
+        /** @return true if at least one published event is waiting, only meaningful on the consumer */
+        bool available() const {
+            position_value_t pos = readerPosition;
+            return readAtomic(const_cast<position_ptr_t>(&slotSequence[pos & mask])) == (position_value_t)(pos + 1);
+        }
+
+        /** @return the number of events that were dropped because the ring was full */
+        position_value_t dropped() const { return readAtomic(const_cast<position_ptr_t>(&droppedEvents)); }
+
+    private:
+        void markDropped() {
+            position_value_t existing;
+            do {
+                existing = readAtomic(&droppedEvents);
+            } while(!casAtomic(&droppedEvents, existing, existing + 1));
+        }
+    };
+
+}
+
+#endif //SIMPLECOLLECTIONS_SCLOCKFREE_H
@@ -12,7 +12,7 @@
  */
 
 // when not on mbed, we need to load Arduino.h to get the right defines for some boards.
-#ifndef __MBED__
+#if !defined(__MBED__) && !defined(SC_HOST_THREADS)
 #include <Arduino.h>
 #endif
 
@@ -23,6 +23,13 @@
  * boards we use LDREX/STREX to create an atomic write situation. On ESP32 we use the FreeRTOS CAS operation, and on all
  * other boards we disable interrupts around the check. This should work for nearly all cases, even with multiple threads
  * and interrupt usage.
+ *
+ * Define SC_HOST_THREADS when building for a desktop OS (for example host unit tests with real threads), the GCC atomic
+ * builtins are then used and Arduino.h is not needed. Adding SC_HOST_CAS_EMULATION instead builds the interrupt
+ * blocking emulation with 32 bit positions, for single threaded tests of that path.
+ *
+ * scMemoryBarrier() orders plain memory accesses around the position updates, it is a full fence on multicore boards
+ * and a compiler barrier on single core boards where only interrupts can interleave.
  */
 
 // You can add your own local definitions header file here, this enables you to adjust build flags in environments
@@ -86,7 +93,22 @@ inline bool casAtomic(position_ptr_t ptr, position_t expected, position_t newVal
     uxPortCompareSet(ptr, exp32, &new32);
     return new32 == expected;
 }
-inline uint16_t readAtomic(position_ptr_t ptr) { return *(ptr); }
+inline uint32_t readAtomic(position_ptr_t ptr) { return *(ptr); }
+#elif defined(SC_HOST_THREADS)
+typedef volatile uint32_t* position_ptr_t;
+typedef volatile uint32_t position_t;
+#define atomicInitialisationSupport()
+#ifdef SC_HOST_CAS_EMULATION
+// the interrupt blocking emulation with 32 bit positions as on ESP8266 and Cortex M0/M3, single threaded tests only
+#define noInterrupts()
+#define interrupts()
+#define NEEDS_CAS_EMULATION
+#else
+inline bool casAtomic(position_ptr_t ptr, position_t expected, position_t newVal) {
+    return __sync_bool_compare_and_swap(ptr, expected, newVal);
+}
+inline uint32_t readAtomic(position_ptr_t ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+#endif // SC_HOST_CAS_EMULATION
 #else
 #include <Arduino.h>
 #define atomicInitialisationSupport()
@@ -97,7 +119,10 @@ typedef volatile uint16_t position_t;
 
 #ifdef NEEDS_CAS_EMULATION
 bool casAtomic(position_ptr_t ptr, position_t expected, position_t newVal);
-inline uint16_t readAtomic(position_ptr_t ptr) { return *ptr; }
+inline position_t readAtomic(position_ptr_t ptr) { return *ptr; }
+#define scMemoryBarrier() __asm__ __volatile__("" ::: "memory")
+#elif !defined(scMemoryBarrier)
+#define scMemoryBarrier() __sync_synchronize()
 #endif // NEEDS_CAS_EMULATION
 
 #endif //SIMPLECOLLECTIONS_SCTHREADINGSUPPORT_H
@@ -13,6 +13,37 @@
 using namespace ioaTreeInternal;
 using namespace tccollection;
 
+BtreeArena::BtreeArena(void *mem, size_t size) {
+    // start on an aligned boundary, then every allocation is rounded up to keep it that way
+    auto start = reinterpret_cast<uintptr_t>(mem);
+    size_t skip = (SC_ARENA_ALIGNMENT - (start % SC_ARENA_ALIGNMENT)) % SC_ARENA_ALIGNMENT;
+    memory = reinterpret_cast<uint8_t *>(mem) + skip;
+    arenaSize = size > skip ? size - skip : 0;
+    used = 0;
+}
+
+void *BtreeArena::allocate(size_t amount) {
+    amount = aligned(amount);
+    if(amount > available()) return nullptr;
+    void *block = memory + used;
+    used += amount;
+    return block;
+}
+
+bool BtreeArena::extend(void *block, size_t oldSize, size_t newSize) {
+    oldSize = aligned(oldSize);
+    newSize = aligned(newSize);
+    if(reinterpret_cast<uint8_t *>(block) + oldSize != memory + used) return false;
+    if(newSize > oldSize && (newSize - oldSize) > available()) return false;
+    used = used - oldSize + newSize;
+    return true;
+}
+
+void BtreeArena::release(void *block, size_t size) {
+    size = aligned(size);
+    if(reinterpret_cast<uint8_t *>(block) + size == memory + used) used -= size;
+}
+
 BtreeStorage::BtreeStorage(bsize_t size, GrowByMode howToGrow, bsize_t itemSize, KeyAccessor keyAccess, CopyOperator copyOperator) {
     currentCapacity = size;
     growByMode = howToGrow;
@@ -20,13 +51,60 @@ BtreeStorage::BtreeStorage(bsize_t size, GrowByMode howToGrow, bsize_t itemSize,
     sizeOfAnItem = itemSize;
     keyAccessor = keyAccess;
     copier = copyOperator;
+    memoryMode = HEAP_MEMORY;
+    arena = nullptr;
     binTree = malloc(sizeOfAnItem * size);
-    swapperSpace = malloc(sizeOfAnItem);
+}
+
+BtreeStorage::BtreeStorage(void *fixedMemory, bsize_t size, bsize_t itemSize, KeyAccessor keyAccess, CopyOperator copyOperator) {
+    currentCapacity = size;
+    growByMode = GROW_NEVER;
+    currentSize = 0;
+    sizeOfAnItem = itemSize;
+    keyAccessor = keyAccess;
+    copier = copyOperator;
+    memoryMode = FIXED_MEMORY;
+    arena = nullptr;
+    binTree = fixedMemory;
+}
+
+BtreeStorage::BtreeStorage(BtreeArena *theArena, bsize_t size, GrowByMode howToGrow, bsize_t itemSize,
+                           KeyAccessor keyAccess, CopyOperator copyOperator) {
+    growByMode = howToGrow;
+    currentSize = 0;
+    sizeOfAnItem = itemSize;
+    keyAccessor = keyAccess;
+    copier = copyOperator;
+    memoryMode = ARENA_MEMORY;
+    arena = theArena;
+    binTree = arena->allocate(sizeOfAnItem * size);
+    currentCapacity = binTree ? size : 0;
 }
 
 BtreeStorage::~BtreeStorage() {
-    free(binTree);
-    free(swapperSpace);
+    if(memoryMode == HEAP_MEMORY) free(binTree);
+    else if(memoryMode == ARENA_MEMORY && binTree) arena->release(binTree, sizeOfAnItem * currentCapacity);
+}
+
+/**
+ * Moves count items from src to dest index, the ranges may overlap. Trivially copyable items are moved in bulk,
+ * others one at a time through the copier, in an order that never overwrites an item before it is moved.
+ */
+void BtreeStorage::moveItems(bsize_t dest, bsize_t src, bsize_t count) {
+    if(count == 0 || dest == src) return;
+    if(copier == nullptr) {
+        memmove(memoryOf(binTree, dest), memoryOf(binTree, src), count * sizeOfAnItem);
+    }
+    else if(dest > src) {
+        for(bsize_t i = count; i > 0; --i) {
+            copier(memoryOf(binTree, dest + i - 1), memoryOf(binTree, src + i - 1));
+        }
+    }
+    else {
+        for(bsize_t i = 0; i < count; ++i) {
+            copier(memoryOf(binTree, dest + i), memoryOf(binTree, src + i));
+        }
+    }
 }
 
 bool BtreeStorage::add(const void *newItem) {
@@ -36,42 +114,31 @@ bool BtreeStorage::add(const void *newItem) {
     // find the insertion point.
     bsize_t insertionPoint = nearestLocation(keyAccessor(newItem));
 
-    // given the insert position, work out the number of items to move
-    int amtToMove = (currentSize - insertionPoint);
-
-    // move the instances in reverse order using their assignment operator.
-    if(amtToMove > 0) {
-        for (bsize_t i = insertionPoint + amtToMove; i > insertionPoint; --i) {
-            copier(memoryOf(binTree, i), memoryOf(binTree, i - 1));
-        }
-    }
+    // move everything from the insertion point up by one to make space
+    moveItems(insertionPoint + 1, insertionPoint, currentSize - insertionPoint);
 
     // and finally, insert the new item
-    copier(memoryOf(binTree, insertionPoint), newItem);
+    if(copier) copier(memoryOf(binTree, insertionPoint), newItem);
+    else memcpy(memoryOf(binTree, insertionPoint), newItem, sizeOfAnItem);
     currentSize++;
     return true;
 }
 
 bool BtreeStorage::removeByKey(uint32_t key) {
-    for(bsize_t i = 0; i<currentSize; ++i) {
-        if(keyAccessor(memoryOf(binTree, i)) == key) {
-            removeIndex(i);
-            return true;
-        }
-    }
-    return false;
+    if(currentSize == 0) return false;
+    bsize_t loc = nearestLocation(key);
+    if(loc >= currentSize || keyAccessor(memoryOf(binTree, loc)) != key) return false;
+
+    // with duplicate keys, remove the first one as the linear search used to
+    while(loc > 0 && keyAccessor(memoryOf(binTree, loc - 1)) == key) --loc;
+    removeIndex(loc);
+    return true;
 }
 
 void BtreeStorage::removeIndex(bsize_t index) {
-    // given the insert position, work out the number of items to move
-    int amtToMove = (currentSize - index) - 1;
-
-    // move the instances in reverse order using their assignment operator.
-    if(amtToMove > 0) {
-        for (bsize_t i = index; i < index + amtToMove; ++i) {
-            copier(memoryOf(binTree, i), memoryOf(binTree, i + 1));
-        }
-    }
+    if(currentSize == 0) return;
+    // close the gap by moving everything above the index down by one, an index past the end drops the last item
+    if(index < currentSize) moveItems(index, index + 1, (currentSize - index) - 1);
     currentSize--;
 }
 
@@ -85,16 +152,37 @@ bool BtreeStorage::checkCapacity() {
     if(currentSize < currentCapacity) return true;
     if(growByMode == GROW_NEVER) return false;
 
-    // now determine the new size and try and group the list.
-    int newSize = currentSize + ((growByMode == GROW_BY_5) ? 5 : currentSize);
-    auto replacement = malloc(sizeOfAnItem * newSize);
+    if(memoryMode == FIXED_MEMORY) return false;
+
+    // now determine the new size and try and group the list, never beyond what bsize_t can count.
+    size_t newSize = currentSize + ((growByMode == GROW_BY_5) ? 5 : (currentSize ? currentSize : 1));
+    if(newSize > (bsize_t)~(bsize_t)0) newSize = (bsize_t)~(bsize_t)0;
+    if(newSize <= currentCapacity) return false;
+
+    // in an arena the list can often grow where it is, then nothing needs to be copied
+    if(memoryMode == ARENA_MEMORY && binTree && arena->extend(binTree, sizeOfAnItem * currentCapacity, sizeOfAnItem * newSize)) {
+        currentCapacity = newSize;
+        return true;
+    }
+
+    void *replacement = (memoryMode == ARENA_MEMORY) ? arena->allocate(sizeOfAnItem * newSize) : malloc(sizeOfAnItem * newSize);
     if(replacement == nullptr) return false;
 
     // now copy over and replace the current tree.
-    for(bsize_t i=0; i<currentSize; ++i) {
-        copier(memoryOf(replacement, i), memoryOf(binTree, i));
+    if(copier == nullptr) {
+        if(currentSize) memcpy(replacement, binTree, currentSize * sizeOfAnItem);
+    }
+    else {
+        for(bsize_t i=0; i<currentSize; ++i) {
+            copier(memoryOf(replacement, i), memoryOf(binTree, i));
+        }
+    }
+    if(memoryMode == ARENA_MEMORY) {
+        if(binTree) arena->release(binTree, sizeOfAnItem * currentCapacity);
+    }
+    else {
+        free(binTree);
     }
-    free(binTree);
     binTree = replacement;
     currentCapacity = newSize;
     return true;
@@ -135,5 +223,5 @@ bsize_t BtreeStorage::nearestLocation(uint32_t key) const {
 void *BtreeStorage::getByKey(uint32_t key) const {
     if(currentSize == 0) return nullptr;
     bsize_t loc = nearestLocation(key);
-    return (keyAccessor(memoryOf(binTree, loc)) == key && loc < currentSize) ? memoryOf(binTree, loc) : nullptr;
+    return (loc < currentSize && keyAccessor(memoryOf(binTree, loc)) == key) ? memoryOf(binTree, loc) : nullptr;
 }
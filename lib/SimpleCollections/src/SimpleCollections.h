@@ -39,6 +39,75 @@ typedef uint8_t bsize_t;
 typedef size_t bsize_t;
 #endif
 
+// Types that are trivially copyable are moved around with memmove instead of item by item through their assignment
+// operator. Compilers without the builtin fall back to the assignment operator for everything.
+#if (defined(__GNUC__) && __GNUC__ >= 5) || defined(__clang__)
+# define SC_IS_TRIVIALLY_COPYABLE(T) __is_trivially_copyable(T)
+#else
+# define SC_IS_TRIVIALLY_COPYABLE(T) false
+#endif
+
+#ifndef SC_ARENA_ALIGNMENT
+# if __BIGGEST_ALIGNMENT__ > 8
+#  define SC_ARENA_ALIGNMENT 8
+# else
+#  define SC_ARENA_ALIGNMENT __BIGGEST_ALIGNMENT__
+# endif
+#endif
+
+namespace tccollection {
+
+    /**
+     * A block of memory that you provide (normally a static array) which lists can allocate and grow into instead of
+     * using the heap. Allocation is a simple bump of the used pointer, so it is very cheap and never fragments the heap.
+     * A list whose storage is the most recent allocation grows in place without copying. Memory given up by a list that
+     * is not the most recent allocation is only reclaimed by reset(), so give each long lived list its own arena, or
+     * size them up front, when memory is tight.
+     */
+    class BtreeArena {
+    private:
+        uint8_t *memory;
+        size_t arenaSize;
+        size_t used;
+    public:
+        /**
+         * @param mem the memory to manage, it must outlive all lists that use it
+         * @param size the size of mem in bytes
+         */
+        BtreeArena(void *mem, size_t size);
+
+        /**
+         * @param amount the number of bytes needed
+         * @return the memory or nullptr if there is not enough left.
+         */
+        void *allocate(size_t amount);
+
+        /**
+         * Try to grow a block without moving it, only possible when it is the most recent allocation.
+         * @return true if the block is now newSize bytes long
+         */
+        bool extend(void *block, size_t oldSize, size_t newSize);
+
+        /**
+         * Give a block back, it is only reused when it is the most recent allocation, otherwise it stays until reset.
+         */
+        void release(void *block, size_t size);
+
+        /** Forget all allocations, only call when no list is using the arena any longer */
+        void reset() { used = 0; }
+
+        /** @return the bytes allocated so far, including any that could not be reclaimed */
+        size_t inUse() const { return used; }
+
+        /** @return the bytes still free at the end of the arena */
+        size_t available() const { return arenaSize - used; }
+
+    private:
+        static size_t aligned(size_t amount) { return (amount + SC_ARENA_ALIGNMENT - 1) & ~(size_t)(SC_ARENA_ALIGNMENT - 1); }
+    };
+
+}
+
 
 namespace ioaTreeInternal {
 
@@ -46,26 +115,45 @@ namespace ioaTreeInternal {
 
     typedef void (*CopyOperator)(void *dest, const void *src);
 
+    /** Where the storage engine gets its memory from */
+    enum BtreeMemory : unsigned char {
+        /** malloc and free, the original behaviour */
+        HEAP_MEMORY,
+        /** memory owned by the caller, the capacity never changes */
+        FIXED_MEMORY,
+        /** allocated from and grown within a BtreeArena */
+        ARENA_MEMORY
+    };
+
     /**
      * This is an internal btree storage engine that used by all the templates to actually store the data (and
      * hopefully save a lot of FLASH). It implements the costly features of the btree in a one off way. However,
      * as a result the keys must now be unsigned integer, and cannot exceed uint32_t. If you need more than this
      * use a std container.
+     *
+     * When the copy operator is nullptr the items are trivially copyable and are moved in bulk with memmove.
      */
     class BtreeStorage {
     private:
         void *binTree;
-        void *swapperSpace;
+        tccollection::BtreeArena *arena;
         KeyAccessor keyAccessor;
         CopyOperator copier;
         bsize_t currentCapacity;
         bsize_t currentSize;
         bsize_t sizeOfAnItem;
         tccollection::GrowByMode growByMode;
+        BtreeMemory memoryMode;
     public:
         BtreeStorage(bsize_t size, tccollection::GrowByMode howToGrow, bsize_t eachItemSize, KeyAccessor compareOperator,
                      CopyOperator copyOperator);
 
+        BtreeStorage(void *fixedMemory, bsize_t size, bsize_t eachItemSize, KeyAccessor compareOperator,
+                     CopyOperator copyOperator);
+
+        BtreeStorage(tccollection::BtreeArena *arena, bsize_t size, tccollection::GrowByMode howToGrow,
+                     bsize_t eachItemSize, KeyAccessor compareOperator, CopyOperator copyOperator);
+
         ~BtreeStorage();
 
         bool add(const void *newItem);
@@ -88,6 +176,7 @@ namespace ioaTreeInternal {
 
     private:
         bool checkCapacity();
+        void moveItems(bsize_t dest, bsize_t src, bsize_t count);
         void *memoryOf(void *baseMem, bsize_t item) const { return ((uint8_t *) baseMem) + (item * sizeOfAnItem); }
     };
 }
@@ -141,7 +230,17 @@ namespace tccollection {
          * @param howToGrow the way in which it should grow if space runs out, optional
          */
         explicit BtreeList(bsize_t size = DEFAULT_LIST_SIZE, GrowByMode howToGrow = DEFAULT_GROW_MODE)
-                : treeStorage(size, howToGrow, sizeof(V), keyAccessor, copyInternal) {}
+                : treeStorage(size, howToGrow, sizeof(V), keyAccessor, copierFor()) {}
+
+        /**
+         * Create a btree list that never uses the heap, the storage is allocated from the arena, and when the list
+         * needs to grow, it grows within the arena. See BtreeArena for how memory is reclaimed.
+         * @param arena the arena to allocate from, it must outlive the list
+         * @param size the initial size of the list
+         * @param howToGrow the way in which it should grow if space runs out, optional
+         */
+        BtreeList(BtreeArena &arena, bsize_t size, GrowByMode howToGrow = DEFAULT_GROW_MODE)
+                : treeStorage(&arena, size, howToGrow, sizeof(V), keyAccessor, copierFor()) {}
         /**
          * Advanced usage constructor, prefer using the other constructor whenever possible.
          *
@@ -162,7 +261,7 @@ namespace tccollection {
          * @param howToGrow the method for growing when space runs out, optional parameter
          */
         explicit BtreeList(ioaTreeInternal::KeyAccessor customAccessor, bsize_t size = DEFAULT_LIST_SIZE, GrowByMode howToGrow = DEFAULT_GROW_MODE)
-                : treeStorage(size, howToGrow, sizeof(V), customAccessor, copyInternal) {}
+                : treeStorage(size, howToGrow, sizeof(V), customAccessor, copierFor()) {}
 
         static uint32_t keyAccessor(const void *itm) {
             return reinterpret_cast<const V *>(itm)->getKey();
@@ -174,6 +273,20 @@ namespace tccollection {
             *itemDest = *itemSrc;
         }
 
+        /** @return nullptr when V can be moved with memmove, otherwise the assignment based copier */
+        static ioaTreeInternal::CopyOperator copierFor() {
+            return SC_IS_TRIVIALLY_COPYABLE(V) ? nullptr : copyInternal;
+        }
+
+    protected:
+        /**
+         * Used by FixedBtreeList, creates a list on memory owned by the caller that never grows.
+         */
+        BtreeList(void *fixedMemory, bsize_t size, ioaTreeInternal::KeyAccessor accessor)
+                : treeStorage(fixedMemory, size, sizeof(V), accessor, copierFor()) {}
+
+    public:
+
         /**
          * Adds an item into the current list of items, the list will be sorted by using getKey()
          * on the object passed in. If the list cannot fit the item and cannot resize to do so, then
@@ -277,6 +390,35 @@ namespace tccollection {
             }
         }
     };
+
+/**
+ * A BtreeList with a capacity that is fixed at compile time, the storage is part of the object itself, so a global
+ * or static instance never touches the heap. When it is full, add returns false. Apart from construction it is used
+ * exactly as BtreeList.
+ *
+ * ```FixedBtreeList<uint32_t, Reading, 32> history;```
+ *
+ * @tparam K the key type
+ * @tparam V the value type, see BtreeList for the restrictions
+ * @tparam N the capacity
+ */
+    template<class K, class V, bsize_t N>
+    class FixedBtreeList : public BtreeList<K, V> {
+    private:
+        alignas(V) uint8_t fixedStorage[sizeof(V) * N];
+    public:
+        FixedBtreeList() : BtreeList<K, V>(fixedStorage, N, BtreeList<K, V>::keyAccessor) {}
+
+        /**
+         * @param customAccessor the custom accessor that is called to return the key, see BtreeList.
+         */
+        explicit FixedBtreeList(ioaTreeInternal::KeyAccessor customAccessor)
+                : BtreeList<K, V>(fixedStorage, N, customAccessor) {}
+
+        // the storage pointer would still refer to the original
+        FixedBtreeList(const FixedBtreeList &) = delete;
+        FixedBtreeList &operator=(const FixedBtreeList &) = delete;
+    };
 }
 
 #ifndef TC_COLLECTION_MANUAL_NAMESPACE
@@ -0,0 +1,95 @@
+
+#include <SCLockFree.h>
+#include <testing/SimpleTest.h>
+#include <IoLogging.h>
+
+using namespace SimpleTest;
+using namespace tccollection;
+
+struct SweepData {
+    uint32_t sweep;
+    uint16_t cm[4];
+};
+
+test(testEventRingKeepsOrderAndCountsDrops) {
+    MpscEventRing<uint16_t> ring(8);
+    uint16_t item;
+    assertFalse(ring.available());
+    assertFalse(ring.get(item));
+
+    for(uint16_t i = 0; i < 10; i++) ring.put(i);
+    assertEquals((uint32_t)2, (uint32_t)ring.dropped());
+
+    for(uint16_t i = 0; i < 8; i++) {
+        assertTrue(ring.get(item));
+        assertEquals(i, item);
+    }
+    assertFalse(ring.available());
+
+    // wraps around the slot sequence numbers many times
+    for(uint16_t i = 0; i < 1000; i++) {
+        assertTrue(ring.put(i));
+        assertTrue(ring.get(item));
+        assertEquals(i, item);
+    }
+    assertEquals((uint32_t)2, (uint32_t)ring.dropped());
+}
+
+test(testSnapshotReadsWhatWasWritten) {
+    SeqLockSnapshot<SweepData> snapshot;
+    assertEquals((uint32_t)0, (uint32_t)snapshot.version());
+
+    SweepData data = {42, {10, 20, 30, 40}};
+    snapshot.write(data);
+    SweepData out;
+    assertTrue(snapshot.tryRead(out));
+    assertEquals((uint32_t)42, out.sweep);
+    assertEquals((uint16_t)40, out.cm[3]);
+    assertEquals((uint32_t)1, (uint32_t)snapshot.version());
+
+    data.sweep = 43;
+    snapshot.write(data);
+    assertEquals((uint32_t)43, snapshot.read().sweep);
+    assertEquals((uint32_t)2, (uint32_t)snapshot.version());
+}
+
+#ifdef ESP32
+#include <pthread.h>
+
+MpscEventRing<uint32_t> glRing(64);
+SeqLockSnapshot<SweepData> glSnapshot;
+volatile bool ringTestRunning = true;
+
+void* ringProducerProc(void*) {
+    for(uint32_t i = 0; ringTestRunning && i < 2000; i++) {
+        while(!glRing.put(i) && ringTestRunning) vPortYield();
+        SweepData data = {i, {(uint16_t)i, (uint16_t)(i * 2), (uint16_t)(i * 3), (uint16_t)(i * 4)}};
+        glSnapshot.write(data);
+    }
+    return nullptr;
+}
+
+test(testEventRingAndSnapshotAcrossCores) {
+    pthread_t producerThread;
+    pthread_create(&producerThread, nullptr, ringProducerProc, (void*) nullptr);
+
+    auto millisThen = millis();
+    uint32_t expected = 0;
+    uint32_t torn = 0;
+    uint32_t item;
+    while(expected < 2000 && (millis() - millisThen) < 2000) {
+        if(glRing.get(item)) {
+            if(item != expected) break;
+            expected++;
+        }
+        SweepData data = glSnapshot.read();
+        if(data.cm[1] != (uint16_t)(data.sweep * 2) || data.cm[3] != (uint16_t)(data.sweep * 4)) torn++;
+    }
+    ringTestRunning = false;
+    pthread_join(producerThread, nullptr);
+
+    assertEquals((uint32_t)2000, expected);
+    assertEquals((uint32_t)0, torn);
+}
+
+#endif
@@ -251,4 +251,57 @@ test(testAddingThenRemovingThenAddingItems) {
     assertEquals(myList.count(), bsize_t(18));
     assertTrue(myList.getByKey(100) == nullptr);
     assertTrue(myList.getByKey(119) == nullptr);
-}
\ No newline at end of file
+}
+test(testFixedListNeverGrows) {
+    FixedBtreeList<uint32_t, NumericStorageItem, 8> myList;
+    assertEquals(myList.capacity(), bsize_t(8));
+
+    // add in reverse so that every add shifts the existing items up
+    for(int i=0;i<8;i++) {
+        assertTrue(myList.add(NumericStorageItem(107 - i)));
+    }
+    assertFalse(myList.add(NumericStorageItem(200)));
+    assertEquals(myList.capacity(), bsize_t(8));
+    assertEquals(myList.count(), bsize_t(8));
+
+    for(int i=0;i<8;i++) {
+        assertEquals(myList.itemAtIndex(i)->getKey(), uint32_t(i + 100));
+    }
+
+    // removing the head shifts everything down
+    assertTrue(myList.removeByKey(100));
+    assertEquals(myList.itemAtIndex(0)->getKey(), uint32_t(101));
+    assertTrue(myList.add(NumericStorageItem(200)));
+    assertEquals(myList.itemAtIndex(7)->getKey(), uint32_t(200));
+}
+
+test(testArenaListGrowsWithinArena) {
+    // room for 44 items (4 then growing by 5), plus some slack for aligning the start
+    static uint8_t arenaMemory[sizeof(NumericStorageItem) * 44 + 8];
+    BtreeArena arena(arenaMemory, sizeof(arenaMemory));
+    {
+        BtreeList<uint32_t, NumericStorageItem> myList(arena, 4, GROW_BY_5);
+        int added = 0;
+        while(added < 100 && myList.add(NumericStorageItem(added + 100))) added++;
+
+        // the list was the only allocation, so it grew in place every time and filled the arena
+        assertEquals(added, 44);
+        assertEquals(myList.capacity(), bsize_t(44));
+        for(int i=0;i<44;i++) {
+            assertTrue(myList.getByKey(i + 100) != nullptr);
+        }
+    }
+    // destroying the only list gives its memory back
+    assertEquals(arena.inUse(), size_t(0));
+}
+
+test(testCopierUsedForNonTrivialItems) {
+    FixedBtreeList<int, TestStorage, 5> myList;
+    myList.add(storage3);
+    myList.add(storage1);
+    myList.add(storage2);
+    assertTrue(myList.removeByKey(1));
+    assertEquals(myList.count(), bsize_t(2));
+    assertEquals(myList.itemAtIndex(0)->getItem(), 101);
+    assertEquals(myList.itemAtIndex(1)->getItem(), 102);
+}
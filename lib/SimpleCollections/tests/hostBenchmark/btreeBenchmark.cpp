@@ -0,0 +1,155 @@
+/*
+ * Throughput of BtreeList insert, lookup and remove on a desktop OS, for each way the list can store its items:
+ *
+ *   copier  - heap storage, items moved one at a time through the assignment operator (how every list worked before
+ *             memmove support, and still how non trivially copyable types work)
+ *   memmove - heap storage, trivially copyable items moved in bulk
+ *   fixed   - FixedBtreeList, compile time capacity, no heap at all
+ *   arena   - storage allocated from and grown within a BtreeArena
+ *
+ * The items look like a detector history entry: keyed by timestamp, 8 bytes. "window" keeps the last N readings per
+ * approach, adding at the end and removing the oldest, which is the worst case for removal as everything shifts down.
+ *
+ * Build and run from this directory:
+ *
+ *     g++ -std=c++17 -O2 -DSC_HOST_THREADS -I../../src btreeBenchmark.cpp ../../src/SimpleCollections.cpp -o btreeBenchmark
+ *     ./btreeBenchmark
+ *
+ * Define BENCH_COPIER_ONLY to build against a version of the library without FixedBtreeList and BtreeArena.
+ */
+
+#include <SimpleCollections.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+struct Reading {
+    uint32_t timestamp;
+    uint16_t distanceCm;
+    uint8_t approach;
+    uint8_t flags;
+
+    uint32_t getKey() const { return timestamp; }
+};
+
+// identical layout, but the user provided assignment makes it non trivially copyable
+struct CopiedReading {
+    uint32_t timestamp;
+    uint16_t distanceCm;
+    uint8_t approach;
+    uint8_t flags;
+
+    CopiedReading() : timestamp(0), distanceCm(0), approach(0), flags(0) {}
+    CopiedReading(uint32_t t, uint16_t d, uint8_t a, uint8_t f) : timestamp(t), distanceCm(d), approach(a), flags(f) {}
+    CopiedReading &operator=(const CopiedReading &other) {
+        timestamp = other.timestamp;
+        distanceCm = other.distanceCm;
+        approach = other.approach;
+        flags = other.flags;
+        return *this;
+    }
+
+    uint32_t getKey() const { return timestamp; }
+};
+
+struct Result {
+    double insertNs;
+    double lookupNs;
+    double removeNs;
+    double windowNs;
+};
+
+static uint32_t randomState = 1;
+static uint32_t nextRandom() {
+    randomState = randomState * 1664525UL + 1013904223UL;
+    return randomState >> 8;
+}
+
+static volatile uint32_t sink;
+
+static double nanosSince(std::chrono::steady_clock::time_point start, uint32_t ops) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return (double)ns / ops;
+}
+
+template<class V, class L> Result benchmark(L &list, bsize_t size, uint32_t rounds) {
+    Result r = {};
+    uint32_t *keys = new uint32_t[size];
+
+    uint32_t inserts = 0, lookups = 0, removes = 0;
+    for(uint32_t round = 0; round < rounds; round++) {
+        list.clear();
+        randomState = round + 1;
+        for(bsize_t i = 0; i < size; i++) keys[i] = (nextRandom() << 4) | i;   // unique
+
+        auto start = std::chrono::steady_clock::now();
+        for(bsize_t i = 0; i < size; i++) list.add(V{keys[i], (uint16_t)i, (uint8_t)(i & 3), 0});
+        r.insertNs += nanosSince(start, 1);
+        inserts += size;
+
+        start = std::chrono::steady_clock::now();
+        for(bsize_t j = 0; j < 4; j++) {
+            for(bsize_t i = 0; i < size; i++) sink = list.getByKey(keys[(i * 7 + j) % size])->distanceCm;
+        }
+        r.lookupNs += nanosSince(start, 1);
+        lookups += size * 4;
+
+        start = std::chrono::steady_clock::now();
+        for(bsize_t i = 0; i < size; i++) list.removeByKey(keys[(i * 13) % size]);
+        r.removeNs += nanosSince(start, 1);
+        removes += size;
+    }
+    r.insertNs /= inserts;
+    r.lookupNs /= lookups;
+    r.removeNs /= removes;
+
+    // sliding window of the last "size" readings
+    list.clear();
+    uint32_t windowOps = rounds * size * 4;
+    auto start = std::chrono::steady_clock::now();
+    for(uint32_t t = 1; t <= windowOps; t++) {
+        if(list.count() == size) list.removeIndex(0);
+        list.add(V{t * 100, (uint16_t)t, (uint8_t)(t & 3), 0});
+    }
+    r.windowNs = nanosSince(start, windowOps);
+
+    delete[] keys;
+    return r;
+}
+
+static void print(const char *name, bsize_t size, const Result &r) {
+    printf("%-8s %5u %10.1f %10.1f %10.1f %10.1f\n", name, (unsigned)size, r.insertNs, r.lookupNs, r.removeNs,
+           r.windowNs);
+}
+
+template<bsize_t N> void runSize(uint32_t rounds) {
+    {
+        BtreeList<uint32_t, CopiedReading> list(N, GROW_NEVER);
+        print("copier", N, benchmark<CopiedReading>(list, N, rounds));
+    }
+#ifndef BENCH_COPIER_ONLY
+    {
+        BtreeList<uint32_t, Reading> list(N, GROW_NEVER);
+        print("memmove", N, benchmark<Reading>(list, N, rounds));
+    }
+    {
+        static FixedBtreeList<uint32_t, Reading, N> list;
+        print("fixed", N, benchmark<Reading>(list, N, rounds));
+    }
+    {
+        static uint8_t memory[2 * N * sizeof(Reading) + 16];
+        BtreeArena arena(memory, sizeof(memory));
+        BtreeList<uint32_t, Reading> list(arena, N / 4, GROW_BY_DOUBLE);
+        print("arena", N, benchmark<Reading>(list, N, rounds));
+    }
+#endif
+}
+
+int main() {
+    printf("%-8s %5s %10s %10s %10s %10s   (ns per operation)\n", "storage", "size", "insert", "lookup", "remove",
+           "window");
+    runSize<32>(20000);
+    runSize<128>(5000);
+    runSize<250>(2000);
+    return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * Stress tests for SCLockFree.h with real threads on a desktop OS. Unlike the other tests these do not need a board,
+ * build and run them from this directory with:
+ *
+ *     g++ -std=c++17 -O2 -pthread -DSC_HOST_THREADS -I../../src hostThreadedTests.cpp -o hostThreadedTests
+ *     ./hostThreadedTests
+ *
+ * Returns non zero if any check fails. Run it a few times, races do not show up on every run.
+ *
+ * The interrupt blocking emulation used on ESP8266 and Cortex M0/M3 is checked single threaded with:
+ *
+ *     g++ -std=c++17 -O2 -pthread -DSC_HOST_THREADS -DSC_HOST_CAS_EMULATION -I../../src hostThreadedTests.cpp \
+ *         ../../src/SCThreadingSupport.cpp -o hostEmulationTests
+ *     ./hostEmulationTests
+ */
+
+#include <SCLockFree.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace tccollection;
+
+static int failures = 0;
+
+#define check(cond, ...) do { if(!(cond)) { failures++; printf("FAIL %s:%d ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while(0)
+
+struct ProducerEvent {
+    uint32_t producer;
+    uint32_t sequence;
+};
+
+// Several producers hammer a small ring, the consumer checks that every producer's events arrive in order, without
+// duplicates, and that whatever is missing was counted as dropped.
+void testMpscManyProducers(int producers, uint32_t perProducer, uint16_t ringSize) {
+    MpscEventRing<ProducerEvent> ring(ringSize);
+    std::atomic<int> running(producers);
+    std::vector<std::thread> threads;
+    std::vector<uint32_t> accepted(producers, 0);
+
+    for(int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            for(uint32_t i = 0; i < perProducer; i++) {
+                if(ring.put(ProducerEvent{(uint32_t)p, i})) accepted[p]++;
+                else std::this_thread::yield();     // give the consumer a chance on small machines
+            }
+            running--;
+        });
+    }
+
+    std::vector<int64_t> lastSeen(producers, -1);
+    std::vector<uint32_t> received(producers, 0);
+    ProducerEvent ev;
+    while(running > 0 || ring.available()) {
+        if(!ring.get(ev)) {
+            std::this_thread::yield();
+            continue;
+        }
+        check(ev.producer < (uint32_t)producers, "bad producer %u", ev.producer);
+        if(ev.producer >= (uint32_t)producers) break;
+        check((int64_t)ev.sequence > lastSeen[ev.producer], "producer %u went from %lld to %u", ev.producer,
+              (long long)lastSeen[ev.producer], ev.sequence);
+        lastSeen[ev.producer] = ev.sequence;
+        received[ev.producer]++;
+    }
+    for(auto& t : threads) t.join();
+    while(ring.get(ev)) received[ev.producer]++;
+
+    uint32_t total = 0, totalAccepted = 0;
+    for(int p = 0; p < producers; p++) {
+        check(received[p] == accepted[p], "producer %d: %u accepted but %u received", p, accepted[p], received[p]);
+        total += received[p];
+        totalAccepted += accepted[p];
+    }
+    uint32_t produced = producers * perProducer;
+    check(totalAccepted + ring.dropped() == produced, "%u accepted + %u dropped != %u produced", totalAccepted,
+          (unsigned)ring.dropped(), produced);
+    printf("mpsc %d producers, ring %u: %u received, %u dropped\n", producers, ringSize, total,
+           (unsigned)ring.dropped());
+}
+
+// A full ring must refuse new events instead of overwriting old ones.
+void testMpscFullRingDrops() {
+    MpscEventRing<ProducerEvent> ring(4);
+    for(uint32_t i = 0; i < 6; i++) ring.put(ProducerEvent{0, i});
+    check(ring.dropped() == 2, "expected 2 dropped, got %u", (unsigned)ring.dropped());
+    ProducerEvent ev;
+    for(uint32_t i = 0; i < 4; i++) {
+        check(ring.get(ev) && ev.sequence == i, "expected event %u", i);
+    }
+    check(!ring.get(ev), "ring should be empty");
+    printf("mpsc full ring: ok\n");
+}
+
+// The positions only ever count up, a long running ring must keep working once they pass what 16 bits can hold.
+// A position cut down to 16 bits makes put spin forever, so a watchdog turns that into a failure.
+void testMpscPastPositionWrap() {
+    MpscEventRing<ProducerEvent> ring(8);
+    ProducerEvent ev;
+    uint32_t lost = 0;
+    std::atomic<bool> done(false);
+    std::thread watchdog([&]() {
+        for(int i = 0; i < 100 && !done; i++) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if(!done) {
+            printf("FAIL %s:%d put stuck past 65536 positions\n", __FILE__, __LINE__);
+            fflush(stdout);
+            _exit(1);
+        }
+    });
+    for(uint32_t i = 0; i < 70000; i++) {
+        ring.put(ProducerEvent{0, i});
+        if(!ring.get(ev) || ev.sequence != i) lost++;
+    }
+    done = true;
+    watchdog.join();
+    check(lost == 0, "%u events lost or out of order", lost);
+    check(ring.dropped() == 0, "expected nothing dropped, got %u", (unsigned)ring.dropped());
+    check(!ring.get(ev), "ring should be empty");
+    printf("mpsc past 65536 positions: ok\n");
+}
+
+struct SensorSweep {
+    uint32_t sweep;
+    uint16_t cm[4];
+    uint32_t checksum;
+
+    void fill(uint32_t s) {
+        sweep = s;
+        checksum = s;
+        for(int i = 0; i < 4; i++) {
+            cm[i] = (uint16_t)(s * (i + 3));
+            checksum ^= cm[i] << (i * 4);
+        }
+    }
+
+    bool consistent() const {
+        uint32_t c = sweep;
+        for(int i = 0; i < 4; i++) {
+            if(cm[i] != (uint16_t)(sweep * (i + 3))) return false;
+            c ^= cm[i] << (i * 4);
+        }
+        return c == checksum;
+    }
+};
+
+// One writer publishes sweeps as fast as it can, several readers must never see a mix of two sweeps and never
+// see the sweep number go backwards. The writer keeps going until every reader has read often enough, otherwise a
+// busy machine can finish the writes before the readers are even scheduled and the test proves nothing.
+#define SEQLOCK_MIN_READS   10000
+#define SEQLOCK_TIMEOUT_S   30
+
+void testSeqLockReaders(int readers, uint32_t writes) {
+    SeqLockSnapshot<SensorSweep> snapshot;
+    std::atomic<bool> writing(true);
+    std::atomic<uint32_t> torn(0);
+    std::atomic<uint32_t> reads(0);
+    std::atomic<int> slowReaders(readers);
+
+    std::vector<std::thread> threads;
+    for(int r = 0; r < readers; r++) {
+        threads.emplace_back([&]() {
+            uint32_t last = 0;
+            uint32_t own = 0;
+            while(writing) {
+                SensorSweep s = snapshot.read();
+                if(!s.consistent()) torn++;
+                if(s.sweep < last) torn++;
+                last = s.sweep;
+                reads++;
+                if(++own == SEQLOCK_MIN_READS) slowReaders--;
+            }
+        });
+    }
+
+    SensorSweep s;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(SEQLOCK_TIMEOUT_S);
+    uint32_t written = 0;
+    while(written < writes || (slowReaders > 0 && std::chrono::steady_clock::now() < deadline)) {
+        s.fill(++written);
+        snapshot.write(s);
+        if(written >= writes) std::this_thread::yield();   // let the readers catch up
+    }
+    writing = false;
+    for(auto& t : threads) t.join();
+
+    check(slowReaders == 0, "%d readers below %u reads within %u s", slowReaders.load(), SEQLOCK_MIN_READS,
+          SEQLOCK_TIMEOUT_S);
+    check(torn == 0, "%u torn or stale reads", (unsigned)torn.load());
+    check(snapshot.read().sweep == written, "last write not visible");
+    check(snapshot.version() == written, "version %u != %u", (unsigned)snapshot.version(), written);
+    printf("seqlock %d readers: %u writes, %u reads, %u torn\n", readers, written, (unsigned)reads.load(),
+           (unsigned)torn.load());
+}
+
+int main() {
+    testMpscFullRingDrops();
+    testMpscPastPositionWrap();
+#ifndef SC_HOST_CAS_EMULATION
+    testMpscManyProducers(1, 1000000, 64);
+    testMpscManyProducers(4, 500000, 64);
+    testMpscManyProducers(8, 200000, 8);
+    testSeqLockReaders(1, 2000000);
+    testSeqLockReaders(4, 2000000);
+#endif
+
+    printf(failures ? "%d FAILED\n" : "all passed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -54,6 +54,7 @@ TaskManager::TaskManager() : taskBlocks {} {
 	taskBlocks[0] = new TaskBlock(0);
 	numberOfBlocks = 1;
 	runningTask = nullptr;
+	profiler = nullptr;
 	tm_internal::atomicWriteBool(&memLockerFlag, false);
 }
 
@@ -186,17 +187,30 @@ void TaskManager::yieldForMicros(uint32_t microsToWait) {
 	tm_internal::atomicWritePtr(&runningTask, prevTask);
 }
 
+/**
+ * Internal helper that marks the running task by scope, and when a profiler is attached, also measures how late the
+ * task started against its requested slot and how long it ran for.
+ */
 class TaskExecutionRecorder {
 private:
     TimerTask* prevTask;
+    TimerTask* thisTask;
     TaskManager* taskMgr;
+    TaskProfiler* profiler;
+    uint32_t lateMicros;
+    uint32_t startMicros;
 public:
-    TaskExecutionRecorder(TaskManager* tm, TimerTask* task) : taskMgr(tm) {
+    TaskExecutionRecorder(TaskManager* tm, TimerTask* task) : thisTask(task), taskMgr(tm), profiler(tm->profiler) {
         prevTask = tm->getRunningTask();
         tm_internal::atomicWritePtr(&tm->runningTask, task);
+        if(profiler) {
+            lateMicros = task->microsLate();
+            startMicros = micros();
+        }
     }
 
     ~TaskExecutionRecorder() {
+        if(profiler) profiler->recordExecution(thisTask, lateMicros, micros() - startMicros);
         tm_internal::atomicWritePtr(&taskMgr->runningTask, prevTask);
     }
 };
@@ -9,6 +9,7 @@
 #include "TaskPlatformDeps.h"
 #include "TaskTypes.h"
 #include "TaskBlock.h"
+#include "TaskProfiler.h"
 
 #ifdef PARTICLE
 enum InterruptMode;
@@ -167,6 +168,7 @@ protected:
 
     tm_internal::TmAtomicBool memLockerFlag;      // memory and list operations are locked by this flag using the TmSpinLocker
     tm_internal::TimerTaskAtomicPtr runningTask;
+    TaskProfiler* volatile profiler;
 public:
     /**
      * On all platforms there is a default instance of TaskManager called taskManager. You can create other instances
@@ -387,6 +389,18 @@ public:
      */
     TimerTask* getRunningTask() { return runningTask; }
 
+    /**
+     * Attaches a profiler that records execution time and scheduling lateness of every task run. When no profiler
+     * is attached, the only cost is a pointer check per task run.
+     * @param newProfiler the profiler to attach, or nullptr to detach.
+     */
+    void setProfiler(TaskProfiler* newProfiler) { profiler = newProfiler; }
+
+    /**
+     * @return the attached profiler or nullptr if there is none.
+     */
+    TaskProfiler* getProfiler() { return profiler; }
+
     friend class TaskExecutionRecorder;
 private:
     /**
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#include "TaskProfiler.h"
+#include "TaskManagerIO.h"
+
+void TaskHistogram::clear() {
+    for(auto& bucket : buckets) bucket = 0;
+}
+
+void TaskHistogram::add(uint32_t value) {
+    // the bucket is the number of significant bits, capped to the overflow bucket
+    uint8_t bucket = 0;
+    while(value != 0 && bucket < (TM_PROFILER_BUCKETS - 1)) {
+        value >>= 1;
+        bucket++;
+    }
+
+    if(buckets[bucket] == 0xFFFF) {
+        for(auto& b : buckets) b >>= 1;
+    }
+    buckets[bucket]++;
+}
+
+uint32_t TaskHistogram::bucketLimit(uint8_t bucket) {
+    if(bucket >= (TM_PROFILER_BUCKETS - 1)) return 0xFFFFFFFFUL;
+    return (1UL << bucket) - 1;
+}
+
+uint32_t TaskHistogram::percentile(uint8_t pct) const {
+    uint32_t total = 0;
+    for(auto bucket : buckets) total += bucket;
+    if(total == 0) return 0;
+
+    // round the required count upwards, so p99 of 50 samples is the highest sample
+    uint32_t needed = (total * pct + 99) / 100;
+    uint32_t seen = 0;
+    for(uint8_t i = 0; i < TM_PROFILER_BUCKETS; i++) {
+        seen += buckets[i];
+        if(seen >= needed) return bucketLimit(i);
+    }
+    return bucketLimit(TM_PROFILER_BUCKETS - 1);
+}
+
+void TaskProfiler::reset() {
+    for(auto& profile : profiles) {
+        profile.task = nullptr;
+        profile.runCount = 0;
+        profile.totalMicros = 0;
+        profile.maxMicros = 0;
+        profile.maxLateMicros = 0;
+        profile.execution.clear();
+        profile.lateness.clear();
+    }
+    untrackedRuns = 0;
+    overheadRuns = 0;
+    overheadTotal = 0;
+    overheadMax = 0;
+}
+
+void TaskProfiler::recordExecution(TimerTask* task, uint32_t lateMicros, uint32_t execMicros) {
+    uint32_t started = micros();
+
+    TaskProfile* profile = nullptr;
+    for(auto& p : profiles) {
+        if(p.task == task) {
+            profile = &p;
+            break;
+        }
+        if(p.task == nullptr && profile == nullptr) profile = &p;
+    }
+
+    if(profile == nullptr) {
+        untrackedRuns++;
+    }
+    else {
+        profile->task = task;
+        profile->runCount++;
+        profile->totalMicros += execMicros;
+        if(execMicros > profile->maxMicros) profile->maxMicros = execMicros;
+        if(lateMicros > profile->maxLateMicros) profile->maxLateMicros = lateMicros;
+        profile->execution.add(execMicros);
+        profile->lateness.add(lateMicros);
+    }
+
+    uint32_t overhead = micros() - started;
+    overheadRuns++;
+    overheadTotal += overhead;
+    if(overhead > overheadMax) overheadMax = overhead;
+}
+
+const TaskProfile* TaskProfiler::findProfile(TimerTask* task) const {
+    for(auto& p : profiles) {
+        if(p.task == task) return &p;
+    }
+    return nullptr;
+}
+
+#ifndef IOA_USE_MBED
+void TaskProfiler::dump(Print& out, TaskManager& tm) const {
+    out.println(F("task,runs,total_ms,max_us,p99_us,late_max_us,late_p99_us"));
+    for(auto& p : profiles) {
+        if(p.task == nullptr) continue;
+
+        // task slots never move in memory, so we can search for the ID
+        int taskId = -1;
+        for(taskid_t id = 0; id < (DEFAULT_TASK_SIZE * DEFAULT_TASK_BLOCKS); id++) {
+            if(tm.getTask(id) == p.task) {
+                taskId = id;
+                break;
+            }
+        }
+
+        out.print(taskId);
+        out.print(',');
+        out.print(p.runCount);
+        out.print(',');
+        out.print((uint32_t)(p.totalMicros / 1000ULL));
+        out.print(',');
+        out.print(p.maxMicros);
+        out.print(',');
+        out.print(p.execution.percentile(99));
+        out.print(',');
+        out.print(p.maxLateMicros);
+        out.print(',');
+        out.println(p.lateness.percentile(99));
+    }
+    out.print(F("untracked,"));
+    out.println(untrackedRuns);
+    out.print(F("overhead_avg_us,"));
+    out.println(getOverheadAverage());
+    out.print(F("overhead_max_us,"));
+    out.println(overheadMax);
+}
+#endif
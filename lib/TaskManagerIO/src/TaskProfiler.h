@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TASKMANAGERIO_TASKPROFILER_H
+#define TASKMANAGERIO_TASKPROFILER_H
+
+/**
+ * @file TaskProfiler.h
+ * @brief an optional profiler that records execution time and scheduling lateness of every task run
+ */
+
+#include "TaskPlatformDeps.h"
+
+class TimerTask;
+class TaskManager;
+
+/**
+ * The number of tasks that can be tracked individually, runs of any further tasks are only counted. Define this
+ * yourself to change it, each slot costs around 90 bytes of RAM.
+ */
+#ifndef TM_PROFILER_SLOTS
+#define TM_PROFILER_SLOTS 8
+#endif
+
+/**
+ * The number of buckets in each histogram. Bucket 0 counts zero, bucket n counts values from 2^(n-1) up to 2^n - 1
+ * microseconds, and the last bucket everything above.
+ */
+#define TM_PROFILER_BUCKETS 16
+
+/**
+ * A fixed size logarithmic histogram of microsecond values. Counts are 16 bit, when any bucket would overflow, all
+ * buckets are halved, so the distribution is kept while older samples slowly lose weight.
+ */
+class TaskHistogram {
+private:
+    uint16_t buckets[TM_PROFILER_BUCKETS];
+public:
+    TaskHistogram() { clear(); }
+
+    /** clear down all buckets */
+    void clear();
+
+    /**
+     * Add a value to the histogram
+     * @param value the value in microseconds
+     */
+    void add(uint32_t value);
+
+    /**
+     * Get the given percentile. As the buckets are logarithmic this is the upper bound of the bucket containing
+     * the percentile, so it is never lower than the real value and at most double.
+     * @param pct the percentile, EG 99 for p99
+     * @return the upper bound in microseconds, 0 if nothing is recorded, 0xFFFFFFFF for the overflow bucket
+     */
+    uint32_t percentile(uint8_t pct) const;
+
+    /**
+     * @param bucket the bucket number
+     * @return the largest value that falls into the bucket
+     */
+    static uint32_t bucketLimit(uint8_t bucket);
+
+    /** @return the number of samples in the given bucket */
+    uint16_t getBucket(uint8_t bucket) const { return buckets[bucket]; }
+};
+
+/**
+ * The recorded statistics for a single task.
+ */
+struct TaskProfile {
+    /** the task being recorded, or nullptr if the slot is free */
+    TimerTask* task;
+    /** the number of times the task has run */
+    uint32_t runCount;
+    /** the total execution time, 64 bit so it does not wrap on long running systems */
+    uint64_t totalMicros;
+    /** the longest execution seen */
+    uint32_t maxMicros;
+    /** the latest start seen compared to the requested schedule slot */
+    uint32_t maxLateMicros;
+    /** distribution of the execution times */
+    TaskHistogram execution;
+    /** distribution of the start time lateness */
+    TaskHistogram lateness;
+};
+
+/**
+ * Records the execution time and the scheduling lateness of each task run by a task manager. Lateness is how long
+ * after the requested slot (for example of scheduleFixedRate) the task actually started. Attach it using
+ * `taskManager.setProfiler(&profiler)`. All storage is fixed size, there are no allocations after construction.
+ *
+ * The profiler also measures its own cost per task run, which is reported alongside the tasks, so it can be
+ * judged if it is cheap enough to leave enabled.
+ */
+class TaskProfiler {
+private:
+    TaskProfile profiles[TM_PROFILER_SLOTS];
+    uint32_t untrackedRuns;
+    uint32_t overheadRuns;
+    uint32_t overheadTotal;
+    uint32_t overheadMax;
+public:
+    TaskProfiler() { reset(); }
+
+    /** clear all statistics and free all slots */
+    void reset();
+
+    /**
+     * Called by task manager after each task run, not normally called from user code.
+     * @param task the task that ran
+     * @param lateMicros how long after the requested slot the task started
+     * @param execMicros how long the task took to execute
+     */
+    void recordExecution(TimerTask* task, uint32_t lateMicros, uint32_t execMicros);
+
+    /**
+     * @param task the task to find
+     * @return the profile for the task, or nullptr if it is not tracked
+     */
+    const TaskProfile* findProfile(TimerTask* task) const;
+
+    /**
+     * @param slot the slot number from 0 to TM_PROFILER_SLOTS - 1
+     * @return the profile in that slot, check the task field to see if it is in use
+     */
+    const TaskProfile* getProfile(uint8_t slot) const { return &profiles[slot]; }
+
+    /** @return the number of runs of tasks that did not fit into a slot */
+    uint32_t getUntrackedRuns() const { return untrackedRuns; }
+
+    /** @return the average cost of recording a single task run in microseconds */
+    uint32_t getOverheadAverage() const { return overheadRuns ? overheadTotal / overheadRuns : 0; }
+
+    /** @return the largest cost of recording a single task run in microseconds */
+    uint32_t getOverheadMax() const { return overheadMax; }
+
+#ifndef IOA_USE_MBED
+    /**
+     * Writes the statistics as CSV, one line per task, to any Print. For example Serial, or an open file on SD.
+     * @param out where to write to
+     * @param tm the task manager, used to convert the task slots back into task IDs
+     */
+    void dump(Print& out, TaskManager& tm) const;
+#endif
+};
+
+#endif //TASKMANAGERIO_TASKPROFILER_H
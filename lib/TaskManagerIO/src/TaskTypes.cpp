@@ -83,6 +83,18 @@ unsigned long TimerTask::microsFromNow() {
     return microsFromNow;
 }
 
+unsigned long TimerTask::microsLate() {
+    uint32_t delay = myTimingSchedule;
+    if (isMicrosSchedule()) {
+        uint32_t alreadyTaken = (micros() - scheduledAt);
+        return (alreadyTaken > delay) ? (alreadyTaken - delay) : 0;
+    }
+    else {
+        uint32_t alreadyTaken = (millis() - scheduledAt);
+        return (alreadyTaken > delay) ? ((alreadyTaken - delay) * 1000UL) : 0;
+    }
+}
+
 void TimerTask::execute() {
     RunningState runningState(this);
 
@@ -152,3 +164,7 @@ ISR_ATTR void BaseEvent::markTriggeredAndNotify() {
     triggered = true;
     taskMgrAssociation->triggerEvents();
 }
+
+void BaseEvent::notifyScheduleChanged() {
+    taskMgrAssociation->triggerEvents();
+}
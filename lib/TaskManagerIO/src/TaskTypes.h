@@ -110,6 +110,12 @@ public:
      * interrupt through task manager, then there is no need to call notify.
      */
     void markTriggeredAndNotify();
+
+    /**
+     * Tell task manager that the value returned by timeOfNextCheck has changed, without triggering the event. Task
+     * manager calls timeOfNextCheck again on its next loop, call this when an event moves its own schedule.
+     */
+    void notifyScheduleChanged();
 };
 
 /**
@@ -204,6 +210,11 @@ public:
      */
     unsigned long microsFromNow();
 
+    /**
+     * @return the number of microseconds that the task is past its scheduled time, 0 if it is not yet due.
+     */
+    unsigned long microsLate();
+
     /**
      * Initialise a task slot with execution information
      * @param executionInfo the time of execution
@@ -14,7 +14,7 @@ uint32_t makeHourSchedule(int hours, int minutes, int seconds, int millis) {
 }
 
 uint32_t makeDaySchedule(int days, int hours) {
-    return (days * 24UL * HOURS_TO_MILLIS) + (hours * MINUTES_TO_MILLIS);
+    return (days * 24UL * HOURS_TO_MILLIS) + (hours * HOURS_TO_MILLIS);
 }
 
 TmLongSchedule::TmLongSchedule(uint32_t milliScheduleNext, Executable* toExecute, bool oneTime) : milliSchedule(milliScheduleNext),
@@ -53,6 +53,13 @@ uint32_t TmLongSchedule::timeOfNextCheck() {
         millisFromNow = milliSchedule;
     }
 
-    // we'll wait a maximum of six minutes in between testing again.
-    return (millisFromNow > SIX_MINUTES_TO_MILLIS) ? SIX_MINUTES_TO_MILLIS : millisFromNow;
+    // we'll wait a maximum of six minutes in between testing again. Events are polled in microseconds.
+    return ((millisFromNow > SIX_MINUTES_TO_MILLIS) ? SIX_MINUTES_TO_MILLIS : millisFromNow) * 1000UL;
+}
+
+void TmLongSchedule::reschedule(uint32_t millisFromNow) {
+    milliSchedule = millisFromNow;
+    lastScheduleTime = millis();
+    if(lastScheduleTime == 0) lastScheduleTime = 1;
+    notifyScheduleChanged();
 }
@@ -19,7 +19,7 @@
  */
 class TmLongSchedule : public BaseEvent {
 private:
-    const uint32_t milliSchedule;
+    uint32_t milliSchedule;
     const TimerFn fnCallback;
     Executable *const theExecutable;
     uint32_t lastScheduleTime;
@@ -40,6 +40,20 @@ public:
     void exec() override;
 
     uint32_t timeOfNextCheck() override;
+
+    /**
+     * Change the schedule so that the event next fires millisFromNow milliseconds after this call, and every
+     * millisFromNow after that. Can be called from within the callback, for example by a calendar that works out
+     * the time of the next entry each time it runs. Task manager is notified so the new schedule takes effect
+     * straight away, rather than after the previous one has been polled.
+     * @param millisFromNow the new schedule in milliseconds
+     */
+    void reschedule(uint32_t millisFromNow);
+
+    /**
+     * @return the current schedule in milliseconds
+     */
+    uint32_t getSchedule() const { return milliSchedule; }
 };
 
 /**
@@ -0,0 +1,61 @@
+
+#include <testing/SimpleTest.h>
+#include <TmLongSchedule.h>
+#include "TaskManagerIO.h"
+#include "test_utils.h"
+
+using namespace SimpleTest;
+
+int longScheduleCount = 0;
+unsigned long longScheduleRanAt = 0;
+
+test(testLongScheduleHelpers) {
+    assertEquals(5400000UL, makeHourSchedule(1, 30));
+    assertEquals(61001UL, makeHourSchedule(0, 1, 1, 1));
+    assertEquals(86400000UL, makeDaySchedule(1));
+    assertEquals(93600000UL, makeDaySchedule(1, 2));
+}
+
+test(testLongScheduleNextCheckIsInMicros) {
+    TmLongSchedule schedule(200, [] { });
+
+    // events are polled in microseconds, a 200 milli schedule must not be polled every 200 micros.
+    uint32_t nextCheck = schedule.timeOfNextCheck();
+    assertMoreThan(150000UL, nextCheck);
+    assertTrue(nextCheck <= 200000UL);
+    assertFalse(schedule.isTriggered());
+
+    // and long schedules are still polled at most every six minutes
+    TmLongSchedule daily(makeDaySchedule(1), [] { });
+    assertEquals(360000000UL, daily.timeOfNextCheck());
+}
+
+test(testLongScheduleRescheduleFromCallback) {
+    taskManager.reset();
+    longScheduleCount = 0;
+    longScheduleRanAt = 0;
+
+    // starts off a day away, the first run moves it to 100 millis, as a calendar would when the next entry is close.
+    static TmLongSchedule moving(makeDaySchedule(1), [] {
+        longScheduleCount++;
+        longScheduleRanAt = millis();
+    });
+    taskManager.registerEvent(&moving);
+    taskManager.yieldForMicros(millisToMicros(20));
+    assertEquals(0, longScheduleCount);
+
+    unsigned long started = millis();
+    moving.reschedule(100);
+    assertEquals(100UL, moving.getSchedule());
+
+    while(longScheduleCount == 0 && (millis() - started) < 1000) {
+        taskManager.yieldForMicros(millisToMicros(10));
+    }
+    assertEquals(1, longScheduleCount);
+    assertMoreThan(95UL, longScheduleRanAt - started);
+    assertTrue((longScheduleRanAt - started) < 150UL);
+
+    moving.setCompleted(true);
+    taskManager.yieldForMicros(millisToMicros(10));
+    taskManager.reset();
+}
@@ -0,0 +1,68 @@
+
+#include <testing/SimpleTest.h>
+#include <TaskProfiler.h>
+#include "TaskManagerIO.h"
+#include "test_utils.h"
+
+using namespace SimpleTest;
+
+TaskProfiler testProfiler;
+taskid_t profiledFastTask;
+taskid_t profiledSlowTask;
+
+test(testHistogramBucketsAndPercentile) {
+    TaskHistogram histogram;
+    assertEquals(0U, histogram.percentile(99));
+
+    for(int i = 0; i < 98; i++) histogram.add(3);
+    histogram.add(100);
+    histogram.add(100000);
+
+    assertEquals(98U, histogram.getBucket(2));
+    assertEquals(1U, histogram.getBucket(7));
+    assertEquals(1U, histogram.getBucket(TM_PROFILER_BUCKETS - 1));
+
+    assertEquals(3U, histogram.percentile(50));
+    assertEquals(127U, histogram.percentile(99));
+    assertEquals(0xFFFFFFFFUL, histogram.percentile(100));
+}
+
+test(testHistogramHalvesWhenFull) {
+    TaskHistogram histogram;
+    for(uint32_t i = 0; i < 0xFFFFUL; i++) histogram.add(1);
+    histogram.add(8);
+    histogram.add(1);
+
+    assertEquals(0x8000U, histogram.getBucket(1));
+    assertEquals(0U, histogram.getBucket(4));
+}
+
+test(testProfilerRecordsEachTask) {
+    taskManager.reset();
+    testProfiler.reset();
+    taskManager.setProfiler(&testProfiler);
+
+    profiledFastTask = taskManager.scheduleFixedRate(1, [] { });
+    profiledSlowTask = taskManager.scheduleFixedRate(10, [] { delayMicroseconds(500); });
+
+    taskManager.yieldForMicros(millisToMicros(100));
+    taskManager.setProfiler(nullptr);
+
+    auto fast = testProfiler.findProfile(taskManager.getTask(profiledFastTask));
+    auto slow = testProfiler.findProfile(taskManager.getTask(profiledSlowTask));
+    assertTrue(fast != nullptr);
+    assertTrue(slow != nullptr);
+
+    assertMoreThan(30U, fast->runCount);
+    assertMoreThan(5U, slow->runCount);
+    assertMoreThan(499U, slow->maxMicros);
+    assertMoreThan(499U, slow->execution.percentile(99));
+    assertEquals(0U, testProfiler.getUntrackedRuns());
+
+    // a slow task holds up the fast one, that must show as lateness
+    assertMoreThan(0U, fast->maxLateMicros);
+
+    serdebugF2("Profiler overhead avg us ", testProfiler.getOverheadAverage());
+    serdebugF2("Profiler overhead max us ", testProfiler.getOverheadMax());
+    taskManager.reset();
+}
@@ -102,6 +102,7 @@ volatile unsigned long RCSwitch::nReceivedValue = 0;
 volatile unsigned int RCSwitch::nReceivedBitlength = 0;
 volatile unsigned int RCSwitch::nReceivedDelay = 0;
 volatile unsigned int RCSwitch::nReceivedProtocol = 0;
+volatile unsigned long RCSwitch::nReceivedMicros = 0;
 int RCSwitch::nReceiveTolerance = 60;
 const unsigned int RCSwitch::nSeparationLimit = 4300;
 // separationLimit: minimum microseconds between received codes, closer codes are ignored.
@@ -601,6 +602,14 @@ unsigned int* RCSwitch::getReceivedRawdata() {
   return RCSwitch::timings;
 }
 
+/**
+ * micros() at the interrupt that completed the received code,
+ * i.e. when it arrived rather than when available() was polled
+ */
+unsigned long RCSwitch::getReceivedMicros() {
+  return RCSwitch::nReceivedMicros;
+}
+
 /* helper function for the receiveProtocol method */
 static inline unsigned int diff(int A, int B) {
   return abs(A - B);
@@ -691,6 +700,7 @@ void RECEIVE_ATTR RCSwitch::handleInterrupt() {
         for(unsigned int i = 1; i <= numProto; i++) {
           if (receiveProtocol(i, changeCount)) {
             // receive succeeded for protocol i
+            RCSwitch::nReceivedMicros = time;
             break;
           }
         }
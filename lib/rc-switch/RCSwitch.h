@@ -92,6 +92,7 @@ class RCSwitch {
     unsigned int getReceivedDelay();
     unsigned int getReceivedProtocol();
     unsigned int* getReceivedRawdata();
+    unsigned long getReceivedMicros();
     #endif
   
     void enableTransmit(int nTransmitterPin);
@@ -171,6 +172,7 @@ class RCSwitch {
     volatile static unsigned int nReceivedBitlength;
     volatile static unsigned int nReceivedDelay;
     volatile static unsigned int nReceivedProtocol;
+    volatile static unsigned long nReceivedMicros;
     const static unsigned int nSeparationLimit;
     /* 
      * timings[0] contains sync timing, followed by a number of bits
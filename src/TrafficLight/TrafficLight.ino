@@ -569,25 +569,27 @@ long measureDistance(int trigPin, int echoPin, int lightNumber) {
   const long SENSOR_THRESHOLD_NIGHT = 300;  
   long sensorThreshold = isDayMode ? SENSOR_THRESHOLD_DAY : SENSOR_THRESHOLD_NIGHT;  
 
+  // Take the button press and clear it in one step: buttonState is an int (2 bytes on AVR),
+  // an ISR between reading and clearing it would tear the read or lose the new press
+  noInterrupts();
+  int pressedButton = buttonState;
+  buttonState = 0;
+  interrupts();
+
   // Check if trigger conditions are met (sensor error, obstacle too far, or manual press)  
-  if (distance == 0 || distance >= sensorThreshold || buttonState > 0) {  
+  if (distance == 0 || distance >= sensorThreshold || pressedButton > 0) {  
     // ---------------------------  
     // Priority: Manual Button Over Sensor Input  
     // ---------------------------  
     // If a manual button is pressed, override lightNumber with buttonState (1=Light1, 2=Light2)  
-    if (buttonState > 0) {  
-      lightNumber = buttonState;  // Use button-pressed light number  
+    if (pressedButton > 0) {  
+      lightNumber = pressedButton;  // Use button-pressed light number  
     }  
 
     // ---------------------------  
     // Trigger Light Transition  
     // ---------------------------  
     status(lightNumber);  // Update light states based on lightNumber  
-
-    // ---------------------------  
-    // Reset Manual Button State  
-    // ---------------------------  
-    buttonState = 0;  // Clear buttonState to avoid repeat triggers  
   }  
 
   return distance;  // Return measured distance (cm)  